@@ -0,0 +1,120 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include <cstring>
+
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/iostreams/filter/zlib.hpp>
+
+#include "common/BasicExceptions.hpp"
+#include "common/BinaryDataCompression.hpp"
+#include "common/StringConversion.hpp"
+
+namespace cf3 {
+namespace common {
+namespace detail {
+
+namespace
+{
+  /// Regroup the bytes of the elements, so byte b of element i ends up at b*nb_elements + i
+  void shuffle(const char* in, const Uint size, const Uint element_size, char* out)
+  {
+    const Uint nb_elements = size / element_size;
+    for(Uint i = 0; i != nb_elements; ++i)
+    {
+      for(Uint b = 0; b != element_size; ++b)
+        out[b*nb_elements + i] = in[i*element_size + b];
+    }
+    // Trailing bytes that don't form a complete element are copied unchanged
+    const Uint shuffled_size = nb_elements*element_size;
+    std::memcpy(out + shuffled_size, in + shuffled_size, size - shuffled_size);
+  }
+
+  void unshuffle(const char* in, const Uint size, const Uint element_size, char* out)
+  {
+    const Uint nb_elements = size / element_size;
+    for(Uint i = 0; i != nb_elements; ++i)
+    {
+      for(Uint b = 0; b != element_size; ++b)
+        out[i*element_size + b] = in[b*nb_elements + i];
+    }
+    const Uint shuffled_size = nb_elements*element_size;
+    std::memcpy(out + shuffled_size, in + shuffled_size, size - shuffled_size);
+  }
+}
+
+void compress_chunk(const char* data, const Uint size, const Uint shuffle_size, const Uint codec, const int level, std::vector<char>& result)
+{
+  result.clear();
+
+  std::vector<char> shuffled;
+  if(shuffle_size > 1)
+  {
+    shuffled.resize(size);
+    shuffle(data, size, shuffle_size, &shuffled[0]);
+    data = &shuffled[0];
+  }
+
+  switch(codec)
+  {
+  case BINARY_CODEC_NONE:
+    result.assign(data, data + size);
+    break;
+  case BINARY_CODEC_ZLIB:
+  {
+    result.reserve(size / 2);
+    boost::iostreams::filtering_ostream compressing_stream;
+    compressing_stream.push(boost::iostreams::zlib_compressor(boost::iostreams::zlib_params(level)));
+    compressing_stream.push(boost::iostreams::back_inserter(result));
+    compressing_stream.write(data, size);
+    compressing_stream.reset();
+    break;
+  }
+  default:
+    throw ValueNotFound(FromHere(), "Unknown binary data codec " + to_str(codec));
+  }
+}
+
+void decompress_chunk(const char* compressed, const Uint compressed_size, const Uint shuffle_size, const Uint codec, char* data, const Uint size)
+{
+  std::vector<char> shuffled;
+  char* out = data;
+  if(shuffle_size > 1)
+  {
+    shuffled.resize(size);
+    out = &shuffled[0];
+  }
+
+  switch(codec)
+  {
+  case BINARY_CODEC_NONE:
+    if(compressed_size != size)
+      throw FileFormatError(FromHere(), "Uncompressed chunk has size " + to_str(compressed_size) + " instead of " + to_str(size));
+    std::memcpy(out, compressed, size);
+    break;
+  case BINARY_CODEC_ZLIB:
+  {
+    boost::iostreams::filtering_istream decompressing_stream;
+    decompressing_stream.push(boost::iostreams::zlib_decompressor());
+    decompressing_stream.push(boost::iostreams::array_source(compressed, compressed_size));
+    decompressing_stream.read(out, size);
+    if(static_cast<Uint>(decompressing_stream.gcount()) != size)
+      throw FileFormatError(FromHere(), "Compressed chunk is truncated");
+    break;
+  }
+  default:
+    throw ValueNotFound(FromHere(), "Unknown binary data codec " + to_str(codec));
+  }
+
+  if(shuffle_size > 1)
+    unshuffle(out, size, shuffle_size, data);
+}
+
+} // detail
+} // common
+} // cf3
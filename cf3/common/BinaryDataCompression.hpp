@@ -0,0 +1,46 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_common_BinaryDataCompression_hpp
+#define cf3_common_BinaryDataCompression_hpp
+
+#include <vector>
+
+#include "common/CF.hpp"
+#include "common/CommonAPI.hpp"
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace common {
+namespace detail {
+
+///////////////////////////////////////////////////////////////////////////////////////
+
+/// Codecs used for the chunks of a binary data block. The values are stored in the files.
+enum BinaryDataCodec
+{
+  BINARY_CODEC_NONE = 0,
+  BINARY_CODEC_ZLIB = 1
+};
+
+/// Compress a chunk of raw data. If shuffle_size is larger than 1, the bytes of the elements of that size are first
+/// regrouped by significance, which makes arrays of floating point numbers compress better.
+/// This is thread-safe, so different chunks may be compressed concurrently.
+Common_API void compress_chunk(const char* data, const Uint size, const Uint shuffle_size, const Uint codec, const int level, std::vector<char>& result);
+
+/// Reverse the operation of compress_chunk, writing size bytes to data
+Common_API void decompress_chunk(const char* compressed, const Uint compressed_size, const Uint shuffle_size, const Uint codec, char* data, const Uint size);
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+} // detail
+} // common
+} // cf3
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+#endif // cf3_common_BinaryDataCompression_hpp
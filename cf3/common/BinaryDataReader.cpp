@@ -4,7 +4,10 @@
 // GNU Lesser General Public License version 3 (LGPLv3).
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
+#include <algorithm>
+
 #include <boost/bind.hpp>
+#include <boost/cstdint.hpp>
 #include <boost/function.hpp>
 
 #include <boost/iostreams/filtering_stream.hpp>
@@ -16,8 +19,10 @@
 #include "common/Signal.hpp"
 #include "common/PropertyList.hpp"
 #include "common/OptionList.hpp"
+#include "common/BinaryDataCompression.hpp"
 #include "common/BinaryDataReader.hpp"
 #include "common/FindComponents.hpp"
+#include "common/Threads.hpp"
 
 #include "common/PE/Comm.hpp"
 
@@ -33,10 +38,13 @@ struct BinaryDataReader::Implementation
 {
   Implementation(const URI& file, const Uint rank) :
     xml_doc(XML::parse_file(file)),
+    offset(0),
     m_rank(rank)
   {
     XmlNode cfbinary(xml_doc->content->first_node("cfbinary"));
-    cf3_assert(from_str<Uint>(cfbinary.attribute_value("version")) == version());
+    file_version = from_str<Uint>(cfbinary.attribute_value("version"));
+    if(file_version == 0 || file_version > version())
+      throw FileFormatError(FromHere(), "Unsupported binary data version " + to_str(file_version) + " in file " + file.path());
 
     XmlNode nodes(cfbinary.content->first_node(("nodes")));
     XmlNode node(nodes.content->first_node("node"));
@@ -50,6 +58,10 @@ struct BinaryDataReader::Implementation
 
       binary_file.open(binary_file_name, std::ios_base::in | std::ios_base::binary);
       my_node = node;
+
+      // Files shared between processes store the position of the data of each process
+      const std::string offset_str = node.attribute_value("offset");
+      offset = offset_str.empty() ? 0 : from_str<boost::uint64_t>(offset_str);
     }
 
     if(!my_node.is_valid())
@@ -62,7 +74,7 @@ struct BinaryDataReader::Implementation
 
   Uint version() const
   {
-    static const Uint current_version = 1;
+    static const Uint current_version = 3;
     return current_version;
   }
   
@@ -89,38 +101,95 @@ struct BinaryDataReader::Implementation
     const Uint compressed_size = block_end - block_begin - block_prefix.size();
 
     // Check the prefix
-    binary_file.seekg(block_begin);
+    binary_file.seekg(offset + block_begin);
     std::vector<char> prefix_buf(block_prefix.size());
     binary_file.read(&prefix_buf[0], block_prefix.size());
     const std::string read_prefix(prefix_buf.begin(), prefix_buf.end());
     if(read_prefix != block_prefix)
       throw SetupError(FromHere(), "Bad block prefix for block " + to_str(block_idx));
    
-    if(count != 0)
+    if(file_version < 3)
     {
-      // Build a decompressing stream
-      boost::iostreams::filtering_istream decompressing_stream;
-      decompressing_stream.set_auto_close(false);
-      decompressing_stream.push(boost::iostreams::zlib_decompressor());
-      decompressing_stream.push(boost::iostreams::restrict(binary_file, 0, compressed_size));
-      
-      // Read the data
-      decompressing_stream.read(data, count);
-      decompressing_stream.pop();
+      if(count != 0)
+      {
+        // Build a decompressing stream
+        boost::iostreams::filtering_istream decompressing_stream;
+        decompressing_stream.set_auto_close(false);
+        decompressing_stream.push(boost::iostreams::zlib_decompressor());
+        decompressing_stream.push(boost::iostreams::restrict(binary_file, 0, compressed_size));
+
+        // Read the data
+        decompressing_stream.read(data, count);
+        decompressing_stream.pop();
+      }
     }
-    
-    cf3_assert(binary_file.tellg() == block_end);
+    else
+    {
+      read_chunks(data, count, block_idx);
+    }
+    cf3_assert(binary_file.tellg() == offset + block_end);
+  }
+
+  // Read a block that was split into independently compressed chunks, decompressing the chunks in parallel
+  void read_chunks(char* data, const Uint count, const Uint block_idx)
+  {
+    // Header with the codec, shuffle element size, chunk size and number of chunks
+    Uint header[4];
+    binary_file.read(reinterpret_cast<char*>(header), sizeof(header));
+    const Uint codec = header[0];
+    const Uint shuffle_size = header[1];
+    const Uint chunk_size = header[2];
+    const Uint nb_chunks = header[3];
+    if(nb_chunks != (count + chunk_size - 1) / chunk_size)
+      throw FileFormatError(FromHere(), "Block " + to_str(block_idx) + " has " + to_str(nb_chunks) + " chunks, which does not match its size of " + to_str(count) + " bytes");
+
+    std::vector<Uint> chunk_offsets(nb_chunks+1, 0);
+    for(Uint i = 0; i != nb_chunks; ++i)
+    {
+      Uint compressed_chunk_size;
+      binary_file.read(reinterpret_cast<char*>(&compressed_chunk_size), sizeof(Uint));
+      chunk_offsets[i+1] = chunk_offsets[i] + compressed_chunk_size;
+    }
+
+    std::vector<char> compressed(chunk_offsets.back());
+    if(!compressed.empty())
+      binary_file.read(&compressed[0], compressed.size());
+
+    std::string error;
+    const int nb_chunks_int = static_cast<int>(nb_chunks);
+    #pragma omp parallel for num_threads(nb_threads()) schedule(dynamic)
+    for(int i = 0; i < nb_chunks_int; ++i)
+    {
+      const Uint chunk_begin = i*chunk_size;
+      try
+      {
+        detail::decompress_chunk(&compressed[chunk_offsets[i]], chunk_offsets[i+1] - chunk_offsets[i], shuffle_size, codec, data + chunk_begin, std::min(chunk_size, count - chunk_begin));
+      }
+      catch(std::exception& e)
+      {
+        #pragma omp critical
+        error = e.what();
+      }
+    }
+    if(!error.empty())
+      throw FileFormatError(FromHere(), "Error reading block " + to_str(block_idx) + ": " + error);
   }
 
   // XML document describing all data added
   boost::shared_ptr<XmlDoc> xml_doc;
 
+  // Version of the file that is read
+  Uint file_version;
+
   // Binary file
   boost::filesystem::fstream binary_file;
 
   // Xml data for the blocks associated with the current rank
   XmlNode my_node;
 
+  // Position of the data of the current rank in the binary file
+  boost::uint64_t offset;
+
   // Rank to read
   const Uint m_rank;
 };
@@ -182,6 +251,11 @@ void BinaryDataReader::read_data_block(char *data, const Uint count, const Uint
 void BinaryDataReader::trigger_file()
 {
   const URI file_uri = options().value<URI>("file");
+  if(file_uri.empty())
+  {
+    m_implementation.reset();
+    return;
+  }
   if(!boost::filesystem::exists(file_uri.path()))
   {
     throw SetupError(FromHere(), "Input file " + file_uri.path() + " does not exist");
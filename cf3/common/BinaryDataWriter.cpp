@@ -4,22 +4,27 @@
 // GNU Lesser General Public License version 3 (LGPLv3).
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
+#include <algorithm>
+#include <sstream>
+
 #include <boost/bind.hpp>
+#include <boost/cstdint.hpp>
 #include <boost/function.hpp>
 #include "common/BoostAssign.hpp"
 
-#include <boost/iostreams/filtering_stream.hpp>
 #include <boost/iostreams/filter/zlib.hpp>
-#include <boost/iostreams/device/file_descriptor.hpp>
 
 #include "common/Log.hpp"
 #include "common/Signal.hpp"
 #include "common/PropertyList.hpp"
 #include "common/OptionList.hpp"
+#include "common/BinaryDataCompression.hpp"
 #include "common/BinaryDataWriter.hpp"
 #include "common/FindComponents.hpp"
+#include "common/Threads.hpp"
 
 #include "common/PE/Comm.hpp"
+#include "common/PE/types.hpp"
 
 #include "common/XML/FileOperations.hpp"
 #include "common/XML/XmlNode.hpp"
@@ -31,16 +36,39 @@ namespace common {
 
 struct BinaryDataWriter::Implementation
 {
-  Implementation(const URI& file) :
+  /// Compression settings
+  struct Compression
+  {
+    Uint codec;
+    int level;
+    Uint chunk_size;
+    bool shuffle;
+  };
+
+  Implementation(const URI& file, const Uint nb_files, const Compression& compression_settings) :
+    compression(compression_settings),
+    nb_procs(PE::Comm::instance().size()),
+    nb_files(nb_files == 0 ? 0 : std::min(nb_files, nb_procs)),
+    file_idx(file_index(PE::Comm::instance().rank())),
     filename(build_filename(file, PE::Comm::instance().rank())),
     xml_filename(file),
     index(0),
     xml_doc("1.0", "ISO-8859-1"),
-    m_total_count(0)
+    m_total_count(0),
+    discarded(false)
   {
     const Uint v = version();
-    out_file.open(filename, std::ios_base::out | std::ios_base::binary);
-    out_file.write(reinterpret_cast<const char*>(&v), sizeof(Uint));
+    if(is_shared())
+    {
+      // Blocks are collected in memory, and written to the shared file at the correct offset when closing
+      out_stream = &shared_buffer;
+    }
+    else
+    {
+      out_file.open(filename, std::ios_base::out | std::ios_base::binary);
+      out_file.write(reinterpret_cast<const char*>(&v), sizeof(Uint));
+      out_stream = &out_file;
+    }
 
     PE::Comm& comm = PE::Comm::instance();
     // Rank 0 writes out an XML file that lists all filenames for all CPUs
@@ -62,7 +90,16 @@ struct BinaryDataWriter::Implementation
 
   ~Implementation()
   {
-    CFdebug << "wrote a total of " << m_total_count << " bytes with a compression ratio of " << static_cast<Real>(out_file.tellp()) / static_cast<Real>(m_total_count) * 100. << "%" << CFendl;
+    if(discarded)
+    {
+      out_file.close();
+      return;
+    }
+
+    if(is_shared())
+      write_shared_file();
+
+    CFdebug << "wrote a total of " << m_total_count << " bytes with a compression ratio of " << static_cast<Real>(out_stream->tellp()) / static_cast<Real>(m_total_count) * 100. << "%" << CFendl;
     out_file.close();
     if(PE::Comm::instance().rank() == 0)
       XML::to_file(xml_doc, xml_filename);
@@ -70,31 +107,138 @@ struct BinaryDataWriter::Implementation
     PE::Comm::instance().barrier();
   }
 
-  Uint write_data_block(const char* data, const std::streamsize count, const std::string& list_name, const Uint nb_rows, const Uint nb_cols, const std::string& type_name)
+  /// True if the processes share files
+  bool is_shared() const
+  {
+    return nb_files != 0;
+  }
+
+  /// Index of the shared file used by the given rank
+  Uint file_index(const Uint rank) const
+  {
+    return is_shared() ? rank * nb_files / nb_procs : rank;
+  }
+
+  /// Write the data collected in memory to the shared file, and store the offset of each process in the index. This is collective.
+  void write_shared_file()
   {
-    cf3_assert(out_file.is_open());
     PE::Comm& comm = PE::Comm::instance();
+    const std::string data = shared_buffer.str();
+    // Offsets in shared files may exceed the range of Uint
+    const boost::uint64_t my_size = data.size();
+    std::vector<boost::uint64_t> sizes(1, my_size);
+    if(comm.is_active())
+      comm.all_gather(my_size, sizes);
+
+    // The data of each process follows the data of the previous processes in the same file, after the version number
+    const boost::uint64_t header_size = sizeof(Uint);
+    std::vector<boost::uint64_t> offsets(nb_procs, header_size);
+    for(Uint i = 1; i != nb_procs; ++i)
+    {
+      if(file_index(i) == file_index(i-1))
+        offsets[i] = offsets[i-1] + sizes[i-1];
+    }
+
+    if(comm.rank() == 0)
+    {
+      for(Uint i = 0; i != nb_procs; ++i)
+        node_xml_data[i].set_attribute("offset", to_str(offsets[i]));
+    }
+
+    const Uint rank = comm.rank();
+    const Uint v = version();
+    if(!comm.is_active())
+    {
+      out_file.open(filename, std::ios_base::out | std::ios_base::binary);
+      out_file.write(reinterpret_cast<const char*>(&v), sizeof(Uint));
+      out_file.write(data.data(), data.size());
+      return;
+    }
+
+    // Write the file collectively, using the processes that share it
+    MPI_Comm file_comm;
+    MPI_CHECK_RESULT(MPI_Comm_split, (comm.communicator(), static_cast<int>(file_idx), static_cast<int>(rank), &file_comm));
+    MPI_File file_handle;
+    MPI_CHECK_RESULT(MPI_File_open, (file_comm, const_cast<char*>(filename.c_str()), MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &file_handle));
+    MPI_CHECK_RESULT(MPI_File_set_size, (file_handle, 0));
+    if(rank == 0 || file_index(rank-1) != file_idx)
+      MPI_CHECK_RESULT(MPI_File_write_at, (file_handle, 0, const_cast<Uint*>(&v), sizeof(Uint), MPI_CHAR, MPI_STATUS_IGNORE));
+
+    // MPI counts are int, so large data is written in several collective calls
+    const boost::uint64_t max_chunk_size = 1u << 30;
+    boost::uint64_t nb_chunks = 0;
+    for(Uint i = 0; i != nb_procs; ++i)
+    {
+      if(file_index(i) == file_idx)
+        nb_chunks = std::max(nb_chunks, (sizes[i] + max_chunk_size - 1) / max_chunk_size);
+    }
+    for(boost::uint64_t chunk = 0; chunk != nb_chunks; ++chunk)
+    {
+      const boost::uint64_t chunk_begin = std::min(chunk*max_chunk_size, my_size);
+      const boost::uint64_t chunk_size = std::min(max_chunk_size, my_size - chunk_begin);
+      MPI_CHECK_RESULT(MPI_File_write_at_all, (file_handle, offsets[rank] + chunk_begin, const_cast<char*>(data.data() + chunk_begin), static_cast<int>(chunk_size), MPI_CHAR, MPI_STATUS_IGNORE));
+    }
+
+    MPI_CHECK_RESULT(MPI_File_close, (&file_handle));
+    MPI_CHECK_RESULT(MPI_Comm_free, (&file_comm));
+  }
+
+  std::pair<Uint, Uint> write_local_block(const char* data, const std::streamsize count, const Uint element_size)
+  {
+    cf3_assert(is_shared() || out_file.is_open());
+    std::ostream& out = *out_stream;
     // Prefix and suffix markers
     static const std::string block_prefix("__CFDATA_BEGIN");
 
-    const Uint block_begin = out_file.tellp();
+    const Uint block_begin = out.tellp();
 
     // Write the prefix
-    out_file.write(block_prefix.c_str(), block_prefix.size());
-    
-    if(count != 0)
+    out.write(block_prefix.c_str(), block_prefix.size());
+
+    // The data is split into chunks that are compressed independently, so this can be done in parallel
+    const Uint shuffle_size = (compression.shuffle && element_size > 1) ? element_size : 1;
+    const Uint chunk_size = std::max(compression.chunk_size / shuffle_size, 1u) * shuffle_size;
+    const Uint nb_chunks = (static_cast<Uint>(count) + chunk_size - 1) / chunk_size;
+    std::vector< std::vector<char> > chunks(nb_chunks);
+    std::string error;
+    const int nb_chunks_int = static_cast<int>(nb_chunks);
+    #pragma omp parallel for num_threads(nb_threads()) schedule(dynamic)
+    for(int i = 0; i < nb_chunks_int; ++i)
     {
-      // Build a compressed stream
-      boost::iostreams::filtering_ostream compressing_stream;
-      compressing_stream.push(boost::iostreams::zlib_compressor());
-      compressing_stream.push(out_file);
-      
-      // Write the data
-      compressing_stream.write(data, count);
-      compressing_stream.pop();
+      const Uint chunk_begin = i*chunk_size;
+      try
+      {
+        detail::compress_chunk(data + chunk_begin, std::min(chunk_size, static_cast<Uint>(count) - chunk_begin), shuffle_size, compression.codec, compression.level, chunks[i]);
+      }
+      catch(std::exception& e)
+      {
+        #pragma omp critical
+        error = e.what();
+      }
+    }
+    if(!error.empty())
+      throw FileSystemError(FromHere(), "Error compressing data for " + filename + ": " + error);
+
+    // Header with the codec, shuffle element size, chunk size, number of chunks and the compressed size of each chunk
+    std::vector<Uint> header = boost::assign::list_of(compression.codec)(shuffle_size)(chunk_size)(nb_chunks);
+    for(Uint i = 0; i != nb_chunks; ++i)
+      header.push_back(chunks[i].size());
+    out.write(reinterpret_cast<const char*>(&header[0]), sizeof(Uint)*header.size());
+    for(Uint i = 0; i != nb_chunks; ++i)
+    {
+      if(!chunks[i].empty())
+        out.write(&chunks[i][0], chunks[i].size());
     }
 
-    const Uint block_end = out_file.tellp();
+    const Uint block_end = out.tellp();
+    m_total_count += count;
+
+    return std::make_pair(block_begin, block_end);
+  }
+
+  Uint register_block(const std::string& list_name, const Uint nb_rows, const Uint nb_cols, const std::string& type_name, const Uint block_begin, const Uint block_end)
+  {
+    PE::Comm& comm = PE::Comm::instance();
 
     // Data describing the block on the current CPU
     const std::vector<Uint> my_block_info = boost::assign::list_of(nb_rows)(nb_cols)(block_begin)(block_end);
@@ -129,14 +273,19 @@ struct BinaryDataWriter::Implementation
     }
 
     ++index;
-    m_total_count += count;
 
     return index - 1;
   }
 
+  Uint write_data_block(const char* data, const std::streamsize count, const std::string& list_name, const Uint nb_rows, const Uint nb_cols, const std::string& type_name, const Uint element_size)
+  {
+    const std::pair<Uint, Uint> block_range = write_local_block(data, count, element_size);
+    return register_block(list_name, nb_rows, nb_cols, type_name, block_range.first, block_range.second);
+  }
+
   Uint version() const
   {
-    static const Uint current_version = 1;
+    static const Uint current_version = 3;
     return current_version;
   }
 
@@ -144,14 +293,26 @@ struct BinaryDataWriter::Implementation
   {
     const URI my_dir = input.base_path();
     const std::string basename = input.base_name();
-    const URI result(my_dir / (basename + "_P" + to_str(rank) + ".cfbin"));
+    const URI result(my_dir / (basename + (is_shared() ? "_F" : "_P") + to_str(file_index(rank)) + ".cfbin"));
     return result.path();
   }
 
+  const Compression compression;
+
+  const Uint nb_procs;
+  // Number of shared files, or 0 if each process writes its own file
+  const Uint nb_files;
+  // Index of the file for the current rank
+  const Uint file_idx;
+
   const std::string filename;
   const URI xml_filename;
   boost::filesystem::fstream out_file;
 
+  // Compressed data for the current rank, when writing to a shared file
+  std::ostringstream shared_buffer;
+  std::ostream* out_stream;
+
   // Index of the next block to write
   Uint index;
 
@@ -160,6 +321,9 @@ struct BinaryDataWriter::Implementation
 
   std::vector<XmlNode> node_xml_data;
   Uint m_total_count;
+
+  // If true, the file is closed without writing the index and without communication
+  bool discarded;
 };
   
 ////////////////////////////////////////////////////////////////////////////////////////////
@@ -170,6 +334,29 @@ BinaryDataWriter::BinaryDataWriter ( const std::string& name ) : Component(name)
     .pretty_name("File")
     .description("File name for the output file")
     .attach_trigger(boost::bind(&BinaryDataWriter::trigger_file, this));
+
+  options().add("nb_files", 0u)
+    .pretty_name("Number of Files")
+    .description("Number of binary files shared by all processes, written collectively using MPI-IO. The default of 0 writes one file per process")
+    .attach_trigger(boost::bind(&BinaryDataWriter::trigger_file, this));
+
+  std::vector<boost::any> codecs = boost::assign::list_of(std::string("none"))(std::string("fast"))(std::string("zlib"));
+  options().add("compression", std::string("zlib"))
+    .pretty_name("Compression")
+    .description("Compression codec: none, fast (zlib at its fastest level) or zlib. Used for files opened after setting this.")
+    .restricted_list() = codecs;
+
+  options().add("compression_level", -1)
+    .pretty_name("Compression Level")
+    .description("zlib compression level, from 1 (fastest) to 9 (smallest), or -1 for the zlib default");
+
+  options().add("chunk_size", 4u*1024u*1024u)
+    .pretty_name("Chunk Size")
+    .description("Size in bytes of the parts of each block that are compressed independently, using nb_threads threads");
+
+  options().add("shuffle", false)
+    .pretty_name("Shuffle")
+    .description("Regroup the bytes of multi-byte values by significance before compressing, improving the ratio for floating point data");
 }
 
 BinaryDataWriter::~BinaryDataWriter()
@@ -182,14 +369,43 @@ void BinaryDataWriter::close()
   m_implementation.reset();
 }
 
-Uint BinaryDataWriter::write_data_block(const char* data, const std::streamsize count, const std::string& list_name, const Uint nb_rows, const Uint nb_cols, const std::string& type_name)
+void BinaryDataWriter::discard()
+{
+  if(is_not_null(m_implementation.get()))
+    m_implementation->discarded = true;
+  m_implementation.reset();
+}
+
+void BinaryDataWriter::open()
 {
   if(is_null(m_implementation.get()))
   {
-    m_implementation.reset(new Implementation(options().value<URI>("file")));
+    Implementation::Compression compression;
+    const std::string codec = options().value<std::string>("compression");
+    compression.codec = codec == "none" ? detail::BINARY_CODEC_NONE : detail::BINARY_CODEC_ZLIB;
+    compression.level = codec == "fast" ? boost::iostreams::zlib::best_speed : options().value<int>("compression_level");
+    compression.chunk_size = std::max(options().value<Uint>("chunk_size"), 1u);
+    compression.shuffle = options().value<bool>("shuffle");
+    m_implementation.reset(new Implementation(options().value<URI>("file"), options().value<Uint>("nb_files"), compression));
   }
+}
+
+std::pair<Uint, Uint> BinaryDataWriter::write_local_block(const char* data, const std::streamsize count, const Uint element_size)
+{
+  cf3_assert(is_not_null(m_implementation.get()));
+  return m_implementation->write_local_block(data, count, element_size);
+}
 
-  return m_implementation->write_data_block(data, count, list_name, nb_rows, nb_cols, type_name);
+Uint BinaryDataWriter::register_block(const std::string& list_name, const Uint nb_rows, const Uint nb_cols, const std::string& type_name, const std::pair<Uint, Uint>& block_range)
+{
+  open();
+  return m_implementation->register_block(list_name, nb_rows, nb_cols, type_name, block_range.first, block_range.second);
+}
+
+Uint BinaryDataWriter::write_data_block(const char* data, const std::streamsize count, const std::string& list_name, const Uint nb_rows, const Uint nb_cols, const std::string& type_name, const Uint element_size)
+{
+  open();
+  return m_implementation->write_data_block(data, count, list_name, nb_rows, nb_cols, type_name, element_size);
 }
 
 void BinaryDataWriter::trigger_file()
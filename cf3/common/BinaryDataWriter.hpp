@@ -7,6 +7,8 @@
 #ifndef cf3_common_BinaryDataWriter_hpp
 #define cf3_common_BinaryDataWriter_hpp
 
+#include <utility>
+
 #include <boost/scoped_ptr.hpp>
 
 #include "common/Component.hpp"
@@ -22,6 +24,10 @@ namespace common {
 
   
 /// Component for writing binary data collected into a single file
+/// By default, each process writes its own binary file, indexed by an XML file written by rank 0. When the option "nb_files"
+/// is set, the processes are divided into that many groups, each writing a single shared file. The compressed data is then kept
+/// in memory until close is called, when each process writes its data at its own offset in the shared file using collective MPI-IO.
+/// Each block is split into chunks of "chunk_size" bytes, which are compressed in parallel using the threads set in the environment.
 class Common_API BinaryDataWriter : public Component {
 
 public: // functions
@@ -38,22 +44,37 @@ public: // functions
   template<typename T>
   Uint append_data(const Table<T>& table)
   {
-    return write_data_block(reinterpret_cast<const char*>(table.array().data()), sizeof(T)*table.row_size()*table.size(), table.name(), table.size(), table.row_size(), class_name<T>());
+    return write_data_block(reinterpret_cast<const char*>(table.array().data()), sizeof(T)*table.row_size()*table.size(), table.name(), table.size(), table.row_size(), class_name<T>(), sizeof(T));
   }
   
   /// Append a new data block, returning the block index number for the current file
   template<typename T>
   Uint append_data(const List<T>& list)
   {
-    return write_data_block(reinterpret_cast<const char*>(list.array().data()), sizeof(T)*list.size(), list.name(), list.size(), 1, class_name<T>());
+    return write_data_block(reinterpret_cast<const char*>(list.array().data()), sizeof(T)*list.size(), list.name(), list.size(), 1, class_name<T>(), sizeof(T));
   }
 
   /// Close the current file
   void close();
 
+  /// Close the current file without writing the index. There is no communication, so unlike close this may be called on some processes only.
+  void discard();
+
+  /// Open the output file, if this was not done yet. Must be called before write_local_block is used from a separate thread.
+  void open();
+
+  /// Compress and write a block of raw data to the file of this process only, returning the begin and end offset of the block.
+  /// There is no communication, so this may run on a background thread as long as no other method is called concurrently.
+  /// The block only becomes part of the file after it is added to the index using register_block.
+  /// element_size is the size of the values in the data, used when the "shuffle" option is set.
+  std::pair<Uint, Uint> write_local_block(const char* data, const std::streamsize count, const Uint element_size = 1);
+
+  /// Add a block that was written by write_local_block to the index, returning the block index number. This is collective.
+  Uint register_block(const std::string& list_name, const Uint nb_rows, const Uint nb_cols, const std::string& type_name, const std::pair<Uint, Uint>& block_range);
+
 private:
   // Write a data block to the binary file
-  Uint write_data_block(const char* data, const std::streamsize count, const std::string& list_name, const Uint nb_rows, const Uint nb_cols, const std::string& type_name);
+  Uint write_data_block(const char* data, const std::streamsize count, const std::string& list_name, const Uint nb_rows, const Uint nb_cols, const std::string& type_name, const Uint element_size);
 
   // Trigger on output file change
   void trigger_file();
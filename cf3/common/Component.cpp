@@ -4,7 +4,9 @@
 // GNU Lesser General Public License version 3.
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
+#include <map>
 #include <sstream>
+#include <typeindex>
 #include <boost/cast.hpp>
 #include <boost/tokenizer.hpp>
 #include <boost/algorithm/string.hpp>
@@ -52,6 +54,30 @@ ComponentBuilder < Component, Component, LibCommon > Component_Builder;
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
+struct Component::SubtreeIndex
+{
+  SubtreeIndex() : tags_built(false) {}
+
+  /// All components of the subtree, in depth-first order
+  std::vector<Component*> subtree;
+
+  /// Components per tag, only valid if tags_built is true
+  bool tags_built;
+  std::map< std::string, std::vector<Component*> > tags;
+
+  /// Components per requested type
+  std::map< std::type_index, std::vector<Component*> > types;
+
+  /// Shared empty result
+  static const std::vector<Component*>& empty()
+  {
+    static const std::vector<Component*> result;
+    return result;
+  }
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
 Component::Component ( const std::string& name ) :
     m_name (),
     m_properties(new PropertyList()),
@@ -206,6 +232,10 @@ Component::Component ( const std::string& name ) :
 
 Component::~Component()
 {
+  // Detach the children, so they don't invalidate the index of this component while it is being destroyed
+  m_subtree_index.reset();
+  for(CompStorageT::iterator it=m_components.begin(); it!=m_components.end(); ++it)
+    (*it)->m_parent = nullptr;
 }
 
 
@@ -307,6 +337,7 @@ Component& Component::add_component ( const boost::shared_ptr<Component>& subcom
   cf3_assert(m_component_lookup.size() == m_components.size());
 
   subcomp->m_parent = this;
+  invalidate_subtree_index();
 
   raise_tree_updated_event();
 
@@ -384,6 +415,7 @@ boost::shared_ptr<Component> Component::remove_component ( const std::string& na
       new_storage.push_back(m_components[i]);
     }
     m_components = new_storage;
+    invalidate_subtree_index();
 
     raise_tree_updated_event();
 
@@ -475,6 +507,77 @@ void Component::change_parent(Handle<Component> to_parent)
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
+void Component::invalidate_subtree_index()
+{
+  for(Component* comp = this; comp != 0; comp = comp->m_parent)
+    comp->m_subtree_index.reset();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void Component::on_tags_changed()
+{
+  // The tags of this component are part of the index of its parents only
+  if(is_not_null(m_parent))
+    m_parent->invalidate_subtree_index();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+const std::vector<Component*>& Component::components_of_type(const std::type_info& type, const TypePredicateT is_type) const
+{
+  if(!m_subtree_index)
+  {
+    m_subtree_index.reset(new SubtreeIndex());
+    std::vector<const Component*> stack(1, this);
+    while(!stack.empty())
+    {
+      const Component* comp = stack.back();
+      stack.pop_back();
+      if(comp != this)
+        m_subtree_index->subtree.push_back(const_cast<Component*>(comp));
+      for(CompStorageT::const_reverse_iterator it = comp->m_components.rbegin(); it != comp->m_components.rend(); ++it)
+        stack.push_back(it->get());
+    }
+  }
+
+  if(is_null(is_type))
+    return m_subtree_index->subtree;
+
+  std::map< std::type_index, std::vector<Component*> >::iterator found = m_subtree_index->types.find(std::type_index(type));
+  if(found != m_subtree_index->types.end())
+    return found->second;
+
+  std::vector<Component*>& result = m_subtree_index->types[std::type_index(type)];
+  BOOST_FOREACH(Component* comp, m_subtree_index->subtree)
+  {
+    if(is_type(*comp))
+      result.push_back(comp);
+  }
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+const std::vector<Component*>& Component::components_with_tag(const std::string& tag) const
+{
+  const std::vector<Component*>& subtree = components_of_type(typeid(Component), 0);
+  if(!m_subtree_index->tags_built)
+  {
+    BOOST_FOREACH(Component* comp, subtree)
+    {
+      BOOST_FOREACH(const std::string& comp_tag, comp->get_tags())
+        m_subtree_index->tags[comp_tag].push_back(comp);
+    }
+    m_subtree_index->tags_built = true;
+  }
+
+  std::map< std::string, std::vector<Component*> >::const_iterator found = m_subtree_index->tags.find(tag);
+  return found == m_subtree_index->tags.end() ? SubtreeIndex::empty() : found->second;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
 void Component::move_to ( Component& new_parent )
 {
   cf3_assert(m_parent);
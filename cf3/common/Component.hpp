@@ -13,8 +13,11 @@
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
+#include <typeinfo>
+
 #include <boost/version.hpp>
 #include <boost/enable_shared_from_this.hpp>
+#include <boost/scoped_ptr.hpp>
 
 #include "common/AllocatedComponent.hpp"
 #include "common/Assertions.hpp"
@@ -397,6 +400,11 @@ public: // functions
   template<typename ComponentT>
   void put_components(std::vector< boost::shared_ptr<ComponentT const> >& vec, const bool recurse) const;
 
+  /// All components in the subtree of this component (excluding itself) that have the given tag,
+  /// in the same depth-first order as put_components.
+  /// Uses an index that is built on the first lookup and cleared when the subtree or the tags in it change.
+  const std::vector<Component*>& components_with_tag(const std::string& tag) const;
+
 
 
 protected: // functions
@@ -420,6 +428,25 @@ private: // helper functions
   /// Triggered when the "ping" event is raised. Useful to find out what components still exist
   void on_ping_event( SignalArgs& args );
 
+  /// Clears the subtree index of this component and of all its parents
+  void invalidate_subtree_index();
+
+  /// Keeps the subtree index up to date when tags change
+  virtual void on_tags_changed();
+
+  /// Predicate type used to build the type index
+  typedef bool (*TypePredicateT)(const Component&);
+
+  /// All components in the subtree of this component (excluding itself) for which is_type returns true,
+  /// cached in the subtree index under the given type. A null is_type selects all components.
+  const std::vector<Component*>& components_of_type(const std::type_info& type, const TypePredicateT is_type) const;
+
+  template<typename ComponentT>
+  static bool is_component_of_type(const Component& component)
+  {
+    return dynamic_cast<const ComponentT*>(&component) != 0;
+  }
+
 private: // data
 
   /// component name (stored as path to ensure validity)
@@ -434,6 +461,9 @@ private: // data
   CompLookupT m_component_lookup;
   /// pointer to parent, naked pointer because of static components
   Component* m_parent;
+  /// lookup of the components in the subtree by tag and by type, built on demand
+  struct SubtreeIndex;
+  mutable boost::scoped_ptr<SubtreeIndex> m_subtree_index;
 
 protected: // functions
 
@@ -457,6 +487,15 @@ protected: // functions
 template<typename ComponentT>
 inline void Component::put_components(std::vector< boost::shared_ptr< ComponentT > >& vec, const bool recurse)
 {
+  if(recurse)
+  {
+    const std::vector<Component*>& matches = components_of_type(typeid(ComponentT), &Component::is_component_of_type<ComponentT>);
+    vec.reserve(vec.size() + matches.size());
+    for(std::vector<Component*>::const_iterator it=matches.begin(); it!=matches.end(); ++it)
+      vec.push_back(boost::dynamic_pointer_cast<ComponentT>((*it)->shared_from_this()));
+    return;
+  }
+
   for(CompStorageT::iterator it=m_components.begin(); it!=m_components.end(); ++it)
   {
     boost::shared_ptr<ComponentT> p = boost::dynamic_pointer_cast<ComponentT>(*it);
@@ -464,8 +503,6 @@ inline void Component::put_components(std::vector< boost::shared_ptr< ComponentT
     {
       vec.push_back(p);
     }
-    if(recurse)
-      (*it)->put_components<ComponentT>(vec, true);
   }
 }
 
@@ -474,6 +511,15 @@ inline void Component::put_components(std::vector< boost::shared_ptr< ComponentT
 template<typename ComponentT>
 void Component::put_components(std::vector< boost::shared_ptr< const ComponentT > >& vec, const bool recurse) const
 {
+  if(recurse)
+  {
+    const std::vector<Component*>& matches = components_of_type(typeid(ComponentT), &Component::is_component_of_type<ComponentT>);
+    vec.reserve(vec.size() + matches.size());
+    for(std::vector<Component*>::const_iterator it=matches.begin(); it!=matches.end(); ++it)
+      vec.push_back(boost::dynamic_pointer_cast<ComponentT const>((*it)->shared_from_this()));
+    return;
+  }
+
   for(CompStorageT::const_iterator it=m_components.begin(); it!=m_components.end(); ++it)
   {
     boost::shared_ptr<ComponentT> p = boost::dynamic_pointer_cast<ComponentT>(*it);
@@ -481,8 +527,6 @@ void Component::put_components(std::vector< boost::shared_ptr< const ComponentT
     {
       vec.push_back(p);
     }
-    if(recurse)
-      (*it)->put_components<ComponentT>(vec, true);
   }
 }
 
@@ -494,11 +538,10 @@ inline void Component::put_components<Component>(std::vector< boost::shared_ptr<
 {
   if(recurse)
   {
-    for(CompStorageT::iterator it=m_components.begin(); it!=m_components.end(); ++it)
-    {
-      vec.push_back(*it);
-      (*it)->put_components<Component>(vec, true);
-    }
+    const std::vector<Component*>& subtree = components_of_type(typeid(Component), 0);
+    vec.reserve(vec.size() + subtree.size());
+    for(std::vector<Component*>::const_iterator it=subtree.begin(); it!=subtree.end(); ++it)
+      vec.push_back((*it)->shared_from_this());
   }
   else
   {
@@ -511,11 +554,10 @@ inline void Component::put_components<Component>(std::vector<boost::shared_ptr<C
 {
   if(recurse)
   {
-    for(CompStorageT::const_iterator it=m_components.begin(); it!=m_components.end(); ++it)
-    {
-      vec.push_back(*it);
-      (*it)->put_components<Component>(vec, true);
-    }
+    const std::vector<Component*>& subtree = components_of_type(typeid(Component), 0);
+    vec.reserve(vec.size() + subtree.size());
+    for(std::vector<Component*>::const_iterator it=subtree.begin(); it!=subtree.end(); ++it)
+      vec.push_back((*it)->shared_from_this());
   }
   else
   {
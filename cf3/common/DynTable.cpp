@@ -61,9 +61,9 @@ std::ostream& operator<<(std::ostream& os, const DynTable<bool>& table)
 {
   if (table.size())
     os << "\n";
-  Uint i=0;
-  boost_foreach(DynTable<bool>::ConstRow row, table.array())
+  for (Uint i=0; i<table.size(); ++i)
   {
+    DynTable<bool>::ConstRow row = table[i];
     os << "  " << i << ":  ";
     if (row.size() == 0)
       os << "~";
@@ -73,7 +73,6 @@ std::ostream& operator<<(std::ostream& os, const DynTable<bool>& table)
       os << entry << " ";
     }
     os << "\n";
-    ++i;
   }
   return os;
 }
@@ -82,9 +81,9 @@ std::ostream& operator<<(std::ostream& os, const DynTable<Uint>& table)
 {
   if (table.size())
     os << "\n";
-  Uint i=0;
-  boost_foreach(DynTable<Uint>::ConstRow row, table.array())
+  for (Uint i=0; i<table.size(); ++i)
   {
+    DynTable<Uint>::ConstRow row = table[i];
     os << "  " << i << ":  ";
     if (row.size() == 0)
       os << "~";
@@ -94,7 +93,6 @@ std::ostream& operator<<(std::ostream& os, const DynTable<Uint>& table)
         os << entry << " ";
     }
     os << "\n";
-    ++i;
   }
   return os;
 }
@@ -103,9 +101,9 @@ std::ostream& operator<<(std::ostream& os, const DynTable<int>& table)
 {
   if (table.size())
     os << "\n";
-  Uint i=0;
-  boost_foreach(DynTable<int>::ConstRow row, table.array())
+  for (Uint i=0; i<table.size(); ++i)
   {
+    DynTable<int>::ConstRow row = table[i];
     os << "  " << i << ":  ";
     if (row.size() == 0)
       os << "~";
@@ -115,7 +113,6 @@ std::ostream& operator<<(std::ostream& os, const DynTable<int>& table)
         os << entry << " ";
     }
     os << "\n";
-    ++i;
   }
   return os;
 }
@@ -124,9 +121,9 @@ std::ostream& operator<<(std::ostream& os, const DynTable<Real>& table)
 {
   if (table.size())
     os << "\n";
-  Uint i=0;
-  boost_foreach(DynTable<Real>::ConstRow row, table.array())
+  for (Uint i=0; i<table.size(); ++i)
   {
+    DynTable<Real>::ConstRow row = table[i];
     os << "  " << i << ":  ";
     if (row.size() == 0)
       os << "~";
@@ -136,7 +133,6 @@ std::ostream& operator<<(std::ostream& os, const DynTable<Real>& table)
         os << entry << " ";
     }
     os << "\n";
-    ++i;
   }
   return os;
 }
@@ -145,9 +141,9 @@ std::ostream& operator<<(std::ostream& os, const DynTable<std::string>& table)
 {
   if (table.size())
     os << "\n";
-  Uint i=0;
-  boost_foreach(DynTable<std::string>::ConstRow row, table.array())
+  for (Uint i=0; i<table.size(); ++i)
   {
+    DynTable<std::string>::ConstRow row = table[i];
     os << "  " << i << ":  ";
     if (row.size() == 0)
       os << "~";
@@ -157,7 +153,6 @@ std::ostream& operator<<(std::ostream& os, const DynTable<std::string>& table)
         os << entry << " ";
     }
     os << "\n";
-    ++i;
   }
   return os;
 }
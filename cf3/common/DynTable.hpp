@@ -10,6 +10,9 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include <deque>
+
+#include <boost/range/iterator_range.hpp>
+
 #include "common/BasicExceptions.hpp"
 #include "common/Component.hpp"
 #include "common/StringConversion.hpp"
@@ -26,6 +29,11 @@ template <typename T>
 class DynArrayBufferT;
 
 /// Component holding a connectivity table with variable row-size per row
+///
+/// Rows are stored as separate vectors while the table is being built. Once it is complete,
+/// compress() converts it to compressed row storage: one array with all values, and the offset
+/// of each row in it. Reading through ConstRow works in both cases. Any modification converts
+/// the table back to separate rows.
 /// @author Willem Deconinck
 template<typename T>
 class DynTable : public common::Component {
@@ -35,21 +43,22 @@ public:
   typedef std::vector< std::vector<T> > ArrayT;
   typedef DynArrayBufferT<T> Buffer;
   typedef std::vector<T>& Row;
-  typedef const std::vector<T>& ConstRow;
+  typedef boost::iterator_range<typename std::vector<T>::const_iterator> ConstRow;
 
   /// Contructor
   /// @param name of the component
-  DynTable ( const std::string& name ) : Component(name) { }
+  DynTable ( const std::string& name ) : Component(name), m_is_compressed(false) { }
 
   ~DynTable () {}
 
   /// Get the class name
   static std::string type_name () { return "DynTable<"+common::class_name<T>()+">"; }
 
-  Uint size() const { return m_array.size(); }
+  Uint size() const { return m_is_compressed ? m_offsets.size()-1 : m_array.size(); }
 
   void resize(const Uint new_size)
   {
+    decompress();
     m_array.resize(new_size);
 //    Uint difference = new_size - size();
 //    if (difference > 0)
@@ -65,23 +74,26 @@ public:
 //    }
   }
 
-  Uint row_size(const Uint i) const {return m_array[i].size();}
+  Uint row_size(const Uint i) const { return m_is_compressed ? m_offsets[i+1]-m_offsets[i] : m_array[i].size(); }
 
-  void set_row_size(const Uint i, const Uint s) { m_array[i].resize(s); }
+  void set_row_size(const Uint i, const Uint s) { decompress(); m_array[i].resize(s); }
 
   Buffer create_buffer(const size_t buffersize=16384)
   {
+    decompress();
     return Buffer(m_array,buffersize);
   }
 
   boost::shared_ptr<Buffer> create_buffer_ptr(const size_t buffersize=16384)
   {
+    decompress();
     return boost::shared_ptr<Buffer> ( new Buffer (m_array,buffersize) );
   }
 
   template<typename VectorT>
   void set_row(const Uint array_idx, const VectorT& row)
   {
+    decompress();
     if (row.size() != row_size(array_idx))
       m_array[array_idx].resize(row.size());
 
@@ -92,24 +104,88 @@ public:
 
   Row operator[] (const Uint idx)
   {
+    decompress();
     return Row(m_array[idx]);
   }
 
   ConstRow operator[] (const Uint idx) const
   {
-    return ConstRow(m_array[idx]);
+    if (m_is_compressed)
+      return ConstRow(m_values.begin()+m_offsets[idx], m_values.begin()+m_offsets[idx+1]);
+    return ConstRow(m_array[idx].begin(), m_array[idx].end());
   }
 
   /// @return A reference to the array data
-  ArrayT& array() { return m_array; }
+  ArrayT& array() { decompress(); return m_array; }
 
   /// @return A const reference to the array data
-  const ArrayT& array() const { return m_array; }
+  /// @throws IllegalCall if the table is compressed
+  const ArrayT& array() const
+  {
+    if (m_is_compressed)
+      throw IllegalCall(FromHere(), "Array data of compressed table "+uri().string()+" is not available, use operator[]");
+    return m_array;
+  }
+
+  /// Convert to compressed row storage, releasing the separate rows
+  void compress()
+  {
+    if (m_is_compressed)
+      return;
+
+    m_offsets.resize(m_array.size()+1);
+    m_offsets[0] = 0;
+    for (Uint i=0; i<m_array.size(); ++i)
+      m_offsets[i+1] = m_offsets[i] + m_array[i].size();
+
+    m_values.clear();
+    m_values.reserve(m_offsets.back());
+    boost_foreach(const std::vector<T>& row, m_array)
+      m_values.insert(m_values.end(), row.begin(), row.end());
+
+    ArrayT().swap(m_array);
+    m_is_compressed = true;
+  }
+
+  /// Convert back to separate rows, so the table can be modified
+  void decompress()
+  {
+    if (!m_is_compressed)
+      return;
+
+    m_array.resize(m_offsets.size()-1);
+    for (Uint i=0; i<m_array.size(); ++i)
+      m_array[i].assign(m_values.begin()+m_offsets[i], m_values.begin()+m_offsets[i+1]);
+
+    std::vector<Uint>().swap(m_offsets);
+    std::vector<T>().swap(m_values);
+    m_is_compressed = false;
+  }
+
+  /// Replace the contents with the given compressed rows, avoiding the separate rows altogether.
+  /// Row i has the values from offsets[i] to offsets[i+1], so offsets has one entry more than the number of rows.
+  /// The arguments are swapped with the table data.
+  void swap_compressed(std::vector<Uint>& offsets, std::vector<T>& values)
+  {
+    cf3_assert(!offsets.empty());
+    cf3_assert(offsets.back() == values.size());
+    ArrayT().swap(m_array);
+    m_offsets.swap(offsets);
+    m_values.swap(values);
+    m_is_compressed = true;
+  }
+
+  bool is_compressed() const { return m_is_compressed; }
 
 private: // data
 
   ArrayT m_array;
 
+  /// Compressed row storage
+  bool m_is_compressed;
+  std::vector<Uint> m_offsets;
+  std::vector<T> m_values;
+
 };
 
 //////////////////////////////////////////////////////////////////////////////
@@ -12,6 +12,7 @@
 #include "common/Log.hpp"
 #include "common/Environment.hpp"
 #include "common/PropertyList.hpp"
+#include "common/Threads.hpp"
 
 namespace cf3 {
 namespace common {
@@ -102,6 +103,12 @@ Environment::Environment ( const std::string& name) : Component ( name )
       .mark_basic()
       .attach_trigger(boost::bind(&Environment::trigger_log_level,this));
 
+  options().add("nb_threads", nb_threads())
+      .pretty_name("Number of Threads")
+      .description("Number of threads used by the loops that support shared-memory parallelism. Requires a build with CF3_ENABLE_OPENMP, otherwise these loops run sequentially.")
+      .mark_basic()
+      .attach_trigger(boost::bind(&Environment::trigger_nb_threads,this));
+
   trigger_log_level();
 
   // signals
@@ -180,5 +187,12 @@ void Environment::trigger_log_level()
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void Environment::trigger_nb_threads()
+{
+  set_nb_threads(options().value<Uint>("nb_threads"));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 } // common
 } // cf3
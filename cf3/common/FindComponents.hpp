@@ -1105,63 +1105,78 @@ find_component_ptr_recursively_with_name(ParentT& parent, StringConverter name)
 
 //////////////////////////////////////////////////////////////////////////////
 
-inline ComponentReference<Component>::type
-find_component_recursively_with_tag(Component& parent, StringConverter tag)
+namespace detail
 {
-  try
+  /// Unique component of type ComponentT with the given tag in the subtree of parent, or null if there are no or several matches.
+  /// Uses the tag index of the parent, so the cost is proportional to the number of components with the tag.
+  template<typename ComponentT>
+  inline ComponentT* unique_component_with_tag(const Component& parent, const std::string& tag)
   {
-    return find_component_recursively_with_filter(parent, IsComponentTag(tag));
+    ComponentT* result = 0;
+    const std::vector<Component*>& tagged = parent.components_with_tag(tag);
+    for(std::vector<Component*>::const_iterator it = tagged.begin(); it != tagged.end(); ++it)
+    {
+      ComponentT* candidate = dynamic_cast<ComponentT*>(*it);
+      if(is_not_null(candidate))
+      {
+        if(is_not_null(result))
+          return 0;
+        result = candidate;
+      }
+    }
+    return result;
   }
-  catch (ValueNotFound& e)
-  {
+}
+
+inline ComponentReference<Component>::type
+find_component_recursively_with_tag(Component& parent, StringConverter tag)
+{
+  Component* result = detail::unique_component_with_tag<Component>(parent, tag.str());
+  if(is_null(result))
     throw ValueNotFound(FromHere(), "Unique component not found recursively with tag \"" +tag.str()+ "\" in " + parent.uri().string());
-  }
+  return *result;
 }
 
 inline ComponentReference<Component const>::type
 find_component_recursively_with_tag(const Component& parent, StringConverter tag)
 {
-  try
-  {
-    return find_component_recursively_with_filter(parent, IsComponentTag(tag));
-  }
-  catch (ValueNotFound& e)
-  {
+  Component* result = detail::unique_component_with_tag<Component>(parent, tag.str());
+  if(is_null(result))
     throw ValueNotFound(FromHere(), "Unique component not found recursively with tag \"" +tag.str()+ "\" in " + parent.uri().string());
-  }
+  return *result;
 }
 
 template<typename ComponentT, typename ParentT>
 inline typename ComponentReference<ParentT, ComponentT>::type
 find_component_recursively_with_tag(ParentT& parent, StringConverter tag)
 {
-  try
-  {
-    return find_component_recursively_with_filter<ComponentT>(parent, IsComponentTag(tag));
-  }
-  catch (ValueNotFound& e)
-  {
+  ComponentT* result = detail::unique_component_with_tag<ComponentT>(parent, tag.str());
+  if(is_null(result))
     throw ValueNotFound(FromHere(), "Unique component not found recursively with tag \"" +tag.str()+ "\" and with type " + ComponentT::type_name() + " in " + parent.uri().string());
-  }
+  return *result;
 }
 
 inline ComponentHandle<Component>::type
 find_component_ptr_recursively_with_tag(Component& parent, StringConverter tag)
 {
-  return find_component_ptr_recursively_with_filter(parent,IsComponentTag(tag));
+  Component* result = detail::unique_component_with_tag<Component>(parent, tag.str());
+  return is_null(result) ? Handle<Component>() : result->handle();
 }
 
 inline ComponentHandle<Component const>::type
 find_component_ptr_recursively_with_tag(const Component& parent, StringConverter tag)
 {
-  return find_component_ptr_recursively_with_filter(parent,IsComponentTag(tag));
+  const Component* result = detail::unique_component_with_tag<Component>(parent, tag.str());
+  return is_null(result) ? Handle<Component const>() : result->handle();
 }
 
 template<typename ComponentT, typename ParentT>
 inline typename ComponentHandle<ParentT, ComponentT>::type
 find_component_ptr_recursively_with_tag(ParentT& parent, StringConverter tag)
 {
-  return find_component_ptr_recursively_with_filter<ComponentT>(parent,IsComponentTag(tag));
+  typedef typename ComponentHandle<ParentT, ComponentT>::type ResultT;
+  ComponentT* result = detail::unique_component_with_tag<ComponentT>(parent, tag.str());
+  return is_null(result) ? ResultT() : ResultT(result->template handle<ComponentT>());
 }
 
 ////////////////////////////////////////////////////////////////////////////////
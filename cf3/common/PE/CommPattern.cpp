@@ -13,6 +13,7 @@
 #include "common/FindComponents.hpp"
 #include "common/Builder.hpp"
 #include "common/Log.hpp"
+#include "common/OptionList.hpp"
 
 #include "common/PE/Comm.hpp"
 #include "common/PE/CommPattern.hpp"
@@ -51,11 +52,19 @@ CommPattern::CommPattern(const std::string& name): Component(name), m_gid(alloca
   m_sendCount(PE::Comm::instance().size(),0),
   m_sendMap(0),
   m_recvCount(PE::Comm::instance().size(),0),
-  m_recvMap(0)
+  m_recvMap(0),
+  m_neighbourExchange(false)
 {
   //self->regist_signal ( "update" , "Executes communication patterns on all the registered data.", "" ).connect ( boost::bind ( &CommPattern2::update, self, _1 ) );
   m_isUpToDate=false;
   m_isFreeze=false;
+
+  options().add("neighbour_exchange", m_neighbourExchange)
+    .pretty_name("Neighbour Exchange")
+    .description("Synchronize using point-to-point messages to the neighbouring ranks only. If false, a global all_to_all is used.")
+    .link_to(&m_neighbourExchange);
+
+  setup_neighbours();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -475,6 +484,8 @@ void CommPattern::setup()
     if (global_nelems[i]!=0)
       delete[] global[i];
 
+  setup_neighbours();
+
 #undef COMPUTE_IRANK
 #undef COMPUTE_INODE
 }
@@ -566,31 +577,123 @@ void CommPattern::setup()
 
 void CommPattern::synchronize_all()
 {
-  std::vector<unsigned char> sndbuf(1);
-  std::vector<unsigned char> rcvbuf(1);
+  std::vector< Handle<CommWrapper> > pobjs;
   BOOST_FOREACH( CommWrapper& pobj, find_components_recursively<CommWrapper>(*this) )
   {
-    synchronize_this(pobj,sndbuf,rcvbuf);
+    if (pobj.needs_update()) pobjs.push_back(pobj.handle<CommWrapper>());
   }
+  synchronize_batch(pobjs);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 void CommPattern::synchronize( const std::string& name )
 {
-  std::vector<unsigned char> sndbuf(1);
-  std::vector<unsigned char> rcvbuf(1);
   Handle<CommWrapper> pobj(get_child(name));
-  synchronize_this(*pobj,sndbuf,rcvbuf);
+  synchronize_this(*pobj,m_sndbuf,m_rcvbuf);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 void CommPattern::synchronize( const CommWrapper& pobj )
 {
-  std::vector<unsigned char> sndbuf(1);
-  std::vector<unsigned char> rcvbuf(1);
-  synchronize_this(pobj,sndbuf,rcvbuf);
+  synchronize_this(pobj,m_sndbuf,m_rcvbuf);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void CommPattern::synchronize( const std::vector<std::string>& names )
+{
+  std::vector< Handle<CommWrapper> > pobjs;
+  BOOST_FOREACH( const std::string& name, names )
+  {
+    Handle<CommWrapper> pobj(get_child(name));
+    if (is_null(pobj)) throw common::ValueNotFound(FromHere(),"No data named '" + name + "' is registered in commpattern '" + this->name() + "'.");
+    if (pobj->needs_update()) pobjs.push_back(pobj);
+  }
+  synchronize_batch(pobjs);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// each object's part of a message is padded, so the data of the next object is aligned for any type
+static inline int padded_size(const int nbytes)
+{
+  return (nbytes+(int)sizeof(double)-1)/(int)sizeof(double)*(int)sizeof(double);
+}
+
+void CommPattern::synchronize_batch( const std::vector< Handle<CommWrapper> >& pobjs )
+{
+  if (pobjs.empty()) return;
+  if (pobjs.size()==1)
+  {
+    synchronize_this(*pobjs.front(),m_sndbuf,m_rcvbuf);
+    return;
+  }
+
+  // message size for each neighbour
+  const int nsend=m_sendNeighbours.size();
+  const int nrecv=m_recvNeighbours.size();
+  std::vector<int> send_starts(nsend+1,0);
+  std::vector<int> recv_starts(nrecv+1,0);
+  for (int i=0; i<nsend; i++)
+  {
+    send_starts[i+1]=send_starts[i];
+    BOOST_FOREACH( const Handle<CommWrapper>& pobj, pobjs )
+      send_starts[i+1]+=padded_size(m_sendNeighbourMaps[i].size()*pobj->size_of()*pobj->stride());
+  }
+  for (int i=0; i<nrecv; i++)
+  {
+    recv_starts[i+1]=recv_starts[i];
+    BOOST_FOREACH( const Handle<CommWrapper>& pobj, pobjs )
+      recv_starts[i+1]+=padded_size(m_recvNeighbourMaps[i].size()*pobj->size_of()*pobj->stride());
+  }
+
+  // pack, neighbour by neighbour
+  m_sndbuf.resize(send_starts.back());
+  m_rcvbuf.resize(recv_starts.back());
+  for (int i=0; i<nsend; i++)
+  {
+    int offset=send_starts[i];
+    BOOST_FOREACH( const Handle<CommWrapper>& pobj, pobjs )
+    {
+      pobj->pack(m_sendNeighbourMaps[i],&m_sndbuf[offset]);
+      offset+=padded_size(m_sendNeighbourMaps[i].size()*pobj->size_of()*pobj->stride());
+    }
+  }
+
+  if (m_neighbourExchange)
+  {
+    const Communicator comm=PE::Comm::instance().communicator();
+    const int tag=batch_tag;
+    m_requests.resize(nrecv+nsend);
+    for (int i=0; i<nrecv; i++)
+      MPI_CHECK_RESULT(MPI_Irecv,(&m_rcvbuf[recv_starts[i]],recv_starts[i+1]-recv_starts[i],MPI_BYTE,m_recvNeighbours[i],tag,comm,&m_requests[i]));
+    for (int i=0; i<nsend; i++)
+      MPI_CHECK_RESULT(MPI_Isend,(&m_sndbuf[send_starts[i]],send_starts[i+1]-send_starts[i],MPI_BYTE,m_sendNeighbours[i],tag,comm,&m_requests[nrecv+i]));
+    if (!m_requests.empty())
+      MPI_CHECK_RESULT(MPI_Waitall,((int)m_requests.size(),&m_requests[0],MPI_STATUSES_IGNORE));
+  }
+  else
+  {
+    const int nproc=PE::Comm::instance().size();
+    std::vector<int> send_bytes(nproc,0);
+    std::vector<int> recv_bytes(nproc,0);
+    for (int i=0; i<nsend; i++) send_bytes[m_sendNeighbours[i]]=send_starts[i+1]-send_starts[i];
+    for (int i=0; i<nrecv; i++) recv_bytes[m_recvNeighbours[i]]=recv_starts[i+1]-recv_starts[i];
+    PE::Comm::instance().all_to_all(m_sndbuf,send_bytes,m_rcvbuf,recv_bytes);
+  }
+
+  // unpack, in the same order
+  for (int i=0; i<nrecv; i++)
+  {
+    int offset=recv_starts[i];
+    BOOST_FOREACH( const Handle<CommWrapper>& pobj, pobjs )
+    {
+      pobj->unpack(&m_rcvbuf[offset],m_recvNeighbourMaps[i]);
+      offset+=padded_size(m_recvNeighbourMaps[i].size()*pobj->size_of()*pobj->stride());
+    }
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -602,6 +705,12 @@ void CommPattern::synchronize_this( const CommWrapper& pobj, std::vector<unsigne
 //  std::cout << PERank << pobj.needs_update() << "\n" << std::flush;
   if ( pobj.needs_update() )
   {
+    if (m_neighbourExchange)
+    {
+      start_synchronize(pobj);
+      finish_synchronize(pobj);
+      return;
+    }
     pobj.pack(sndbuf,m_sendMap);
     rcvbuf.resize(m_recvMap.size()*pobj.size_of()*pobj.stride());
     PE::Comm::instance().all_to_all(sndbuf,m_sendCount,rcvbuf,m_recvCount,pobj.size_of()*pobj.stride());
@@ -611,6 +720,139 @@ void CommPattern::synchronize_this( const CommWrapper& pobj, std::vector<unsigne
 
 ////////////////////////////////////////////////////////////////////////////////
 
+int CommPattern::exchange_tag( const CommWrapper& pobj ) const
+{
+  // the commwrappers are inserted collectively, so their position is the same on all ranks
+  int tag=batch_tag+1;
+  for (Component::const_iterator it=begin(); it!=end(); ++it, ++tag)
+  {
+    if (&(*it)!=&pobj) continue;
+    if (tag>32767) // the smallest MPI_TAG_UB allowed by the standard
+      throw common::NotSupported(FromHere(),"Too many commwrappers in commpattern '" + name() + "' to give each exchange its own tag.");
+    return tag;
+  }
+  throw common::ValueNotFound(FromHere(),"Commwrapper '" + pobj.name() + "' is not registered in commpattern '" + name() + "'.");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void CommPattern::start_synchronize( const CommWrapper& pobj )
+{
+  if ( !pobj.needs_update() ) return;
+
+  if ( !m_neighbourExchange )
+  {
+    synchronize(pobj);
+    return;
+  }
+
+  Exchange& exchange=m_exchanges[pobj.name()];
+  if (exchange.started)
+    throw common::IllegalCall(FromHere(),"Synchronization of '" + pobj.name() + "' in commpattern '" + name() + "' was already started.");
+
+  const int item_size=pobj.size_of()*pobj.stride();
+  pobj.pack(exchange.sndbuf,m_sendMap);
+  exchange.rcvbuf.resize(m_recvMap.size()*item_size);
+  exchange.requests.resize(m_recvNeighbours.size()+m_sendNeighbours.size());
+
+  // post the receives first, so the messages can be delivered directly into the buffer
+  const Communicator comm=PE::Comm::instance().communicator();
+  const int tag=exchange_tag(pobj);
+  MPI_Request* request=exchange.requests.empty() ? nullptr : &exchange.requests[0];
+  for (int i=0; i<(const int)m_recvNeighbours.size(); i++, request++)
+  {
+    const int start=m_recvNeighbourStarts[i]*item_size;
+    const int count=(m_recvNeighbourStarts[i+1]-m_recvNeighbourStarts[i])*item_size;
+    MPI_CHECK_RESULT(MPI_Irecv,(&exchange.rcvbuf[start],count,MPI_BYTE,m_recvNeighbours[i],tag,comm,request));
+  }
+  for (int i=0; i<(const int)m_sendNeighbours.size(); i++, request++)
+  {
+    const int start=m_sendNeighbourStarts[i]*item_size;
+    const int count=(m_sendNeighbourStarts[i+1]-m_sendNeighbourStarts[i])*item_size;
+    MPI_CHECK_RESULT(MPI_Isend,(&exchange.sndbuf[start],count,MPI_BYTE,m_sendNeighbours[i],tag,comm,request));
+  }
+  exchange.started=true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void CommPattern::finish_synchronize( const CommWrapper& pobj )
+{
+  std::map<std::string, Exchange>::iterator it=m_exchanges.find(pobj.name());
+  if (it==m_exchanges.end()) return;
+
+  Exchange& exchange=it->second;
+  if (!exchange.started) return;
+  exchange.started=false;
+
+  if (!exchange.requests.empty())
+    MPI_CHECK_RESULT(MPI_Waitall,((int)exchange.requests.size(),&exchange.requests[0],MPI_STATUSES_IGNORE));
+  if (!m_recvMap.empty()) pobj.unpack(exchange.rcvbuf,m_recvMap);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void CommPattern::finish_synchronize()
+{
+  for (std::map<std::string, Exchange>::iterator it=m_exchanges.begin(); it!=m_exchanges.end(); ++it)
+  {
+    if (!it->second.started) continue;
+    Handle<CommWrapper> pobj(get_child(it->first));
+    if (is_null(pobj))
+      throw common::ValueNotFound(FromHere(),"Commwrapper '" + it->first + "' with a pending synchronization is no longer registered in commpattern '" + name() + "'.");
+    finish_synchronize(*pobj);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void CommPattern::setup_neighbours()
+{
+  for (std::map<std::string, Exchange>::iterator it=m_exchanges.begin(); it!=m_exchanges.end(); ++it)
+    if (it->second.started)
+      throw common::IllegalCall(FromHere(),"Commpattern '" + name() + "' was modified while the synchronization of '" + it->first + "' was in progress.");
+
+  m_sendNeighbours.clear();
+  m_sendNeighbourStarts.assign(1,0);
+  for (int i=0; i<(const int)m_sendCount.size(); i++)
+    if (m_sendCount[i]>0)
+    {
+      m_sendNeighbours.push_back(i);
+      m_sendNeighbourStarts.push_back(m_sendNeighbourStarts.back()+m_sendCount[i]);
+    }
+    else if (m_sendCount[i]<0) // not yet set up
+    {
+      m_sendNeighbours.clear();
+      m_sendNeighbourStarts.assign(1,0);
+      break;
+    }
+
+  m_recvNeighbours.clear();
+  m_recvNeighbourStarts.assign(1,0);
+  for (int i=0; i<(const int)m_recvCount.size(); i++)
+    if (m_recvCount[i]>0)
+    {
+      m_recvNeighbours.push_back(i);
+      m_recvNeighbourStarts.push_back(m_recvNeighbourStarts.back()+m_recvCount[i]);
+    }
+    else if (m_recvCount[i]<0)
+    {
+      m_recvNeighbours.clear();
+      m_recvNeighbourStarts.assign(1,0);
+      break;
+    }
+
+  m_sendNeighbourMaps.resize(m_sendNeighbours.size());
+  for (int i=0; i<(const int)m_sendNeighbours.size(); i++)
+    m_sendNeighbourMaps[i].assign(m_sendMap.begin()+m_sendNeighbourStarts[i],m_sendMap.begin()+m_sendNeighbourStarts[i+1]);
+
+  m_recvNeighbourMaps.resize(m_recvNeighbours.size());
+  for (int i=0; i<(const int)m_recvNeighbours.size(); i++)
+    m_recvNeighbourMaps[i].assign(m_recvMap.begin()+m_recvNeighbourStarts[i],m_recvMap.begin()+m_recvNeighbourStarts[i+1]);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void CommPattern::add_global(Uint gid, Uint rank)
 {
   // later a mechanism could be implemented when commpattern can give gids by calling a "reserve(int num)" beforehand, to optimize performance
@@ -229,6 +229,25 @@ public:
   /// @param name the name of the parallel object
   void synchronize( const CommWrapper& pobj );
 
+  /// synchronize several parallel objects together, sending a single message to each neighbour
+  /// the names must be given in the same order on all ranks
+  /// @param names the names of the parallel objects
+  void synchronize( const std::vector<std::string>& names );
+
+  /// start synchronizing the parallel object designated by its commwrapper reference, without waiting for the communication to complete
+  /// the sends and receives are posted to the neighbouring ranks only, so work that does not touch the ghosts can be overlapped with communication
+  /// the data of pobj must not be modified until finish_synchronize is called
+  /// if the neighbour_exchange option is off, this is equivalent to synchronize(pobj)
+  /// @param pobj reference to the commwrapper object to synchronize
+  void start_synchronize( const CommWrapper& pobj );
+
+  /// wait for the synchronization started by start_synchronize and unpack the received ghost values
+  /// @param pobj reference to the commwrapper object passed to start_synchronize
+  void finish_synchronize( const CommWrapper& pobj );
+
+  /// wait for all synchronizations started by start_synchronize
+  void finish_synchronize();
+
   /// add element to the commpattern
   /// when all changes done, all needs to be committed by calling setup
   /// if global id is not on current rank, then a ghost is automatically created on current rank
@@ -284,6 +303,14 @@ public:
   /// Return the rank associated with the given local ID
   int rank(const Uint lid) const { return m_ranks[lid]; }
 
+  /// accessor to the ranks this process sends ghost updates to
+  /// @return vector of ranks, in increasing order
+  const std::vector<int>& send_neighbours() const { return m_sendNeighbours; }
+
+  /// accessor to the ranks this process receives ghost updates from
+  /// @return vector of ranks, in increasing order
+  const std::vector<int>& recv_neighbours() const { return m_recvNeighbours; }
+
   //@} END ACCESSORS
 
 protected: // helper function
@@ -295,8 +322,32 @@ protected: // helper function
   /// @param rcvbuf vector for intermediate buffer for recieve
   void synchronize_this( const CommWrapper& pobj, std::vector<unsigned char>& sndbuf, std::vector<unsigned char>& rcvbuf );
 
+  /// build the neighbour lists and buffer offsets from m_sendCount and m_recvCount
+  void setup_neighbours();
+
+  /// synchronize the given objects in a single exchange, the data of each neighbour is packed object after object
+  /// @param pobjs the commwrapper objects to synchronize, all of them need update
+  void synchronize_batch( const std::vector< Handle<CommWrapper> >& pobjs );
+
+  /// MPI tag of the batched exchange, the exchanges of start_synchronize use the tags above it
+  static const int batch_tag=0;
+
+  /// MPI tag for the exchange of pobj started by start_synchronize, so exchanges of different commwrappers
+  /// that are in flight together can be started in any order
+  int exchange_tag( const CommWrapper& pobj ) const;
+
 private:
 
+  /// helper struct holding the state of an exchange started by start_synchronize
+  /// the buffers are kept between synchronizations, to avoid reallocating them
+  struct Exchange {
+    Exchange() : started(false) {}
+    bool started;
+    std::vector<unsigned char> sndbuf;
+    std::vector<unsigned char> rcvbuf;
+    std::vector<MPI_Request> requests;
+  };
+
   /// @name PROPERTIES
   //@{
 
@@ -349,6 +400,39 @@ private:
   /// Rank for all the gids in local index space
   std::vector<int> m_ranks;
 
+  /// ranks with a non-zero entry in m_sendCount
+  std::vector<int> m_sendNeighbours;
+
+  /// offset of the data for each send neighbour in m_sendMap, with an extra entry for the end
+  std::vector<int> m_sendNeighbourStarts;
+
+  /// ranks with a non-zero entry in m_recvCount
+  std::vector<int> m_recvNeighbours;
+
+  /// offset of the data for each receive neighbour in m_recvMap, with an extra entry for the end
+  std::vector<int> m_recvNeighbourStarts;
+
+  /// part of m_sendMap for each send neighbour
+  std::vector< std::vector<int> > m_sendNeighbourMaps;
+
+  /// part of m_recvMap for each receive neighbour
+  std::vector< std::vector<int> > m_recvNeighbourMaps;
+
+  /// persistent send buffer for the blocking synchronizations
+  std::vector<unsigned char> m_sndbuf;
+
+  /// persistent receive buffer for the blocking synchronizations
+  std::vector<unsigned char> m_rcvbuf;
+
+  /// persistent requests for the batched synchronization
+  std::vector<MPI_Request> m_requests;
+
+  /// use point-to-point communication with the neighbours instead of a global all_to_all
+  bool m_neighbourExchange;
+
+  /// exchanges started with start_synchronize, indexed by the name of the commwrapper
+  std::map<std::string, Exchange> m_exchanges;
+
 }; // CommPattern
 
 ////////////////////////////////////////////////////////////////////////////////////////////
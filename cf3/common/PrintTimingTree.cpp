@@ -4,9 +4,12 @@
 // GNU Lesser General Public License version 3 (LGPLv3).
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
+#include <fstream>
+
 #include "common/Builder.hpp"
 #include "common/OptionList.hpp"
 #include "common/TimedComponent.hpp"
+#include "common/PE/Comm.hpp"
 
 #include "PrintTimingTree.hpp"
 
@@ -24,12 +27,43 @@ PrintTimingTree::PrintTimingTree(const std::string& name): Action(name)
     .pretty_name("Root")
     .link_to(&m_root)
     .mark_basic();
+
+  options().add("json_file", URI())
+    .pretty_name("JSON File")
+    .description("If set, also write the timing statistics of all timed components to this file in JSON format")
+    .mark_basic();
+
+  options().add("csv_file", URI())
+    .pretty_name("CSV File")
+    .description("If set, also write the timing statistics of all timed components to this file in CSV format")
+    .mark_basic();
 }
 
 void PrintTimingTree::execute()
 {
-  if(is_not_null(m_root))
-    print_timing_tree(*m_root);
+  if(is_null(m_root))
+    return;
+
+  const std::vector<TimingStatistics> statistics = gather_timing_statistics(*m_root);
+  print_timing_statistics(statistics);
+
+  if(PE::Comm::instance().rank() != 0)
+    return;
+
+  const URI json_file = options().value<URI>("json_file");
+  const URI csv_file = options().value<URI>("csv_file");
+
+  if(!json_file.empty())
+  {
+    std::ofstream json_stream(json_file.path().c_str());
+    write_timing_json(statistics, json_stream);
+  }
+
+  if(!csv_file.empty())
+  {
+    std::ofstream csv_stream(csv_file.path().c_str());
+    write_timing_csv(statistics, csv_stream);
+  }
 }
 
 
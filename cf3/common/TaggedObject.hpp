@@ -38,6 +38,13 @@ public:
   /// @param tag to remove
   void remove_tag(const std::string& tag);
 
+protected:
+
+  virtual ~TaggedObject() {}
+
+  /// Called after a tag was added or removed
+  virtual void on_tags_changed() {}
+
 private:
 
   std::string m_tags;
@@ -0,0 +1,45 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include "common/BasicExceptions.hpp"
+#include "common/Threads.hpp"
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace common {
+
+///////////////////////////////////////////////////////////////////////////////////////
+
+namespace detail
+{
+  Uint& stored_nb_threads()
+  {
+    static Uint nb_threads = 1;
+    return nb_threads;
+  }
+}
+
+Uint nb_threads()
+{
+  return detail::stored_nb_threads();
+}
+
+void set_nb_threads(const Uint nb_threads)
+{
+  if(nb_threads == 0)
+    throw BadValue(FromHere(), "The number of threads must be at least 1");
+
+  detail::stored_nb_threads() = nb_threads;
+#ifdef _OPENMP
+  omp_set_num_threads(static_cast<int>(nb_threads));
+#endif
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+} // common
+} // cf3
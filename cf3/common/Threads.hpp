@@ -0,0 +1,48 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_common_Threads_hpp
+#define cf3_common_Threads_hpp
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "common/CommonAPI.hpp"
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace common {
+
+///////////////////////////////////////////////////////////////////////////////////////
+
+/// Number of threads to use in loops that support shared-memory parallelism.
+/// This is set through the nb_threads option of the Environment and defaults to 1.
+/// If coolfluid was built without OpenMP, loops that query this still work, but execute sequentially.
+Common_API Uint nb_threads();
+
+/// Change the number of threads. Normally only called by the Environment when its option changes.
+Common_API void set_nb_threads(const Uint nb_threads);
+
+/// Index of the calling thread inside a parallel region. Returns 0 outside a parallel region or without OpenMP
+inline Uint thread_id()
+{
+#ifdef _OPENMP
+  return static_cast<Uint>(omp_get_thread_num());
+#else
+  return 0;
+#endif
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+} // common
+} // cf3
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+#endif // cf3_common_Threads_hpp
@@ -4,6 +4,7 @@
 // GNU Lesser General Public License version 3 (LGPLv3).
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
+#include <algorithm>
 #include <iostream>
 
 #include "common/Component.hpp"
@@ -35,78 +36,233 @@ void store_timings(Component& root)
 
 /////////////////////////////////////////////////////////////////////////////////////
 
-void print_timing_tree(cf3::common::Component& root, const bool print_untimed, const std::string& prefix)
+namespace detail
+{
+
+/// Depth-first list of the components in a tree, with their depth
+void collect_timing_components(Component& root, const Uint depth, std::vector< std::pair<Component*, Uint> >& components)
 {
-  if(prefix.empty()) // Top-level recursion
+  components.push_back(std::make_pair(&root, depth));
+  BOOST_FOREACH(Component& component, root)
   {
-    store_timings(root);
-    if(PE::Comm::instance().rank() == 0)
-      std::cout << "<DartMeasurement name=\"Timings\" type=\"text/plain\"><![CDATA[<html><body><pre>\n";
+    collect_timing_components(component, depth+1, components);
   }
+}
+
+/// Number of values sent per component: timed flag, mean, min, max and count
+const Uint nb_timing_values = 5;
+
+/// Escape a string for use in JSON
+std::string json_escape(const std::string& str)
+{
+  std::string result;
+  result.reserve(str.size());
+  BOOST_FOREACH(const char c, str)
+  {
+    if(c == '"' || c == '\\')
+      result.push_back('\\');
+    result.push_back(c);
+  }
+  return result;
+}
+
+} // detail
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+TimingStatistics::TimingStatistics() :
+  depth(0),
+  timed(false),
+  count(0),
+  mean(0.),
+  min(0.),
+  max(0.),
+  mean_min(0.),
+  mean_max(0.),
+  slowest_rank(0)
+{
+}
 
-  if(!root.properties().check("timer_mean") && print_untimed && PE::Comm::instance().rank() == 0)
+Real TimingStatistics::imbalance() const
+{
+  return mean > 0. ? mean_max / mean : 1.;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<TimingStatistics> gather_timing_statistics(Component& root)
+{
+  store_timings(root);
+
+  std::vector< std::pair<Component*, Uint> > components;
+  detail::collect_timing_components(root, 0, components);
+  const Uint nb_components = components.size();
+
+  // Flat array with the local timings of all components
+  std::vector<Real> local_values(nb_components*detail::nb_timing_values, 0.);
+  for(Uint i = 0; i != nb_components; ++i)
   {
-    std::cout << prefix << root.name() << ": no timing info\n";
+    const Component& comp = *components[i].first;
+    if(!comp.properties().check("timer_mean"))
+      continue;
+    Real* values = &local_values[i*detail::nb_timing_values];
+    values[0] = 1.;
+    values[1] = comp.properties().value<Real>("timer_mean");
+    values[2] = comp.properties().value<Real>("timer_minimum");
+    values[3] = comp.properties().value<Real>("timer_maximum");
+    values[4] = static_cast<Real>(comp.properties().value<Uint>("timer_count"));
   }
 
+  const bool is_parallel = PE::Comm::instance().is_active() && PE::Comm::instance().size() > 1;
+  const Uint nb_procs = is_parallel ? PE::Comm::instance().size() : 1;
+  std::vector<Real> all_values;
+  if(is_parallel)
+    PE::Comm::instance().gather(local_values, all_values, 0);
+  else
+    all_values.swap(local_values);
 
-  if(root.properties().check("timer_mean"))
+  std::vector<TimingStatistics> result(nb_components);
+  for(Uint i = 0; i != nb_components; ++i)
   {
-    const Real local_mean = root.properties().value<Real>("timer_mean");
-    const Real local_min = root.properties().value<Real>("timer_minimum");
-    const Real local_max = root.properties().value<Real>("timer_maximum");
-    const Uint local_count = root.properties().value<Uint>("timer_count");
+    TimingStatistics& stats = result[i];
+    stats.path = components[i].first->uri().path();
+    stats.name = components[i].first->name();
+    stats.depth = components[i].second;
+
+    if(all_values.empty()) // Not rank 0
+      continue;
 
-    // Only bother with global averages if we have more than 1 process
-    if(PE::Comm::instance().is_active() && PE::Comm::instance().size() > 1)
+    Uint nb_timed = 0;
+    for(Uint rank = 0; rank != nb_procs; ++rank)
     {
-      // Average, minimum and maximum of each statistic over all CPUs
-      Real mean_mean, mean_min, mean_max, max_mean, max_min, max_max, min_mean, min_min, min_max;
-      Uint min_count, max_count;
-      PE::Comm::instance().all_reduce(PE::plus(), &local_mean, 1, &mean_mean);
-      PE::Comm::instance().all_reduce(PE::min(), &local_mean, 1, &mean_min);
-      PE::Comm::instance().all_reduce(PE::max(), &local_mean, 1, &mean_max);
-
-      PE::Comm::instance().all_reduce(PE::plus(), &local_min, 1, &min_mean);
-      PE::Comm::instance().all_reduce(PE::min(), &local_min, 1, &min_min);
-      PE::Comm::instance().all_reduce(PE::max(), &local_min, 1, &min_max);
-
-      PE::Comm::instance().all_reduce(PE::plus(), &local_max, 1, &max_mean);
-      PE::Comm::instance().all_reduce(PE::min(), &local_max, 1, &max_min);
-      PE::Comm::instance().all_reduce(PE::max(), &local_max, 1, &max_max);
-      
-      PE::Comm::instance().all_reduce(PE::min(), &local_count, 1, &min_count);
-      PE::Comm::instance().all_reduce(PE::max(), &local_count, 1, &max_count);
-      cf3_assert(min_count == max_count);
-
-      const Real nb_procs = static_cast<Real>(PE::Comm::instance().size());
-      mean_mean /= nb_procs; min_mean /= nb_procs; max_mean /= nb_procs;
-
-      if(PE::Comm::instance().rank() == 0)
+      const Real* values = &all_values[(rank*nb_components + i)*detail::nb_timing_values];
+      if(values[0] == 0.)
+        continue;
+
+      if(nb_timed == 0)
+      {
+        stats.count = static_cast<Uint>(values[4]);
+        stats.min = values[2];
+        stats.max = values[3];
+        stats.mean_min = values[1];
+        stats.mean_max = values[1];
+        stats.slowest_rank = rank;
+      }
+      else
       {
-        if(prefix.empty()) std::cout << "Timings in seconds, with [min, mean, max] over CPUs\n";
-        std::cout << prefix << root.name()
-          << ": mean: "  << mean_mean
-          << ", min: " << min_min
-          << ", max: " << max_max
-          << ", count: " << min_count << "\n";
+        cf3_assert(stats.count == static_cast<Uint>(values[4]));
+        stats.min = std::min(stats.min, values[2]);
+        stats.max = std::max(stats.max, values[3]);
+        stats.mean_min = std::min(stats.mean_min, values[1]);
+        if(values[1] > stats.mean_max)
+        {
+          stats.mean_max = values[1];
+          stats.slowest_rank = rank;
+        }
       }
+      stats.mean += values[1];
+      ++nb_timed;
     }
-    else
+
+    if(nb_timed != 0)
     {
-      std::cout << prefix << root.name() << ": mean: " << local_mean << ", max: " << local_max << ", min: " << local_min << ", count: " << local_count << "\n";
+      stats.timed = true;
+      stats.mean /= static_cast<Real>(nb_timed);
     }
   }
 
-  BOOST_FOREACH(Component& component, root)
+  return result;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+void write_timing_json(const std::vector<TimingStatistics>& statistics, std::ostream& stream)
+{
+  stream << "[";
+  bool first = true;
+  BOOST_FOREACH(const TimingStatistics& stats, statistics)
   {
-    print_timing_tree(component, print_untimed, prefix + "  ");
+    if(!stats.timed)
+      continue;
+    stream << (first ? "\n" : ",\n");
+    first = false;
+    stream << "  {\"path\": \"" << detail::json_escape(stats.path) << "\""
+           << ", \"name\": \"" << detail::json_escape(stats.name) << "\""
+           << ", \"depth\": " << stats.depth
+           << ", \"count\": " << stats.count
+           << ", \"mean\": " << stats.mean
+           << ", \"min\": " << stats.min
+           << ", \"max\": " << stats.max
+           << ", \"mean_min\": " << stats.mean_min
+           << ", \"mean_max\": " << stats.mean_max
+           << ", \"imbalance\": " << stats.imbalance()
+           << ", \"slowest_rank\": " << stats.slowest_rank << "}";
   }
+  stream << "\n]\n";
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+void write_timing_csv(const std::vector<TimingStatistics>& statistics, std::ostream& stream)
+{
+  stream << "path,name,depth,count,mean,min,max,mean_min,mean_max,imbalance,slowest_rank\n";
+  BOOST_FOREACH(const TimingStatistics& stats, statistics)
+  {
+    if(!stats.timed)
+      continue;
+    stream << stats.path << "," << stats.name << "," << stats.depth << "," << stats.count << ","
+           << stats.mean << "," << stats.min << "," << stats.max << ","
+           << stats.mean_min << "," << stats.mean_max << "," << stats.imbalance() << "," << stats.slowest_rank << "\n";
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+void print_timing_statistics(const std::vector<TimingStatistics>& statistics, const bool print_untimed, const std::string& prefix)
+{
+  if(PE::Comm::instance().rank() != 0)
+    return;
+
+  const bool is_parallel = PE::Comm::instance().is_active() && PE::Comm::instance().size() > 1;
+
+  if(prefix.empty())
+    std::cout << "<DartMeasurement name=\"Timings\" type=\"text/plain\"><![CDATA[<html><body><pre>\n";
 
-  if(prefix.empty() && PE::Comm::instance().rank() == 0)
+  BOOST_FOREACH(const TimingStatistics& stats, statistics)
+  {
+    const std::string indent = prefix + std::string(2*stats.depth, ' ');
+    if(!stats.timed)
+    {
+      if(print_untimed)
+        std::cout << indent << stats.name << ": no timing info\n";
+      continue;
+    }
+
+    if(is_parallel)
+    {
+      if(prefix.empty() && stats.depth == 0) std::cout << "Timings in seconds, with [min, mean, max] over CPUs\n";
+      std::cout << indent << stats.name
+        << ": mean: "  << stats.mean
+        << ", min: " << stats.min
+        << ", max: " << stats.max
+        << ", count: " << stats.count << "\n";
+    }
+    else
+    {
+      std::cout << indent << stats.name << ": mean: " << stats.mean << ", max: " << stats.max << ", min: " << stats.min << ", count: " << stats.count << "\n";
+    }
+  }
+
+  if(prefix.empty())
     std::cout << "</pre></body></html>]]></DartMeasurement>" << std::endl;
 }
 
+/////////////////////////////////////////////////////////////////////////////////////
+
+void print_timing_tree(cf3::common::Component& root, const bool print_untimed, const std::string& prefix)
+{
+  print_timing_statistics(gather_timing_statistics(root), print_untimed, prefix);
+}
 
 /////////////////////////////////////////////////////////////////////////////////////
 
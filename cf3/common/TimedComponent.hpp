@@ -7,6 +7,10 @@
 #ifndef cf3_common_TimedComponent_hpp
 #define cf3_common_TimedComponent_hpp
 
+#include <iosfwd>
+#include <string>
+#include <vector>
+
 #include "common/CommonAPI.hpp"
 
 /////////////////////////////////////////////////////////////////////////////////////
@@ -30,6 +34,52 @@ public:
 /// Store accumulated timings in properties for readout
 void store_timings(Component& root);
 
+/// Timing statistics of a single component, combined over all processes
+struct Common_API TimingStatistics
+{
+  TimingStatistics();
+
+  /// Path of the component
+  std::string path;
+  /// Name of the component
+  std::string name;
+  /// Depth of the component, relative to the root of the statistics
+  Uint depth;
+  /// True if the component has timing info on at least one process
+  bool timed;
+  /// Number of timed executions. Taken from the first timed process, it should be the same everywhere
+  Uint count;
+  /// Average over the processes of the mean execution time
+  Real mean;
+  /// Minimum over the processes of the minimum execution time
+  Real min;
+  /// Maximum over the processes of the maximum execution time
+  Real max;
+  /// Lowest mean execution time of any process
+  Real mean_min;
+  /// Highest mean execution time of any process
+  Real mean_max;
+  /// Process with the highest mean execution time
+  Uint slowest_rank;
+
+  /// Load imbalance: highest mean time of any process relative to the average, 1 for a perfect balance
+  Real imbalance() const;
+};
+
+/// Collect the timing statistics of root and all its subcomponents, in depth-first order.
+/// This is collective: the local timings of all processes are sent to rank 0 in a single gather, so the
+/// component tree must be the same on all processes. The process-combined values are only valid on rank 0.
+std::vector<TimingStatistics> gather_timing_statistics(Component& root);
+
+/// Write the statistics of the timed components as a JSON array of objects, one per component
+void write_timing_json(const std::vector<TimingStatistics>& statistics, std::ostream& stream);
+
+/// Write the statistics of the timed components as CSV, with a header line
+void write_timing_csv(const std::vector<TimingStatistics>& statistics, std::ostream& stream);
+
+/// Print the statistics as an indented tree on rank 0
+void print_timing_statistics(const std::vector<TimingStatistics>& statistics, const bool print_untimed = false, const std::string& prefix="");
+
 /// Print timing tree based on the existing properties
 void print_timing_tree(Component& root, const bool print_untimed = false, const std::string& prefix="");
 
@@ -0,0 +1,207 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include <algorithm>
+#include <limits>
+
+#include "common/BasicExceptions.hpp"
+#include "common/StringConversion.hpp"
+
+#include "math/KDTree.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace math {
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace detail
+{
+
+/// Order point indices by one of their coordinates
+struct CoordinateLess
+{
+  CoordinateLess(const std::vector<Real>& coordinates, const Uint dim, const Uint direction) :
+    m_coordinates(coordinates),
+    m_dim(dim),
+    m_direction(direction)
+  {
+  }
+
+  bool operator()(const Uint a, const Uint b) const
+  {
+    return m_coordinates[a*m_dim + m_direction] < m_coordinates[b*m_dim + m_direction];
+  }
+
+  const std::vector<Real>& m_coordinates;
+  const Uint m_dim;
+  const Uint m_direction;
+};
+
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+KDTree::KDTree(const Uint dim, const Uint leaf_size) :
+  m_dim(dim),
+  m_leaf_size(std::max(leaf_size, 1u))
+{
+  if(dim == 0)
+    throw common::BadValue(FromHere(), "KDTree dimension must be at least 1");
+}
+
+void KDTree::build(const std::vector<Real>& coordinates)
+{
+  if(coordinates.size() % m_dim != 0)
+    throw common::BadValue(FromHere(), "Number of coordinates " + common::to_str(coordinates.size()) + " is not a multiple of the dimension " + common::to_str(m_dim));
+
+  m_coordinates = coordinates;
+  const Uint nb_pts = coordinates.size() / m_dim;
+  m_indices.resize(nb_pts);
+  for(Uint i = 0; i != nb_pts; ++i)
+    m_indices[i] = i;
+
+  m_nodes.clear();
+  if(nb_pts == 0)
+    return;
+
+  m_nodes.reserve(2*(nb_pts / m_leaf_size + 1));
+  build_node(0, nb_pts);
+}
+
+Uint KDTree::build_node(const Uint begin, const Uint end)
+{
+  const Uint node_idx = m_nodes.size();
+  m_nodes.push_back(Node());
+  m_nodes[node_idx].begin = begin;
+  m_nodes[node_idx].end = end;
+  m_nodes[node_idx].split_dim = 0;
+  m_nodes[node_idx].split_value = 0.;
+  m_nodes[node_idx].left = 0;
+  m_nodes[node_idx].right = 0;
+
+  if(end - begin <= m_leaf_size)
+    return node_idx;
+
+  // Split along the direction with the largest extent
+  Uint split_dim = 0;
+  Real largest_extent = -1.;
+  for(Uint d = 0; d != m_dim; ++d)
+  {
+    Real min_coord = std::numeric_limits<Real>::max();
+    Real max_coord = -std::numeric_limits<Real>::max();
+    for(Uint i = begin; i != end; ++i)
+    {
+      const Real x = m_coordinates[m_indices[i]*m_dim + d];
+      min_coord = std::min(min_coord, x);
+      max_coord = std::max(max_coord, x);
+    }
+    if(max_coord - min_coord > largest_extent)
+    {
+      largest_extent = max_coord - min_coord;
+      split_dim = d;
+    }
+  }
+
+  const Uint middle = begin + (end - begin) / 2;
+  std::nth_element(m_indices.begin() + begin, m_indices.begin() + middle, m_indices.begin() + end, detail::CoordinateLess(m_coordinates, m_dim, split_dim));
+
+  m_nodes[node_idx].split_dim = split_dim;
+  m_nodes[node_idx].split_value = m_coordinates[m_indices[middle]*m_dim + split_dim];
+  // m_nodes may be reallocated during the recursion, so no references are kept
+  const Uint left = build_node(begin, middle);
+  const Uint right = build_node(middle, end);
+  m_nodes[node_idx].left = left;
+  m_nodes[node_idx].right = right;
+
+  return node_idx;
+}
+
+Uint KDTree::nearest(const Real* point, Real& squared_distance) const
+{
+  Uint best = nb_points();
+  squared_distance = std::numeric_limits<Real>::max();
+  if(!m_nodes.empty())
+    nearest_in_node(0, point, best, squared_distance);
+  return best;
+}
+
+Uint KDTree::nearest(const RealVector& point, Real& squared_distance) const
+{
+  cf3_assert(point.size() == m_dim);
+  return nearest(point.data(), squared_distance);
+}
+
+void KDTree::points_in_radius(const Real* point, const Real radius, std::vector<Uint>& result) const
+{
+  result.clear();
+  if(!m_nodes.empty())
+    radius_in_node(0, point, radius*radius, result);
+}
+
+void KDTree::nearest_in_node(const Uint node_idx, const Real* point, Uint& best, Real& best_distance) const
+{
+  const Node& node = m_nodes[node_idx];
+  if(node.left == 0)
+  {
+    for(Uint i = node.begin; i != node.end; ++i)
+    {
+      const Real dist = squared_distance(m_indices[i], point);
+      if(dist < best_distance)
+      {
+        best_distance = dist;
+        best = m_indices[i];
+      }
+    }
+    return;
+  }
+
+  // Descend into the side containing the point first, and only visit the other side if it can be closer
+  const Real offset = point[node.split_dim] - node.split_value;
+  const Uint near_child = offset < 0. ? node.left : node.right;
+  const Uint far_child = offset < 0. ? node.right : node.left;
+  nearest_in_node(near_child, point, best, best_distance);
+  if(offset*offset < best_distance)
+    nearest_in_node(far_child, point, best, best_distance);
+}
+
+void KDTree::radius_in_node(const Uint node_idx, const Real* point, const Real squared_radius, std::vector<Uint>& result) const
+{
+  const Node& node = m_nodes[node_idx];
+  if(node.left == 0)
+  {
+    for(Uint i = node.begin; i != node.end; ++i)
+    {
+      if(squared_distance(m_indices[i], point) <= squared_radius)
+        result.push_back(m_indices[i]);
+    }
+    return;
+  }
+
+  const Real offset = point[node.split_dim] - node.split_value;
+  if(offset < 0. || offset*offset <= squared_radius)
+    radius_in_node(node.left, point, squared_radius, result);
+  if(offset >= 0. || offset*offset <= squared_radius)
+    radius_in_node(node.right, point, squared_radius, result);
+}
+
+Real KDTree::squared_distance(const Uint point_idx, const Real* point) const
+{
+  const Real* coords = &m_coordinates[point_idx*m_dim];
+  Real result = 0.;
+  for(Uint d = 0; d != m_dim; ++d)
+  {
+    const Real delta = coords[d] - point[d];
+    result += delta*delta;
+  }
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // math
+} // cf3
@@ -0,0 +1,92 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_math_KDTree_hpp
+#define cf3_math_KDTree_hpp
+
+////////////////////////////////////////////////////////////////////////////////
+
+#include <vector>
+
+#include "math/MatrixTypes.hpp"
+#include "math/LibMath.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace math {
+
+//////////////////////////////////////////////////////////////////////////////
+
+/// @brief k-d tree for nearest neighbour searches in a static set of points
+///
+/// The points are split recursively at the median of the direction with the largest extent,
+/// until at most leaf_size points remain. The tree is stored as flat arrays, and queries
+/// only read it, so they can be done concurrently from several threads.
+class Math_API KDTree
+{
+public:
+
+  /// Gets the Class name
+  static std::string type_name() { return "KDTree"; }
+
+  /// Construct an empty tree for points of the given dimension
+  KDTree(const Uint dim = 3, const Uint leaf_size = 8);
+
+  /// Build the tree for the given coordinates, stored contiguously with dimension() values per point.
+  /// The points are numbered in the order they appear in the coordinates.
+  void build(const std::vector<Real>& coordinates);
+
+  /// Number of points in the tree
+  Uint nb_points() const { return m_indices.size(); }
+
+  /// Dimension of the points
+  Uint dimension() const { return m_dim; }
+
+  /// Index of the point closest to the given point, or nb_points() if the tree is empty
+  /// @param [out] squared_distance Squared distance to the closest point
+  Uint nearest(const Real* point, Real& squared_distance) const;
+
+  /// Index of the point closest to the given point, or nb_points() if the tree is empty
+  Uint nearest(const RealVector& point, Real& squared_distance) const;
+
+  /// Indices of all points that are within the given distance of the point, in no particular order
+  void points_in_radius(const Real* point, const Real radius, std::vector<Uint>& result) const;
+
+private:
+  struct Node
+  {
+    /// Range in m_indices covered by this node
+    Uint begin;
+    Uint end;
+    /// Split direction and value, only valid for interior nodes
+    Uint split_dim;
+    Real split_value;
+    /// Children, both 0 for a leaf
+    Uint left;
+    Uint right;
+  };
+
+  Uint build_node(const Uint begin, const Uint end);
+  void nearest_in_node(const Uint node_idx, const Real* point, Uint& best, Real& best_distance) const;
+  void radius_in_node(const Uint node_idx, const Real* point, const Real squared_radius, std::vector<Uint>& result) const;
+  Real squared_distance(const Uint point_idx, const Real* point) const;
+
+  Uint m_dim;
+  Uint m_leaf_size;
+  std::vector<Real> m_coordinates;
+  std::vector<Uint> m_indices;
+  std::vector<Node> m_nodes;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // math
+} // cf3
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif // cf3_math_KDTree_hpp
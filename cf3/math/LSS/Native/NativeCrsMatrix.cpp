@@ -0,0 +1,710 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <fstream>
+
+#include "common/Assertions.hpp"
+#include "common/BasicExceptions.hpp"
+#include "common/Builder.hpp"
+#include "common/Log.hpp"
+#include "common/PE/Comm.hpp"
+#include "common/PE/CommPattern.hpp"
+#include "common/PropertyList.hpp"
+
+#include "math/VariablesDescriptor.hpp"
+#include "math/LSS/Native/NativeCrsMatrix.hpp"
+#include "math/LSS/Native/NativeDetail.hpp"
+#include "math/LSS/Native/NativeVector.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+  @file NativeCrsMatrix.cpp implementation of LSS::NativeCrsMatrix
+**/
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+using namespace cf3;
+using namespace cf3::math;
+using namespace cf3::math::LSS;
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+common::ComponentBuilder < LSS::NativeCrsMatrix, LSS::Matrix, LSS::LibLSS > NativeCrsMatrix_Builder;
+
+NativeCrsMatrix::NativeCrsMatrix(const std::string& name) :
+  LSS::Matrix(name),
+  m_is_created(false),
+  m_neq(0),
+  m_block_size(0),
+  m_nb_owned_blocks(0),
+  m_nb_blocks(0)
+{
+  properties().add("vector_type", std::string("cf3.math.LSS.NativeVector"));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeCrsMatrix::create(cf3::common::PE::CommPattern& cp, const Uint neq, const std::vector<Uint>& node_connectivity, const std::vector<Uint>& starting_indices, LSS::Vector& solution, LSS::Vector& rhs, const std::vector<Uint>& periodic_links_nodes, const std::vector<bool>& periodic_links_active)
+{
+  // if already created
+  if (m_is_created) destroy();
+
+  m_neq = neq;
+  m_block_size = neq*neq;
+
+  std::vector<Uint> block_gids, block_ranks;
+  create_native_block_map(cp, m_p2m, block_gids, block_ranks, m_nb_owned_blocks, periodic_links_nodes, periodic_links_active);
+  m_nb_blocks = block_gids.size();
+
+  // Copy node connectivity
+  m_node_connectivity.assign(node_connectivity.begin(), node_connectivity.end());
+  m_starting_indices.assign(starting_indices.begin(), starting_indices.end());
+
+  // Gather the columns of each owned block row. Periodic nodes add their connectivity to the row of their link target.
+  const Uint nb_nodes = m_p2m.size();
+  cf3_assert(starting_indices.size() == nb_nodes+1);
+  std::vector< std::vector<Uint> > row_columns(m_nb_owned_blocks);
+  for(Uint i = 0; i != nb_nodes; ++i)
+  {
+    const int block_row = m_p2m[i];
+    if(block_row >= static_cast<int>(m_nb_owned_blocks))
+      continue;
+    std::vector<Uint>& columns = row_columns[block_row];
+    columns.push_back(block_row);
+    for(Uint l = starting_indices[i]; l != starting_indices[i+1]; ++l)
+      columns.push_back(m_p2m[node_connectivity[l]]);
+  }
+
+  m_row_starts.resize(m_nb_owned_blocks+1);
+  m_row_starts[0] = 0;
+  for(Uint row = 0; row != m_nb_owned_blocks; ++row)
+  {
+    std::vector<Uint>& columns = row_columns[row];
+    std::sort(columns.begin(), columns.end());
+    columns.erase(std::unique(columns.begin(), columns.end()), columns.end());
+    m_row_starts[row+1] = m_row_starts[row] + columns.size();
+  }
+
+  m_column_indices.clear();
+  m_column_indices.reserve(m_row_starts.back());
+  m_diagonal_positions.resize(m_nb_owned_blocks);
+  for(Uint row = 0; row != m_nb_owned_blocks; ++row)
+  {
+    const std::vector<Uint>& columns = row_columns[row];
+    m_diagonal_positions[row] = m_column_indices.size() + (std::lower_bound(columns.begin(), columns.end(), row) - columns.begin());
+    m_column_indices.insert(m_column_indices.end(), columns.begin(), columns.end());
+    std::vector<Uint>().swap(row_columns[row]);
+  }
+
+  m_values.assign(m_column_indices.size()*m_block_size, 0.);
+
+  m_halo_pattern = create_native_comm_pattern(block_gids, block_ranks);
+  if(is_not_null(m_halo_pattern))
+  {
+    m_halo.assign(m_nb_blocks*m_neq, 0.);
+    m_halo_name = native_wrapper_name(*m_halo_pattern, name());
+    m_halo_pattern->insert(m_halo_name, m_halo, m_neq, true);
+  }
+
+  m_is_created=true;
+  CFdebug << "Rank " << common::PE::Comm::instance().rank() << ": Created a native block matrix with " << m_nb_owned_blocks << " local block rows, "
+          << m_column_indices.size() << " non-zero blocks and block size " << m_neq << CFendl;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeCrsMatrix::create_blocked(common::PE::CommPattern& cp, const VariablesDescriptor& vars, const std::vector< Uint >& node_connectivity, const std::vector< Uint >& starting_indices, Vector& solution, Vector& rhs, const std::vector<Uint>& periodic_links_nodes, const std::vector<bool>& periodic_links_active)
+{
+  create(cp, vars.size(), node_connectivity, starting_indices, solution, rhs, periodic_links_nodes, periodic_links_active);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeCrsMatrix::destroy()
+{
+  if(is_not_null(m_halo_pattern) && is_not_null(m_halo_pattern->get_child(m_halo_name)))
+    m_halo_pattern->remove_component(m_halo_name);
+  m_halo_pattern.reset();
+  m_halo_name.clear();
+  m_halo.clear();
+  m_p2m.clear();
+  m_row_starts.clear();
+  m_column_indices.clear();
+  m_diagonal_positions.clear();
+  m_values.clear();
+  m_node_connectivity.clear();
+  m_starting_indices.clear();
+  m_symmetric_dirichlet_values.clear();
+  m_neq=0;
+  m_block_size=0;
+  m_nb_owned_blocks=0;
+  m_nb_blocks=0;
+  m_is_created=false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+int NativeCrsMatrix::block_position(const Uint block_row, const Uint block_col) const
+{
+  cf3_assert(block_row < m_nb_owned_blocks);
+  const std::vector<Uint>::const_iterator row_begin = m_column_indices.begin() + m_row_starts[block_row];
+  const std::vector<Uint>::const_iterator row_end = m_column_indices.begin() + m_row_starts[block_row+1];
+  const std::vector<Uint>::const_iterator found = std::lower_bound(row_begin, row_end, block_col);
+  if(found == row_end || *found != block_col)
+    return -1;
+  return found - m_column_indices.begin();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeCrsMatrix::set_value(const Uint icol, const Uint irow, const Real value)
+{
+  cf3_assert(m_is_created);
+  const Uint block_row = m_p2m[irow/m_neq];
+  if(block_row >= m_nb_owned_blocks)
+    return;
+  const int pos = block_position(block_row, m_p2m[icol/m_neq]);
+  if(pos < 0)
+    throw common::BadValue(FromHere(),"Trying to access an illegal entry.");
+  block(pos)[(irow%m_neq)*m_neq + icol%m_neq] = value;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeCrsMatrix::add_value(const Uint icol, const Uint irow, const Real value)
+{
+  cf3_assert(m_is_created);
+  const Uint block_row = m_p2m[irow/m_neq];
+  if(block_row >= m_nb_owned_blocks)
+    return;
+  const int pos = block_position(block_row, m_p2m[icol/m_neq]);
+  if(pos < 0)
+    throw common::BadValue(FromHere(),"Trying to access an illegal entry.");
+  block(pos)[(irow%m_neq)*m_neq + icol%m_neq] += value;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeCrsMatrix::get_value(const Uint icol, const Uint irow, Real& value)
+{
+  cf3_assert(m_is_created);
+  const Uint block_row = m_p2m[irow/m_neq];
+  const int pos = block_row < m_nb_owned_blocks ? block_position(block_row, m_p2m[icol/m_neq]) : -1;
+  if(pos < 0)
+    throw common::BadValue(FromHere(),"Trying to access an illegal entry.");
+  value = block(pos)[(irow%m_neq)*m_neq + icol%m_neq];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeCrsMatrix::set_values(const BlockAccumulator& values)
+{
+  cf3_assert(m_is_created);
+  const Uint nb_nodes = values.indices.size();
+  cf3_assert(values.mat.rows() == nb_nodes*m_neq);
+  for(Uint i = 0; i != nb_nodes; ++i)
+  {
+    const Uint block_row = m_p2m[values.indices[i]];
+    if(block_row >= m_nb_owned_blocks)
+      continue;
+    for(Uint j = 0; j != nb_nodes; ++j)
+    {
+      const int pos = block_position(block_row, m_p2m[values.indices[j]]);
+      if(pos < 0)
+        throw common::BadValue(FromHere(),"Trying to access an illegal entry.");
+      Real* blk = block(pos);
+      for(Uint a = 0; a != m_neq; ++a)
+        for(Uint b = 0; b != m_neq; ++b)
+          blk[a*m_neq+b] = values.mat(i*m_neq+a, j*m_neq+b);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeCrsMatrix::add_values(const BlockAccumulator& values)
+{
+  cf3_assert(m_is_created);
+  const Uint nb_nodes = values.indices.size();
+  cf3_assert(values.mat.rows() == nb_nodes*m_neq);
+  for(Uint i = 0; i != nb_nodes; ++i)
+  {
+    const Uint block_row = m_p2m[values.indices[i]];
+    if(block_row >= m_nb_owned_blocks)
+      continue;
+    for(Uint j = 0; j != nb_nodes; ++j)
+    {
+      const int pos = block_position(block_row, m_p2m[values.indices[j]]);
+      if(pos < 0)
+        throw common::BadValue(FromHere(),"Trying to access an illegal entry.");
+      Real* blk = block(pos);
+      for(Uint a = 0; a != m_neq; ++a)
+        for(Uint b = 0; b != m_neq; ++b)
+          blk[a*m_neq+b] += values.mat(i*m_neq+a, j*m_neq+b);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeCrsMatrix::get_values(BlockAccumulator& values)
+{
+  cf3_assert(m_is_created);
+  values.mat.setZero();
+  const Uint nb_nodes = values.indices.size();
+  cf3_assert(values.mat.rows() == nb_nodes*m_neq);
+  for(Uint i = 0; i != nb_nodes; ++i)
+  {
+    const Uint block_row = m_p2m[values.indices[i]];
+    if(block_row >= m_nb_owned_blocks)
+      continue;
+    for(Uint j = 0; j != nb_nodes; ++j)
+    {
+      const int pos = block_position(block_row, m_p2m[values.indices[j]]);
+      if(pos < 0)
+        continue;
+      const Real* blk = block(pos);
+      for(Uint a = 0; a != m_neq; ++a)
+        for(Uint b = 0; b != m_neq; ++b)
+          values.mat(i*m_neq+a, j*m_neq+b) = blk[a*m_neq+b];
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeCrsMatrix::set_row(const Uint iblockrow, const Uint ieq, Real diagval, Real offdiagval)
+{
+  cf3_assert(m_is_created);
+  const Uint block_row = m_p2m[iblockrow];
+  if(block_row >= m_nb_owned_blocks)
+    return;
+
+  for(Uint pos = m_row_starts[block_row]; pos != m_row_starts[block_row+1]; ++pos)
+  {
+    Real* blk_row = block(pos) + ieq*m_neq;
+    for(Uint b = 0; b != m_neq; ++b)
+      blk_row[b] = offdiagval;
+  }
+  block(m_diagonal_positions[block_row])[ieq*m_neq+ieq] = diagval;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeCrsMatrix::get_column_and_replace_to_zero(const Uint iblockcol, Uint ieq, std::vector<Real>& values)
+{
+  throw common::NotImplemented(FromHere(), "get_column_and_replace_to_zero is not implemented for NativeCrsMatrix");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeCrsMatrix::symmetric_dirichlet(const Uint blockrow, const Uint ieq, const Real value, Vector& rhs)
+{
+  cf3_assert(m_is_created);
+  NativeVector* native_rhs = dynamic_cast<NativeVector*>(&rhs);
+  if(is_null(native_rhs))
+    throw common::SetupError(FromHere(), "symmetric_dirichlet of NativeCrsMatrix needs a NativeVector as RHS, but a " + rhs.derived_type_name() + " was supplied instead.");
+  std::vector<Real>& rhs_data = native_rhs->data();
+
+  const Uint bc_block = m_p2m[blockrow];
+  const int bc_col = bc_block*m_neq+ieq;
+
+  DirichletEntryT& cached_col_values = m_symmetric_dirichlet_values[bc_col];
+
+  if(cached_col_values.empty())
+  {
+    for(Uint l = m_starting_indices[blockrow]; l != m_starting_indices[blockrow+1]; ++l)
+    {
+      const Uint other_block = m_p2m[m_node_connectivity[l]];
+      if(other_block >= m_nb_owned_blocks)
+        continue;
+
+      const int pos = block_position(other_block, bc_block);
+      cf3_assert(pos >= 0);
+      Real* blk = block(pos);
+      for(Uint e = 0; e != m_neq; ++e)
+      {
+        const int other_row = other_block*m_neq+e;
+        if(other_row == bc_col || cached_col_values.count(other_row))
+          continue;
+        Real& entry = blk[e*m_neq+ieq];
+        cached_col_values[other_row] = entry;
+        rhs_data[other_row] -= entry * value;
+        entry = 0.;
+      }
+    }
+
+    if(bc_block < m_nb_owned_blocks)
+    {
+      for(Uint pos = m_row_starts[bc_block]; pos != m_row_starts[bc_block+1]; ++pos)
+      {
+        Real* blk_row = block(pos) + ieq*m_neq;
+        for(Uint b = 0; b != m_neq; ++b)
+          blk_row[b] = 0.;
+      }
+      block(m_diagonal_positions[bc_block])[ieq*m_neq+ieq] = 1.;
+    }
+  }
+  else // Reuse the cached values, if the matrix wasn't reset since the previous BC application
+  {
+    for(DirichletEntryT::const_iterator it = cached_col_values.begin(); it != cached_col_values.end(); ++it)
+    {
+      rhs_data[it->first] -= it->second * value;
+    }
+  }
+
+  rhs.set_value(blockrow, ieq, value);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeCrsMatrix::tie_blockrow_pairs (const Uint iblockrow_to, const Uint iblockrow_from)
+{
+  cf3_assert(m_is_created);
+  const Uint block_to = m_p2m[iblockrow_to];
+  const Uint block_from = m_p2m[iblockrow_from];
+
+  if(block_from >= m_nb_owned_blocks || block_to >= m_nb_owned_blocks)
+    return;
+
+  const Uint to_begin = m_row_starts[block_to];
+  const Uint from_begin = m_row_starts[block_from];
+  const Uint nb_blocks_in_row = m_row_starts[block_to+1] - to_begin;
+  if(nb_blocks_in_row != m_row_starts[block_from+1] - from_begin)
+    throw common::BadValue(FromHere(),"Number of entries do not match for the two block rows to be tied together.");
+
+  for(Uint k = 0; k != nb_blocks_in_row; ++k)
+  {
+    if(m_column_indices[to_begin+k] != m_column_indices[from_begin+k])
+      throw common::BadValue(FromHere(),"Indices of the entries do not match for the two block rows to be tied together.");
+    Real* blk_to = block(to_begin+k);
+    Real* blk_from = block(from_begin+k);
+    for(Uint i = 0; i != m_block_size; ++i)
+    {
+      blk_to[i] += blk_from[i];
+      blk_from[i] = 0.;
+    }
+  }
+
+  const int from_in_to = block_position(block_to, block_from);
+  const int to_in_from = block_position(block_from, block_to);
+  if(from_in_to < 0 || to_in_from < 0)
+    throw common::BadValue(FromHere(),"Block rows to be tied together are not connected.");
+
+  // The from row becomes x_from - x_to = 0
+  Real* from_diag = block(m_diagonal_positions[block_from]);
+  Real* from_pair = block(to_in_from);
+  for(Uint i = 0; i != m_neq; ++i)
+  {
+    from_diag[i*m_neq+i] = 1.;
+    from_pair[i*m_neq+i] = -1.;
+  }
+
+  // In the to row, the contributions of x_from move to x_to
+  Real* to_diag = block(m_diagonal_positions[block_to]);
+  Real* to_pair = block(from_in_to);
+  for(Uint i = 0; i != m_block_size; ++i)
+  {
+    to_diag[i] += to_pair[i];
+    to_pair[i] = 0.;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeCrsMatrix::set_diagonal(const std::vector<Real>& diag)
+{
+  cf3_assert(m_is_created);
+  cf3_assert(diag.size() == m_p2m.size()*m_neq);
+  const Uint nb_nodes = m_p2m.size();
+  for(Uint i = 0; i != nb_nodes; ++i)
+  {
+    const Uint block_row = m_p2m[i];
+    if(block_row >= m_nb_owned_blocks)
+      continue;
+    Real* blk = block(m_diagonal_positions[block_row]);
+    for(Uint e = 0; e != m_neq; ++e)
+      blk[e*m_neq+e] = diag[i*m_neq+e];
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeCrsMatrix::add_diagonal(const std::vector<Real>& diag)
+{
+  cf3_assert(m_is_created);
+  cf3_assert(diag.size() == m_p2m.size()*m_neq);
+  const Uint nb_nodes = m_p2m.size();
+  for(Uint i = 0; i != nb_nodes; ++i)
+  {
+    const Uint block_row = m_p2m[i];
+    if(block_row >= m_nb_owned_blocks)
+      continue;
+    Real* blk = block(m_diagonal_positions[block_row]);
+    for(Uint e = 0; e != m_neq; ++e)
+      blk[e*m_neq+e] += diag[i*m_neq+e];
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeCrsMatrix::get_diagonal(std::vector<Real>& diag)
+{
+  cf3_assert(m_is_created);
+  const Uint nb_nodes = m_p2m.size();
+  diag.resize(nb_nodes*m_neq);
+  for(Uint i = 0; i != nb_nodes; ++i)
+  {
+    const Uint block_row = m_p2m[i];
+    for(Uint e = 0; e != m_neq; ++e)
+      diag[i*m_neq+e] = block_row < m_nb_owned_blocks ? block(m_diagonal_positions[block_row])[e*m_neq+e] : 0.;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeCrsMatrix::reset(Real reset_to)
+{
+  cf3_assert(m_is_created);
+  m_values.assign(m_values.size(), reset_to);
+  m_symmetric_dirichlet_values.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeCrsMatrix::clone_to(Matrix &other)
+{
+  if(!m_is_created)
+    throw common::SetupError(FromHere(), "Matrix to clone " + uri().string() + " is not created");
+
+  NativeCrsMatrix* other_ptr = dynamic_cast<NativeCrsMatrix*>(&other);
+  if(is_null(other_ptr))
+    throw common::SetupError(FromHere(), "clone_to method of NativeCrsMatrix needs another NativeCrsMatrix, but a " + other.derived_type_name() + " was supplied instead.");
+
+  other_ptr->destroy();
+  other_ptr->m_is_created = m_is_created;
+  other_ptr->m_neq = m_neq;
+  other_ptr->m_block_size = m_block_size;
+  other_ptr->m_nb_owned_blocks = m_nb_owned_blocks;
+  other_ptr->m_nb_blocks = m_nb_blocks;
+  other_ptr->m_p2m = m_p2m;
+  other_ptr->m_row_starts = m_row_starts;
+  other_ptr->m_column_indices = m_column_indices;
+  other_ptr->m_diagonal_positions = m_diagonal_positions;
+  other_ptr->m_values = m_values;
+  other_ptr->m_node_connectivity = m_node_connectivity;
+  other_ptr->m_starting_indices = m_starting_indices;
+  other_ptr->m_symmetric_dirichlet_values = m_symmetric_dirichlet_values;
+  other_ptr->m_halo = m_halo;
+  other_ptr->m_halo_pattern = m_halo_pattern;
+  if(is_not_null(m_halo_pattern))
+  {
+    other_ptr->m_halo_name = native_wrapper_name(*m_halo_pattern, other_ptr->name());
+    m_halo_pattern->insert(other_ptr->m_halo_name, other_ptr->m_halo, m_neq, true);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeCrsMatrix::read_native(const common::URI& file)
+{
+  throw common::NotImplemented(FromHere(), "read_native is not implemented for NativeCrsMatrix");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeCrsMatrix::print(common::LogStream& stream)
+{
+  if (m_is_created)
+  {
+    std::vector<Uint> row_indices, col_indices;
+    std::vector<Real> values;
+    debug_data(row_indices, col_indices, values);
+    const Uint nb_entries = values.size();
+    for(Uint i = 0; i != nb_entries; ++i)
+      stream << row_indices[i] << " " << -static_cast<int>(col_indices[i]) << " " << values[i] << CFendl;
+    stream << "# name:                 " << name() << "\n";
+    stream << "# type_name:            " << type_name() << "\n";
+    stream << "# process:              " << common::PE::Comm::instance().rank() << "\n";
+    stream << "# number of equations:  " << m_neq << "\n";
+    stream << "# number of rows:       " << m_nb_owned_blocks*m_neq << "\n";
+    stream << "# number of cols:       " << m_nb_blocks*m_neq << "\n";
+    stream << "# number of block rows: " << m_nb_owned_blocks << "\n";
+    stream << "# number of block cols: " << m_nb_blocks << "\n";
+    stream << "# number of entries:    " << nb_entries << "\n";
+  } else {
+    stream << name() << " of type " << type_name() << "::is_created() is false, nothing is printed.";
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeCrsMatrix::print(std::ostream& stream)
+{
+  if (m_is_created)
+  {
+    std::vector<Uint> row_indices, col_indices;
+    std::vector<Real> values;
+    debug_data(row_indices, col_indices, values);
+    const Uint nb_entries = values.size();
+    for(Uint i = 0; i != nb_entries; ++i)
+      stream << col_indices[i] << " " << -static_cast<int>(row_indices[i]) << " " << values[i] << "\n";
+    stream << "# name:                 " << name() << "\n";
+    stream << "# type_name:            " << type_name() << "\n";
+    stream << "# process:              " << common::PE::Comm::instance().rank() << "\n";
+    stream << "# number of equations:  " << m_neq << "\n";
+    stream << "# number of rows:       " << m_nb_owned_blocks*m_neq << "\n";
+    stream << "# number of cols:       " << m_nb_blocks*m_neq << "\n";
+    stream << "# number of block rows: " << m_nb_owned_blocks << "\n";
+    stream << "# number of block cols: " << m_nb_blocks << "\n";
+    stream << "# number of entries:    " << nb_entries << "\n" << std::flush;
+  } else {
+    stream << name() << " of type " << type_name() << "::is_created() is false, nothing is printed.";
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeCrsMatrix::print(const std::string& filename, std::ios_base::openmode mode )
+{
+  std::ofstream stream(filename.c_str(),mode);
+  stream << "VARIABLES=COL,ROW,VAL\n" << std::flush;
+  stream << "ZONE T=\"" << type_name() << "::" << name() <<  "\"\n" << std::flush;
+  print(stream);
+  stream.close();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeCrsMatrix::print_native(std::ostream& stream)
+{
+  for(Uint row = 0; row != m_nb_owned_blocks; ++row)
+  {
+    for(Uint pos = m_row_starts[row]; pos != m_row_starts[row+1]; ++pos)
+    {
+      stream << row << " " << m_column_indices[pos] << " :";
+      for(Uint i = 0; i != m_block_size; ++i)
+        stream << " " << m_values[pos*m_block_size+i];
+      stream << "\n";
+    }
+  }
+  stream << std::flush;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeCrsMatrix::debug_data(std::vector<Uint>& row_indices, std::vector<Uint>& col_indices, std::vector<Real>& values)
+{
+  row_indices.clear(); col_indices.clear(); values.clear();
+  const Uint nnz = m_values.size();
+  row_indices.reserve(nnz); col_indices.reserve(nnz); values.reserve(nnz);
+
+  // first node that maps onto each block
+  const Uint nb_nodes = m_p2m.size();
+  std::vector<Uint> m2p(m_nb_blocks, nb_nodes);
+  for(Uint i = nb_nodes; i != 0; --i)
+    m2p[m_p2m[i-1]] = i-1;
+
+  for(Uint row = 0; row != m_nb_owned_blocks; ++row)
+  {
+    for(Uint pos = m_row_starts[row]; pos != m_row_starts[row+1]; ++pos)
+    {
+      const Real* blk = block(pos);
+      for(Uint a = 0; a != m_neq; ++a)
+      {
+        for(Uint b = 0; b != m_neq; ++b)
+        {
+          row_indices.push_back(m2p[row]*m_neq+a);
+          col_indices.push_back(m2p[m_column_indices[pos]]*m_neq+b);
+          values.push_back(blk[a*m_neq+b]);
+        }
+      }
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeCrsMatrix::multiply(const Real* x, Real* y)
+{
+  cf3_assert(m_is_created);
+  const Real* x_all = x;
+  if(is_not_null(m_halo_pattern))
+  {
+    std::copy(x, x + m_nb_owned_blocks*m_neq, m_halo.begin());
+    m_halo_pattern->synchronize(m_halo_name);
+    x_all = m_halo.empty() ? 0 : &m_halo[0];
+  }
+
+  const int nb_rows = m_nb_owned_blocks;
+  const Uint neq = m_neq;
+  const Uint block_size = m_block_size;
+  const Uint* row_starts = &m_row_starts[0];
+  const Uint* columns = m_column_indices.empty() ? 0 : &m_column_indices[0];
+  const Real* vals = m_values.empty() ? 0 : &m_values[0];
+
+  if(neq == 1)
+  {
+    #pragma omp parallel for schedule(static)
+    for(int row = 0; row < nb_rows; ++row)
+    {
+      Real sum = 0.;
+      for(Uint pos = row_starts[row]; pos != row_starts[row+1]; ++pos)
+        sum += vals[pos]*x_all[columns[pos]];
+      y[row] = sum;
+    }
+    return;
+  }
+
+  #pragma omp parallel for schedule(static)
+  for(int row = 0; row < nb_rows; ++row)
+  {
+    Real* y_row = y + row*neq;
+    for(Uint a = 0; a != neq; ++a)
+      y_row[a] = 0.;
+    for(Uint pos = row_starts[row]; pos != row_starts[row+1]; ++pos)
+    {
+      const Real* blk = vals + pos*block_size;
+      const Real* x_col = x_all + columns[pos]*neq;
+      for(Uint a = 0; a != neq; ++a)
+      {
+        Real sum = 0.;
+        for(Uint b = 0; b != neq; ++b)
+          sum += blk[a*neq+b]*x_col[b];
+        y_row[a] += sum;
+      }
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeCrsMatrix::apply(const Handle< Vector >& y, const Handle< Vector const >& x, const Real alpha, const Real beta)
+{
+  Handle<NativeVector> y_nat(y);
+  Handle<NativeVector const> x_nat(x);
+
+  if(is_null(y_nat) || is_null(x_nat))
+    throw common::SetupError(FromHere(), "NativeCrsMatrix::apply must be given NativeVector arguments");
+
+  cf3_assert(x_nat->nb_owned_entries() == m_nb_owned_blocks*m_neq);
+  cf3_assert(y_nat->nb_owned_entries() == m_nb_owned_blocks*m_neq);
+
+  // multiply is collective in parallel, so it must be called even if there are no local rows
+  const Uint nb_rows = m_nb_owned_blocks*m_neq;
+  std::vector<Real> ax(nb_rows);
+  multiply(x_nat->data().empty() ? 0 : &x_nat->data()[0], ax.empty() ? 0 : &ax[0]);
+
+  std::vector<Real>& y_data = y_nat->data();
+  for(Uint i = 0; i != nb_rows; ++i)
+    y_data[i] = alpha*ax[i] + (beta == 0. ? 0. : beta*y_data[i]);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
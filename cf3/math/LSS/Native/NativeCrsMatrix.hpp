@@ -0,0 +1,249 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_Math_LSS_NativeCrsMatrix_hpp
+#define cf3_Math_LSS_NativeCrsMatrix_hpp
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <map>
+
+#include <boost/shared_ptr.hpp>
+
+#include "math/LSS/LibLSS.hpp"
+#include "math/LSS/BlockAccumulator.hpp"
+#include "math/LSS/Vector.hpp"
+#include "math/LSS/Matrix.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+  @file NativeCrsMatrix.hpp definition of LSS::NativeCrsMatrix
+
+  Block compressed sparse row matrix of the native LSS backend. Each entry of the sparsity graph is a dense
+  neq x neq block, stored row-major. Only the block rows owned by this process are stored, the columns
+  refer to the block numbering of NativeVector, i.e. owned blocks first and ghosts at the back.
+**/
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace math {
+namespace LSS {
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+class LSS_API NativeCrsMatrix : public LSS::Matrix {
+public:
+
+  /// @name CREATION, DESTRUCTION AND COMPONENT SYSTEM
+  //@{
+
+  /// name of the type
+  static std::string type_name () { return "NativeCrsMatrix"; }
+
+  /// Accessor to solver type
+  const std::string solvertype() { return "Native"; }
+
+  /// Accessor to the flag if matrix, solution and rhs are tied together or not
+  const bool is_swappable(const LSS::Vector& solution, const LSS::Vector& rhs) { return true; }
+
+  /// Default constructor
+  NativeCrsMatrix(const std::string& name);
+
+  /// Setup sparsity structure
+  void create(cf3::common::PE::CommPattern& cp, const Uint neq, const std::vector<Uint>& node_connectivity, const std::vector<Uint>& starting_indices, LSS::Vector& solution, LSS::Vector& rhs, const std::vector<Uint>& periodic_links_nodes = std::vector<Uint>(), const std::vector<bool>& periodic_links_active = std::vector<bool>());
+
+  /// The native backend always interleaves the variables per node, so this is equivalent to create with vars.size() equations
+  void create_blocked(common::PE::CommPattern& cp, const VariablesDescriptor& vars, const std::vector< Uint >& node_connectivity, const std::vector< Uint >& starting_indices, Vector& solution, Vector& rhs, const std::vector<Uint>& periodic_links_nodes = std::vector<Uint>(), const std::vector<bool>& periodic_links_active = std::vector<bool>());
+
+  /// Deallocate underlying data
+  void destroy();
+
+  //@} END CREATION, DESTRUCTION AND COMPONENT SYSTEM
+
+  /// @name INDIVIDUAL ACCESS
+  //@{
+
+  /// Set value at given location in the matrix
+  void set_value(const Uint icol, const Uint irow, const Real value);
+
+  /// Add value at given location in the matrix
+  void add_value(const Uint icol, const Uint irow, const Real value);
+
+  /// Get value at given location in the matrix
+  void get_value(const Uint icol, const Uint irow, Real& value);
+
+  //@} END INDIVIDUAL ACCESS
+
+  /// @name EFFICCIENT ACCESS
+  //@{
+
+  /// Set a list of values
+  void set_values(const BlockAccumulator& values);
+
+  /// Add a list of values. Safe to call concurrently for element blocks that touch disjoint rows.
+  void add_values(const BlockAccumulator& values);
+
+  /// Add a list of values
+  void get_values(BlockAccumulator& values);
+
+  /// Set a row, diagonal and off-diagonals values separately (dirichlet-type boundaries)
+  void set_row(const Uint iblockrow, const Uint ieq, Real diagval, Real offdiagval);
+
+  /// Get a column and replace it to zero (dirichlet-type boundaries, when trying to preserve symmetry)
+  void get_column_and_replace_to_zero(const Uint iblockcol, Uint ieq, std::vector<Real>& values);
+
+  void symmetric_dirichlet(const Uint blockrow, const Uint ieq, const Real value, Vector& rhs);
+
+  /// Add one line to another and tie to it via dirichlet-style (applying periodicity)
+  void tie_blockrow_pairs (const Uint iblockrow_to, const Uint iblockrow_from);
+
+  /// Set the diagonal
+  void set_diagonal(const std::vector<Real>& diag);
+
+  /// Add to the diagonal
+  void add_diagonal(const std::vector<Real>& diag);
+
+  /// Get the diagonal
+  void get_diagonal(std::vector<Real>& diag);
+
+  /// Reset Matrix
+  void reset(Real reset_to=0.);
+
+  //@} END EFFICCIENT ACCESS
+
+  /// @name MISCELLANEOUS
+  //@{
+
+  /// Print to wherever
+  void print(common::LogStream& stream);
+
+  /// Print to wherever
+  void print(std::ostream& stream);
+
+  /// Print to file given by filename
+  void print(const std::string& filename, std::ios_base::openmode mode = std::ios_base::out );
+
+  /// Print the raw block CSR arrays
+  void print_native(std::ostream& stream);
+
+  /// Accessor to the state of create
+  const bool is_created() { return m_is_created; }
+
+  /// Accessor to the number of equations
+  const Uint neq() { cf3_assert(m_is_created); return m_neq; }
+
+  /// Accessor to the number of block rows
+  const Uint blockrow_size() { cf3_assert(m_is_created); return m_nb_owned_blocks; }
+
+  /// Accessor to the number of block columns
+  const Uint blockcol_size() { cf3_assert(m_is_created); return m_p2m.size(); }
+
+  void clone_to(Matrix& other);
+
+  void read_native(const common::URI& file);
+
+  //@} END MISCELLANEOUS
+
+  /// @name LINEAR ALGEBRA
+  //@{
+
+  /// Compute y = alpha*A*x + beta*y
+  void apply(const Handle<Vector>& y, const Handle<Vector const>& x, const Real alpha = 1., const Real beta = 0.);
+
+  /// Compute y = A*x for the owned rows. x only needs valid owned entries, the ghosts are exchanged internally.
+  /// Both arrays are in the block numbering of NativeVector.
+  void multiply(const Real* x, Real* y);
+
+  //@} END LINEAR ALGEBRA
+
+  /// @name NATIVE ACCESS
+  //@{
+
+  /// Number of block rows stored on this process
+  Uint nb_owned_blocks() const { return m_nb_owned_blocks; }
+
+  /// Start of each block row in column_indices(), with one extra entry at the end
+  const std::vector<Uint>& row_starts() const { return m_row_starts; }
+
+  /// Block column index for each stored block, sorted within each row
+  const std::vector<Uint>& column_indices() const { return m_column_indices; }
+
+  /// Position of the diagonal block of each row in column_indices()
+  const std::vector<Uint>& diagonal_positions() const { return m_diagonal_positions; }
+
+  /// Block values, stored row-major per block, in the order of column_indices()
+  const std::vector<Real>& values() const { return m_values; }
+
+  //@} END NATIVE ACCESS
+
+  /// @name TEST ONLY
+  //@{
+
+  /// exports the matrix into big linear arrays
+  /// @attention only for debug and utest purposes
+  void debug_data(std::vector<Uint>& row_indices, std::vector<Uint>& col_indices, std::vector<Real>& values);
+
+  //@} END TEST ONLY
+
+private:
+
+  /// Position of block (block_row, block_col) in m_column_indices, or -1 if it is not part of the sparsity
+  int block_position(const Uint block_row, const Uint block_col) const;
+
+  /// Pointer to the start of the block at the given position
+  inline Real* block(const Uint position) { return &m_values[position*m_block_size]; }
+
+  /// state of creation
+  bool m_is_created;
+
+  /// number of equations
+  Uint m_neq;
+
+  /// number of values in a block, i.e. m_neq*m_neq
+  Uint m_block_size;
+
+  /// number of block rows owned by this process
+  Uint m_nb_owned_blocks;
+
+  /// total number of blocks (owned and ghost) in the local column space
+  Uint m_nb_blocks;
+
+  /// mapper array, maps from process local node numbering to the block numbering (owned first, then ghosts)
+  std::vector<int> m_p2m;
+
+  /// Block CSR structure
+  std::vector<Uint> m_row_starts;
+  std::vector<Uint> m_column_indices;
+  std::vector<Uint> m_diagonal_positions;
+  std::vector<Real> m_values;
+
+  /// Copy of the connectivity data
+  std::vector<Uint> m_node_connectivity, m_starting_indices;
+
+  /// Cache matrix values in case of symmetric dirichlet, so they can be applied multiple times even if the matrix is not changed
+  typedef std::map<int, Real> DirichletEntryT;
+  typedef std::map<int, DirichletEntryT> DirichletMapT;
+  DirichletMapT m_symmetric_dirichlet_values;
+
+  /// Input vector of multiply, including the ghosts. Only used in parallel.
+  std::vector<Real> m_halo;
+
+  /// Comm pattern to fill the ghosts of m_halo. Null in serial.
+  boost::shared_ptr<common::PE::CommPattern> m_halo_pattern;
+
+  /// Name of the commwrapper of m_halo in m_halo_pattern, which is shared with the clones of this matrix
+  std::string m_halo_name;
+}; // end of class NativeCrsMatrix
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace LSS
+} // namespace math
+} // namespace cf3
+
+#endif // cf3_Math_LSS_NativeCrsMatrix_hpp
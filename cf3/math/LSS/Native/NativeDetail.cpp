@@ -0,0 +1,130 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "common/Assertions.hpp"
+#include "common/StringConversion.hpp"
+#include "common/PE/Comm.hpp"
+#include "common/PE/CommPattern.hpp"
+#include "common/PE/CommWrapper.hpp"
+
+#include "math/LSS/Native/NativeDetail.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace math {
+namespace LSS {
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+bool native_is_distributed()
+{
+  const common::PE::Comm& comm = common::PE::Comm::instance();
+  return comm.is_active() && comm.size() > 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void create_native_block_map(common::PE::CommPattern& cp, std::vector<int>& p2m, std::vector<Uint>& block_gids, std::vector<Uint>& block_ranks, Uint& nb_owned_blocks, const std::vector<Uint>& periodic_links_nodes, const std::vector<bool>& periodic_links_active)
+{
+  const Uint nb_nodes = cp.isUpdatable().size();
+  const bool has_periodic = !periodic_links_active.empty();
+  cf3_assert(!has_periodic || periodic_links_active.size() == nb_nodes);
+  cf3_assert(periodic_links_active.size() == periodic_links_nodes.size());
+
+  std::vector<Uint> node_gids(nb_nodes);
+  if(nb_nodes != 0)
+  {
+    cf3_assert(cp.gid()->size_of() == sizeof(Uint));
+    cp.gid()->pack(&node_gids[0]);
+  }
+
+  p2m.assign(nb_nodes, -1);
+  block_gids.clear(); block_gids.reserve(nb_nodes);
+  block_ranks.clear(); block_ranks.reserve(nb_nodes);
+
+  // owned nodes first, ghosts at the back
+  for(Uint i = 0; i != nb_nodes; ++i)
+  {
+    if(cp.isUpdatable()[i] && !(has_periodic && periodic_links_active[i]))
+    {
+      p2m[i] = block_gids.size();
+      block_gids.push_back(node_gids[i]);
+      block_ranks.push_back(cp.rank(i));
+    }
+  }
+  nb_owned_blocks = block_gids.size();
+  for(Uint i = 0; i != nb_nodes; ++i)
+  {
+    if(!cp.isUpdatable()[i] && !(has_periodic && periodic_links_active[i]))
+    {
+      p2m[i] = block_gids.size();
+      block_gids.push_back(node_gids[i]);
+      block_ranks.push_back(cp.rank(i));
+    }
+  }
+
+  if(has_periodic)
+  {
+    for(Uint i = 0; i != nb_nodes; ++i)
+    {
+      if(periodic_links_active[i])
+      {
+        Uint final_linked_node = periodic_links_nodes[i];
+        while(periodic_links_active[final_linked_node])
+          final_linked_node = periodic_links_nodes[final_linked_node];
+        p2m[i] = p2m[final_linked_node];
+      }
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+boost::shared_ptr<common::PE::CommPattern> create_native_comm_pattern(const std::vector<Uint>& block_gids, const std::vector<Uint>& block_ranks)
+{
+  boost::shared_ptr<common::PE::CommPattern> result;
+  if(!native_is_distributed())
+    return result;
+
+  std::vector<Uint> gids(block_gids);
+  std::vector<Uint> ranks(block_ranks);
+  result = common::allocate_component<common::PE::CommPattern>("CommPattern");
+  result->insert("gid", gids, 1, false);
+  result->setup(Handle<common::PE::CommWrapper>(result->get_child("gid")), ranks);
+  result->remove_component("gid");
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string native_wrapper_name(const common::PE::CommPattern& cp, const std::string& name)
+{
+  std::string result = name;
+  for(Uint i = 1; is_not_null(cp.get_child(result)); ++i)
+    result = name + "_" + common::to_str(i);
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+Real native_global_sum(const Real local_value)
+{
+  if(!native_is_distributed())
+    return local_value;
+
+  Real result = 0.;
+  common::PE::Comm::instance().all_reduce(common::PE::plus(), &local_value, 1, &result);
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace LSS
+} // namespace math
+} // namespace cf3
@@ -0,0 +1,66 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_Math_LSS_NativeDetail_hpp
+#define cf3_Math_LSS_NativeDetail_hpp
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <string>
+
+#include <boost/shared_ptr.hpp>
+
+#include "common/CF.hpp"
+
+#include "math/LSS/LibLSS.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+  @file NativeDetail.hpp Shared functions between the native LSS classes
+**/
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+  namespace common { namespace PE { class CommPattern; } }
+namespace math {
+namespace LSS {
+
+/// True if the native LSS runs on more than one process, i.e. ghosts need to be exchanged and reductions summed
+bool native_is_distributed();
+
+/// Create a local node index to block index lookup. Blocks of owned nodes are numbered first, followed by the ghosts.
+/// Nodes with an active periodic link share the block of their final link target.
+/// @param cp The comm pattern that governs the node distribution
+/// @param p2m Mapping from node index to block index
+/// @param block_gids Global ID for each block
+/// @param block_ranks Owning rank for each block
+/// @param nb_owned_blocks The number of blocks owned by this rank, these are the first nb_owned_blocks items in block_gids
+void create_native_block_map(common::PE::CommPattern& cp,
+                             std::vector<int>& p2m,
+                             std::vector<Uint>& block_gids,
+                             std::vector<Uint>& block_ranks,
+                             Uint& nb_owned_blocks,
+                             const std::vector<Uint>& periodic_links_nodes = std::vector<Uint>(),
+                             const std::vector<bool>& periodic_links_active = std::vector<bool>());
+
+/// Build a comm pattern that can synchronize data laid out according to the block numbering of create_native_block_map.
+/// Returns a null pointer in serial runs, where there is nothing to synchronize.
+boost::shared_ptr<common::PE::CommPattern> create_native_comm_pattern(const std::vector<Uint>& block_gids, const std::vector<Uint>& block_ranks);
+
+/// Name for a new commwrapper in cp: the given name if it is free, or the name with the first free numeric suffix otherwise.
+/// Clones of a native matrix or vector share the comm pattern, but have to be synchronized separately.
+std::string native_wrapper_name(const common::PE::CommPattern& cp, const std::string& name);
+
+/// Sum the given value over all processes
+Real native_global_sum(const Real local_value);
+
+} // namespace LSS
+} // namespace math
+} // namespace cf3
+
+#endif // cf3_Math_LSS_NativeDetail_hpp
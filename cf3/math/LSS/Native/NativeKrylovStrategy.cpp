@@ -0,0 +1,770 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <cmath>
+
+#include <boost/assign/std/vector.hpp>
+#include <boost/bind.hpp>
+
+#include <Eigen/LU>
+
+#include "common/BasicExceptions.hpp"
+#include "common/Builder.hpp"
+#include "common/Log.hpp"
+#include "common/OptionList.hpp"
+#include "common/PropertyList.hpp"
+
+#include "math/LSS/Native/NativeCrsMatrix.hpp"
+#include "math/LSS/Native/NativeDetail.hpp"
+#include "math/LSS/Native/NativeKrylovStrategy.hpp"
+#include "math/LSS/Native/NativeOperatorMatrix.hpp"
+#include "math/LSS/Native/NativeVector.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace math {
+namespace LSS {
+
+common::ComponentBuilder<NativeKrylovStrategy, SolutionStrategy, LibLSS> NativeKrylovStrategy_builder;
+
+namespace detail
+{
+
+typedef Eigen::Matrix<Real, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> BlockT;
+
+/// c -= a*b for n x n row-major blocks
+inline void block_mult_sub(const Real* a, const Real* b, Real* c, const Uint n)
+{
+  for(Uint i = 0; i != n; ++i)
+    for(Uint k = 0; k != n; ++k)
+    {
+      const Real a_ik = a[i*n+k];
+      for(Uint j = 0; j != n; ++j)
+        c[i*n+j] -= a_ik*b[k*n+j];
+    }
+}
+
+/// y -= a*x for an n x n row-major block
+inline void block_vec_mult_sub(const Real* a, const Real* x, Real* y, const Uint n)
+{
+  for(Uint i = 0; i != n; ++i)
+  {
+    Real sum = 0.;
+    for(Uint j = 0; j != n; ++j)
+      sum += a[i*n+j]*x[j];
+    y[i] -= sum;
+  }
+}
+
+/// y = a*x for an n x n row-major block
+inline void block_vec_mult(const Real* a, const Real* x, Real* y, const Uint n)
+{
+  for(Uint i = 0; i != n; ++i)
+  {
+    Real sum = 0.;
+    for(Uint j = 0; j != n; ++j)
+      sum += a[i*n+j]*x[j];
+    y[i] = sum;
+  }
+}
+
+/// Invert the n x n block in place, throwing if it is singular
+inline void invert_block(Real* a, const Uint n, const Uint block_row)
+{
+  if(n == 1)
+  {
+    if(a[0] == 0.)
+      throw common::BadValue(FromHere(), "Zero diagonal entry in block row " + common::to_str(block_row) + " while building the preconditioner");
+    a[0] = 1./a[0];
+    return;
+  }
+  Eigen::Map<BlockT> blk(a, n, n);
+  Eigen::FullPivLU<BlockT> lu(blk);
+  if(!lu.isInvertible())
+    throw common::BadValue(FromHere(), "Singular diagonal block in block row " + common::to_str(block_row) + " while building the preconditioner");
+  blk = lu.inverse();
+}
+
+/// Preconditioner interface: out = M^-1 in, for the owned entries
+struct Preconditioner
+{
+  virtual ~Preconditioner() {}
+  virtual void setup(NativeCrsMatrix& matrix) = 0;
+  /// Matrix-free matrices only provide their diagonal, so by default they can't be preconditioned
+  virtual void setup(NativeOperatorMatrix& matrix)
+  {
+    throw common::SetupError(FromHere(), "Only the Jacobi preconditioner can be used with matrix-free matrix " + matrix.uri().path());
+  }
+  virtual void apply(const Real* in, Real* out) const = 0;
+};
+
+/// Stores the inverse of the diagonal blocks. With point_jacobi, only the diagonal of each block is kept.
+struct BlockJacobiPreconditioner : Preconditioner
+{
+  BlockJacobiPreconditioner(const bool point_jacobi) : m_point_jacobi(point_jacobi), m_neq(0), m_nb_blocks(0) {}
+
+  virtual void setup(NativeCrsMatrix& matrix)
+  {
+    m_nb_blocks = matrix.nb_owned_blocks();
+    m_neq = matrix.neq();
+    const Uint block_size = m_neq*m_neq;
+    const std::vector<Uint>& diag_pos = matrix.diagonal_positions();
+    const std::vector<Real>& values = matrix.values();
+
+    if(m_point_jacobi)
+    {
+      m_inverse.resize(m_nb_blocks*m_neq);
+      for(Uint i = 0; i != m_nb_blocks; ++i)
+      {
+        for(Uint e = 0; e != m_neq; ++e)
+        {
+          const Real d = values[diag_pos[i]*block_size + e*m_neq + e];
+          if(d == 0.)
+            throw common::BadValue(FromHere(), "Zero diagonal entry in block row " + common::to_str(i) + " while building the Jacobi preconditioner");
+          m_inverse[i*m_neq+e] = 1./d;
+        }
+      }
+    }
+    else
+    {
+      m_inverse.resize(m_nb_blocks*block_size);
+      for(Uint i = 0; i != m_nb_blocks; ++i)
+      {
+        std::copy(values.begin() + diag_pos[i]*block_size, values.begin() + (diag_pos[i]+1)*block_size, m_inverse.begin() + i*block_size);
+        invert_block(&m_inverse[i*block_size], m_neq, i);
+      }
+    }
+  }
+
+  virtual void setup(NativeOperatorMatrix& matrix)
+  {
+    if(!m_point_jacobi)
+      Preconditioner::setup(matrix);
+
+    m_nb_blocks = matrix.nb_owned_blocks();
+    m_neq = matrix.neq();
+    const std::vector<Real>& diagonal = matrix.diagonal();
+    m_inverse.resize(diagonal.size());
+    for(Uint i = 0; i != diagonal.size(); ++i)
+    {
+      if(diagonal[i] == 0.)
+        throw common::BadValue(FromHere(), "Zero diagonal entry in block row " + common::to_str(i/m_neq) + " while building the Jacobi preconditioner");
+      m_inverse[i] = 1./diagonal[i];
+    }
+  }
+
+  virtual void apply(const Real* in, Real* out) const
+  {
+    const Uint neq = m_neq;
+    if(m_point_jacobi || neq == 1)
+    {
+      const int size = m_nb_blocks*neq;
+      const Real* inv = m_inverse.empty() ? 0 : &m_inverse[0];
+      #pragma omp parallel for schedule(static)
+      for(int i = 0; i < size; ++i)
+        out[i] = inv[i]*in[i];
+      return;
+    }
+
+    const int nb_blocks = m_nb_blocks;
+    const Uint block_size = neq*neq;
+    #pragma omp parallel for schedule(static)
+    for(int i = 0; i < nb_blocks; ++i)
+      block_vec_mult(&m_inverse[i*block_size], in + i*neq, out + i*neq, neq);
+  }
+
+  const bool m_point_jacobi;
+  Uint m_neq;
+  Uint m_nb_blocks;
+  std::vector<Real> m_inverse;
+};
+
+/// Block ILU(0): incomplete LU factorization restricted to the sparsity of the process-local part of the matrix.
+/// For a single equation this is the classical ILU(0).
+struct ILU0Preconditioner : Preconditioner
+{
+  virtual void setup(NativeCrsMatrix& matrix)
+  {
+    m_nb_blocks = matrix.nb_owned_blocks();
+    m_neq = matrix.neq();
+    m_row_starts = &matrix.row_starts();
+    m_columns = &matrix.column_indices();
+    m_diagonal_positions = &matrix.diagonal_positions();
+    m_factors = matrix.values();
+
+    const Uint n = m_neq;
+    const Uint block_size = n*n;
+    const std::vector<Uint>& row_starts = *m_row_starts;
+    const std::vector<Uint>& columns = *m_columns;
+    const std::vector<Uint>& diag_pos = *m_diagonal_positions;
+
+    std::vector<Real> lik(block_size);
+    std::vector<int> marker(m_nb_blocks, -1);
+    for(Uint i = 0; i != m_nb_blocks; ++i)
+    {
+      const Uint row_begin = row_starts[i];
+      const Uint row_end = row_starts[i+1];
+      for(Uint pos = row_begin; pos != row_end; ++pos)
+      {
+        if(columns[pos] < m_nb_blocks)
+          marker[columns[pos]] = pos;
+      }
+
+      for(Uint pos_ik = row_begin; pos_ik != diag_pos[i]; ++pos_ik)
+      {
+        const Uint k = columns[pos_ik];
+        // L_ik = A_ik * inv(U_kk), the diagonal blocks of finished rows already hold their inverse
+        Real* a_ik = &m_factors[pos_ik*block_size];
+        std::fill(lik.begin(), lik.end(), 0.);
+        block_mult_sub(a_ik, &m_factors[diag_pos[k]*block_size], &lik[0], n);
+        for(Uint j = 0; j != block_size; ++j)
+          a_ik[j] = -lik[j];
+
+        for(Uint pos_kj = diag_pos[k]+1; pos_kj != row_starts[k+1]; ++pos_kj)
+        {
+          const Uint j = columns[pos_kj];
+          if(j >= m_nb_blocks || marker[j] < 0)
+            continue;
+          block_mult_sub(a_ik, &m_factors[pos_kj*block_size], &m_factors[marker[j]*block_size], n);
+        }
+      }
+
+      invert_block(&m_factors[diag_pos[i]*block_size], n, i);
+
+      for(Uint pos = row_begin; pos != row_end; ++pos)
+      {
+        if(columns[pos] < m_nb_blocks)
+          marker[columns[pos]] = -1;
+      }
+    }
+  }
+
+  virtual void apply(const Real* in, Real* out) const
+  {
+    const Uint n = m_neq;
+    const Uint block_size = n*n;
+    const std::vector<Uint>& row_starts = *m_row_starts;
+    const std::vector<Uint>& columns = *m_columns;
+    const std::vector<Uint>& diag_pos = *m_diagonal_positions;
+
+    // Forward substitution with the unit lower triangle, storing the intermediate result in out
+    for(Uint i = 0; i != m_nb_blocks; ++i)
+    {
+      Real* out_i = out + i*n;
+      for(Uint e = 0; e != n; ++e)
+        out_i[e] = in[i*n+e];
+      for(Uint pos = row_starts[i]; pos != diag_pos[i]; ++pos)
+        block_vec_mult_sub(&m_factors[pos*block_size], out + columns[pos]*n, out_i, n);
+    }
+
+    // Backward substitution with the upper triangle
+    std::vector<Real> tmp(n);
+    for(Uint i = m_nb_blocks; i != 0; --i)
+    {
+      const Uint row = i-1;
+      Real* out_i = out + row*n;
+      for(Uint pos = diag_pos[row]+1; pos != row_starts[row+1]; ++pos)
+      {
+        if(columns[pos] < m_nb_blocks)
+          block_vec_mult_sub(&m_factors[pos*block_size], out + columns[pos]*n, out_i, n);
+      }
+      block_vec_mult(&m_factors[diag_pos[row]*block_size], out_i, &tmp[0], n);
+      std::copy(tmp.begin(), tmp.end(), out_i);
+    }
+  }
+
+  Uint m_neq;
+  Uint m_nb_blocks;
+  const std::vector<Uint>* m_row_starts;
+  const std::vector<Uint>* m_columns;
+  const std::vector<Uint>* m_diagonal_positions;
+  std::vector<Real> m_factors;
+};
+
+} // namespace detail
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+struct NativeKrylovStrategy::Implementation
+{
+  Implementation(common::Component& self) :
+    m_self(self),
+    m_solver("GMRES"),
+    m_preconditioner_type("ILU0"),
+    m_max_iterations(1000),
+    m_tolerance(1e-8),
+    m_gmres_restart(30),
+    m_preconditioner_reset(1),
+    m_solve_count(0)
+  {
+    using namespace boost::assign;
+
+    m_self.options().add("solver", m_solver)
+      .pretty_name("Solver")
+      .description("Krylov method: GMRES (restarted, right preconditioned), BiCGStab (right preconditioned) or CG (symmetric positive definite systems only)")
+      .link_to(&m_solver)
+      .attach_trigger(boost::bind(&Implementation::trigger_solver, this))
+      .mark_basic()
+      .restricted_list() += std::string("BiCGStab"), std::string("CG");
+
+    m_self.options().add("preconditioner", m_preconditioner_type)
+      .pretty_name("Preconditioner")
+      .description("Preconditioner: ILU0 (block ILU(0)), BlockJacobi, Jacobi or None")
+      .link_to(&m_preconditioner_type)
+      .attach_trigger(boost::bind(&Implementation::trigger_preconditioner, this))
+      .mark_basic()
+      .restricted_list() += std::string("BlockJacobi"), std::string("Jacobi"), std::string("None");
+
+    m_self.options().add("max_iterations", m_max_iterations)
+      .pretty_name("Maximum Iterations")
+      .description("Maximum number of Krylov iterations")
+      .link_to(&m_max_iterations)
+      .mark_basic();
+
+    m_self.options().add("tolerance", m_tolerance)
+      .pretty_name("Tolerance")
+      .description("Convergence criterion on the residual norm, relative to the norm of the right hand side")
+      .link_to(&m_tolerance)
+      .mark_basic();
+
+    m_self.options().add("gmres_restart", m_gmres_restart)
+      .pretty_name("GMRES Restart")
+      .description("Size of the Krylov subspace after which GMRES restarts")
+      .link_to(&m_gmres_restart);
+
+    m_self.options().add("preconditioner_reset", m_preconditioner_reset)
+      .pretty_name("Preconditioner Reset")
+      .description("Number of solves after which the preconditioner is rebuilt")
+      .link_to(&m_preconditioner_reset)
+      .mark_basic();
+
+    m_self.options().add("verbosity_level", 1)
+      .pretty_name("Verbosity Level")
+      .description("0: silent, 1: print a summary after each solve, 2: print the residual at each iteration")
+      .mark_basic();
+
+    m_self.options().add("compute_residual", false)
+      .pretty_name("Compute Residual")
+      .description("Indicate if the true residual should be computed and printed after each solve. This incurs an extra matrix application")
+      .mark_basic();
+
+    m_self.properties().add("iterations", Uint(0));
+    m_self.properties().add("relative_residual", Real(0.));
+    m_self.properties().add("converged", false);
+
+    trigger_preconditioner();
+  }
+
+  void trigger_solver()
+  {
+    m_basis.clear();
+  }
+
+  void trigger_preconditioner()
+  {
+    if(m_preconditioner_type == "ILU0")
+      m_preconditioner.reset(new detail::ILU0Preconditioner());
+    else if(m_preconditioner_type == "BlockJacobi")
+      m_preconditioner.reset(new detail::BlockJacobiPreconditioner(false));
+    else if(m_preconditioner_type == "Jacobi")
+      m_preconditioner.reset(new detail::BlockJacobiPreconditioner(true));
+    else
+      m_preconditioner.reset();
+    m_solve_count = 0;
+  }
+
+  void check_setup()
+  {
+    if(is_null(m_crs_matrix) && is_null(m_operator_matrix))
+      throw common::SetupError(FromHere(), "Null matrix for " + m_self.uri().path());
+
+    if(is_null(m_rhs))
+      throw common::SetupError(FromHere(), "Null RHS for " + m_self.uri().path());
+
+    if(is_null(m_solution))
+      throw common::SetupError(FromHere(), "Null solution vector for " + m_self.uri().path());
+  }
+
+  /// Number of owned entries, i.e. the length of all work vectors
+  Uint size() const
+  {
+    return m_solution->nb_owned_entries();
+  }
+
+  /// out = M^-1 in
+  void precondition(const std::vector<Real>& in, std::vector<Real>& out) const
+  {
+    if(in.empty())
+      return;
+    if(m_preconditioner)
+      m_preconditioner->apply(&in[0], &out[0]);
+    else
+      std::copy(in.begin(), in.end(), out.begin());
+  }
+
+  /// y = A x, collective in parallel
+  void multiply(const std::vector<Real>& x, std::vector<Real>& y) const
+  {
+    if(is_not_null(m_crs_matrix))
+      m_crs_matrix->multiply(x.empty() ? 0 : &x[0], y.empty() ? 0 : &y[0]);
+    else
+      m_operator_matrix->multiply(x.empty() ? 0 : &x[0], y.empty() ? 0 : &y[0]);
+  }
+
+  /// Dot product over all processes
+  static Real dot(const std::vector<Real>& a, const std::vector<Real>& b)
+  {
+    const int size = a.size();
+    Real result = 0.;
+    #pragma omp parallel for schedule(static) reduction(+:result)
+    for(int i = 0; i < size; ++i)
+      result += a[i]*b[i];
+    return native_global_sum(result);
+  }
+
+  static Real norm(const std::vector<Real>& a)
+  {
+    return std::sqrt(dot(a, a));
+  }
+
+  /// y += alpha*x
+  static void axpy(const Real alpha, const std::vector<Real>& x, std::vector<Real>& y)
+  {
+    const int size = x.size();
+    #pragma omp parallel for schedule(static)
+    for(int i = 0; i < size; ++i)
+      y[i] += alpha*x[i];
+  }
+
+  /// r = b - A x
+  void residual(const std::vector<Real>& x, std::vector<Real>& r)
+  {
+    multiply(x, r);
+    const std::vector<Real>& b = m_rhs->data();
+    const int size = r.size();
+    #pragma omp parallel for schedule(static)
+    for(int i = 0; i < size; ++i)
+      r[i] = b[i] - r[i];
+  }
+
+  void solve()
+  {
+    check_setup();
+
+    const Uint n = size();
+    if(m_preconditioner && (m_solve_count % std::max(m_preconditioner_reset, Uint(1)) == 0))
+    {
+      if(is_not_null(m_crs_matrix))
+        m_preconditioner->setup(*m_crs_matrix);
+      else
+        m_preconditioner->setup(*m_operator_matrix);
+    }
+
+    // Work on a copy of the owned part of the solution, so the ghosts stay untouched until the final sync
+    std::vector<Real> x(m_solution->data().begin(), m_solution->data().begin() + n);
+    std::vector<Real> b(m_rhs->data().begin(), m_rhs->data().begin() + n);
+    Real b_norm = norm(b);
+    if(b_norm == 0.)
+      b_norm = 1.;
+
+    m_iterations = 0;
+    m_relative_residual = 0.;
+    m_converged = false;
+    if(m_solver == "CG")
+      solve_cg(x, b_norm);
+    else if(m_solver == "BiCGStab")
+      solve_bicgstab(x, b_norm);
+    else
+      solve_gmres(x, b_norm);
+
+    std::copy(x.begin(), x.end(), m_solution->data().begin());
+    m_solution->sync();
+    ++m_solve_count;
+
+    m_self.properties()["iterations"] = m_iterations;
+    m_self.properties()["relative_residual"] = m_relative_residual;
+    m_self.properties()["converged"] = m_converged;
+
+    if(m_self.options().value<int>("verbosity_level") > 0)
+    {
+      CFinfo << m_self.uri().path() << ": " << m_solver << " with preconditioner " << m_preconditioner_type
+             << (m_converged ? " converged in " : " did not converge after ") << m_iterations << " iterations, relative residual " << m_relative_residual << CFendl;
+    }
+    else if(!m_converged)
+    {
+      CFwarn << m_self.uri().path() << ": " << m_solver << " did not converge after " << m_iterations << " iterations, relative residual " << m_relative_residual << CFendl;
+    }
+
+    if(m_self.options().value<bool>("compute_residual"))
+      CFinfo << "Solver residual: " << compute_residual() << CFendl;
+  }
+
+  /// Track convergence, returns true if converged
+  bool check_convergence(const Real residual_norm, const Real b_norm)
+  {
+    m_relative_residual = residual_norm / b_norm;
+    if(m_self.options().value<int>("verbosity_level") > 1)
+      CFinfo << "  iteration " << m_iterations << ": relative residual " << m_relative_residual << CFendl;
+    m_converged = m_relative_residual <= m_tolerance;
+    return m_converged;
+  }
+
+  void solve_cg(std::vector<Real>& x, const Real b_norm)
+  {
+    const Uint n = x.size();
+    std::vector<Real> r(n), z(n), p(n), q(n);
+    residual(x, r);
+    precondition(r, z);
+    p = z;
+    Real rz = dot(r, z);
+
+    while(!check_convergence(norm(r), b_norm) && m_iterations < m_max_iterations)
+    {
+      multiply(p, q);
+      const Real pq = dot(p, q);
+      if(pq == 0.)
+        break;
+      const Real alpha = rz / pq;
+      axpy(alpha, p, x);
+      axpy(-alpha, q, r);
+      precondition(r, z);
+      const Real rz_new = dot(r, z);
+      const Real beta = rz_new / rz;
+      rz = rz_new;
+      const int size = n;
+      #pragma omp parallel for schedule(static)
+      for(int i = 0; i < size; ++i)
+        p[i] = z[i] + beta*p[i];
+      ++m_iterations;
+    }
+  }
+
+  void solve_bicgstab(std::vector<Real>& x, const Real b_norm)
+  {
+    const Uint n = x.size();
+    std::vector<Real> r(n), r0(n), p(n, 0.), v(n, 0.), p_hat(n), s(n), s_hat(n), t(n);
+    residual(x, r);
+    r0 = r;
+    Real rho = 1., alpha = 1., omega = 1.;
+
+    while(!check_convergence(norm(r), b_norm) && m_iterations < m_max_iterations)
+    {
+      const Real rho_new = dot(r0, r);
+      if(rho_new == 0. || omega == 0.)
+      {
+        CFwarn << m_self.uri().path() << ": BiCGStab breakdown at iteration " << m_iterations << CFendl;
+        break;
+      }
+      const Real beta = (rho_new/rho)*(alpha/omega);
+      rho = rho_new;
+      const int size = n;
+      #pragma omp parallel for schedule(static)
+      for(int i = 0; i < size; ++i)
+        p[i] = r[i] + beta*(p[i] - omega*v[i]);
+
+      precondition(p, p_hat);
+      multiply(p_hat, v);
+      alpha = rho / dot(r0, v);
+      axpy(alpha, p_hat, x);
+      #pragma omp parallel for schedule(static)
+      for(int i = 0; i < size; ++i)
+        s[i] = r[i] - alpha*v[i];
+
+      ++m_iterations;
+      if(check_convergence(norm(s), b_norm))
+      {
+        r.swap(s);
+        break;
+      }
+
+      precondition(s, s_hat);
+      multiply(s_hat, t);
+      const Real tt = dot(t, t);
+      omega = tt == 0. ? 0. : dot(t, s) / tt;
+      axpy(omega, s_hat, x);
+      #pragma omp parallel for schedule(static)
+      for(int i = 0; i < size; ++i)
+        r[i] = s[i] - omega*t[i];
+    }
+  }
+
+  void solve_gmres(std::vector<Real>& x, const Real b_norm)
+  {
+    const Uint n = x.size();
+    const Uint m = std::max(m_gmres_restart, Uint(1));
+    m_basis.resize(m+1);
+    for(Uint i = 0; i != m+1; ++i)
+      m_basis[i].resize(n);
+
+    std::vector<Real> w(n), z(n);
+    std::vector<Real> hessenberg((m+1)*m), g(m+1), cs(m), sn(m), y(m);
+
+    residual(x, m_basis[0]);
+    Real beta = norm(m_basis[0]);
+    while(!check_convergence(beta, b_norm) && m_iterations < m_max_iterations)
+    {
+      for(Uint i = 0; i != n; ++i)
+        m_basis[0][i] /= beta;
+      std::fill(g.begin(), g.end(), 0.);
+      g[0] = beta;
+
+      Uint k = 0;
+      while(k != m && m_iterations < m_max_iterations)
+      {
+        precondition(m_basis[k], z);
+        multiply(z, w);
+
+        // Modified Gram-Schmidt
+        for(Uint i = 0; i <= k; ++i)
+        {
+          const Real h = dot(w, m_basis[i]);
+          hessenberg[i*m+k] = h;
+          axpy(-h, m_basis[i], w);
+        }
+        const Real h_next = norm(w);
+        hessenberg[(k+1)*m+k] = h_next;
+        if(h_next != 0.)
+        {
+          for(Uint i = 0; i != n; ++i)
+            m_basis[k+1][i] = w[i] / h_next;
+        }
+
+        // Apply the previous Givens rotations to the new column, then compute the new one
+        for(Uint i = 0; i != k; ++i)
+        {
+          const Real h_i = hessenberg[i*m+k];
+          const Real h_i1 = hessenberg[(i+1)*m+k];
+          hessenberg[i*m+k] = cs[i]*h_i + sn[i]*h_i1;
+          hessenberg[(i+1)*m+k] = -sn[i]*h_i + cs[i]*h_i1;
+        }
+        const Real h_kk = hessenberg[k*m+k];
+        const Real denom = std::sqrt(h_kk*h_kk + h_next*h_next);
+        cs[k] = denom == 0. ? 1. : h_kk / denom;
+        sn[k] = denom == 0. ? 0. : h_next / denom;
+        hessenberg[k*m+k] = denom;
+        hessenberg[(k+1)*m+k] = 0.;
+        g[k+1] = -sn[k]*g[k];
+        g[k] = cs[k]*g[k];
+
+        ++k;
+        ++m_iterations;
+        if(check_convergence(std::abs(g[k]), b_norm) || h_next == 0.)
+          break;
+      }
+
+      // Solve the upper triangular system and update x += M^-1 (V y)
+      for(Uint i = k; i != 0; --i)
+      {
+        const Uint row = i-1;
+        Real sum = g[row];
+        for(Uint j = row+1; j != k; ++j)
+          sum -= hessenberg[row*m+j]*y[j];
+        y[row] = sum / hessenberg[row*m+row];
+      }
+      std::fill(w.begin(), w.end(), 0.);
+      for(Uint i = 0; i != k; ++i)
+        axpy(y[i], m_basis[i], w);
+      precondition(w, z);
+      axpy(1., z, x);
+
+      // Recompute the true residual for the restart
+      residual(x, m_basis[0]);
+      beta = norm(m_basis[0]);
+      if(m_converged)
+      {
+        check_convergence(beta, b_norm);
+        break;
+      }
+    }
+  }
+
+  Real compute_residual()
+  {
+    check_setup();
+    const Uint n = size();
+    std::vector<Real> x(m_solution->data().begin(), m_solution->data().begin() + n);
+    std::vector<Real> r(n);
+    residual(x, r);
+    return norm(r);
+  }
+
+  common::Component& m_self;
+
+  /// Exactly one of both is set, depending on the type of the matrix
+  Handle<NativeCrsMatrix> m_crs_matrix;
+  Handle<NativeOperatorMatrix> m_operator_matrix;
+  Handle<NativeVector> m_rhs;
+  Handle<NativeVector> m_solution;
+
+  std::string m_solver;
+  std::string m_preconditioner_type;
+  Uint m_max_iterations;
+  Real m_tolerance;
+  Uint m_gmres_restart;
+  Uint m_preconditioner_reset;
+
+  boost::scoped_ptr<detail::Preconditioner> m_preconditioner;
+  Uint m_solve_count;
+
+  /// GMRES Krylov basis, kept between solves to avoid reallocation
+  std::vector< std::vector<Real> > m_basis;
+
+  Uint m_iterations;
+  Real m_relative_residual;
+  bool m_converged;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+NativeKrylovStrategy::NativeKrylovStrategy(const std::string& name) :
+  SolutionStrategy(name),
+  m_implementation(new Implementation(*this))
+{
+}
+
+NativeKrylovStrategy::~NativeKrylovStrategy()
+{
+}
+
+void NativeKrylovStrategy::set_matrix(const Handle< Matrix >& matrix)
+{
+  m_implementation->m_crs_matrix = Handle<NativeCrsMatrix>(matrix);
+  m_implementation->m_operator_matrix = Handle<NativeOperatorMatrix>(matrix);
+  m_implementation->m_solve_count = 0;
+}
+
+void NativeKrylovStrategy::set_rhs(const Handle< Vector >& rhs)
+{
+  m_implementation->m_rhs = Handle<NativeVector>(rhs);
+}
+
+void NativeKrylovStrategy::set_solution(const Handle< Vector >& solution)
+{
+  m_implementation->m_solution = Handle<NativeVector>(solution);
+}
+
+void NativeKrylovStrategy::solve()
+{
+  m_implementation->solve();
+}
+
+Real NativeKrylovStrategy::compute_residual()
+{
+  return m_implementation->compute_residual();
+}
+
+void NativeKrylovStrategy::set_coordinates(common::PE::CommPattern& cp, const common::Table< Real >& coords, const common::List< Uint >& used_nodes, const std::vector< bool >& periodic_links_active)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace LSS
+} // namespace math
+} // namespace cf3
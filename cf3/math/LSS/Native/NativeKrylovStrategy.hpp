@@ -0,0 +1,68 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_Math_LSS_NativeKrylovStrategy_hpp
+#define cf3_Math_LSS_NativeKrylovStrategy_hpp
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <boost/scoped_ptr.hpp>
+
+#include "math/LSS/SolutionStrategy.hpp"
+#include "math/LSS/LibLSS.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ *  @file NativeKrylovStrategy.hpp Krylov solvers for the native LSS backend
+ *
+ *  Solves systems built from NativeCrsMatrix and NativeVector using CG, BiCGStab or restarted GMRES,
+ *  preconditioned with Jacobi, block-Jacobi or block ILU(0). In parallel the preconditioners act
+ *  on the process-local part of the matrix only (additive Schwarz without overlap).
+ *  Matrix-free systems using NativeOperatorMatrix are supported as well, with Jacobi preconditioning
+ *  based on the assembled diagonal or without preconditioner.
+ **/
+////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace math {
+namespace LSS {
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+class LSS_API NativeKrylovStrategy : public SolutionStrategy
+{
+public:
+
+  /// Default constructor
+  NativeKrylovStrategy(const std::string& name);
+
+  ~NativeKrylovStrategy();
+
+  /// name of the type
+  static std::string type_name () { return "NativeKrylovStrategy"; }
+
+  void set_matrix(const Handle<LSS::Matrix>& matrix);
+  void set_rhs(const Handle<LSS::Vector>& rhs);
+  void set_solution(const Handle<LSS::Vector>& solution);
+  void solve();
+  Real compute_residual();
+
+  /// Coordinates are not used by any of the native preconditioners
+  virtual void set_coordinates(common::PE::CommPattern& cp, const common::Table< Real >& coords, const common::List< Uint >& used_nodes, const std::vector< bool >& periodic_links_active);
+
+private:
+  struct Implementation;
+  boost::scoped_ptr<Implementation> m_implementation;
+}; // end of class NativeKrylovStrategy
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace LSS
+} // namespace math
+} // namespace cf3
+
+#endif // cf3_Math_LSS_NativeKrylovStrategy_hpp
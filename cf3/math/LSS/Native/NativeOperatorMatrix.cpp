@@ -0,0 +1,471 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <fstream>
+
+#include "common/Assertions.hpp"
+#include "common/BasicExceptions.hpp"
+#include "common/Builder.hpp"
+#include "common/Log.hpp"
+#include "common/PE/Comm.hpp"
+#include "common/PE/CommPattern.hpp"
+#include "common/PropertyList.hpp"
+
+#include "math/VariablesDescriptor.hpp"
+#include "math/LSS/Native/NativeDetail.hpp"
+#include "math/LSS/Native/NativeOperatorMatrix.hpp"
+#include "math/LSS/Native/NativeVector.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+  @file NativeOperatorMatrix.cpp implementation of LSS::NativeOperatorMatrix
+**/
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+using namespace cf3;
+using namespace cf3::math;
+using namespace cf3::math::LSS;
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+common::ComponentBuilder < LSS::NativeOperatorMatrix, LSS::Matrix, LSS::LibLSS > NativeOperatorMatrix_Builder;
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+NativeOperatorMatrix::NativeOperatorMatrix(const std::string& name) :
+  LSS::Matrix(name),
+  m_is_created(false),
+  m_neq(0),
+  m_nb_owned_blocks(0)
+{
+  properties().add("vector_type", std::string("cf3.math.LSS.NativeVector"));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeOperatorMatrix::create(cf3::common::PE::CommPattern& cp, const Uint neq, const std::vector<Uint>& node_connectivity, const std::vector<Uint>& starting_indices, LSS::Vector& solution, LSS::Vector& rhs, const std::vector<Uint>& periodic_links_nodes, const std::vector<bool>& periodic_links_active)
+{
+  if (m_is_created) destroy();
+
+  m_neq = neq;
+
+  std::vector<Uint> block_gids, block_ranks;
+  create_native_block_map(cp, m_p2m, block_gids, block_ranks, m_nb_owned_blocks, periodic_links_nodes, periodic_links_active);
+
+  m_diagonal.assign(m_nb_owned_blocks*m_neq, 0.);
+  m_constrained.assign(m_nb_owned_blocks*m_neq, false);
+
+  m_x = common::allocate_component<NativeVector>("OperatorInput");
+  m_y = common::allocate_component<NativeVector>("OperatorOutput");
+  m_x->create(cp, neq, periodic_links_nodes, periodic_links_active);
+  m_y->create(cp, neq, periodic_links_nodes, periodic_links_active);
+
+  m_is_created = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeOperatorMatrix::create_blocked(common::PE::CommPattern& cp, const VariablesDescriptor& vars, const std::vector< Uint >& node_connectivity, const std::vector< Uint >& starting_indices, Vector& solution, Vector& rhs, const std::vector<Uint>& periodic_links_nodes, const std::vector<bool>& periodic_links_active)
+{
+  create(cp, vars.size(), node_connectivity, starting_indices, solution, rhs, periodic_links_nodes, periodic_links_active);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeOperatorMatrix::destroy()
+{
+  m_x.reset();
+  m_y.reset();
+  m_p2m.clear();
+  m_diagonal.clear();
+  m_constrained.clear();
+  m_neq=0;
+  m_nb_owned_blocks=0;
+  m_is_created=false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+int NativeOperatorMatrix::diagonal_index(const Uint inode, const Uint ieq) const
+{
+  cf3_assert(inode < m_p2m.size());
+  const Uint block_row = m_p2m[inode];
+  if(block_row >= m_nb_owned_blocks)
+    return -1;
+  return block_row*m_neq + ieq;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeOperatorMatrix::set_value(const Uint icol, const Uint irow, const Real value)
+{
+  cf3_assert(m_is_created);
+  if(icol != irow)
+    throw common::NotSupported(FromHere(), "Only diagonal entries can be set in matrix-free matrix " + uri().path());
+  const int idx = diagonal_index(irow/m_neq, irow%m_neq);
+  if(idx >= 0)
+    m_diagonal[idx] = value;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeOperatorMatrix::add_value(const Uint icol, const Uint irow, const Real value)
+{
+  cf3_assert(m_is_created);
+  if(icol != irow)
+    throw common::NotSupported(FromHere(), "Only diagonal entries can be modified in matrix-free matrix " + uri().path());
+  const int idx = diagonal_index(irow/m_neq, irow%m_neq);
+  if(idx >= 0)
+    m_diagonal[idx] += value;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeOperatorMatrix::get_value(const Uint icol, const Uint irow, Real& value)
+{
+  cf3_assert(m_is_created);
+  if(icol != irow)
+    throw common::NotSupported(FromHere(), "Only diagonal entries are stored in matrix-free matrix " + uri().path());
+  const int idx = diagonal_index(irow/m_neq, irow%m_neq);
+  value = idx >= 0 ? m_diagonal[idx] : 0.;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeOperatorMatrix::set_values(const BlockAccumulator& values)
+{
+  cf3_assert(m_is_created);
+  const Uint nb_nodes = values.indices.size();
+  cf3_assert(values.mat.rows() == nb_nodes*m_neq);
+  for(Uint i = 0; i != nb_nodes; ++i)
+  {
+    for(Uint a = 0; a != m_neq; ++a)
+    {
+      const int idx = diagonal_index(values.indices[i], a);
+      if(idx >= 0)
+        m_diagonal[idx] = values.mat(i*m_neq+a, i*m_neq+a);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeOperatorMatrix::add_values(const BlockAccumulator& values)
+{
+  cf3_assert(m_is_created);
+  const Uint nb_nodes = values.indices.size();
+  cf3_assert(values.mat.rows() == nb_nodes*m_neq);
+  for(Uint i = 0; i != nb_nodes; ++i)
+  {
+    for(Uint a = 0; a != m_neq; ++a)
+    {
+      const int idx = diagonal_index(values.indices[i], a);
+      if(idx >= 0)
+        m_diagonal[idx] += values.mat(i*m_neq+a, i*m_neq+a);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeOperatorMatrix::get_values(BlockAccumulator& values)
+{
+  cf3_assert(m_is_created);
+  values.mat.setZero();
+  const Uint nb_nodes = values.indices.size();
+  for(Uint i = 0; i != nb_nodes; ++i)
+  {
+    for(Uint a = 0; a != m_neq; ++a)
+    {
+      const int idx = diagonal_index(values.indices[i], a);
+      if(idx >= 0)
+        values.mat(i*m_neq+a, i*m_neq+a) = m_diagonal[idx];
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeOperatorMatrix::set_row(const Uint iblockrow, const Uint ieq, Real diagval, Real offdiagval)
+{
+  cf3_assert(m_is_created);
+  if(offdiagval != 0.)
+    throw common::NotSupported(FromHere(), "Matrix-free matrix " + uri().path() + " only supports set_row with zero off-diagonal values");
+  const int idx = diagonal_index(iblockrow, ieq);
+  if(idx < 0)
+    return;
+  m_diagonal[idx] = diagval;
+  m_constrained[idx] = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeOperatorMatrix::get_column_and_replace_to_zero(const Uint iblockcol, Uint ieq, std::vector<Real>& values)
+{
+  throw common::NotSupported(FromHere(), "get_column_and_replace_to_zero is not possible for matrix-free matrix " + uri().path());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeOperatorMatrix::symmetric_dirichlet(const Uint blockrow, const Uint ieq, const Real value, Vector& rhs)
+{
+  throw common::NotSupported(FromHere(), "symmetric_dirichlet is not possible for matrix-free matrix " + uri().path() + ", use set_row instead");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeOperatorMatrix::tie_blockrow_pairs (const Uint iblockrow_to, const Uint iblockrow_from)
+{
+  throw common::NotSupported(FromHere(), "tie_blockrow_pairs is not possible for matrix-free matrix " + uri().path());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeOperatorMatrix::set_diagonal(const std::vector<Real>& diag)
+{
+  cf3_assert(m_is_created);
+  cf3_assert(diag.size() == m_p2m.size()*m_neq);
+  const Uint nb_nodes = m_p2m.size();
+  for(Uint i = 0; i != nb_nodes; ++i)
+  {
+    for(Uint e = 0; e != m_neq; ++e)
+    {
+      const int idx = diagonal_index(i, e);
+      if(idx >= 0)
+        m_diagonal[idx] = diag[i*m_neq+e];
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeOperatorMatrix::add_diagonal(const std::vector<Real>& diag)
+{
+  cf3_assert(m_is_created);
+  cf3_assert(diag.size() == m_p2m.size()*m_neq);
+  const Uint nb_nodes = m_p2m.size();
+  for(Uint i = 0; i != nb_nodes; ++i)
+  {
+    for(Uint e = 0; e != m_neq; ++e)
+    {
+      const int idx = diagonal_index(i, e);
+      if(idx >= 0)
+        m_diagonal[idx] += diag[i*m_neq+e];
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeOperatorMatrix::get_diagonal(std::vector<Real>& diag)
+{
+  cf3_assert(m_is_created);
+  const Uint nb_nodes = m_p2m.size();
+  diag.resize(nb_nodes*m_neq);
+  for(Uint i = 0; i != nb_nodes; ++i)
+  {
+    for(Uint e = 0; e != m_neq; ++e)
+    {
+      const int idx = diagonal_index(i, e);
+      diag[i*m_neq+e] = idx >= 0 ? m_diagonal[idx] : 0.;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeOperatorMatrix::reset(Real reset_to)
+{
+  cf3_assert(m_is_created);
+  m_diagonal.assign(m_diagonal.size(), reset_to);
+  m_constrained.assign(m_constrained.size(), false);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeOperatorMatrix::clone_to(Matrix &other)
+{
+  if(!m_is_created)
+    throw common::SetupError(FromHere(), "Matrix to clone " + uri().string() + " is not created");
+
+  NativeOperatorMatrix* other_ptr = dynamic_cast<NativeOperatorMatrix*>(&other);
+  if(is_null(other_ptr))
+    throw common::SetupError(FromHere(), "clone_to method of NativeOperatorMatrix needs another NativeOperatorMatrix, but a " + other.derived_type_name() + " was supplied instead.");
+
+  other_ptr->destroy();
+  other_ptr->m_is_created = m_is_created;
+  other_ptr->m_neq = m_neq;
+  other_ptr->m_nb_owned_blocks = m_nb_owned_blocks;
+  other_ptr->m_p2m = m_p2m;
+  other_ptr->m_diagonal = m_diagonal;
+  other_ptr->m_constrained = m_constrained;
+  other_ptr->m_operator = m_operator;
+  other_ptr->m_x = common::allocate_component<NativeVector>("OperatorInput");
+  other_ptr->m_y = common::allocate_component<NativeVector>("OperatorOutput");
+  m_x->clone_to(*other_ptr->m_x);
+  m_y->clone_to(*other_ptr->m_y);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeOperatorMatrix::read_native(const common::URI& file)
+{
+  throw common::NotImplemented(FromHere(), "read_native is not implemented for NativeOperatorMatrix");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeOperatorMatrix::print(common::LogStream& stream)
+{
+  if (m_is_created)
+  {
+    std::vector<Uint> row_indices, col_indices;
+    std::vector<Real> values;
+    debug_data(row_indices, col_indices, values);
+    const Uint nb_entries = values.size();
+    for(Uint i = 0; i != nb_entries; ++i)
+      stream << row_indices[i] << " " << -static_cast<int>(col_indices[i]) << " " << values[i] << CFendl;
+    stream << "# name:                 " << name() << "\n";
+    stream << "# type_name:            " << type_name() << "\n";
+    stream << "# process:              " << common::PE::Comm::instance().rank() << "\n";
+    stream << "# number of equations:  " << m_neq << "\n";
+    stream << "# number of rows:       " << m_nb_owned_blocks*m_neq << "\n";
+    stream << "# number of block rows: " << m_nb_owned_blocks << "\n";
+    stream << "# operator set:         " << (has_operator() ? "yes" : "no") << "\n";
+  } else {
+    stream << name() << " of type " << type_name() << "::is_created() is false, nothing is printed.";
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeOperatorMatrix::print(std::ostream& stream)
+{
+  if (m_is_created)
+  {
+    std::vector<Uint> row_indices, col_indices;
+    std::vector<Real> values;
+    debug_data(row_indices, col_indices, values);
+    const Uint nb_entries = values.size();
+    for(Uint i = 0; i != nb_entries; ++i)
+      stream << col_indices[i] << " " << -static_cast<int>(row_indices[i]) << " " << values[i] << "\n";
+    stream << "# name:                 " << name() << "\n";
+    stream << "# type_name:            " << type_name() << "\n";
+    stream << "# process:              " << common::PE::Comm::instance().rank() << "\n";
+    stream << "# number of equations:  " << m_neq << "\n";
+    stream << "# number of rows:       " << m_nb_owned_blocks*m_neq << "\n";
+    stream << "# number of block rows: " << m_nb_owned_blocks << "\n";
+    stream << "# operator set:         " << (has_operator() ? "yes" : "no") << "\n" << std::flush;
+  } else {
+    stream << name() << " of type " << type_name() << "::is_created() is false, nothing is printed.";
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeOperatorMatrix::print(const std::string& filename, std::ios_base::openmode mode )
+{
+  std::ofstream stream(filename.c_str(),mode);
+  stream << "VARIABLES=COL,ROW,VAL\n" << std::flush;
+  stream << "ZONE T=\"" << type_name() << "::" << name() <<  "\"\n" << std::flush;
+  print(stream);
+  stream.close();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeOperatorMatrix::print_native(std::ostream& stream)
+{
+  const Uint nb_rows = m_diagonal.size();
+  for(Uint row = 0; row != nb_rows; ++row)
+    stream << row << " : " << m_diagonal[row] << (m_constrained[row] ? " constrained" : "") << "\n";
+  stream << std::flush;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeOperatorMatrix::debug_data(std::vector<Uint>& row_indices, std::vector<Uint>& col_indices, std::vector<Real>& values)
+{
+  row_indices.clear(); col_indices.clear(); values.clear();
+  const Uint nb_rows = m_diagonal.size();
+  row_indices.reserve(nb_rows); col_indices.reserve(nb_rows); values.reserve(nb_rows);
+
+  // first node that maps onto each owned block
+  const Uint nb_nodes = m_p2m.size();
+  std::vector<Uint> m2p(m_nb_owned_blocks, nb_nodes);
+  for(Uint i = nb_nodes; i != 0; --i)
+  {
+    if(m_p2m[i-1] < static_cast<int>(m_nb_owned_blocks))
+      m2p[m_p2m[i-1]] = i-1;
+  }
+
+  for(Uint row = 0; row != m_nb_owned_blocks; ++row)
+  {
+    for(Uint a = 0; a != m_neq; ++a)
+    {
+      row_indices.push_back(m2p[row]*m_neq+a);
+      col_indices.push_back(m2p[row]*m_neq+a);
+      values.push_back(m_diagonal[row*m_neq+a]);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeOperatorMatrix::set_operator(const OperatorT& op)
+{
+  m_operator = op;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeOperatorMatrix::multiply(const Real* x, Real* y)
+{
+  cf3_assert(m_is_created);
+  if(m_operator.empty())
+    throw common::SetupError(FromHere(), "No operator was set for matrix-free matrix " + uri().path());
+
+  const Uint nb_rows = m_nb_owned_blocks*m_neq;
+  std::copy(x, x + nb_rows, m_x->data().begin());
+  m_x->sync();
+  m_y->reset(0.);
+
+  m_operator(*m_y, *m_x);
+
+  const std::vector<Real>& y_data = m_y->data();
+  for(Uint i = 0; i != nb_rows; ++i)
+    y[i] = m_constrained[i] ? m_diagonal[i]*x[i] : y_data[i];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeOperatorMatrix::apply(const Handle< Vector >& y, const Handle< Vector const >& x, const Real alpha, const Real beta)
+{
+  Handle<NativeVector> y_nat(y);
+  Handle<NativeVector const> x_nat(x);
+
+  if(is_null(y_nat) || is_null(x_nat))
+    throw common::SetupError(FromHere(), "NativeOperatorMatrix::apply must be given NativeVector arguments");
+
+  cf3_assert(x_nat->nb_owned_entries() == m_nb_owned_blocks*m_neq);
+  cf3_assert(y_nat->nb_owned_entries() == m_nb_owned_blocks*m_neq);
+
+  // multiply is collective in parallel, so it must be called even if there are no local rows
+  const Uint nb_rows = m_nb_owned_blocks*m_neq;
+  std::vector<Real> ax(nb_rows);
+  multiply(x_nat->data().empty() ? 0 : &x_nat->data()[0], ax.empty() ? 0 : &ax[0]);
+
+  std::vector<Real>& y_data = y_nat->data();
+  for(Uint i = 0; i != nb_rows; ++i)
+    y_data[i] = alpha*ax[i] + (beta == 0. ? 0. : beta*y_data[i]);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
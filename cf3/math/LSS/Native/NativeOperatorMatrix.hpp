@@ -0,0 +1,235 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_Math_LSS_NativeOperatorMatrix_hpp
+#define cf3_Math_LSS_NativeOperatorMatrix_hpp
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "math/LSS/LibLSS.hpp"
+#include "math/LSS/BlockAccumulator.hpp"
+#include "math/LSS/Vector.hpp"
+#include "math/LSS/Matrix.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+  @file NativeOperatorMatrix.hpp definition of LSS::NativeOperatorMatrix
+
+  Matrix-free matrix of the native LSS backend. The product with a vector is delegated to a user supplied
+  operator, e.g. an element loop that computes y += A_e x_e on the fly, so the matrix itself is never stored.
+  Only the diagonal is kept: it is filled by assembling element matrices with add_values, and used by the
+  Jacobi preconditioner of NativeKrylovStrategy. Rows set with set_row (Dirichlet conditions) replace the
+  result of the operator by diagval*x.
+**/
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace math {
+namespace LSS {
+
+class NativeVector;
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+class LSS_API NativeOperatorMatrix : public LSS::Matrix {
+public:
+
+  /// Signature of the operator: add A*x to y. The ghosts of x are synchronized and y is zero on entry.
+  typedef boost::function<void (Vector& y, const Vector& x)> OperatorT;
+
+  /// @name CREATION, DESTRUCTION AND COMPONENT SYSTEM
+  //@{
+
+  /// name of the type
+  static std::string type_name () { return "NativeOperatorMatrix"; }
+
+  /// Accessor to solver type
+  const std::string solvertype() { return "Native"; }
+
+  /// Accessor to the flag if matrix, solution and rhs are tied together or not
+  const bool is_swappable(const LSS::Vector& solution, const LSS::Vector& rhs) { return true; }
+
+  /// Default constructor
+  NativeOperatorMatrix(const std::string& name);
+
+  /// Setup the vector layout. The connectivity is not used, since there is no sparsity structure to store.
+  void create(cf3::common::PE::CommPattern& cp, const Uint neq, const std::vector<Uint>& node_connectivity, const std::vector<Uint>& starting_indices, LSS::Vector& solution, LSS::Vector& rhs, const std::vector<Uint>& periodic_links_nodes = std::vector<Uint>(), const std::vector<bool>& periodic_links_active = std::vector<bool>());
+
+  /// The native backend always interleaves the variables per node, so this is equivalent to create with vars.size() equations
+  void create_blocked(common::PE::CommPattern& cp, const VariablesDescriptor& vars, const std::vector< Uint >& node_connectivity, const std::vector< Uint >& starting_indices, Vector& solution, Vector& rhs, const std::vector<Uint>& periodic_links_nodes = std::vector<Uint>(), const std::vector<bool>& periodic_links_active = std::vector<bool>());
+
+  /// Deallocate underlying data
+  void destroy();
+
+  //@} END CREATION, DESTRUCTION AND COMPONENT SYSTEM
+
+  /// @name INDIVIDUAL ACCESS
+  //@{
+
+  /// Set value at given location in the matrix. Only diagonal entries can be set.
+  void set_value(const Uint icol, const Uint irow, const Real value);
+
+  /// Add value at given location in the matrix. Only diagonal entries can be modified.
+  void add_value(const Uint icol, const Uint irow, const Real value);
+
+  /// Get value at given location in the matrix. Only diagonal entries are available.
+  void get_value(const Uint icol, const Uint irow, Real& value);
+
+  //@} END INDIVIDUAL ACCESS
+
+  /// @name EFFICCIENT ACCESS
+  //@{
+
+  /// Set the diagonal entries of a list of values, the off-diagonal entries are ignored
+  void set_values(const BlockAccumulator& values);
+
+  /// Add the diagonal entries of a list of values, the off-diagonal entries are ignored.
+  /// Safe to call concurrently for element blocks that touch disjoint rows.
+  void add_values(const BlockAccumulator& values);
+
+  /// Get a list of values. Only the diagonal is known, the off-diagonal entries are set to zero.
+  void get_values(BlockAccumulator& values);
+
+  /// Replace the row by diagval on the diagonal. Only offdiagval equal to zero is supported.
+  void set_row(const Uint iblockrow, const Uint ieq, Real diagval, Real offdiagval);
+
+  /// Not supported, since the columns are not stored
+  void get_column_and_replace_to_zero(const Uint iblockcol, Uint ieq, std::vector<Real>& values);
+
+  /// Not supported, since the columns are not stored
+  void symmetric_dirichlet(const Uint blockrow, const Uint ieq, const Real value, Vector& rhs);
+
+  /// Not supported, periodicity must be handled through the periodic links at creation
+  void tie_blockrow_pairs (const Uint iblockrow_to, const Uint iblockrow_from);
+
+  /// Set the diagonal
+  void set_diagonal(const std::vector<Real>& diag);
+
+  /// Add to the diagonal
+  void add_diagonal(const std::vector<Real>& diag);
+
+  /// Get the diagonal
+  void get_diagonal(std::vector<Real>& diag);
+
+  /// Reset the diagonal and remove the rows set with set_row. The operator is kept.
+  void reset(Real reset_to=0.);
+
+  //@} END EFFICCIENT ACCESS
+
+  /// @name MISCELLANEOUS
+  //@{
+
+  /// Print to wherever
+  void print(common::LogStream& stream);
+
+  /// Print to wherever
+  void print(std::ostream& stream);
+
+  /// Print to file given by filename
+  void print(const std::string& filename, std::ios_base::openmode mode = std::ios_base::out );
+
+  /// Print the diagonal and the constrained rows
+  void print_native(std::ostream& stream);
+
+  /// Accessor to the state of create
+  const bool is_created() { return m_is_created; }
+
+  /// Accessor to the number of equations
+  const Uint neq() { cf3_assert(m_is_created); return m_neq; }
+
+  /// Accessor to the number of block rows
+  const Uint blockrow_size() { cf3_assert(m_is_created); return m_nb_owned_blocks; }
+
+  /// Accessor to the number of block columns
+  const Uint blockcol_size() { cf3_assert(m_is_created); return m_p2m.size(); }
+
+  void clone_to(Matrix& other);
+
+  void read_native(const common::URI& file);
+
+  //@} END MISCELLANEOUS
+
+  /// @name LINEAR ALGEBRA
+  //@{
+
+  /// Set the operator that computes the product with a vector
+  void set_operator(const OperatorT& op);
+
+  /// True if an operator was set
+  bool has_operator() const { return !m_operator.empty(); }
+
+  /// Compute y = alpha*A*x + beta*y
+  void apply(const Handle<Vector>& y, const Handle<Vector const>& x, const Real alpha = 1., const Real beta = 0.);
+
+  /// Compute y = A*x for the owned rows. x only needs valid owned entries, the ghosts are exchanged internally.
+  /// Both arrays are in the block numbering of NativeVector.
+  void multiply(const Real* x, Real* y);
+
+  //@} END LINEAR ALGEBRA
+
+  /// @name NATIVE ACCESS
+  //@{
+
+  /// Number of block rows owned by this process
+  Uint nb_owned_blocks() const { return m_nb_owned_blocks; }
+
+  /// Diagonal of the owned rows, in the block numbering of NativeVector
+  const std::vector<Real>& diagonal() const { return m_diagonal; }
+
+  //@} END NATIVE ACCESS
+
+  /// @name TEST ONLY
+  //@{
+
+  /// exports the diagonal into big linear arrays
+  /// @attention only for debug and utest purposes
+  void debug_data(std::vector<Uint>& row_indices, std::vector<Uint>& col_indices, std::vector<Real>& values);
+
+  //@} END TEST ONLY
+
+private:
+
+  /// Index in m_diagonal for the given node and equation, or -1 if the node is a ghost
+  int diagonal_index(const Uint inode, const Uint ieq) const;
+
+  /// state of creation
+  bool m_is_created;
+
+  /// number of equations
+  Uint m_neq;
+
+  /// number of block rows owned by this process
+  Uint m_nb_owned_blocks;
+
+  /// mapper array, maps from process local node numbering to the block numbering (owned first, then ghosts)
+  std::vector<int> m_p2m;
+
+  /// Diagonal of the owned rows
+  std::vector<Real> m_diagonal;
+
+  /// Flags the owned rows that were set using set_row
+  std::vector<bool> m_constrained;
+
+  /// Computes the product
+  OperatorT m_operator;
+
+  /// Work vectors passed to the operator, including the ghosts
+  boost::shared_ptr<NativeVector> m_x;
+  boost::shared_ptr<NativeVector> m_y;
+}; // end of class NativeOperatorMatrix
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace LSS
+} // namespace math
+} // namespace cf3
+
+#endif // cf3_Math_LSS_NativeOperatorMatrix_hpp
@@ -0,0 +1,435 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <fstream>
+
+#include "common/Assertions.hpp"
+#include "common/Builder.hpp"
+#include "common/Log.hpp"
+#include "common/PE/Comm.hpp"
+#include "common/PE/CommPattern.hpp"
+
+#include "math/VariablesDescriptor.hpp"
+#include "math/LSS/Native/NativeDetail.hpp"
+#include "math/LSS/Native/NativeVector.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+  @file NativeVector.cpp Implementation of the LSS::Vector interface for the native backend
+**/
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+using namespace cf3;
+using namespace cf3::math;
+using namespace cf3::math::LSS;
+
+common::ComponentBuilder < LSS::NativeVector, LSS::Vector, LSS::LibLSS > NativeVector_Builder;
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+NativeVector::NativeVector(const std::string& name) :
+  LSS::Vector(name),
+  m_neq(0),
+  m_blockrow_size(0),
+  m_nb_owned_blocks(0),
+  m_is_created(false)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::create(common::PE::CommPattern& cp, Uint neq, const std::vector<Uint>& periodic_links_nodes, const std::vector<bool>& periodic_links_active)
+{
+  if (m_is_created) destroy();
+
+  std::vector<Uint> block_gids, block_ranks;
+  create_native_block_map(cp, m_p2m, block_gids, block_ranks, m_nb_owned_blocks, periodic_links_nodes, periodic_links_active);
+
+  m_neq = neq;
+  m_blockrow_size = cp.isUpdatable().size();
+  m_data.assign(block_gids.size()*m_neq, 0.);
+
+  if(is_not_null(m_comm_pattern))
+    m_comm_pattern.reset();
+  m_comm_pattern = create_native_comm_pattern(block_gids, block_ranks);
+  if(is_not_null(m_comm_pattern))
+  {
+    m_wrapper_name = native_wrapper_name(*m_comm_pattern, name());
+    m_comm_pattern->insert(m_wrapper_name, m_data, m_neq, true);
+  }
+
+  m_is_created=true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::create_blocked(common::PE::CommPattern& cp, const VariablesDescriptor& vars, const std::vector<Uint>& periodic_links_nodes, const std::vector<bool>& periodic_links_active)
+{
+  create(cp, vars.size(), periodic_links_nodes, periodic_links_active);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::destroy()
+{
+  if(is_not_null(m_comm_pattern) && is_not_null(m_comm_pattern->get_child(m_wrapper_name)))
+    m_comm_pattern->remove_component(m_wrapper_name);
+  m_comm_pattern.reset();
+  m_wrapper_name.clear();
+  m_data.clear();
+  m_p2m.clear();
+  m_neq=0;
+  m_blockrow_size=0;
+  m_nb_owned_blocks=0;
+  m_is_created=false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::set_value(const Uint irow, const Real value)
+{
+  cf3_assert(m_is_created);
+  m_data[data_index(irow/m_neq, irow%m_neq)]=value;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::add_value(const Uint irow, const Real value)
+{
+  cf3_assert(m_is_created);
+  m_data[data_index(irow/m_neq, irow%m_neq)]+=value;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::get_value(const Uint irow, Real& value)
+{
+  cf3_assert(m_is_created);
+  value=m_data[data_index(irow/m_neq, irow%m_neq)];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::set_value(const Uint iblockrow, const Uint ieq, const Real value)
+{
+  cf3_assert(m_is_created);
+  m_data[data_index(iblockrow, ieq)]=value;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::add_value(const Uint iblockrow, const Uint ieq, const Real value)
+{
+  cf3_assert(m_is_created);
+  m_data[data_index(iblockrow, ieq)]+=value;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::get_value(const Uint iblockrow, const Uint ieq, Real& value)
+{
+  cf3_assert(m_is_created);
+  value=m_data[data_index(iblockrow, ieq)];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::set_rhs_values(const BlockAccumulator& values)
+{
+  cf3_assert(m_is_created);
+  const Uint nb_blocks = values.indices.size();
+  for(Uint i = 0; i != nb_blocks; ++i)
+  {
+    Real* block = &m_data[data_index(values.indices[i], 0)];
+    for(Uint j = 0; j != m_neq; ++j)
+      block[j] = values.rhs[i*m_neq+j];
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::add_rhs_values(const BlockAccumulator& values)
+{
+  cf3_assert(m_is_created);
+  const Uint nb_blocks = values.indices.size();
+  for(Uint i = 0; i != nb_blocks; ++i)
+  {
+    Real* block = &m_data[data_index(values.indices[i], 0)];
+    for(Uint j = 0; j != m_neq; ++j)
+      block[j] += values.rhs[i*m_neq+j];
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::get_rhs_values(BlockAccumulator& values)
+{
+  cf3_assert(m_is_created);
+  const Uint nb_blocks = values.indices.size();
+  for(Uint i = 0; i != nb_blocks; ++i)
+  {
+    const Real* block = &m_data[data_index(values.indices[i], 0)];
+    for(Uint j = 0; j != m_neq; ++j)
+      values.rhs[i*m_neq+j] = block[j];
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::set_sol_values(const BlockAccumulator& values)
+{
+  cf3_assert(m_is_created);
+  const Uint nb_blocks = values.indices.size();
+  for(Uint i = 0; i != nb_blocks; ++i)
+  {
+    Real* block = &m_data[data_index(values.indices[i], 0)];
+    for(Uint j = 0; j != m_neq; ++j)
+      block[j] = values.sol[i*m_neq+j];
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::add_sol_values(const BlockAccumulator& values)
+{
+  cf3_assert(m_is_created);
+  const Uint nb_blocks = values.indices.size();
+  for(Uint i = 0; i != nb_blocks; ++i)
+  {
+    Real* block = &m_data[data_index(values.indices[i], 0)];
+    for(Uint j = 0; j != m_neq; ++j)
+      block[j] += values.sol[i*m_neq+j];
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::get_sol_values(BlockAccumulator& values)
+{
+  cf3_assert(m_is_created);
+  const Uint nb_blocks = values.indices.size();
+  for(Uint i = 0; i != nb_blocks; ++i)
+  {
+    const Real* block = &m_data[data_index(values.indices[i], 0)];
+    for(Uint j = 0; j != m_neq; ++j)
+      values.sol[i*m_neq+j] = block[j];
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::reset(Real reset_to)
+{
+  cf3_assert(m_is_created);
+  m_data.assign(m_data.size(), reset_to);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::get( boost::multi_array<Real, 2>& data)
+{
+  cf3_assert(m_is_created);
+  cf3_assert(data.shape()[0]==m_blockrow_size);
+  cf3_assert(data.shape()[1]==m_neq);
+  for (Uint i=0; i != m_blockrow_size; i++)
+    for (Uint j=0; j != m_neq; j++)
+      data[i][j]=m_data[data_index(i, j)];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::set( boost::multi_array<Real, 2>& data)
+{
+  cf3_assert(m_is_created);
+  cf3_assert(data.shape()[0]==m_blockrow_size);
+  cf3_assert(data.shape()[1]==m_neq);
+  for (Uint i=0; i != m_blockrow_size; i++)
+    for (Uint j=0; j != m_neq; j++)
+      m_data[data_index(i, j)]=data[i][j];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::print(common::LogStream& stream)
+{
+  if (m_is_created)
+  {
+    for (Uint i=0; i != m_blockrow_size; i++)
+      for (Uint j=0; j != m_neq; j++)
+        stream << 0 << " " << -(int)(i*m_neq+j) << " " << m_data[data_index(i, j)] << "\n";
+    stream << "# name:                 " << name() << "\n";
+    stream << "# type_name:            " << type_name() << "\n";
+    stream << "# process:              " << common::PE::Comm::instance().rank() << "\n";
+    stream << "# number of equations:  " << m_neq << "\n";
+    stream << "# number of rows:       " << m_blockrow_size*m_neq << "\n";
+    stream << "# number of block rows: " << m_blockrow_size << "\n";
+  } else {
+    stream << name() << " of type " << type_name() << "::is_created() is false, nothing is printed.";
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::print(std::ostream& stream)
+{
+  if (m_is_created)
+  {
+    for (Uint i=0; i != m_blockrow_size; i++)
+      for (Uint j=0; j != m_neq; j++)
+        stream << 0 << " " << -(int)(i*m_neq+j) << " " << m_data[data_index(i, j)] << "\n";
+    stream << "# name:                 " << name() << "\n";
+    stream << "# type_name:            " << type_name() << "\n";
+    stream << "# process:              " << common::PE::Comm::instance().rank() << "\n";
+    stream << "# number of equations:  " << m_neq << "\n";
+    stream << "# number of rows:       " << m_blockrow_size*m_neq << "\n";
+    stream << "# number of block rows: " << m_blockrow_size << "\n" << std::flush;
+  } else {
+    stream << name() << " of type " << type_name() << "::is_created() is false, nothing is printed.";
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::print(const std::string& filename, std::ios_base::openmode mode)
+{
+  std::ofstream stream(filename.c_str(),mode);
+  stream << "VARIABLES=COL,ROW,VAL\n" << std::flush;
+  stream << "ZONE T=\"" << type_name() << "::" << name() <<  "\"\n" << std::flush;
+  print(stream);
+  stream.close();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::print_native(std::ostream& stream)
+{
+  const Uint nb_entries = m_data.size();
+  for(Uint i = 0; i != nb_entries; ++i)
+    stream << i << (i < nb_owned_entries() ? " " : " ghost ") << m_data[i] << "\n";
+  stream << std::flush;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::debug_data(std::vector<Real>& values)
+{
+  cf3_assert(m_is_created);
+  values.clear();
+  for (Uint i=0; i != m_blockrow_size; i++)
+    for (Uint j=0; j != m_neq; j++)
+      values.push_back(m_data[data_index(i, j)]);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::clone_to(Vector &other)
+{
+  if(!m_is_created)
+    throw common::SetupError(FromHere(), "Vector to clone " + uri().string() + " is not created");
+
+  NativeVector* other_ptr = dynamic_cast<NativeVector*>(&other);
+  if(is_null(other_ptr))
+    throw common::SetupError(FromHere(), "clone_to method of NativeVector needs another NativeVector, but a " + other.derived_type_name() + " was supplied instead.");
+
+  other_ptr->destroy();
+  other_ptr->m_data = m_data;
+  other_ptr->m_neq = m_neq;
+  other_ptr->m_blockrow_size = m_blockrow_size;
+  other_ptr->m_nb_owned_blocks = m_nb_owned_blocks;
+  other_ptr->m_is_created = m_is_created;
+  other_ptr->m_p2m = m_p2m;
+  other_ptr->m_comm_pattern = m_comm_pattern;
+  if(is_not_null(m_comm_pattern))
+  {
+    other_ptr->m_wrapper_name = native_wrapper_name(*m_comm_pattern, other_ptr->name());
+    m_comm_pattern->insert(other_ptr->m_wrapper_name, other_ptr->m_data, m_neq, true);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::assign(const Vector& source)
+{
+  NativeVector const* source_ptr = dynamic_cast<NativeVector const*>(&source);
+
+  if(is_null(source_ptr))
+    throw common::SetupError(FromHere(), "assign method of NativeVector needs another NativeVector, but a " + source.derived_type_name() + " was supplied instead.");
+
+  if(source_ptr->m_data.size() != m_data.size())
+    throw common::SetupError(FromHere(), "assign method of NativeVector got a vector with incorrect size");
+
+  m_data.assign(source_ptr->m_data.begin(), source_ptr->m_data.end());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::update(const Vector& source, const Real alpha)
+{
+  NativeVector const* source_ptr = dynamic_cast<NativeVector const*>(&source);
+
+  if(is_null(source_ptr))
+    throw common::SetupError(FromHere(), "update method of NativeVector needs another NativeVector, but a " + source.derived_type_name() + " was supplied instead.");
+
+  if(source_ptr->m_data.size() != m_data.size())
+    throw common::SetupError(FromHere(), "update method of NativeVector got a vector with incorrect size");
+
+  const int size = m_data.size();
+  const Real* src = source_ptr->m_data.empty() ? 0 : &source_ptr->m_data[0];
+  Real* dst = m_data.empty() ? 0 : &m_data[0];
+  #pragma omp parallel for schedule(static)
+  for(int i = 0; i < size; ++i)
+    dst[i] += alpha*src[i];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::scale(const Real alpha)
+{
+  if(alpha == 1.)
+    return;
+
+  const int size = m_data.size();
+  Real* dst = m_data.empty() ? 0 : &m_data[0];
+  #pragma omp parallel for schedule(static)
+  for(int i = 0; i < size; ++i)
+    dst[i] *= alpha;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::sync()
+{
+  if(is_not_null(m_comm_pattern))
+    m_comm_pattern->synchronize(m_wrapper_name);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void NativeVector::read_native(const common::URI& filename, const std::string type)
+{
+  throw common::NotImplemented(FromHere(), "read_native is not implemented for NativeVector");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+Real NativeVector::dot(const NativeVector& other) const
+{
+  cf3_assert(other.m_data.size() == m_data.size());
+  const int size = nb_owned_entries();
+  const Real* a = m_data.empty() ? 0 : &m_data[0];
+  const Real* b = other.m_data.empty() ? 0 : &other.m_data[0];
+  Real result = 0.;
+  #pragma omp parallel for schedule(static) reduction(+:result)
+  for(int i = 0; i < size; ++i)
+    result += a[i]*b[i];
+  return native_global_sum(result);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
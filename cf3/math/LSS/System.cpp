@@ -50,7 +50,15 @@ common::ComponentBuilder < LSS::System, LSS::System, LSS::LibLSS > System_Builde
 LSS::System::System(const std::string& name) :
   Component(name)
 {
-  options().add( "matrix_builder" , "cf3.math.LSS.TrilinosFEVbrMatrix")
+#ifdef CF3_HAVE_TRILINOS
+  const std::string default_matrix_builder = "cf3.math.LSS.TrilinosFEVbrMatrix";
+  const std::string default_solution_strategy = "cf3.math.LSS.TrilinosStratimikosStrategy";
+#else
+  const std::string default_matrix_builder = "cf3.math.LSS.NativeCrsMatrix";
+  const std::string default_solution_strategy = "cf3.math.LSS.NativeKrylovStrategy";
+#endif
+
+  options().add( "matrix_builder" , default_matrix_builder)
     .pretty_name("Matrix Builder")
     .description("Name for the builder used to create the LSS matrix")
     .mark_basic();
@@ -60,7 +68,7 @@ LSS::System::System(const std::string& name) :
     .description("Name for the builder used for the vectors. If left empty, this is obtained from the vector_type property of the matrix")
     .mark_basic();
 
-  options().add("solution_strategy", "cf3.math.LSS.TrilinosStratimikosStrategy")
+  options().add("solution_strategy", default_solution_strategy)
     .pretty_name("Solution Strategy")
     .description("Name of the builder that will be used to create the solution strategy")
     .mark_basic();
@@ -82,7 +90,7 @@ LSS::System::System(const std::string& name) :
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
-void LSS::System::create(cf3::common::PE::CommPattern& cp, Uint neq, std::vector<Uint>& node_connectivity, std::vector<Uint>& starting_indices, const std::vector<Uint>& periodic_links_nodes, const std::vector<bool>& periodic_links_active)
+void LSS::System::create(cf3::common::PE::CommPattern& cp, Uint neq, const std::vector<Uint>& node_connectivity, const std::vector<Uint>& starting_indices, const std::vector<Uint>& periodic_links_nodes, const std::vector<bool>& periodic_links_active)
 {
   if (is_created())
     destroy();
@@ -114,7 +122,7 @@ void LSS::System::create(cf3::common::PE::CommPattern& cp, Uint neq, std::vector
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
-void LSS::System::create_blocked(common::PE::CommPattern& cp, const VariablesDescriptor& vars, std::vector< Uint >& node_connectivity, std::vector< Uint >& starting_indices, const std::vector<Uint>& periodic_links_nodes, const std::vector<bool>& periodic_links_active)
+void LSS::System::create_blocked(common::PE::CommPattern& cp, const VariablesDescriptor& vars, const std::vector< Uint >& node_connectivity, const std::vector< Uint >& starting_indices, const std::vector<Uint>& periodic_links_nodes, const std::vector<bool>& periodic_links_active)
 {
   if (is_created())
     destroy();
@@ -6,6 +6,7 @@
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
+#include <algorithm>
 #include <iostream>
 #include <set>
 
@@ -70,9 +71,15 @@ TrilinosCrsMatrix::TrilinosCrsMatrix(const std::string& name) :
   m_num_my_elements(0),
   m_p2m(0),
   m_converted_indices(0),
-  m_comm(common::PE::Comm::instance().communicator())
+  m_comm(common::PE::Comm::instance().communicator()),
+  m_use_scatter_map(true)
 {
   properties().add("vector_type", std::string("cf3.math.LSS.TrilinosVector"));
+
+  options().add("use_scatter_map", m_use_scatter_map)
+    .pretty_name("Use Scatter Map")
+    .description("Accumulate element blocks directly into the matrix storage using offsets computed at creation. Set to false to use the Epetra SumIntoMyValues path, e.g. for validation.")
+    .link_to(&m_use_scatter_map);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////
@@ -92,57 +99,23 @@ void TrilinosCrsMatrix::create_blocked(common::PE::CommPattern& cp, const Variab
   // if already created
   if (m_is_created) destroy();
 
-  // Copy node connectivity
-  m_node_connectivity.resize(node_connectivity.size());
-  m_starting_indices.resize(starting_indices.size());
-  std::copy(node_connectivity.begin(), node_connectivity.end(), m_node_connectivity.begin());
-  std::copy(starting_indices.begin(), starting_indices.end(), m_starting_indices.begin());
+  // The graph is shared with other matrices built from the same connectivity and variables
+  m_graph = shared_crs_graph(cp, vars, node_connectivity, starting_indices, m_comm, periodic_links_nodes, periodic_links_active);
+  m_p2m = m_graph->p2m;
+  m_num_my_elements = m_graph->num_my_elements;
+  m_converted_indices.resize(m_graph->max_row_size);
 
   const Uint total_nb_eq = vars.size();
 
-  // prepare intermediate data
-  std::vector<int> my_global_elements;
-  std::vector<Uint> my_ranks;
-
-  create_map_data(cp, vars, m_p2m, my_global_elements, my_ranks, m_num_my_elements, periodic_links_nodes, periodic_links_active);
-  std::vector<int> num_indices_per_row; num_indices_per_row.reserve(m_num_my_elements);
-  std::vector<int> indices_per_row;
-  create_indices_per_row(cp, vars, node_connectivity, starting_indices, m_p2m, num_indices_per_row, indices_per_row, periodic_links_nodes, periodic_links_active);
-
-  m_converted_indices.resize(*std::max_element(num_indices_per_row.begin(), num_indices_per_row.end()));
-
-  // rowmap, ghosts not present
-  Epetra_Map rowmap(-1,m_num_my_elements,&my_global_elements[0],0,m_comm);
-
-  // colmap, has ghosts at the end
-  Epetra_Map colmap(-1,my_global_elements.size(),&my_global_elements[0],0,m_comm);
-  my_global_elements.clear(); // no longer needed
-
-  // Create the graph, using static profile for performance
-  Epetra_CrsGraph graph(Copy, rowmap, colmap, &num_indices_per_row[0], true);
-
-  // Fill the graph
-  int row_start = 0;
-  cf3_assert(num_indices_per_row.size() == m_num_my_elements);
-  for(int i = 0; i != m_num_my_elements; ++i)
-  {
-    const int row_nb_elems = num_indices_per_row[i];
-    cf3_assert( (row_start + row_nb_elems) <= indices_per_row.size() );
-    TRILINOS_THROW(graph.InsertMyIndices(i, row_nb_elems, &indices_per_row[row_start]));
-    row_start += row_nb_elems;
-  }
-
-  TRILINOS_THROW(graph.FillComplete());
-  TRILINOS_THROW(graph.OptimizeStorage());
-
   // create matrix
-  m_mat=Teuchos::rcp(new Epetra_CrsMatrix(Copy, graph));
+  m_mat=Teuchos::rcp(new Epetra_CrsMatrix(Copy, *m_graph->graph));
   TRILINOS_THROW(m_mat->FillComplete());
   TRILINOS_THROW(m_mat->OptimizeStorage());
 
   // set class properties
   m_is_created=true;
   m_neq=total_nb_eq;
+  build_scatter_map();
   CFdebug << "Rank " << common::PE::Comm::instance().rank() << ": Created a " << m_mat->NumGlobalCols() << " x " << m_mat->NumGlobalRows() << " trilinos matrix with " << m_mat->NumGlobalNonzeros() << " non-zero elements and " << m_num_my_elements << " local rows" << CFendl;
 }
 
@@ -156,6 +129,9 @@ void TrilinosCrsMatrix::destroy()
   }
   m_p2m.resize(0);
   m_p2m.reserve(0);
+  m_graph.reset();
+  m_scatter_offsets.clear();
+  m_scatter_nodes.clear();
   m_neq=0;
   m_num_my_elements=0;
   m_is_created=false;
@@ -228,23 +204,139 @@ void TrilinosCrsMatrix::set_values(const BlockAccumulator& values)
 void TrilinosCrsMatrix::add_values(const BlockAccumulator& values)
 {
   cf3_assert(m_is_created);
+  if(m_use_scatter_map && !m_scatter_offsets.empty() && add_values_scatter(values))
+    return;
+
   const Uint nb_nodes = values.indices.size();
   const int num_entries = nb_nodes*m_neq;
   cf3_assert(values.mat.rows() == num_entries);
+  // Scratch space for the converted indices, per thread so element blocks touching disjoint rows can be added concurrently
+  static thread_local std::vector<int> converted_indices;
+  converted_indices.resize(num_entries);
   // Convert the index vector
   for(Uint i = 0; i != nb_nodes; ++i)
   {
     const Uint local_start_idx = values.indices[i]*m_neq;
     for(int j = 0; j != m_neq; ++j)
-      m_converted_indices[i*m_neq+j] = m_p2m[local_start_idx+j];
+      converted_indices[i*m_neq+j] = m_p2m[local_start_idx+j];
   }
   // insert the values
   for(Uint i = 0; i != nb_nodes; ++i)
   {
     for(int j = 0; j != m_neq; ++j)
     {
-      if(m_converted_indices[i*m_neq+j] < m_num_my_elements)
-        TRILINOS_THROW(m_mat->SumIntoMyValues(m_converted_indices[i*m_neq+j], num_entries, values.mat.data()+(num_entries*(i*m_neq+j)),&m_converted_indices[0]));
+      if(converted_indices[i*m_neq+j] < m_num_my_elements)
+        TRILINOS_THROW(m_mat->SumIntoMyValues(converted_indices[i*m_neq+j], num_entries, values.mat.data()+(num_entries*(i*m_neq+j)),&converted_indices[0]));
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+bool TrilinosCrsMatrix::add_values_scatter(const BlockAccumulator& values)
+{
+  int* row_offsets;
+  int* column_indices;
+  Real* matrix_values;
+  if(m_mat->ExtractCrsDataPointers(row_offsets, column_indices, matrix_values) != 0)
+    return false;
+
+  const Uint nb_nodes = values.indices.size();
+  const Uint num_entries = nb_nodes*m_neq;
+  const Uint block_size = m_neq*m_neq;
+
+  // Look up the connectivity entry for each node pair first, so nothing is added if we need to fall back
+  static thread_local std::vector<int> entries;
+  entries.resize(nb_nodes*nb_nodes);
+  for(Uint i = 0; i != nb_nodes; ++i)
+  {
+    const Uint row_node = values.indices[i];
+    if(m_p2m[row_node*m_neq] >= m_num_my_elements)
+    {
+      std::fill(entries.begin() + i*nb_nodes, entries.begin() + (i+1)*nb_nodes, -1);
+      continue;
+    }
+    const std::vector<int>::const_iterator conn_begin = m_scatter_nodes.begin() + m_graph->starting_indices[row_node];
+    const std::vector<int>::const_iterator conn_end = m_scatter_nodes.begin() + m_graph->starting_indices[row_node+1];
+    for(Uint j = 0; j != nb_nodes; ++j)
+    {
+      const int column_node = values.indices[j];
+      const std::vector<int>::const_iterator found = std::lower_bound(conn_begin, conn_end, column_node);
+      if(found == conn_end || *found != column_node)
+        return false;
+      entries[i*nb_nodes+j] = found - m_scatter_nodes.begin();
+    }
+  }
+
+  for(Uint i = 0; i != nb_nodes; ++i)
+  {
+    if(entries[i*nb_nodes] < 0)
+      continue;
+    for(Uint j = 0; j != nb_nodes; ++j)
+    {
+      const int* offsets = &m_scatter_offsets[entries[i*nb_nodes+j]*block_size];
+      for(Uint k = 0; k != m_neq; ++k)
+      {
+        const Real* block_row = values.mat.data() + (i*m_neq+k)*num_entries + j*m_neq;
+        for(Uint l = 0; l != m_neq; ++l)
+          matrix_values[offsets[k*m_neq+l]] += block_row[l];
+      }
+    }
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void TrilinosCrsMatrix::build_scatter_map()
+{
+  m_scatter_offsets.clear();
+  m_scatter_nodes.clear();
+
+  int* row_offsets;
+  int* column_indices;
+  Real* matrix_values;
+  if(m_mat->ExtractCrsDataPointers(row_offsets, column_indices, matrix_values) != 0)
+  {
+    CFdebug << "Rank " << common::PE::Comm::instance().rank() << ": storage of " << uri().path() << " is not optimized, add_values will use SumIntoMyValues" << CFendl;
+    return;
+  }
+
+  // The connected nodes are sorted per node, so add_values_scatter can find them with a binary search
+  m_scatter_nodes = m_graph->node_connectivity;
+  const Uint nb_nodes = m_graph->starting_indices.size() - 1;
+  for(Uint node = 0; node != nb_nodes; ++node)
+    std::sort(m_scatter_nodes.begin() + m_graph->starting_indices[node], m_scatter_nodes.begin() + m_graph->starting_indices[node+1]);
+
+  const Uint block_size = m_neq*m_neq;
+  m_scatter_offsets.resize(m_scatter_nodes.size()*block_size, -1);
+  for(Uint node = 0; node != nb_nodes; ++node)
+  {
+    for(int l = m_graph->starting_indices[node]; l != m_graph->starting_indices[node+1]; ++l)
+    {
+      const Uint other_node = m_scatter_nodes[l];
+      for(Uint i = 0; i != m_neq; ++i)
+      {
+        const int row = m_p2m[node*m_neq+i];
+        if(row >= m_num_my_elements)
+          continue;
+        const int* row_begin = column_indices + row_offsets[row];
+        const int* row_end = column_indices + row_offsets[row+1];
+        for(Uint j = 0; j != m_neq; ++j)
+        {
+          const int* found = std::find(row_begin, row_end, m_p2m[other_node*m_neq+j]);
+          if(found == row_end)
+          {
+            // Should not happen, since the graph was built from the same connectivity
+            CFwarn << "Rank " << common::PE::Comm::instance().rank() << ": sparsity of " << uri().path() << " does not match its connectivity, add_values will use SumIntoMyValues" << CFendl;
+            m_scatter_offsets.clear();
+            m_scatter_nodes.clear();
+            return;
+          }
+          m_scatter_offsets[(l*m_neq+i)*m_neq+j] = found - column_indices;
+        }
+      }
     }
   }
 }
@@ -335,15 +427,15 @@ void TrilinosCrsMatrix::symmetric_dirichlet(const Uint blockrow, const Uint ieq,
 
   m_dirichlet_nodes.push_back(std::make_pair(blockrow, ieq));
 
-  const Uint nb_connected_nodes = m_starting_indices[blockrow+1] - m_starting_indices[blockrow];
+  const Uint nb_connected_nodes = m_graph->starting_indices[blockrow+1] - m_graph->starting_indices[blockrow];
   std::vector<int> row_indices; row_indices.reserve(m_neq*nb_connected_nodes);
-  const Uint conn_start = m_starting_indices[blockrow];
-  const Uint conn_end = m_starting_indices[blockrow+1];
+  const Uint conn_start = m_graph->starting_indices[blockrow];
+  const Uint conn_end = m_graph->starting_indices[blockrow+1];
   for(Uint i = conn_start; i != conn_end; ++i)
   {
     for(Uint j = 0; j != m_neq; ++j)
     {
-      row_indices.push_back(m_p2m[m_node_connectivity[i]*m_neq+j]);
+      row_indices.push_back(m_p2m[m_graph->node_connectivity[i]*m_neq+j]);
     }
   }
   
@@ -530,9 +622,9 @@ void TrilinosCrsMatrix::clone_to(Matrix &other)
   other_ptr->m_num_my_elements = m_num_my_elements;
   other_ptr->m_p2m = m_p2m;
   other_ptr->m_converted_indices = m_converted_indices;
-  other_ptr->m_node_connectivity = m_node_connectivity;
-  other_ptr->m_starting_indices = m_starting_indices;
+  other_ptr->m_graph = m_graph;
   other_ptr->m_symmetric_dirichlet_values = m_symmetric_dirichlet_values;
+  other_ptr->build_scatter_map();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////
@@ -540,6 +632,8 @@ void TrilinosCrsMatrix::clone_to(Matrix &other)
 void TrilinosCrsMatrix::read_native(const common::URI& file)
 {  
   EpetraExt::readEpetraLinearSystem(file.path(), m_comm, &m_mat);
+  m_scatter_offsets.clear();
+  m_scatter_nodes.clear();
   
   m_is_created = true;
 }
@@ -17,6 +17,7 @@
 #include "math/LSS/BlockAccumulator.hpp"
 #include "math/LSS/Vector.hpp"
 #include "math/LSS/Matrix.hpp"
+#include "math/LSS/Trilinos/TrilinosDetail.hpp"
 
 #include "ThyraOperator.hpp"
 
@@ -87,6 +88,8 @@ public:
   /// Add a list of values
   /// local ibdices
   /// eigen, templatization on top level
+  /// Unless the use_scatter_map option is false, the values are accumulated directly into the Epetra value array
+  /// using the offsets computed in create. Blocks that contain node pairs outside of the sparsity go through SumIntoMyValues.
   void add_values(const BlockAccumulator& values);
 
   /// Add a list of values
@@ -163,6 +166,8 @@ public:
   void replace_epetra_matrix(const Teuchos::RCP<Epetra_CrsMatrix>& mat)
   {
     m_mat = mat;
+    m_scatter_offsets.clear(); // The structure of the new matrix is unknown
+    m_scatter_nodes.clear();
   }
   
   /// Store the local matrix GIDs belonging to each variable in the given vector
@@ -204,6 +209,13 @@ public:
 
 private:
 
+  /// Compute m_scatter_offsets from the connectivity and the structure of m_mat
+  void build_scatter_map();
+
+  /// Accumulate the values using m_scatter_offsets. Returns false without touching the matrix if any node pair
+  /// of the block is not in the connectivity, so the caller can fall back to SumIntoMyValues.
+  bool add_values_scatter(const BlockAccumulator& values);
+
   /// teuchos style smart pointer wrapping the matrix
   Teuchos::RCP<Epetra_CrsMatrix> m_mat;
 
@@ -225,8 +237,19 @@ private:
   /// a helper array used in set/add/get_values to avoid frequent new+free combo
   std::vector<int> m_converted_indices;
 
-  /// Copy of the connectivity data
-  std::vector<int> m_node_connectivity, m_starting_indices;
+  /// Graph of the matrix, including the connectivity data. Shared with the other matrices built from the same data.
+  boost::shared_ptr<CrsGraphData const> m_graph;
+
+  /// Connectivity of the graph, with the connected nodes of each node sorted
+  std::vector<int> m_scatter_nodes;
+
+  /// Position in the Epetra value array of each entry of m_scatter_nodes, for each equation pair.
+  /// Entry (l*m_neq + i)*m_neq + j is the position of row equation i and column equation j for connectivity entry l, or -1 for ghost rows.
+  /// Empty if the matrix storage is not optimized.
+  std::vector<int> m_scatter_offsets;
+
+  /// Use m_scatter_offsets in add_values
+  bool m_use_scatter_map;
 
   /// Cache matrix values in case of symmetric dirichlet, so they can be applied multiple times even if the matrix is not changed
   typedef std::map<int, Real> DirichletEntryT;
@@ -6,8 +6,12 @@
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
+#include <algorithm>
+#include <map>
 #include <set>
 
+#include <boost/weak_ptr.hpp>
+
 #include "common/PE/Comm.hpp"
 #include "common/PE/CommPattern.hpp"
 #include "common/Log.hpp"
@@ -18,6 +22,9 @@
 #include "math/LSS/Trilinos/TrilinosDetail.hpp"
 #include "TrilinosVector.hpp"
 
+#include <Epetra_Comm.h>
+#include <Epetra_CrsGraph.h>
+#include <Epetra_Map.h>
 #include <Epetra_Operator.h>
 
 ////////////////////////////////////////////////////////////////////////////////////////////
@@ -377,6 +384,113 @@ void create_indices_per_row(cf3::common::PE::CommPattern& cp,
 }
 
 
+namespace detail
+{
+
+/// True if the graph was built from the given data
+bool graph_matches(const CrsGraphData& data,
+                   const std::vector<Uint>& node_connectivity,
+                   const std::vector<Uint>& starting_indices,
+                   const std::vector<int>& p2m,
+                   const std::vector<int>& global_elements,
+                   const int num_my_elements,
+                   const std::vector<Uint>& periodic_links_nodes,
+                   const std::vector<bool>& periodic_links_active)
+{
+  return data.num_my_elements == num_my_elements
+      && data.node_connectivity.size() == node_connectivity.size() && std::equal(node_connectivity.begin(), node_connectivity.end(), data.node_connectivity.begin())
+      && data.starting_indices.size() == starting_indices.size() && std::equal(starting_indices.begin(), starting_indices.end(), data.starting_indices.begin())
+      && data.p2m == p2m
+      && data.global_elements == global_elements
+      && data.periodic_links_nodes == periodic_links_nodes
+      && data.periodic_links_active == periodic_links_active;
+}
+
+}
+
+boost::shared_ptr<CrsGraphData const> shared_crs_graph(cf3::common::PE::CommPattern& cp,
+                                                       const VariablesDescriptor& variables,
+                                                       const std::vector<Uint>& node_connectivity,
+                                                       const std::vector<Uint>& starting_indices,
+                                                       const Epetra_Comm& comm,
+                                                       const std::vector<Uint>& periodic_links_nodes,
+                                                       const std::vector<bool>& periodic_links_active)
+{
+  // Graphs stay alive as long as a matrix uses them. They are built collectively, so their ids are the same on all processes
+  static std::map< Uint, boost::weak_ptr<CrsGraphData const> > graphs;
+  static Uint next_graph_id = 0;
+
+  std::vector<int> p2m;
+  std::vector<int> global_elements;
+  std::vector<Uint> ranks;
+  int num_my_elements;
+  create_map_data(cp, variables, p2m, global_elements, ranks, num_my_elements, periodic_links_nodes, periodic_links_active);
+
+  // Flag the graphs that match the local data
+  std::vector<int> matches(next_graph_id, 0);
+  for(std::map< Uint, boost::weak_ptr<CrsGraphData const> >::iterator it = graphs.begin(); it != graphs.end();)
+  {
+    boost::shared_ptr<CrsGraphData const> graph = it->second.lock();
+    if(!graph)
+    {
+      graphs.erase(it++);
+      continue;
+    }
+    if(detail::graph_matches(*graph, node_connectivity, starting_indices, p2m, global_elements, num_my_elements, periodic_links_nodes, periodic_links_active))
+      matches[it->first] = 1;
+    ++it;
+  }
+
+  // Building the graph is collective, so all processes must agree on the graph to reuse, or on building a new one
+  if(next_graph_id != 0 && common::PE::Comm::instance().is_active())
+    common::PE::Comm::instance().all_reduce(common::PE::min(), &matches[0], next_graph_id, &matches[0]);
+  const std::vector<int>::const_iterator match = std::find(matches.begin(), matches.end(), 1);
+  if(match != matches.end())
+    return graphs[match - matches.begin()].lock();
+
+  boost::shared_ptr<CrsGraphData> data(new CrsGraphData());
+  data->node_connectivity.assign(node_connectivity.begin(), node_connectivity.end());
+  data->starting_indices.assign(starting_indices.begin(), starting_indices.end());
+  data->num_my_elements = num_my_elements;
+  data->periodic_links_nodes = periodic_links_nodes;
+  data->periodic_links_active = periodic_links_active;
+
+  std::vector<int> num_indices_per_row; num_indices_per_row.reserve(num_my_elements);
+  std::vector<int> indices_per_row;
+  create_indices_per_row(cp, variables, node_connectivity, starting_indices, p2m, num_indices_per_row, indices_per_row, periodic_links_nodes, periodic_links_active);
+
+  data->max_row_size = *std::max_element(num_indices_per_row.begin(), num_indices_per_row.end());
+
+  // rowmap, ghosts not present
+  Epetra_Map rowmap(-1,num_my_elements,&global_elements[0],0,comm);
+
+  // colmap, has ghosts at the end
+  Epetra_Map colmap(-1,global_elements.size(),&global_elements[0],0,comm);
+
+  // Create the graph, using static profile for performance
+  data->graph = Teuchos::rcp(new Epetra_CrsGraph(Copy, rowmap, colmap, &num_indices_per_row[0], true));
+
+  // Fill the graph
+  int row_start = 0;
+  cf3_assert(num_indices_per_row.size() == num_my_elements);
+  for(int i = 0; i != num_my_elements; ++i)
+  {
+    const int row_nb_elems = num_indices_per_row[i];
+    cf3_assert( (row_start + row_nb_elems) <= indices_per_row.size() );
+    TRILINOS_THROW(data->graph->InsertMyIndices(i, row_nb_elems, &indices_per_row[row_start]));
+    row_start += row_nb_elems;
+  }
+
+  TRILINOS_THROW(data->graph->FillComplete());
+  TRILINOS_THROW(data->graph->OptimizeStorage());
+
+  data->p2m.swap(p2m);
+  data->global_elements.swap(global_elements);
+
+  graphs[next_graph_id++] = data;
+  return data;
+}
+
 void apply_matrix ( const Epetra_Operator& op, const Handle< Vector >& y, const cf3::Handle< const Vector >& x, const Real alpha, const Real beta )
 {
   Handle<TrilinosVector> y_tril(y);
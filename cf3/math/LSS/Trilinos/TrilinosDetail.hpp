@@ -9,6 +9,10 @@
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
+#include <boost/shared_ptr.hpp>
+
+#include <Teuchos_RCP.hpp>
+
 #include "common/CF.hpp"
 #include "common/List.hpp"
 
@@ -22,6 +26,8 @@
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
+class Epetra_Comm;
+class Epetra_CrsGraph;
 class Epetra_Operator;
 namespace cf3 {
   namespace common { namespace PE { class CommPattern; } }
@@ -67,6 +73,40 @@ void create_indices_per_row(cf3::common::PE::CommPattern& cp,
                      const std::vector<bool>& periodic_links_active = std::vector<bool>()
                     );
 
+/// Graph of a CRS matrix, together with the data it was built from
+struct CrsGraphData
+{
+  /// Copy of the connectivity data
+  std::vector<int> node_connectivity, starting_indices;
+  /// Mapping from node index to local matrix index, as computed by create_map_data
+  std::vector<int> p2m;
+  /// GID for each column in the matrix, as computed by create_map_data
+  std::vector<int> global_elements;
+  int num_my_elements;
+  std::vector<Uint> periodic_links_nodes;
+  std::vector<bool> periodic_links_active;
+  /// Largest number of entries in a row
+  int max_row_size;
+  /// The graph itself, filled and with optimized storage
+  Teuchos::RCP<Epetra_CrsGraph> graph;
+};
+
+/// Get the graph for the given connectivity and variables. Graphs that are still used by another matrix and were built from
+/// identical data are reused, so systems created on the same mesh with the same variables only pay for one graph.
+/// This is collective, and a graph is only reused if it matches on all processes.
+/// @param cp The comm pattern that governs the node distribution
+/// @param variables The variables to use. Equations will be grouped per variable
+/// @param node_connectivity The connected nodes for each node
+/// @param starting_indices For each node, the start index into node_connectivity to find its connected nodes
+/// @param comm Communicator for the maps of the graph
+boost::shared_ptr<CrsGraphData const> shared_crs_graph(cf3::common::PE::CommPattern& cp,
+                                                       const VariablesDescriptor& variables,
+                                                       const std::vector<Uint>& node_connectivity,
+                                                       const std::vector<Uint>& starting_indices,
+                                                       const Epetra_Comm& comm,
+                                                       const std::vector<Uint>& periodic_links_nodes = std::vector<Uint>(),
+                                                       const std::vector<bool>& periodic_links_active = std::vector<bool>());
+
 /// Compute y = alpha*op*x + beta*y
 void apply_matrix(const Epetra_Operator& op, const Handle<Vector>& y, const Handle<Vector const>& x, const Real alpha = 1., const Real beta = 0.);
 
@@ -322,9 +322,11 @@ void TrilinosFEVbrMatrix::add_values(const BlockAccumulator& values)
   const int numblocks=values.indices.size();
   const int rowoffset=(numblocks-1)*m_neq;
   const int neqneq=m_neq*m_neq;
-  if (m_converted_indices.size()<numblocks) m_converted_indices.resize(numblocks);
-  for (int i=0; i<(const int)numblocks; i++) m_converted_indices[i]=m_p2m[values.indices[i]];
-  int* idxs=(int*)&m_converted_indices[0];
+  // per-thread scratch space, so element blocks touching disjoint rows can be added concurrently
+  static thread_local std::vector<int> converted_indices;
+  if (converted_indices.size()<numblocks) converted_indices.resize(numblocks);
+  for (int i=0; i<(const int)numblocks; i++) converted_indices[i]=m_p2m[values.indices[i]];
+  int* idxs=(int*)&converted_indices[0];
   for (int irow=0; irow<(const int)numblocks; irow++)
   {
     if (idxs[irow]<m_blockrow_size)
@@ -129,6 +129,8 @@ void Dictionary::resize(const Uint size)
   boost_foreach(Field& field, find_components<Field>(*this))
       field.resize(size);
 
+  clear_inverse_periodic_links();
+
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -431,6 +433,72 @@ void Dictionary::update_structures()
   {
     m_fields.push_back(field.handle<Field>());
   }
+
+  clear_inverse_periodic_links();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+const Dictionary::InversePeriodicLinks& Dictionary::inverse_periodic_links() const
+{
+  if(is_not_null(m_inverse_periodic_links.get()))
+    return *m_inverse_periodic_links;
+
+  m_inverse_periodic_links.reset(new InversePeriodicLinks());
+  InversePeriodicLinks& inverse = *m_inverse_periodic_links;
+  inverse.offsets.push_back(0);
+
+  Handle< common::List<Uint> const > periodic_links_nodes_h(get_child("periodic_links_nodes"));
+  Handle< common::List<bool> const > periodic_links_active_h(get_child("periodic_links_active"));
+  if(is_null(periodic_links_nodes_h) || is_null(periodic_links_active_h))
+    return inverse;
+
+  const common::List<Uint>& periodic_links_nodes = *periodic_links_nodes_h;
+  const common::List<bool>& periodic_links_active = *periodic_links_active_h;
+  const Uint nb_nodes = periodic_links_nodes.size();
+
+  // Count the links to each final target, resolving chains of links
+  std::vector<Uint> final_targets(nb_nodes, nb_nodes);
+  std::vector<Uint> nb_links(nb_nodes, 0);
+  for(Uint i = 0; i != nb_nodes; ++i)
+  {
+    if(!periodic_links_active[i])
+      continue;
+    Uint final_target_node = periodic_links_nodes[i];
+    while(periodic_links_active[final_target_node])
+      final_target_node = periodic_links_nodes[final_target_node];
+    final_targets[i] = final_target_node;
+    ++nb_links[final_target_node];
+  }
+
+  // Row index of each target in the compressed storage
+  std::vector<Uint> target_rows(nb_nodes, nb_nodes);
+  for(Uint i = 0; i != nb_nodes; ++i)
+  {
+    if(nb_links[i] == 0)
+      continue;
+    target_rows[i] = inverse.targets.size();
+    inverse.targets.push_back(i);
+    inverse.offsets.push_back(inverse.offsets.back() + nb_links[i]);
+  }
+
+  // Fill the rows, keeping the linked nodes in increasing order
+  inverse.nodes.resize(inverse.offsets.back());
+  std::vector<Uint> fill_positions(inverse.offsets.begin(), inverse.offsets.end() - 1);
+  for(Uint i = 0; i != nb_nodes; ++i)
+  {
+    if(final_targets[i] != nb_nodes)
+      inverse.nodes[fill_positions[target_rows[final_targets[i]]]++] = i;
+  }
+
+  return inverse;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Dictionary::clear_inverse_periodic_links()
+{
+  m_inverse_periodic_links.reset();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
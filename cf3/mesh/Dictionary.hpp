@@ -8,6 +8,7 @@
 #define cf3_mesh_Dictionary_hpp
 
 #include <boost/cstdint.hpp>
+#include <boost/scoped_ptr.hpp>
 
 #include "common/Map.hpp"
 #include "mesh/LibMesh.hpp"
@@ -98,6 +99,23 @@ public:
   /// Node to space-element connectivity
   const common::DynTable<SpaceElem>& connectivity() const { return *m_connectivity; }
 
+  /// Inverse of the periodic links, in compressed row storage. The nodes that are periodically linked to
+  /// targets[i] (following link chains to their final target) are nodes[offsets[i]] up to nodes[offsets[i+1]].
+  /// Only target nodes with at least one link are listed.
+  struct InversePeriodicLinks
+  {
+    std::vector<Uint> targets;
+    std::vector<Uint> offsets;
+    std::vector<Uint> nodes;
+  };
+
+  /// Inverse periodic links, built from the periodic_links_nodes and periodic_links_active lists on first use.
+  /// Empty if there are no periodic links. The result is kept until update_structures() or clear_inverse_periodic_links() is called.
+  const InversePeriodicLinks& inverse_periodic_links() const;
+
+  /// Drop the stored inverse periodic links, needed when the periodic links are modified
+  void clear_inverse_periodic_links();
+
   /// Return the comm pattern valid for this field group. Created based on the glb_idx and rank if it didn't exist already
   common::PE::CommPattern& comm_pattern();
 
@@ -173,6 +191,9 @@ protected:
   /// Connectivity with the element of the space
   Handle<common::DynTable<SpaceElem> > m_connectivity;
 
+  /// Cached inverse of the periodic links
+  mutable boost::scoped_ptr<InversePeriodicLinks> m_inverse_periodic_links;
+
 private:
 
   std::map< Handle<Entities const> , Handle<Space const> > m_spaces_map;
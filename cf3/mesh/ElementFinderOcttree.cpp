@@ -51,7 +51,6 @@ ElementFinderOcttree::ElementFinderOcttree(const std::string &name) :
     .description("If true, an inexact match is allowed, finding the closest element")
     .link_to(&m_closest);
 
-  m_octtree_idx.resize(3,0);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -84,94 +83,41 @@ bool ElementFinderOcttree::find_element(const RealVector& target_coord, SpaceEle
   if (m_octtree->is_created() == false)
       m_octtree->create_octtree();
 
-  RealVector t_coord(m_octtree->dimension());
+  RealVector t_coord = RealVector::Zero(m_octtree->dimension());
   for (Uint d=0; d<target_coord.size(); ++d)
     t_coord[d] = target_coord[d];
 
-  m_elements_pool.clear();
-
-  if (m_octtree->find_octtree_cell(t_coord,m_octtree_idx))
+  if (m_octtree->find_element(t_coord,m_tmp))
   {
-    Uint pool_size = 0;
-    Uint rings=0;
-    for ( ; pool_size==0 ; ++rings)
-    {
-      pool_size=m_elements_pool.size();
-      m_octtree->gather_elements_around_idx(m_octtree_idx,rings,m_elements_pool);
-      boost_foreach(const Entity& pool_elem, boost::make_iterator_range(m_elements_pool.begin()+pool_size,m_elements_pool.end()))
-      {
-        cf3_assert(is_not_null(pool_elem.comp));
-        const RealMatrix elem_coordinates = pool_elem.get_coordinates();
-        if (pool_elem.element_type().is_coord_in_element(t_coord,elem_coordinates))
-        {
-          element = SpaceElem(*const_cast<Space*>(&m_dict->space(*pool_elem.comp)),pool_elem.idx);
-          return true;
-        }
-      }
-    }
-    // if arrived here, keep searching
-    // it means no element has been found. The search is enlarged with one more ring, for possible misses.
-    m_octtree->gather_elements_around_idx(m_octtree_idx,rings,m_elements_pool);
-    boost_foreach(const Entity& pool_elem, boost::make_iterator_range(m_elements_pool.begin()+pool_size,m_elements_pool.end()))
-    {
-      cf3_assert(is_not_null(pool_elem.comp));
-      const RealMatrix elem_coordinates = pool_elem.get_coordinates();
-      if (pool_elem.element_type().is_coord_in_element(t_coord,elem_coordinates))
-      {
-        element = SpaceElem(*const_cast<Space*>(&m_dict->space(*pool_elem.comp)),pool_elem.idx);
-        return true;
-      }
-    }
+    element = SpaceElem(*const_cast<Space*>(&m_dict->space(*m_tmp.comp)),m_tmp.idx);
+    return true;
   }
-  if (m_closest)
+
+  // Inexact match: the element with the closest centroid, if the coordinate is not farther from
+  // that centroid than its furthest node
+  if (m_closest && m_octtree->find_closest_element(t_coord,m_tmp))
   {
-//    std::cout << "didnt find element ... will look more in a pool of " << m_elements_pool.size() << std::endl;
-    Real distance=math::Consts::real_max();
-    int closest_idx=-1;
-    RealVector s_elem_centroid = t_coord;
-    for (Uint i=0; i<m_elements_pool.size(); ++i)
+    m_tmp.allocate_coordinates(m_coordinates);
+    m_tmp.put_coordinates(m_coordinates);
+    RealVector centroid(t_coord.size());
+    m_tmp.element_type().compute_centroid(m_coordinates,centroid);
+    const Real distance = math::Functions::get_distance(centroid,t_coord);
+    for (Uint n=0; n<m_tmp.element_type().nb_nodes(); ++n)
     {
-      int elem_dim=m_elements_pool[i].element_type().dimension();
-      m_elements_pool[i].allocate_coordinates(m_coordinates);
-      m_elements_pool[i].put_coordinates(m_coordinates);
-      m_elements_pool[i].element_type().compute_centroid( m_elements_pool[i].get_coordinates() , s_elem_centroid);
-
-      Real newdistance = math::Functions::get_distance(s_elem_centroid,t_coord);
-      if (newdistance < distance)
+      if (math::Functions::get_distance(centroid,m_coordinates.row(n)) > distance)
       {
-        distance = newdistance;
-
-        for (Uint n=0; n<m_elements_pool[i].element_type().nb_nodes(); ++n)
-        {
-          newdistance = math::Functions::get_distance(s_elem_centroid,m_coordinates.row(n));
-          if (newdistance>distance)
-          {
-            closest_idx = i; break;
-          }
-        }
+        element = SpaceElem(*const_cast<Space*>(&m_dict->space(*m_tmp.comp)),m_tmp.idx);
+        return true;
       }
     }
-    if (closest_idx>=0)
-    {
-//      int elem_dim=m_elements_pool[closest_idx].element_type().dimension();
-//      m_elements_pool[closest_idx].allocate_coordinates(m_coordinates);
-//      m_elements_pool[closest_idx].put_coordinates(m_coordinates);
-
-//      Real volume = m_elements_pool[closest_idx].element_type().volume( m_coordinates );
-//      Real dx3 = std::pow(distance, elem_dim);
-//      std::cout << "---> found at distance " << distance << "    vol="<<volume<<"   dx3="<<dx3<< std::endl;
-      element = SpaceElem(*const_cast<Space*>(&m_dict->space(*m_elements_pool[closest_idx].comp)),m_elements_pool[closest_idx].idx);
-      return true;
-    }
   }
-//  std::cout << "---> not found" << std::endl;
-  // if arrived here, it means no element has been found in the octtree cell. Give up.
+  // if arrived here, it means no element has been found. Give up.
   CFdebug << "coord";
   for(Uint i = 0; i != t_coord.size(); ++i)
   {
     CFdebug << " " << common::to_str(t_coord[i]);
   }
-  CFdebug << " has not been found in the octtree cell" << CFendl;
+  CFdebug << " has not been found in the mesh" << CFendl;
   return false;
 
 //  bool found = m_octtree->find_element(target_coord,m_tmp);
@@ -0,0 +1,422 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include <algorithm>
+#include <exception>
+
+#include "common/Foreach.hpp"
+#include "common/FindComponents.hpp"
+#include "common/Threads.hpp"
+
+#include "math/Consts.hpp"
+
+#include "mesh/ElementTree.hpp"
+#include "mesh/ElementType.hpp"
+#include "mesh/Elements.hpp"
+#include "mesh/Mesh.hpp"
+#include "mesh/Region.hpp"
+#include "mesh/Space.hpp"
+
+//////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace mesh {
+
+  using namespace common;
+
+//////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+  /// Orders element indices by one component of their centroid
+  struct CentroidLess
+  {
+    CentroidLess(const std::vector<Real>& centroids, const Uint dim, const Uint direction) :
+      m_centroids(centroids), m_dim(dim), m_direction(direction)
+    {
+    }
+
+    bool operator()(const Uint a, const Uint b) const
+    {
+      return m_centroids[a*m_dim + m_direction] < m_centroids[b*m_dim + m_direction];
+    }
+
+    const std::vector<Real>& m_centroids;
+    const Uint m_dim;
+    const Uint m_direction;
+  };
+
+  /// The tree is balanced, so the depth is at most the number of bits in the element count
+  const Uint max_depth = 64;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+ElementTree::ElementTree() :
+  m_dim(0)
+{
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void ElementTree::clear()
+{
+  m_dim = 0;
+  std::vector<Node>().swap(m_nodes);
+  std::vector<Real>().swap(m_node_boxes);
+  std::vector<Entity>().swap(m_elements);
+  std::vector<Real>().swap(m_element_boxes);
+  std::vector<Real>().swap(m_centroids);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void ElementTree::build(const Mesh& mesh, const Uint nb_elems_per_leaf)
+{
+  clear();
+  m_dim = mesh.dimension();
+  const Uint nb_elems = mesh.topology().recursive_filtered_elements_count(IsElementsVolume(),true);
+
+  // Bounding box and centroid of each element. The boxes are slightly enlarged,
+  // so that coordinates on the element boundary are not missed due to round-off
+  std::vector<Entity> elements; elements.reserve(nb_elems);
+  std::vector<Real> element_boxes; element_boxes.reserve(2*m_dim*nb_elems);
+  std::vector<Real> centroids; centroids.reserve(m_dim*nb_elems);
+  RealVector centroid(m_dim);
+  boost_foreach (const Elements& elements_comp, find_components_recursively_with_filter<Elements>(mesh.topology(),IsElementsVolume()))
+  {
+    const Space& space = elements_comp.geometry_space();
+    const ElementType& etype = elements_comp.element_type();
+    RealMatrix coordinates;
+    space.allocate_coordinates(coordinates);
+    for (Uint elem_idx=0; elem_idx<elements_comp.size(); ++elem_idx)
+    {
+      space.put_coordinates(coordinates,elem_idx);
+      etype.compute_centroid(coordinates,centroid);
+      const RealVector min = coordinates.colwise().minCoeff().transpose();
+      const RealVector max = coordinates.colwise().maxCoeff().transpose();
+      const Real tolerance = 1e-8*(max-min).maxCoeff() + 100*math::Consts::eps();
+      for (Uint d=0; d<m_dim; ++d)
+        element_boxes.push_back(min[d]-tolerance);
+      for (Uint d=0; d<m_dim; ++d)
+        element_boxes.push_back(max[d]+tolerance);
+      centroids.insert(centroids.end(), centroid.data(), centroid.data()+m_dim);
+      elements.push_back(Entity(elements_comp,elem_idx));
+    }
+  }
+
+  if (elements.empty())
+    return;
+
+  // Top-down construction. The permutation is partitioned in place, so each node refers to a contiguous range.
+  std::vector<Uint> permutation(elements.size());
+  for (Uint i=0; i<permutation.size(); ++i)
+    permutation[i] = i;
+
+  const Uint leaf_size = std::max(nb_elems_per_leaf, 1u);
+  Node root = { 0, static_cast<Uint>(elements.size()), 0 };
+  m_nodes.reserve(4*elements.size()/leaf_size + 1);
+  m_nodes.push_back(root);
+  std::vector<Uint> to_split(1, 0);
+  std::vector<Real> centroid_min(m_dim), centroid_max(m_dim);
+  while (!to_split.empty())
+  {
+    const Uint node_idx = to_split.back();
+    to_split.pop_back();
+    const Uint begin = m_nodes[node_idx].begin;
+    const Uint end = m_nodes[node_idx].end;
+    if (end - begin <= leaf_size)
+      continue;
+
+    // Split along the direction where the centroids are most spread out
+    std::fill(centroid_min.begin(), centroid_min.end(), math::Consts::real_max());
+    std::fill(centroid_max.begin(), centroid_max.end(), -math::Consts::real_max());
+    for (Uint i=begin; i<end; ++i)
+    {
+      for (Uint d=0; d<m_dim; ++d)
+      {
+        centroid_min[d] = std::min(centroid_min[d], centroids[permutation[i]*m_dim+d]);
+        centroid_max[d] = std::max(centroid_max[d], centroids[permutation[i]*m_dim+d]);
+      }
+    }
+    Uint direction = 0;
+    for (Uint d=1; d<m_dim; ++d)
+    {
+      if (centroid_max[d]-centroid_min[d] > centroid_max[direction]-centroid_min[direction])
+        direction = d;
+    }
+    if (centroid_max[direction] == centroid_min[direction])
+      continue;
+
+    const Uint middle = begin + (end-begin)/2;
+    std::nth_element(permutation.begin()+begin, permutation.begin()+middle, permutation.begin()+end, CentroidLess(centroids,m_dim,direction));
+
+    m_nodes[node_idx].children = m_nodes.size();
+    const Node left = { begin, middle, 0 };
+    const Node right = { middle, end, 0 };
+    m_nodes.push_back(left);
+    m_nodes.push_back(right);
+    to_split.push_back(m_nodes.size()-2);
+    to_split.push_back(m_nodes.size()-1);
+  }
+
+  // Store the elements in the order of the leaves
+  m_elements.resize(elements.size());
+  m_element_boxes.resize(element_boxes.size());
+  m_centroids.resize(centroids.size());
+  for (Uint i=0; i<permutation.size(); ++i)
+  {
+    const Uint e = permutation[i];
+    m_elements[i] = elements[e];
+    std::copy(&element_boxes[2*m_dim*e], &element_boxes[2*m_dim*(e+1)], &m_element_boxes[2*m_dim*i]);
+    std::copy(&centroids[m_dim*e], &centroids[m_dim*(e+1)], &m_centroids[m_dim*i]);
+  }
+
+  // Node boxes enclose the boxes of their elements. Children always come after their parent,
+  // so the boxes are merged bottom-up by looping over the nodes in reverse
+  m_node_boxes.resize(2*m_dim*m_nodes.size());
+  for (Uint n=m_nodes.size(); n-- != 0; )
+  {
+    Real* node_min = &m_node_boxes[2*m_dim*n];
+    Real* node_max = node_min + m_dim;
+    std::fill(node_min, node_max, math::Consts::real_max());
+    std::fill(node_max, node_max+m_dim, -math::Consts::real_max());
+    const std::vector<Real>& boxes = m_nodes[n].children ? m_node_boxes : m_element_boxes;
+    const Uint first = m_nodes[n].children ? m_nodes[n].children : m_nodes[n].begin;
+    const Uint last = m_nodes[n].children ? m_nodes[n].children+2 : m_nodes[n].end;
+    for (Uint i=first; i<last; ++i)
+    {
+      for (Uint d=0; d<m_dim; ++d)
+      {
+        node_min[d] = std::min(node_min[d], box_min(boxes,i)[d]);
+        node_max[d] = std::max(node_max[d], box_max(boxes,i)[d]);
+      }
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+bool ElementTree::box_contains(const std::vector<Real>& boxes, const Uint i, const Real* coordinate) const
+{
+  const Real* min = box_min(boxes,i);
+  const Real* max = box_max(boxes,i);
+  for (Uint d=0; d<m_dim; ++d)
+  {
+    if (coordinate[d] < min[d] || coordinate[d] > max[d])
+      return false;
+  }
+  return true;
+}
+
+Real ElementTree::box_distance2(const std::vector<Real>& boxes, const Uint i, const Real* coordinate) const
+{
+  const Real* min = box_min(boxes,i);
+  const Real* max = box_max(boxes,i);
+  Real result = 0.;
+  for (Uint d=0; d<m_dim; ++d)
+  {
+    const Real outside = std::max(min[d]-coordinate[d], 0.) + std::max(coordinate[d]-max[d], 0.);
+    result += outside*outside;
+  }
+  return result;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+bool ElementTree::find_element(const Real* coordinate, RealVector& work_coordinate, RealMatrix& work_nodes, Entity& element) const
+{
+  if (m_nodes.empty() || !box_contains(m_node_boxes,0,coordinate))
+    return false;
+
+  for (Uint d=0; d<m_dim; ++d)
+    work_coordinate[d] = coordinate[d];
+
+  Uint stack[max_depth];
+  Uint stack_size = 0;
+  stack[stack_size++] = 0;
+  while (stack_size)
+  {
+    const Node& node = m_nodes[stack[--stack_size]];
+    if (node.children)
+    {
+      for (Uint c=node.children; c<node.children+2; ++c)
+      {
+        if (box_contains(m_node_boxes,c,coordinate))
+          stack[stack_size++] = c;
+      }
+      continue;
+    }
+
+    for (Uint i=node.begin; i<node.end; ++i)
+    {
+      if (!box_contains(m_element_boxes,i,coordinate))
+        continue;
+      const Entity& candidate = m_elements[i];
+      candidate.allocate_coordinates(work_nodes);
+      candidate.put_coordinates(work_nodes);
+      if (candidate.element_type().is_coord_in_element(work_coordinate,work_nodes))
+      {
+        element = candidate;
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+bool ElementTree::find_element(const RealVector& coordinate, Entity& element) const
+{
+  cf3_assert(coordinate.size() == static_cast<int>(m_dim));
+  RealVector work_coordinate(m_dim);
+  RealMatrix work_nodes;
+  return find_element(coordinate.data(), work_coordinate, work_nodes, element);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void ElementTree::find_elements(const boost::multi_array<Real,2>& coordinates, std::vector<Entity>& elements) const
+{
+  const int nb_coords = static_cast<int>(coordinates.size());
+  elements.assign(nb_coords, Entity());
+  if (nb_coords == 0)
+    return;
+  cf3_assert(coordinates.shape()[1] >= m_dim);
+
+  // Exceptions can't leave the parallel region, so the first one is stored and rethrown afterwards
+  std::exception_ptr error;
+  #pragma omp parallel num_threads(nb_threads())
+  {
+    RealVector work_coordinate(m_dim);
+    RealMatrix work_nodes;
+    std::vector<Real> coordinate(m_dim);
+    #pragma omp for schedule(dynamic,64)
+    for (int i = 0; i < nb_coords; ++i)
+    {
+      try
+      {
+        for (Uint d=0; d<m_dim; ++d)
+          coordinate[d] = coordinates[i][d];
+        find_element(&coordinate[0], work_coordinate, work_nodes, elements[i]);
+      }
+      catch(...)
+      {
+        #pragma omp critical
+        {
+          if(!error)
+            error = std::current_exception();
+        }
+      }
+    }
+  }
+
+  if(error)
+    std::rethrow_exception(error);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+bool ElementTree::find_closest_element(const RealVector& coordinate, Entity& element) const
+{
+  cf3_assert(coordinate.size() == static_cast<int>(m_dim));
+  if (m_nodes.empty())
+    return false;
+
+  // Depth-first search, visiting the nearest child first and skipping nodes that are farther than the best centroid so far
+  Real best_distance2 = math::Consts::real_max();
+  Uint best = 0;
+  Uint stack[max_depth];
+  Uint stack_size = 0;
+  stack[stack_size++] = 0;
+  while (stack_size)
+  {
+    const Uint node_idx = stack[--stack_size];
+    if (box_distance2(m_node_boxes,node_idx,coordinate.data()) >= best_distance2)
+      continue;
+
+    const Node& node = m_nodes[node_idx];
+    if (node.children)
+    {
+      const Uint near = node.children;
+      const Uint far = node.children+1;
+      if (box_distance2(m_node_boxes,near,coordinate.data()) <= box_distance2(m_node_boxes,far,coordinate.data()))
+      {
+        stack[stack_size++] = far;
+        stack[stack_size++] = near;
+      }
+      else
+      {
+        stack[stack_size++] = near;
+        stack[stack_size++] = far;
+      }
+      continue;
+    }
+
+    for (Uint i=node.begin; i<node.end; ++i)
+    {
+      Real distance2 = 0.;
+      for (Uint d=0; d<m_dim; ++d)
+        distance2 += (m_centroids[i*m_dim+d]-coordinate[d])*(m_centroids[i*m_dim+d]-coordinate[d]);
+      if (distance2 < best_distance2)
+      {
+        best_distance2 = distance2;
+        best = i;
+      }
+    }
+  }
+
+  element = m_elements[best];
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void ElementTree::gather_elements_in_box(const RealVector& min, const RealVector& max, std::vector<Entity>& elements) const
+{
+  cf3_assert(min.size() == static_cast<int>(m_dim));
+  cf3_assert(max.size() == static_cast<int>(m_dim));
+  if (m_nodes.empty())
+    return;
+
+  Uint stack[max_depth];
+  Uint stack_size = 0;
+  stack[stack_size++] = 0;
+  while (stack_size)
+  {
+    const Uint node_idx = stack[--stack_size];
+    const Real* node_min = box_min(m_node_boxes,node_idx);
+    const Real* node_max = box_max(m_node_boxes,node_idx);
+    bool overlaps = true;
+    for (Uint d=0; d<m_dim && overlaps; ++d)
+      overlaps = node_min[d] <= max[d] && node_max[d] >= min[d];
+    if (!overlaps)
+      continue;
+
+    const Node& node = m_nodes[node_idx];
+    if (node.children)
+    {
+      stack[stack_size++] = node.children+1;
+      stack[stack_size++] = node.children;
+      continue;
+    }
+
+    for (Uint i=node.begin; i<node.end; ++i)
+    {
+      bool inside = true;
+      for (Uint d=0; d<m_dim && inside; ++d)
+        inside = m_centroids[i*m_dim+d] >= min[d] && m_centroids[i*m_dim+d] <= max[d];
+      if (inside)
+        elements.push_back(m_elements[i]);
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+} // mesh
+} // cf3
@@ -0,0 +1,112 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_mesh_ElementTree_hpp
+#define cf3_mesh_ElementTree_hpp
+
+////////////////////////////////////////////////////////////////////////////////
+
+#include <vector>
+
+#include "common/BoostArray.hpp"
+
+#include "math/MatrixTypes.hpp"
+
+#include "mesh/Entities.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace mesh {
+
+  class Mesh;
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// @brief Bounding volume hierarchy over the volume elements of a mesh
+///
+/// Each node of the tree holds the bounding box of its elements. Nodes are split at the median
+/// centroid along their longest direction, until they contain at most a given number of elements,
+/// so the tree follows the local element size, also for strongly stretched meshes.
+/// The nodes, the element boxes and the elements are stored in flat arrays, in the order of the leaves.
+/// All queries are const, and can be called from several threads at once.
+class Mesh_API ElementTree
+{
+public:
+
+  ElementTree();
+
+  /// Build the tree from the volume elements of the given mesh
+  /// @param nb_elems_per_leaf  Maximum number of elements in a leaf of the tree
+  void build(const Mesh& mesh, const Uint nb_elems_per_leaf);
+
+  /// Release all storage
+  void clear();
+
+  bool empty() const { return m_nodes.empty(); }
+
+  Uint dimension() const { return m_dim; }
+
+  /// Number of elements in the tree
+  Uint size() const { return m_elements.size(); }
+
+  /// Number of nodes in the tree
+  Uint nb_nodes() const { return m_nodes.size(); }
+
+  /// @brief Find the element that contains a given coordinate
+  /// @return false if no element contains the coordinate
+  bool find_element(const RealVector& coordinate, Entity& element) const;
+
+  /// @brief Find the elements that contain each row of the given coordinates, using all threads
+  /// @param elements [out] the found elements. Coordinates that are not found get a null Entity.
+  void find_elements(const boost::multi_array<Real,2>& coordinates, std::vector<Entity>& elements) const;
+
+  /// @brief Find the element with the centroid closest to the given coordinate
+  /// @return false if the tree is empty
+  bool find_closest_element(const RealVector& coordinate, Entity& element) const;
+
+  /// Append the elements with a centroid inside the box [min, max] to the given vector
+  void gather_elements_in_box(const RealVector& min, const RealVector& max, std::vector<Entity>& elements) const;
+
+private:
+
+  struct Node
+  {
+    Uint begin;
+    Uint end;
+    /// Index of the first of both children, or 0 for a leaf
+    Uint children;
+  };
+
+  bool find_element(const Real* coordinate, RealVector& work_coordinate, RealMatrix& work_nodes, Entity& element) const;
+
+  /// Minimum and maximum of box i in a flat array of boxes
+  const Real* box_min(const std::vector<Real>& boxes, const Uint i) const { return &boxes[2*m_dim*i]; }
+  const Real* box_max(const std::vector<Real>& boxes, const Uint i) const { return &boxes[2*m_dim*i + m_dim]; }
+
+  bool box_contains(const std::vector<Real>& boxes, const Uint i, const Real* coordinate) const;
+
+  /// Squared distance from a coordinate to box i
+  Real box_distance2(const std::vector<Real>& boxes, const Uint i, const Real* coordinate) const;
+
+  Uint m_dim;
+
+  std::vector<Node> m_nodes;
+  std::vector<Real> m_node_boxes;
+
+  std::vector<Entity> m_elements;
+  std::vector<Real> m_element_boxes;
+  std::vector<Real> m_centroids;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // mesh
+} // cf3
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif // cf3_mesh_ElementTree_hpp
@@ -12,11 +12,13 @@
 #include "common/Builder.hpp"
 #include "common/DynTable.hpp"
 #include "common/OptionList.hpp"
+#include "common/Threads.hpp"
 
 #include "math/MatrixTypes.hpp"
 #include "math/Consts.hpp"
 
 #include "mesh/FaceCellConnectivity.hpp"
+#include "mesh/FaceNodeTable.hpp"
 #include "mesh/NodeElementConnectivity.hpp"
 #include "mesh/Dictionary.hpp"
 #include "mesh/Mesh.hpp"
@@ -125,9 +127,6 @@ void FaceCellConnectivity::build_connectivity()
   common::Table<Uint>::Buffer cell_rotation = m_cell_rotation->create_buffer();
   common::Table<bool>::Buffer cell_orientation = m_cell_orientation->create_buffer();
 
-  Dictionary& geometry_fields = find_parent_component<Mesh>(*used()[0]).geometry_fields();
-  Uint tot_nb_nodes = geometry_fields.size();
-  std::vector < std::vector<Uint> > mapNodeFace(tot_nb_nodes);
   std::vector<Uint> face_nodes;  face_nodes.reserve(100);
   std::vector<Entity> dummy_element_row(2);
   std::vector<Uint> tmp_row(2);
@@ -165,140 +164,127 @@ void FaceCellConnectivity::build_connectivity()
     }
   }
 
+  // Faces that were found in only one element so far, identified by their sorted nodes.
+  // Matched faces are removed, so at most the boundary faces remain at the end.
+  FaceNodeTable open_faces;
+  open_faces.reserve(max_nb_faces/2);
+
+  // Sorted nodes and hashes of the faces of all elements in one Elements component
+  std::vector<Uint> sorted_face_nodes;
+  std::vector<std::size_t> face_hashes;
+  std::vector<Uint> face_nodes_offset;
+
   // Declarations to save frequent allocations in the loop algorithm
   Uint nb_inner_faces = 0;
-  Uint nb_matched_nodes = 1;
-  Uint face_node_idx;
-  Uint face_node;
-  Uint face;
-  Uint connected_face;
-  Uint node;
   Uint nb_nodes;
-  bool found_face = false;
-  Handle< Component > elem_location_comp;
-  Uint elem_location_idx;
 
   // loop over the element types
   m_nb_faces=0;
   boost_foreach (Handle< Component > elements_comp, used() )
   {
     Elements& elements = dynamic_cast<Elements&>(*elements_comp);
-    const Uint nb_faces_in_elem = elements.element_type().nb_faces();
+    const ElementType& element_type = elements.element_type();
+    const Uint nb_faces_in_elem = element_type.nb_faces();
+    const Connectivity& connectivity = elements.geometry_space().connectivity();
+    const Uint nb_elem = connectivity.size();
 
     Handle< common::List<bool> > is_bdry_elem;
 
     if (m_face_building_algorithm)
       is_bdry_elem = Handle< common::List<bool> >(elements.get_child("is_bdry"));
 
-    // loop over the elements of this type
-    Uint loc_elem_idx=0;
-    boost_foreach(Connectivity::ConstRow elem_nodes, elements.geometry_space().connectivity().array() )
+    // Position of the nodes of each face, relative to the first face of its element
+    face_nodes_offset.assign(1,0);
+    for (Uint face_idx = 0; face_idx != nb_faces_in_elem; ++face_idx)
+      face_nodes_offset.push_back(face_nodes_offset.back() + element_type.face_type(face_idx).nb_nodes());
+    const Uint nb_face_nodes_in_elem = face_nodes_offset.back();
+
+    // Sort and hash the face nodes. This only depends on the element itself, so it is done for all elements at once, using threads.
+    sorted_face_nodes.resize(nb_elem*nb_face_nodes_in_elem);
+    face_hashes.resize(nb_elem*nb_faces_in_elem);
+    const int nb_elem_int = static_cast<int>(nb_elem);
+    #pragma omp parallel for num_threads(common::nb_threads()) schedule(static)
+    for (int e = 0; e < nb_elem_int; ++e)
+    {
+      if ( is_not_null(is_bdry_elem) && (*is_bdry_elem)[e] == false )
+        continue;
+      Connectivity::ConstRow elem_nodes = connectivity[e];
+      for (Uint face_idx = 0; face_idx != nb_faces_in_elem; ++face_idx)
+      {
+        Uint* face_begin = &sorted_face_nodes[e*nb_face_nodes_in_elem + face_nodes_offset[face_idx]];
+        Uint i(0);
+        boost_foreach(const Uint face_node_idx, element_type.faces().nodes_range(face_idx))
+          face_begin[i++] = elem_nodes[face_node_idx];
+        face_hashes[e*nb_faces_in_elem + face_idx] = FaceNodeTable::make_key(face_begin, i);
+      }
+    }
+
+    // loop over the elements of this type, in order, so the faces are numbered as they are first encountered
+    for (Uint loc_elem_idx=0; loc_elem_idx<nb_elem; ++loc_elem_idx)
     {
       if ( is_not_null(is_bdry_elem) )
         if ( (*is_bdry_elem)[loc_elem_idx] == false )
           continue;
 
+      Connectivity::ConstRow elem_nodes = connectivity[loc_elem_idx];
       Entity element(elements,loc_elem_idx);
 
       // loop over the faces in the current element
       for (Uint face_idx = 0; face_idx != nb_faces_in_elem; ++face_idx)
       {
-        // construct sets of nodes that make the corresponding face in this element
-        nb_nodes = elements.element_type().face_type(face_idx).nb_nodes();
-        face_nodes.resize(nb_nodes);
-
-        Uint i(0);
-        boost_foreach(const Uint face_node_idx, elements.element_type().faces().nodes_range(face_idx))
-            face_nodes[i++] = elem_nodes[face_node_idx];
-
+        nb_nodes = face_nodes_offset[face_idx+1] - face_nodes_offset[face_idx];
+        const Uint* sorted_nodes = &sorted_face_nodes[loc_elem_idx*nb_face_nodes_in_elem + face_nodes_offset[face_idx]];
+        const std::size_t hash = face_hashes[loc_elem_idx*nb_faces_in_elem + face_idx];
+        cf3_assert(sorted_nodes[nb_nodes-1]<find_parent_component<Mesh>(*used()[0]).geometry_fields().size());
 
-        // consider the first node belonging to the current face
-        // check if you find a face ID shared between all the other
-        // nodes building a face
-        node = face_nodes[0];
-        cf3_assert(node<tot_nb_nodes);
-
-        found_face = false;
-        // search for matching face if they are registered to the node yet
-        boost_foreach( face, mapNodeFace[node] )
+        const Uint face = open_faces.find(sorted_nodes, nb_nodes, hash);
+        if (face != FaceNodeTable::not_found)
         {
-          nb_matched_nodes = 1;
+          // the corresponding face already exists, meaning
+          // that the face is an internal one, shared by two elements
+          // here you set the second element (==state) neighbor of the face
+          open_faces.erase(sorted_nodes, nb_nodes, hash);
+          f2c.get_row(face)[1]=element;
+          face_number.get_row(face)[1]=face_idx;
+          // since it has two neighbor cells,
+          // this face is surely NOT a boundary face
+          is_bdry_face.get_row(face)=false;
+
           if (nb_nodes > 1)
           {
-            for (face_node_idx=1; face_node_idx!=nb_nodes; ++face_node_idx)
+            // construct the nodes that make the corresponding face in this element, in the order of this element
+            face_nodes.resize(nb_nodes);
+            Uint i(0);
+            boost_foreach(const Uint face_node_idx, element_type.faces().nodes_range(face_idx))
+                face_nodes[i++] = elem_nodes[face_node_idx];
+
+            // First node in first face element:
+            Uint first_node_loc_idx = f2c.get_row(face)[0].get_nodes()[
+                                        f2c.get_row(face)[0].element_type().faces().nodes_range(
+                                          face_number.get_row(face)[0])[0]
+                                      ];
+
+            // Find orientation ( or find match between first face-nodes of both neighbouring elements )
+            Uint rotation;
+            for (rotation=0; rotation<=nb_nodes; ++rotation)
             {
-              boost_foreach (connected_face, mapNodeFace[face_nodes[face_node_idx]])
-              {
-                if (connected_face == face)
-                {
-                  ++nb_matched_nodes;
-                  break;
-                }
-              }
-
-
-              if (nb_matched_nodes == nb_nodes) // face matches the nodes
+              if (face_nodes[rotation] == first_node_loc_idx)
               {
-                // the corresponding face already exists, meaning
-                // that the face is an internal one, shared by two elements
-                // here you set the second element (==state) neighbor of the face
-                found_face = true;
-                f2c.get_row(face)[1]=element;
-                face_number.get_row(face)[1]=face_idx;
-                // since it has two neighbor cells,
-                // this face is surely NOT a boundary face
-                is_bdry_face.get_row(face)=false;
-
-                // First node in first face element:
-                Uint first_node_loc_idx = f2c.get_row(face)[0].get_nodes()[
-                                            f2c.get_row(face)[0].element_type().faces().nodes_range(
-                                              face_number.get_row(face)[0])[0]
-                                          ];
-
-                // Find orientation ( or find match between first face-nodes of both neighbouring elements )
-                Uint rotation;
-                for (rotation=0; rotation<=nb_nodes; ++rotation)
-                {
-                  if (face_nodes[rotation] == first_node_loc_idx)
-                  {
-                    cell_rotation.get_row(face)[1]=rotation;
-                    break;
-                  }
-                }
-                // Following assertion fails, it means the correct orientation was not found! This should never happen!
-                cf3_always_assert(rotation != nb_nodes);
-
-                // increment number of inner faces (they always have 2 states)
-                ++nb_inner_faces;
+                cell_rotation.get_row(face)[1]=rotation;
                 break;
               }
             }
+            // Following assertion fails, it means the correct orientation was not found! This should never happen!
+            cf3_always_assert(rotation != nb_nodes);
           }
-          else // this only applies to the 1D case
-          {
-            // the corresponding faceID already exists, meaning
-            // that the face is an internal one, shared by two elements
-            // here you set the second element (==state) neighbor of the face
-            found_face = true;
-            //(*elem_to_face)[elemID][iFace] = currFaceID;
-            f2c.get_row(face)[1]=element;
-            face_number.get_row(face)[1]=face_idx;
-            is_bdry_face.get_row(face)=false;
-
-            // increment number of inner faces (they always have 2 states)
-            ++nb_inner_faces;
-            break;
-          }
+
+          // increment number of inner faces (they always have 2 states)
+          ++nb_inner_faces;
         }
-        if (found_face == false)
+        else
         {
           // a new face has been found
-          // add the ID of the new face in the corresponding nodes
-          // referencing it
-          boost_foreach (face_node, face_nodes)
-          {
-            mapNodeFace[face_node].push_back(m_nb_faces);
-          }
+          open_faces.insert(sorted_nodes, nb_nodes, hash, m_nb_faces);
 
           // increment the number of faces
           dummy_element_row[0]=element;
@@ -316,7 +302,6 @@ void FaceCellConnectivity::build_connectivity()
           ++m_nb_faces;
         }
       }
-      ++loc_elem_idx;
     } // end foreach element
   } // end foreach elements component
 
@@ -0,0 +1,162 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include <algorithm>
+
+#include <boost/functional/hash.hpp>
+
+#include "math/Consts.hpp"
+
+#include "mesh/FaceNodeTable.hpp"
+
+namespace cf3 {
+namespace mesh {
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+  enum SlotState { EMPTY=0, USED=1, ERASED=2 };
+  const Uint min_capacity = 16;
+}
+
+const Uint FaceNodeTable::not_found = math::Consts::uint_max();
+
+////////////////////////////////////////////////////////////////////////////////
+
+FaceNodeTable::FaceNodeTable() :
+  m_nb_used(0),
+  m_nb_erased(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void FaceNodeTable::reserve(const Uint nb_faces)
+{
+  // Keep the load factor below one half
+  Uint capacity = min_capacity;
+  while (capacity < 2*nb_faces)
+    capacity *= 2;
+  if (capacity > m_slots.size())
+    rehash(capacity);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void FaceNodeTable::clear()
+{
+  m_slots.clear();
+  m_nodes.clear();
+  m_nb_used = 0;
+  m_nb_erased = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+std::size_t FaceNodeTable::make_key(Uint* nodes, const Uint nb_nodes)
+{
+  std::sort(nodes, nodes+nb_nodes);
+  return boost::hash_range(nodes, nodes+nb_nodes);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Uint FaceNodeTable::probe(const Uint* sorted_nodes, const Uint nb_nodes, const std::size_t hash) const
+{
+  const Uint mask = m_slots.size()-1;
+  for (Uint s = hash & mask; ; s = (s+1) & mask)
+  {
+    const Slot& slot = m_slots[s];
+    if (slot.state == EMPTY)
+      return s;
+    if (slot.state == USED && slot.hash == hash && slot.nb_nodes == nb_nodes
+        && std::equal(sorted_nodes, sorted_nodes+nb_nodes, m_nodes.begin()+slot.nodes_begin))
+      return s;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Uint FaceNodeTable::find(const Uint* sorted_nodes, const Uint nb_nodes, const std::size_t hash) const
+{
+  if (m_slots.empty())
+    return not_found;
+  const Slot& slot = m_slots[probe(sorted_nodes, nb_nodes, hash)];
+  return slot.state == USED ? slot.value : not_found;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void FaceNodeTable::insert(const Uint* sorted_nodes, const Uint nb_nodes, const std::size_t hash, const Uint value)
+{
+  // Erased slots are only reused after a rehash, so they count for the load factor
+  if (2*(m_nb_used+m_nb_erased+1) > m_slots.size())
+    grow();
+
+  const Uint s = probe(sorted_nodes, nb_nodes, hash);
+  cf3_assert(m_slots[s].state == EMPTY);
+  Slot& slot = m_slots[s];
+  slot.hash = hash;
+  slot.nodes_begin = m_nodes.size();
+  slot.nb_nodes = nb_nodes;
+  slot.value = value;
+  slot.state = USED;
+  m_nodes.insert(m_nodes.end(), sorted_nodes, sorted_nodes+nb_nodes);
+  ++m_nb_used;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool FaceNodeTable::erase(const Uint* sorted_nodes, const Uint nb_nodes, const std::size_t hash)
+{
+  if (m_slots.empty())
+    return false;
+  Slot& slot = m_slots[probe(sorted_nodes, nb_nodes, hash)];
+  if (slot.state != USED)
+    return false;
+  slot.state = ERASED;
+  --m_nb_used;
+  ++m_nb_erased;
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void FaceNodeTable::grow()
+{
+  // Rehashing drops the erased slots, so the capacity is only doubled if many faces are in use
+  Uint capacity = std::max(static_cast<Uint>(m_slots.size()), min_capacity);
+  if (4*(m_nb_used+1) > capacity)
+    capacity *= 2;
+  rehash(capacity);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void FaceNodeTable::rehash(const Uint capacity)
+{
+  // Value-initialized slots are empty
+  std::vector<Slot> old_slots(capacity);
+  old_slots.swap(m_slots);
+  std::vector<Uint> old_nodes;
+  old_nodes.swap(m_nodes);
+  m_nodes.reserve(old_nodes.size());
+
+  m_nb_used = 0;
+  m_nb_erased = 0;
+  for (Uint s=0; s<old_slots.size(); ++s)
+  {
+    const Slot& slot = old_slots[s];
+    if (slot.state == USED)
+      insert(&old_nodes[slot.nodes_begin], slot.nb_nodes, slot.hash, slot.value);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // mesh
+} // cf3
@@ -0,0 +1,93 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_mesh_FaceNodeTable_hpp
+#define cf3_mesh_FaceNodeTable_hpp
+
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cstddef>
+#include <vector>
+
+#include "common/CF.hpp"
+
+#include "mesh/LibMesh.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace mesh {
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// @brief Hash table that finds faces by their nodes
+///
+/// A face is identified by its sorted node indices, so faces of neighbouring cells match regardless
+/// of their orientation and rotation. The sorted nodes of all faces are stored contiguously and the
+/// table uses open addressing with linear probing, so no memory is allocated for individual faces.
+///
+/// The key of a face is made by make_key(), which only depends on the face itself, so keys
+/// can be computed concurrently before they are used in the (sequential) table operations.
+class Mesh_API FaceNodeTable
+{
+public:
+
+  /// Value returned by find() if the face is not in the table
+  static const Uint not_found;
+
+  FaceNodeTable();
+
+  /// Prepare the table for the given number of faces
+  void reserve(const Uint nb_faces);
+
+  /// Remove all faces
+  void clear();
+
+  /// Number of faces in the table
+  Uint size() const { return m_nb_used; }
+
+  /// Sort the given nodes in place and return their hash
+  static std::size_t make_key(Uint* nodes, const Uint nb_nodes);
+
+  /// Value stored for the face with the given sorted nodes and hash, or not_found
+  Uint find(const Uint* sorted_nodes, const Uint nb_nodes, const std::size_t hash) const;
+
+  /// Add a face that is not in the table yet
+  void insert(const Uint* sorted_nodes, const Uint nb_nodes, const std::size_t hash, const Uint value);
+
+  /// Remove a face, returning false if it was not in the table
+  bool erase(const Uint* sorted_nodes, const Uint nb_nodes, const std::size_t hash);
+
+private:
+  struct Slot
+  {
+    std::size_t hash;
+    Uint nodes_begin;
+    Uint nb_nodes;
+    Uint value;
+    /// empty, used or erased
+    char state;
+  };
+
+  /// Index of the slot containing the face, or of the empty slot that ends the probe sequence
+  Uint probe(const Uint* sorted_nodes, const Uint nb_nodes, const std::size_t hash) const;
+  void grow();
+  void rehash(const Uint capacity);
+
+  std::vector<Slot> m_slots;
+  std::vector<Uint> m_nodes;
+  Uint m_nb_used;
+  Uint m_nb_erased;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // mesh
+} // cf3
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif // cf3_mesh_FaceNodeTable_hpp
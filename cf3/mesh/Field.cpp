@@ -164,6 +164,14 @@ void Field::synchronize()
   if(!common::PE::Comm::instance().is_active())
     return;
 
+  CFdebug << "Synchronizing field " << uri().path() << CFendl;
+  comm_pattern().synchronize( name() );
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+CommPattern& Field::comm_pattern()
+{
   if(is_null(m_comm_pattern))
   {
     CFdebug << "Applying default parallelization from dict for field " << uri().path() << CFendl;
@@ -171,9 +179,39 @@ void Field::synchronize()
   }
 
   cf3_assert(is_not_null(m_comm_pattern));
+  return *m_comm_pattern;
+}
 
-  CFdebug << "Synchronizing field " << uri().path() << CFendl;
-  m_comm_pattern->synchronize( name() );
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void synchronize_fields(const std::vector< Handle<Field> >& fields)
+{
+  if(!common::PE::Comm::instance().is_active())
+    return;
+
+  // Group the field names per comm pattern, keeping the order of the patterns in which they first appear
+  std::vector< Handle<CommPattern> > patterns;
+  std::vector< std::vector<std::string> > names;
+  BOOST_FOREACH(const Handle<Field>& field, fields)
+  {
+    CommPattern& comm_pattern = field->comm_pattern();
+    const Uint nb_patterns = patterns.size();
+    Uint pattern_idx = 0;
+    while(pattern_idx != nb_patterns && patterns[pattern_idx].get() != &comm_pattern)
+      ++pattern_idx;
+    if(pattern_idx == nb_patterns)
+    {
+      patterns.push_back(comm_pattern.handle<CommPattern>());
+      names.push_back(std::vector<std::string>());
+    }
+    names[pattern_idx].push_back(field->name());
+  }
+
+  for(Uint i = 0; i != patterns.size(); ++i)
+  {
+    CFdebug << "Synchronizing " << names[i].size() << " fields with comm pattern " << patterns[i]->uri().path() << CFendl;
+    patterns[i]->synchronize(names[i]);
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////
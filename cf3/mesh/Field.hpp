@@ -124,6 +124,9 @@ public: // functions
 
   void synchronize();
 
+  /// The comm pattern used to synchronize this field. The default parallelization from the dict is applied if needed.
+  common::PE::CommPattern& comm_pattern();
+
   math::VariablesDescriptor& descriptor() const { return *m_descriptor; }
 
   void set_descriptor(math::VariablesDescriptor& descriptor);
@@ -330,6 +333,12 @@ private:
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
+/// Synchronize several fields at once. Fields that share a comm pattern are exchanged together,
+/// in a single message per neighbouring rank. The fields must be given in the same order on all ranks.
+Mesh_API void synchronize_fields(const std::vector< Handle<Field> >& fields);
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
 } // mesh
 } // cf3
 
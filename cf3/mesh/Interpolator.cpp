@@ -4,6 +4,10 @@
 // GNU Lesser General Public License version 3 (LGPLv3).
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 #include <boost/function.hpp>
 #include <boost/bind.hpp>
 
@@ -15,6 +19,7 @@
 #include "common/OptionT.hpp"
 #include "common/Signal.hpp"
 #include "common/XML/SignalOptions.hpp"
+#include "common/PE/Comm.hpp"
 #include "common/PE/debug.hpp"
 
 #include "mesh/Interpolator.hpp"
@@ -58,155 +63,180 @@ Interpolator::Interpolator(const std::string &name) :
 
 ////////////////////////////////////////////////////////////////////////////////
 
+namespace
+{
+
+/// Exchange variable-sized data between all processes
 template <typename T>
-void Interpolator_send_receive(const Uint send_to_pid, std::vector<T>& send, const Uint receive_from_pid, std::vector<T>& receive)
+void Interpolator_exchange(const std::vector< std::vector<T> >& send, std::vector< std::vector<T> >& receive)
 {
-  if (send_to_pid == PE::Comm::instance().rank() &&
-      receive_from_pid == PE::Comm::instance().rank())
-  {
+  if (PE::Comm::instance().is_active())
+    PE::Comm::instance().all_to_all(send, receive);
+  else
     receive = send;
-      return;
-  }
-  size_t recv_size;
-  size_t send_size = send.size();
-  MPI_Sendrecv(&send_size, 1, PE::get_mpi_datatype<size_t>(), (int)send_to_pid, 0,
-               &recv_size, 1, PE::get_mpi_datatype<size_t>(), (int)receive_from_pid, 0,
-               PE::Comm::instance().communicator(), MPI_STATUS_IGNORE);
-  receive.resize(recv_size);
-  MPI_Sendrecv(&send[0], (int)send.size(), PE::get_mpi_datatype<T>(), (int)send_to_pid, 0,
-               &receive[0], (int)receive.size(), PE::get_mpi_datatype<T>(), (int)receive_from_pid, 0,
-               PE::Comm::instance().communicator(), MPI_STATUS_IGNORE);
 }
 
-////////////////////////////////////////////////////////////////////////////////
-
-
-void Interpolator::store(const Dictionary& dict, const Table<Real>& target_coords)
+/// Send each target coordinate only to the processes whose bounding box contains it.
+/// The local bounding boxes of the mesh of the source dictionary are exchanged once, so locating the coordinates
+/// takes a single sparse exchange instead of a round for every process.
+/// @param [out] send_coords  Coordinates to send to each process
+/// @param [out] sent_ids     Index in target_coords of each coordinate sent to each process
+void Interpolator_route_coordinates(const Dictionary& dict, const Table<Real>& target_coords, std::vector< std::vector<Real> >& send_coords, std::vector< std::vector<Uint> >& sent_ids)
 {
-  m_dict  = dict.handle<Dictionary>();
-  m_table = target_coords.handle< Table<Real> >();
-
-  cf3_assert(m_point_interpolator);
-  m_point_interpolator->options().set("dict", const_cast<Dictionary*>(m_dict.get())->handle<Dictionary>());
-
-  Uint nb_coords = target_coords.size();
-  Uint dim = target_coords.row_size();
-
-  std::vector<Uint> not_found; not_found.reserve(nb_coords);
-  for (Uint i=0; i<nb_coords; ++i)
-    not_found.push_back(i);
-
-  m_proc.resize(nb_coords,-1);
-
-  m_proc.clear();
-  m_expect_recv.clear();
-  m_stored_element.clear();
-  m_stored_stencil.clear();
-  m_stored_source_field_points.clear();
-  m_stored_source_field_weights.clear();
-
-  m_expect_recv.resize(PE::Comm::instance().size());
-  m_stored_element.resize(PE::Comm::instance().size());
-  m_stored_stencil.resize(PE::Comm::instance().size());
-  m_stored_source_field_points.resize(PE::Comm::instance().size());
-  m_stored_source_field_weights.resize(PE::Comm::instance().size());
+  const Uint nb_procs = PE::Comm::instance().size();
+  const Uint nb_coords = target_coords.size();
+  const Uint dim = target_coords.row_size();
 
+  // Local bounding box, stored as the minimum followed by the maximum
+  const Field& coordinates = find_parent_component<Mesh>(dict).geometry_fields().coordinates();
+  const Uint box_dim = std::min(dim, coordinates.row_size());
+  std::vector<Real> my_box(2*dim);
+  for (Uint d=0; d<dim; ++d)
+  {
+    my_box[d] = d < box_dim ? std::numeric_limits<Real>::max() : -std::numeric_limits<Real>::max();
+    my_box[dim+d] = d < box_dim ? -std::numeric_limits<Real>::max() : std::numeric_limits<Real>::max();
+  }
+  boost_foreach (Field::ConstRow node, coordinates.array())
+  {
+    for (Uint d=0; d<box_dim; ++d)
+    {
+      my_box[d] = std::min(my_box[d], node[d]);
+      my_box[dim+d] = std::max(my_box[dim+d], node[d]);
+    }
+  }
 
-  // Now find missing on other procs.
-  for (Uint pid=0; pid<PE::Comm::instance().size(); pid++)
+  // Grow the box a little, so points found within the tolerance of the element search are not missed
+  if (coordinates.size() != 0)
   {
-    // Trade my requests with processor send and recv
-    const Uint pid_send_coords = (PE::Comm::instance().rank() + pid) %
-                                  PE::Comm::instance().size();
-    const Uint pid_recv_coords = (PE::Comm::instance().size() + PE::Comm::instance().rank() - pid) %
-                                  PE::Comm::instance().size();
+    Real diagonal = 0.;
+    for (Uint d=0; d<box_dim; ++d)
+      diagonal += (my_box[dim+d]-my_box[d])*(my_box[dim+d]-my_box[d]);
+    const Real tolerance = 1e-6*std::sqrt(diagonal) + 1e-12;
+    for (Uint d=0; d<box_dim; ++d)
+    {
+      my_box[d] -= tolerance;
+      my_box[dim+d] += tolerance;
+    }
+  }
 
-    std::vector<Real> send_coords; send_coords.reserve(not_found.size()*target_coords.row_size());
-    std::vector<Real> received_coords;
+  std::vector<Real> boxes;
+  if (PE::Comm::instance().is_active())
+    PE::Comm::instance().all_gather(my_box, boxes);
+  else
+    boxes = my_box;
 
-    // fill in coords to send
-    boost_foreach (const Uint t, not_found)
+  send_coords.assign(nb_procs, std::vector<Real>());
+  sent_ids.assign(nb_procs, std::vector<Uint>());
+  for (Uint t=0; t<nb_coords; ++t)
+  {
+    Table<Real>::ConstRow coord = target_coords[t];
+    for (Uint pid=0; pid<nb_procs; ++pid)
     {
-      boost_foreach (const Real& xyz, target_coords[t])
+      const Real* box = &boxes[pid*2*dim];
+      bool inside = true;
+      for (Uint d=0; d<dim && inside; ++d)
+        inside = coord[d] >= box[d] && coord[d] <= box[dim+d];
+      if (inside)
       {
-        send_coords.push_back(xyz);
+        send_coords[pid].insert(send_coords[pid].end(), coord.begin(), coord.end());
+        sent_ids[pid].push_back(t);
       }
     }
+  }
+}
 
-    // send coords, and receive coords
-    Interpolator_send_receive(pid_send_coords,   send_coords,
-                              pid_recv_coords,   received_coords);
-
-    Uint nb_received_coords = received_coords.size()/dim;
+}
 
-    // Find interpolated
+////////////////////////////////////////////////////////////////////////////////
 
-    m_stored_element[pid_recv_coords].clear();
-    m_stored_stencil[pid_recv_coords].clear();
-    m_stored_source_field_points[pid_recv_coords].clear();
-    m_stored_source_field_weights[pid_recv_coords].clear();
 
-    m_stored_element[pid_recv_coords].reserve(nb_received_coords);
-    m_stored_stencil[pid_recv_coords].reserve(nb_received_coords);
-    m_stored_source_field_points[pid_recv_coords].reserve(nb_received_coords);
-    m_stored_source_field_weights[pid_recv_coords].reserve(nb_received_coords);
+void Interpolator::store(const Dictionary& dict, const Table<Real>& target_coords)
+{
+  m_dict  = dict.handle<Dictionary>();
+  m_table = target_coords.handle< Table<Real> >();
 
-    std::vector<Uint> send_found_coords;  send_found_coords.reserve(nb_received_coords);
+  cf3_assert(m_point_interpolator);
+  m_point_interpolator->options().set("dict", const_cast<Dictionary*>(m_dict.get())->handle<Dictionary>());
 
-    Uint dim = target_coords.row_size();
-    RealVector t_point(dim);
-    SpaceElem element;
-    std::vector<SpaceElem> stencil;
-    std::vector<Uint> points;
-    std::vector<Real> weights;
+  const Uint nb_procs = PE::Comm::instance().size();
+  const Uint nb_coords = target_coords.size();
+  const Uint dim = target_coords.row_size();
 
+  // Send the coordinates to the processes that may contain them
+  std::vector< std::vector<Real> > send_coords;
+  std::vector< std::vector<Uint> > sent_ids;
+  Interpolator_route_coordinates(dict, target_coords, send_coords, sent_ids);
+  std::vector< std::vector<Real> > received_coords;
+  Interpolator_exchange(send_coords, received_coords);
+
+  // Locate the received coordinates
+  std::vector< std::vector< SpaceElem              > > found_element(nb_procs);
+  std::vector< std::vector< std::vector<SpaceElem> > > found_stencil(nb_procs);
+  std::vector< std::vector< std::vector<Uint>      > > found_points(nb_procs);
+  std::vector< std::vector< std::vector<Real>      > > found_weights(nb_procs);
+  std::vector< std::vector<Uint> > send_found_coords(nb_procs);
+
+  RealVector t_point(dim);
+  SpaceElem element;
+  std::vector<SpaceElem> stencil;
+  std::vector<Uint> points;
+  std::vector<Real> weights;
+  for (Uint pid=0; pid<nb_procs; ++pid)
+  {
+    const Uint nb_received_coords = received_coords[pid].size()/dim;
     for (Uint t=0; t<nb_received_coords; ++t)
     {
-      t_point = RealVector::MapType(&received_coords[t*dim],dim);
-      bool interpolation_possible_on_this_proc =
-          m_point_interpolator->compute_storage(t_point,
-                                                element,
-                                                stencil,
-                                                points,
-                                                weights);
-
-      if (interpolation_possible_on_this_proc)
+      t_point = RealVector::MapType(&received_coords[pid][t*dim],dim);
+      if (m_point_interpolator->compute_storage(t_point, element, stencil, points, weights))
       {
-        m_stored_element[pid_recv_coords].push_back(element);
-        m_stored_stencil[pid_recv_coords].push_back(stencil);
-        m_stored_source_field_points[pid_recv_coords].push_back(points);
-        m_stored_source_field_weights[pid_recv_coords].push_back(weights);
-
-        // mark found
-        send_found_coords.push_back(t);
+        found_element[pid].push_back(element);
+        found_stencil[pid].push_back(stencil);
+        found_points[pid].push_back(points);
+        found_weights[pid].push_back(weights);
+        send_found_coords[pid].push_back(t);
       }
-
     }
+  }
 
-    std::vector<Uint> recv_found_coords;
-
-    const Uint pid_send_back = pid_recv_coords;
-    const Uint pid_recv_back = pid_send_coords;
-
-    Interpolator_send_receive (pid_send_back, send_found_coords,
-                               pid_recv_back, recv_found_coords);
-
-    m_expect_recv[pid_recv_back].reserve(recv_found_coords.size());
+  std::vector< std::vector<Uint> > recv_found_coords;
+  Interpolator_exchange(send_found_coords, recv_found_coords);
 
-    boost_foreach(const Uint i, recv_found_coords)
+  // Each coordinate is interpolated by the first process that found it, in rank order starting from this process
+  m_proc.assign(nb_coords, -1);
+  m_expect_recv.assign(nb_procs, std::vector<Uint>());
+  std::vector< std::vector<Uint> > send_selected(nb_procs);
+  for (Uint k=0; k<nb_procs; ++k)
+  {
+    const Uint pid = (PE::Comm::instance().rank() + k) % nb_procs;
+    for (Uint i=0; i<recv_found_coords[pid].size(); ++i)
     {
-      cf3_assert(i<not_found.size());
-      const Uint t = not_found[i];
+      const Uint t = sent_ids[pid][recv_found_coords[pid][i]];
       cf3_assert(t<nb_coords);
-      m_proc[t] = pid_recv_back;
-      m_expect_recv[pid_recv_back].push_back(t);
+      if (m_proc[t] < 0)
+      {
+        m_proc[t] = pid;
+        m_expect_recv[pid].push_back(t);
+        send_selected[pid].push_back(i);
+      }
     }
+  }
+
+  std::vector< std::vector<Uint> > recv_selected;
+  Interpolator_exchange(send_selected, recv_selected);
 
-    not_found.clear();
-    for (Uint t=0; t<nb_coords; ++t)
+  // Only keep the stencils of the coordinates this process interpolates
+  m_stored_element.assign(nb_procs, std::vector<SpaceElem>());
+  m_stored_stencil.assign(nb_procs, std::vector< std::vector<SpaceElem> >());
+  m_stored_source_field_points.assign(nb_procs, std::vector< std::vector<Uint> >());
+  m_stored_source_field_weights.assign(nb_procs, std::vector< std::vector<Real> >());
+  for (Uint pid=0; pid<nb_procs; ++pid)
+  {
+    boost_foreach (const Uint i, recv_selected[pid])
     {
-      if (m_proc[t]<0)
-        not_found.push_back(t);
+      m_stored_element[pid].push_back(found_element[pid][i]);
+      m_stored_stencil[pid].push_back(found_stencil[pid][i]);
+      m_stored_source_field_points[pid].push_back(found_points[pid][i]);
+      m_stored_source_field_weights[pid].push_back(found_weights[pid][i]);
     }
   }
 }
@@ -215,30 +245,20 @@ void Interpolator::store(const Dictionary& dict, const Table<Real>& target_coord
 
 void Interpolator::stored_interpolation(const Field& source_field, Table<Real>& target)
 {
-  // Do interpolation on processors that can do the interpolation,
-  // and send back an array of interpolated values
-  for (Uint pid=0; pid<PE::Comm::instance().size(); pid++)
-  {
-    // Trade my requests with processor send and recv
-    const Uint pid_send_interpolated = (PE::Comm::instance().size() + PE::Comm::instance().rank() - pid) %
-                                        PE::Comm::instance().size();
-    const Uint pid_recv_interpolated = (PE::Comm::instance().rank() + pid) %
-                                        PE::Comm::instance().size();
-
-    // number of points to be interpolated
-    const Uint nb_points = m_stored_element[pid_send_interpolated].size();
-
-    // number of variables for each point to be interpolated
-    const Uint nb_vars = m_source_vars.size();
+  const Uint nb_procs = PE::Comm::instance().size();
 
-    // storage for interpolated variables, which will be sent to the pid that reqests it (pid_recv_interpolated)
-    std::vector<Real> interpolated; interpolated.reserve(nb_points*nb_vars);
+  // number of variables for each point to be interpolated
+  const Uint nb_vars = m_source_vars.size();
 
-    // Interpolation points and weights
-    const std::vector< std::vector<Uint> >& s_points  = m_stored_source_field_points[pid_send_interpolated];
-    const std::vector< std::vector<Real> >& s_weights = m_stored_source_field_weights[pid_send_interpolated];
-
-    // Do interpolation
+  // Do interpolation for the points requested by each process
+  std::vector< std::vector<Real> > send_interpolated(nb_procs);
+  for (Uint pid=0; pid<nb_procs; ++pid)
+  {
+    const std::vector< std::vector<Uint> >& s_points  = m_stored_source_field_points[pid];
+    const std::vector< std::vector<Real> >& s_weights = m_stored_source_field_weights[pid];
+    const Uint nb_points = s_points.size();
+    std::vector<Real>& interpolated = send_interpolated[pid];
+    interpolated.reserve(nb_points*nb_vars);
     for (Uint t=0; t<nb_points; ++t)
     {
       for (Uint v=0; v<nb_vars; ++v)
@@ -251,20 +271,21 @@ void Interpolator::stored_interpolation(const Field& source_field, Table<Real>&
         }
       }
     }
+  }
 
-    // Send/Receive interpolated variables
-    std::vector<Real> recv_interpolated;
-    Interpolator_send_receive(pid_send_interpolated   , interpolated,
-                              pid_recv_interpolated   , recv_interpolated);
+  std::vector< std::vector<Real> > recv_interpolated;
+  Interpolator_exchange(send_interpolated, recv_interpolated);
 
-    // Fill the target_field with received interpolated variables from requested processor
+  // Fill the target with the interpolated variables received from each process
+  for (Uint pid=0; pid<nb_procs; ++pid)
+  {
     Uint it=0;
-    boost_foreach( const Uint t, m_expect_recv[pid_recv_interpolated] )
+    boost_foreach( const Uint t, m_expect_recv[pid] )
     {
       for (Uint v=0; v<nb_vars; ++v)
       {
         cf3_assert(t<target.size());
-        target[t][ m_target_vars[v] ] = recv_interpolated[it++];
+        target[t][ m_target_vars[v] ] = recv_interpolated[pid][it++];
       }
     }
   }
@@ -281,97 +302,63 @@ void Interpolator::unstored_interpolation(const Field& source_field, const commo
   cf3_assert(m_point_interpolator);
   m_point_interpolator->options().set("dict", const_cast<Dictionary*>(&source_field.dict())->handle<Dictionary>());
 
+  const Uint nb_procs = PE::Comm::instance().size();
   const Uint nb_coords = target_coords.size();
   const Uint dim = target_coords.row_size();
 
-  std::vector<int> not_found; not_found.reserve(nb_coords);
-  for (Uint i=0; i<nb_coords; ++i)
-    not_found.push_back(i);
-
-  // Now find missing on other procs.
-  for (Uint pid=0; pid<PE::Comm::instance().size(); pid++)
+  // number of variables for each point to be interpolated
+  const Uint nb_vars = m_source_vars.size();
+
+  // Send the coordinates to the processes that may contain them
+  std::vector< std::vector<Real> > send_coords;
+  std::vector< std::vector<Uint> > sent_ids;
+  Interpolator_route_coordinates(source_field.dict(), target_coords, send_coords, sent_ids);
+  std::vector< std::vector<Real> > received_coords;
+  Interpolator_exchange(send_coords, received_coords);
+
+  // Interpolate the received coordinates that are found on this process
+  std::vector< std::vector<Uint> > send_found_coords(nb_procs);
+  std::vector< std::vector<Real> > send_interpolated(nb_procs);
+  RealVector t_point(dim);
+  RealVector t_val(source_field.row_size());
+  for (Uint pid=0; pid<nb_procs; ++pid)
   {
-    // Trade my requests with processor send and recv
-    const Uint pid_send_coords = (PE::Comm::instance().rank() + pid) %
-                                  PE::Comm::instance().size();
-    const Uint pid_recv_coords = (PE::Comm::instance().size() + PE::Comm::instance().rank() - pid) %
-                                  PE::Comm::instance().size();
-
-    std::vector<Real> send_coords; send_coords.reserve(not_found.size()*target_coords.row_size());
-    std::vector<Uint>  unknown_ids; unknown_ids.reserve(not_found.size());
-    std::vector<Real> received_coords;
-
-    // fill in coords to send
-    boost_foreach (const int t, not_found)
-    {
-      if (t>=0)
-      {
-        unknown_ids.push_back(t);
-        boost_foreach (const Real& xyz, target_coords[t])
-        {
-          send_coords.push_back(xyz);
-        }
-      }
-    }
-
-    // send coords, and receive coords
-    Interpolator_send_receive(pid_send_coords,   send_coords,
-                              pid_recv_coords,   received_coords);
-
-    Uint nb_received_coords = received_coords.size()/dim;
-
-    // Find interpolated
-
-    std::vector<Uint> send_found_coords;  send_found_coords.reserve(nb_received_coords);
-
-    // number of variables for each point to be interpolated
-    const Uint nb_vars = m_source_vars.size();
-
-    // storage for interpolated variables, which will be sent to the pid that reqests it (pid_recv_interpolated)
-    std::vector<Real> send_interpolated; send_interpolated.reserve(nb_received_coords*nb_vars);
-
-    Uint dim = target_coords.row_size();
-    RealVector t_point(dim);
-    RealVector t_val(source_field.row_size());
-
+    const Uint nb_received_coords = received_coords[pid].size()/dim;
     for (Uint t=0; t<nb_received_coords; ++t)
     {
-      t_point = RealVector::MapType(&received_coords[t*dim],dim);
-      bool interpolation_possible_on_this_proc =
-          m_point_interpolator->interpolate(source_field,t_point,t_val);
-      if (interpolation_possible_on_this_proc)
+      t_point = RealVector::MapType(&received_coords[pid][t*dim],dim);
+      if (m_point_interpolator->interpolate(source_field,t_point,t_val))
       {
-        // mark found
-        send_found_coords.push_back(t);
-
+        send_found_coords[pid].push_back(t);
         for (Uint v=0; v<nb_vars; ++v)
-          send_interpolated.push_back(t_val[ m_source_vars[v] ] );
+          send_interpolated[pid].push_back(t_val[ m_source_vars[v] ] );
       }
     }
+  }
 
-    std::vector<Uint> recv_found_coords;
-    std::vector<Real> recv_interpolated;
-
-    const Uint pid_send_back = pid_recv_coords;
-    const Uint pid_recv_back = pid_send_coords;
-
-    Interpolator_send_receive (pid_send_back, send_found_coords,
-                               pid_recv_back, recv_found_coords);
-    Interpolator_send_receive (pid_send_back, send_interpolated,
-                               pid_recv_back, recv_interpolated);
+  std::vector< std::vector<Uint> > recv_found_coords;
+  std::vector< std::vector<Real> > recv_interpolated;
+  Interpolator_exchange(send_found_coords, recv_found_coords);
+  Interpolator_exchange(send_interpolated, recv_interpolated);
 
+  // Use the values of the first process that found each coordinate, in rank order starting from this process
+  std::vector<bool> found(nb_coords, false);
+  for (Uint k=0; k<nb_procs; ++k)
+  {
+    const Uint pid = (PE::Comm::instance().rank() + k) % nb_procs;
     Uint it=0;
-    boost_foreach(const Uint i, recv_found_coords)
+    boost_foreach(const Uint i, recv_found_coords[pid])
     {
-      cf3_assert(i<unknown_ids.size());
-      const int t = unknown_ids[i];
-      not_found[t] = -1;
-      cf3_assert_desc(common::to_str(t)+'<'+common::to_str(nb_coords),t<(int)nb_coords);
-      for (Uint v=0; v<nb_vars; ++v)
+      cf3_assert(i<sent_ids[pid].size());
+      const Uint t = sent_ids[pid][i];
+      cf3_assert(t<target.size());
+      if (!found[t])
       {
-        cf3_assert(t<target.size());
-        target[t][ m_target_vars[v] ] = recv_interpolated[it++];
+        found[t] = true;
+        for (Uint v=0; v<nb_vars; ++v)
+          target[t][ m_target_vars[v] ] = recv_interpolated[pid][it+v];
       }
+      it += nb_vars;
     }
   }
 }
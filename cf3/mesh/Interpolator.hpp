@@ -27,6 +27,8 @@ class APointInterpolator;
 /// mesh as the source, depending on concrete implementations
 /// The interpolation also works with parallel distributed fields. Interpolation
 /// is delegated to the processor that has the necessary source values.
+/// Each target coordinate is only sent to the processors whose bounding box
+/// contains it, so one sparse exchange replaces a round over all processors.
 /// @author Willem Deconinck
 class Mesh_API Interpolator : public AInterpolator {
 
@@ -95,9 +95,6 @@ private:
     }
   };
 
-  static RealVector2 m_D;
-  static Real m_scale;
-
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -258,26 +258,27 @@ bool Quad2D::is_coord_in_element(const CoordsT& coord, const NodesT& nodes)
     return false;
 
 
-  m_D <<
+  RealVector2 D;
+  D <<
       nodes.col(XX).maxCoeff()-nodes.col(XX).minCoeff(),
       nodes.col(YY).maxCoeff()-nodes.col(YY).minCoeff();
-  m_scale = 1./m_D.minCoeff();
+  const Real scale = 1./D.minCoeff();
 
-  if (scp(nodes.row(0),nodes.row(7),coord,m_scale) * scp(nodes.row(0),coord,nodes.row(4),m_scale) < -tolerance)
+  if (scp(nodes.row(0),nodes.row(7),coord,scale) * scp(nodes.row(0),coord,nodes.row(4),scale) < -tolerance)
       return false;
-  if (scp(nodes.row(4),nodes.row(0),coord,m_scale) * scp(nodes.row(4),coord,nodes.row(1),m_scale) < -tolerance)
+  if (scp(nodes.row(4),nodes.row(0),coord,scale) * scp(nodes.row(4),coord,nodes.row(1),scale) < -tolerance)
       return false;
-  if (scp(nodes.row(1),nodes.row(4),coord,m_scale) * scp(nodes.row(1),coord,nodes.row(5),m_scale) < -tolerance)
+  if (scp(nodes.row(1),nodes.row(4),coord,scale) * scp(nodes.row(1),coord,nodes.row(5),scale) < -tolerance)
       return false;
-  if (scp(nodes.row(5),nodes.row(1),coord,m_scale) * scp(nodes.row(5),coord,nodes.row(2),m_scale) < -tolerance)
+  if (scp(nodes.row(5),nodes.row(1),coord,scale) * scp(nodes.row(5),coord,nodes.row(2),scale) < -tolerance)
       return false;
-  if (scp(nodes.row(2),nodes.row(5),coord,m_scale) * scp(nodes.row(2),coord,nodes.row(6),m_scale) < -tolerance)
+  if (scp(nodes.row(2),nodes.row(5),coord,scale) * scp(nodes.row(2),coord,nodes.row(6),scale) < -tolerance)
       return false;
-  if (scp(nodes.row(6),nodes.row(2),coord,m_scale) * scp(nodes.row(6),coord,nodes.row(3),m_scale) < -tolerance)
+  if (scp(nodes.row(6),nodes.row(2),coord,scale) * scp(nodes.row(6),coord,nodes.row(3),scale) < -tolerance)
       return false;
-  if (scp(nodes.row(3),nodes.row(6),coord,m_scale) * scp(nodes.row(3),coord,nodes.row(7),m_scale) < -tolerance)
+  if (scp(nodes.row(3),nodes.row(6),coord,scale) * scp(nodes.row(3),coord,nodes.row(7),scale) < -tolerance)
       return false;
-  if (scp(nodes.row(7),nodes.row(3),coord,m_scale) * scp(nodes.row(7),coord,nodes.row(0),m_scale) < -tolerance)
+  if (scp(nodes.row(7),nodes.row(3),coord,scale) * scp(nodes.row(7),coord,nodes.row(0),scale) < -tolerance)
       return false;
 
   return true;
@@ -310,8 +311,6 @@ Quad2D::MappedCoordsT Quad2D::mapped_coordinate(const CoordsT& coord, const Node
 
 ////////////////////////////////////////////////////////////////////////////////
 
-RealVector2 Quad2D::m_D;
-Real Quad2D::m_scale;
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -55,7 +55,6 @@ void NodeElementConnectivity::setup(Region& region)
 void NodeElementConnectivity::set_nodes(Dictionary& nodes)
 {
   m_nodes->link_to(nodes);
-  m_connectivity->resize(nodes.size());
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -70,8 +69,8 @@ void NodeElementConnectivity::build_connectivity()
   cf3_assert(m_nodes->follow());
   Dictionary const& nodes = *Handle<Dictionary>(m_nodes->follow());
 
-  // Reserve memory in m_connectivity->array()
-  std::vector<Uint> connectivity_sizes(nodes.size());
+  // Count the elements of each node, to find the offset of each node in the compressed table
+  std::vector<Uint> offsets(nodes.size()+1, 0);
   boost_foreach(Handle<Component> elements_comp, m_elements->components() )
   {
     Entities& elements = dynamic_cast<Entities&>(*elements_comp);
@@ -80,17 +79,16 @@ void NodeElementConnectivity::build_connectivity()
       boost_foreach (const Uint node_idx, elem_nodes)
       {
         cf3_assert(node_idx<nodes.size());
-        ++connectivity_sizes[node_idx];
+        ++offsets[node_idx+1];
       }
     }
   }
-  Uint i(0);
-  boost_foreach (DynTable<Uint>::Row row, m_connectivity->array() )
-  {
-    row.reserve(connectivity_sizes[i++]);
-  }
+  for (Uint i=0; i<nodes.size(); ++i)
+    offsets[i+1] += offsets[i];
 
-  // fill m_connectivity->array()
+  // fill the element indices
+  std::vector<Uint> values(offsets.back());
+  std::vector<Uint> fill_positions(offsets.begin(), offsets.end()-1);
   Uint glb_elem_idx = 0;
   boost_foreach(Handle<Component> elements_comp, m_elements->components() )
   {
@@ -99,11 +97,13 @@ void NodeElementConnectivity::build_connectivity()
     {
       boost_foreach (const Uint node_idx, elem_nodes)
       {
-        m_connectivity->array()[node_idx].push_back(glb_elem_idx);
+        values[fill_positions[node_idx]++] = glb_elem_idx;
       }
       ++glb_elem_idx;
     }
   }
+
+  m_connectivity->swap_compressed(offsets, values);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
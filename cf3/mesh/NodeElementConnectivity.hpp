@@ -51,7 +51,7 @@ public:
   void setup(Region& region);
 
   /// Build the connectivity table
-  /// Build the connectivity table as a DynTable<Uint>
+  /// Build the connectivity table as a compressed DynTable<Uint>
   /// @pre set_nodes() and set_elements() must have been called
   void build_connectivity();
 
@@ -60,7 +60,6 @@ public:
 
 
   /// const access to the node to element connectivity table in unified indices
-  common::DynTable<Uint>& connectivity() { return *m_connectivity; }
   const common::DynTable<Uint>& connectivity() const { return *m_connectivity; }
 
 private: //functions
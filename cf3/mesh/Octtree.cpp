@@ -9,14 +9,18 @@
 #include <boost/function.hpp>
 #include <boost/bind.hpp>
 
+#include "common/BoostAssign.hpp"
 #include "common/Foreach.hpp"
 #include "common/Log.hpp"
 #include "common/Builder.hpp"
+#include "common/Core.hpp"
+#include "common/EventHandler.hpp"
 #include "common/FindComponents.hpp"
 #include "common/OptionList.hpp"
 #include "common/OptionT.hpp"
 #include "common/OptionArray.hpp"
 #include "common/OptionComponent.hpp"
+#include "common/XML/SignalOptions.hpp"
 
 #include "common/PE/Comm.hpp"
 #include "common/PE/debug.hpp"
@@ -30,9 +34,11 @@
 #include "mesh/Elements.hpp"
 #include "mesh/Field.hpp"
 #include "mesh/ElementType.hpp"
+#include "mesh/ElementTree.hpp"
 #include "mesh/Dictionary.hpp"
 #include "mesh/Space.hpp"
 #include "mesh/Connectivity.hpp"
+#include "mesh/Tags.hpp"
 
 //////////////////////////////////////////////////////////////////////////////
 
@@ -50,7 +56,7 @@ cf3::common::ComponentBuilder < Octtree, Component, LibMesh > Octtree_Builder;
 ////////////////////////////////////////////////////////////////////////////////
 
 Octtree::Octtree( const std::string& name )
-  : Component(name), m_dim(0), m_N(3), m_D(3), m_octtree_idx(3)
+  : Component(name), m_created(false), m_use_grid(false), m_dim(0), m_N(3), m_D(3), m_octtree_idx(3)
 {
 
   options().add("mesh", m_mesh)
@@ -68,6 +74,28 @@ Octtree::Octtree( const std::string& name )
       .description("The number of cells in each direction of the comb. "
                         "Takes precedence over \"Number of Elements per Octtree Cell\". ")
       .pretty_name("Number of Cells");
+
+  std::vector<boost::any> structures = boost::assign::list_of(std::string("tree"))(std::string("grid"));
+  options().add( "search_structure", std::string("tree") )
+      .description("Structure used to find elements: \"tree\" for the adaptive bounding volume hierarchy, "
+                   "or \"grid\" for the uniform grid of octtree cells")
+      .pretty_name("Search Structure")
+      .restricted_list() = structures;
+
+  options().add( "nb_elems_per_leaf", 4u )
+      .description("The maximum number of elements in a leaf of the bounding volume hierarchy")
+      .pretty_name("Number of Elements per Leaf");
+
+  Core::instance().event_handler().connect_to_event(Tags::event_mesh_changed(), this, &Octtree::on_mesh_changed_event);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Octtree::on_mesh_changed_event(SignalArgs& args)
+{
+  XML::SignalOptions options(args);
+  if (is_not_null(m_mesh) && options.value<URI>("mesh_uri") == m_mesh->uri())
+    m_created = false;
 }
 
 
@@ -82,6 +110,19 @@ void Octtree::create_octtree()
 
   m_dim = m_mesh->dimension();
 
+  m_use_grid = options().value<std::string>("search_structure") == "grid";
+  m_tree.build(*m_mesh, options().value<Uint>("nb_elems_per_leaf"));
+  m_octtree.resize(boost::extents[0][0][0]);
+  m_created = true;
+
+  if (m_use_grid)
+    create_grid();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Octtree::create_grid()
+{
   std::vector<Real> L(3);
 
   Real V=1;
@@ -186,85 +227,92 @@ void Octtree::create_octtree()
 
 void Octtree::find_cell_ranks( const boost::multi_array<Real,2>& coordinates, std::vector<Uint>& ranks )
 {
-  ranks.resize(coordinates.size());
+  if ( !is_created() )
+    create_octtree();
 
-  Entity dummy;
-  std::deque<Uint> missing_cells;
+  const Uint nb_procs = Comm::instance().size();
+  const Uint my_rank = Comm::instance().rank();
+  static const Real tolerance = 100*math::Consts::eps();
 
-  RealVector coord(m_dim);
+  // The bounding boxes of all processes are exchanged once, so the coordinates that are not found
+  // on this rank are only sent to the processes that may contain them
+  std::vector<Real> my_box(2*m_dim);
+  for (Uint d=0; d<m_dim; ++d)
+  {
+    my_box[d] = m_bounding_box.min()[d] - tolerance;
+    my_box[m_dim+d] = m_bounding_box.max()[d] + tolerance;
+  }
+  std::vector<Real> boxes;
+  if (Comm::instance().is_active())
+    Comm::instance().all_gather(my_box, boxes);
+  else
+    boxes = my_box;
 
+  ranks.assign(coordinates.size(), math::Consts::uint_max());
+
+  std::vector<Entity> found;
+  find_elements(coordinates, found);
+
+  RealVector coord(m_dim);
+  std::vector< std::vector<Real> > send_coords(nb_procs);
+  std::vector< std::vector<Uint> > sent_ids(nb_procs);
   for(Uint i=0; i<coordinates.size(); ++i)
   {
-    for (Uint d=0; d<m_dim; ++d)
-      coord[d] = coordinates[i][d];
-    if( find_element(coord,dummy) ) // if element is found on this rank
+    if( is_not_null(found[i].comp) ) // if element is found on this rank
     {
-      ranks[i] = Comm::instance().rank();
+      ranks[i] = my_rank;
+      continue;
     }
-    else
+    for (Uint d=0; d<m_dim; ++d)
+      coord[d] = coordinates[i][d];
+
+    for (Uint pid=0; pid<nb_procs; ++pid)
     {
-      ranks[i] = math::Consts::uint_max();
-      missing_cells.push_back(i);
+      if (pid == my_rank)
+        continue;
+      const Real* box = &boxes[pid*2*m_dim];
+      bool inside = true;
+      for (Uint d=0; d<m_dim && inside; ++d)
+        inside = coord[d] >= box[d] && coord[d] <= box[m_dim+d];
+      if (inside)
+      {
+        send_coords[pid].insert(send_coords[pid].end(), coord.data(), coord.data()+m_dim);
+        sent_ids[pid].push_back(i);
+      }
     }
   }
 
-  std::vector<Real> send_coords(m_dim*missing_cells.size());
-  std::vector<Real> recv_coords;
+  if (!Comm::instance().is_active())
+    return;
 
-  Uint c(0);
-  boost_foreach(const Uint i, missing_cells)
-  {
-    for(Uint d=0; d<m_dim; ++d)
-      send_coords[c++]=coordinates[i][d];
-  }
+  std::vector< std::vector<Real> > recv_coords;
+  Comm::instance().all_to_all(send_coords, recv_coords);
 
-  for (Uint root=0; root<PE::Comm::instance().size(); ++root)
+  // Answer with the indices of the received coordinates that are found on this rank
+  std::vector< std::vector<Uint> > send_found(nb_procs);
+  for (Uint pid=0; pid<nb_procs; ++pid)
   {
-
-    recv_coords.resize(0);
-    PE::Comm::instance().broadcast(send_coords,recv_coords,root,m_dim);
-
-    // size is only because it doesn't get resized for this rank
-    std::vector<Uint> send_found(missing_cells.size(),math::Consts::uint_max());
-
-    if (root!=Comm::instance().rank())
+    const Uint nb_recv_coords = recv_coords[pid].size()/m_dim;
+    boost::multi_array<Real,2> recv_array(boost::extents[nb_recv_coords][m_dim]);
+    std::copy(recv_coords[pid].begin(), recv_coords[pid].end(), recv_array.data());
+    find_elements(recv_array, found);
+    for (Uint i=0; i<nb_recv_coords; ++i)
     {
-      std::vector<RealVector> recv_coordinates(recv_coords.size()/m_dim) ;
-      boost_foreach(RealVector& realvec, recv_coordinates)
-          realvec.resize(m_dim);
-
-      c=0;
-      for (Uint i=0; i<recv_coordinates.size(); ++i)
-      {
-        for(Uint d=0; d<m_dim; ++d)
-          recv_coordinates[i][d]=recv_coords[c++];
-      }
-
-      send_found.resize(recv_coordinates.size());
-      for (Uint i=0; i<recv_coordinates.size(); ++i)
-      {
-        if( find_element(recv_coordinates[i],dummy) ) // if element found on this rank
-        {
-          send_found[i] = Comm::instance().rank();
-        }
-        else
-          send_found[i] = math::Consts::uint_max();
-      }
+      if( is_not_null(found[i].comp) ) // if element found on this rank
+        send_found[pid].push_back(i);
     }
+  }
 
-    std::vector<Uint> recv_found(missing_cells.size()*Comm::instance().size());
-    PE::Comm::instance().gather(send_found,recv_found,root);
+  std::vector< std::vector<Uint> > recv_found;
+  Comm::instance().all_to_all(send_found, recv_found);
 
-    if( root==Comm::instance().rank())
+  // The lowest rank containing the coordinate is used
+  for (Uint pid=0; pid<nb_procs; ++pid)
+  {
+    boost_foreach(const Uint i, recv_found[pid])
     {
-      const Uint stride = missing_cells.size();
-      for (Uint i=0; i<missing_cells.size(); ++i)
-      {
-        for(Uint p=0; p<Comm::instance().size(); ++p)
-        {
-          ranks[missing_cells[i]] = std::min(recv_found[i+p*stride] , ranks[missing_cells[i]]);
-        }
-      }
+      const Uint c = sent_ids[pid][i];
+      ranks[c] = std::min(ranks[c], pid);
     }
   }
 }
@@ -273,8 +321,10 @@ void Octtree::find_cell_ranks( const boost::multi_array<Real,2>& coordinates, st
 
 bool Octtree::find_octtree_cell(const RealVector& coordinate, std::vector<Uint>& octtree_idx)
 {
-  if (m_octtree.num_elements() == 0)
+  if ( !is_created() )
     create_octtree();
+  if (m_octtree.num_elements() == 0)
+    create_grid();
 
   static const Real tolerance = 100*math::Consts::eps();
   //CFinfo << "point " << coordinate.transpose() << " ("<<coordinate.size() << ")    dim " << m_dim << CFendl;
@@ -417,12 +467,71 @@ bool Octtree::find_element(const RealVector& target_coord, Entity& element)
     create_octtree();
 
   cf3_assert(target_coord.size() <= (long)m_dim);
-  RealVector t_coord(m_dim);
+  RealVector t_coord = RealVector::Zero(m_dim);
   for (Uint d=0; d<target_coord.size(); ++d)
     t_coord[d] = target_coord[d];
 
-  for (Uint t=0; t<target_coord.size(); ++t)
+  if (m_use_grid)
+    return find_element_in_grid(t_coord,element);
+
+  if (m_tree.find_element(t_coord,element))
+    return true;
 
+  element = Entity();
+  CFdebug << "coord";
+  for(Uint i = 0; i != m_dim; ++i)
+  {
+    CFdebug << " " << common::to_str(t_coord[i]);
+  }
+  CFdebug << " has not been found in the element tree" << CFendl;
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Octtree::find_elements(const boost::multi_array<Real,2>& coordinates, std::vector<Entity>& elements)
+{
+  if ( !is_created() )
+    create_octtree();
+
+  if (!m_use_grid)
+  {
+    m_tree.find_elements(coordinates,elements);
+    return;
+  }
+
+  elements.assign(coordinates.size(), Entity());
+  RealVector t_coord(m_dim);
+  for (Uint i=0; i<coordinates.size(); ++i)
+  {
+    for (Uint d=0; d<m_dim; ++d)
+      t_coord[d] = coordinates[i][d];
+    find_element_in_grid(t_coord,elements[i]);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool Octtree::find_closest_element(const RealVector& target_coord, Entity& element)
+{
+  if ( !is_created() )
+    create_octtree();
+  return m_tree.find_closest_element(target_coord,element);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Octtree::gather_elements_in_box(const RealVector& min, const RealVector& max, std::vector<Entity>& elements)
+{
+  if ( !is_created() )
+    create_octtree();
+  m_tree.gather_elements_in_box(min,max,elements);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool Octtree::find_element_in_grid(const RealVector& t_coord, Entity& element)
+{
   if (find_octtree_cell(t_coord,m_octtree_idx))
   {
     m_elements_pool.clear();
@@ -15,6 +15,7 @@
 #include "math/BoundingBox.hpp"
 
 #include "mesh/Elements.hpp"
+#include "mesh/ElementTree.hpp"
 
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -26,7 +27,12 @@ namespace mesh {
 
 //////////////////////////////////////////////////////////////////////////////
 
-/// This class defines neutral mesh format reader
+/// @brief Spatial search structure to find the elements of a mesh
+///
+/// Elements are searched in an adaptive bounding volume hierarchy (ElementTree) by default.
+/// The original uniform grid of octtree cells, sized from the average element volume, can still
+/// be selected with the option "search_structure", and is always built for the functions that
+/// work on octtree cells.
 /// @author Willem Deconinck
 class Mesh_API Octtree : public common::Component
 {
@@ -55,6 +61,17 @@ public: // functions
   /// @return if element was found
   virtual bool find_element(const RealVector& target_coord, Entity& element);
 
+  /// @brief Find which elements contain each row of the given coordinates
+  /// @param elements [out] the found elements, or a null Entity for coordinates outside the mesh
+  void find_elements(const boost::multi_array<Real,2>& coordinates, std::vector<Entity>& elements);
+
+  /// @brief Find the element with the centroid closest to a given coordinate
+  /// @return false if the mesh has no volume elements
+  bool find_closest_element(const RealVector& target_coord, Entity& element);
+
+  /// Append the elements with a centroid inside the box [min, max]
+  void gather_elements_in_box(const RealVector& min, const RealVector& max, std::vector<Entity>& elements);
+
   /// Given a coordinate, find which box in the octtree it is located in
   /// @param coordinate  [in]  The coordinate to look for
   /// @param octtree_idx [out] location of the box (i,j,k) in which the coordinate sits
@@ -71,12 +88,27 @@ public: // functions
 
   void find_cell_ranks( const boost::multi_array<Real,2>& coordinates, std::vector<Uint>& ranks );
 
-  bool is_created() const { return m_octtree.num_elements()!=0; }
+  bool is_created() const { return m_created; }
 
   const Uint dimension() { return m_dim; }
 
+private: // functions
+
+  /// Fill the uniform grid of octtree cells
+  void create_grid();
+
+  bool find_element_in_grid(const RealVector& target_coord, Entity& element);
+
+  /// Rebuild the search structures on the next search if the mesh changed
+  void on_mesh_changed_event(common::SignalArgs& args);
+
 private: // data
 
+  bool m_created;
+  bool m_use_grid;
+
+  ElementTree m_tree;
+
   ArrayT m_octtree;
 
   Uint m_dim;
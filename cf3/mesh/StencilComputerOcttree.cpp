@@ -55,7 +55,6 @@ void StencilComputerOcttree::configure_octtree()
   m_nb_elems_in_mesh = mesh->topology().recursive_filtered_elements_count(IsElementsVolume(),true);
   m_dim = m_dict->coordinates().row_size();
   m_centroid.resize(m_dim);
-  m_octtree_cell.resize(3);
 
   if (Handle<Component> found = mesh->get_child("octtree"))
     m_octtree = Handle<Octtree>(found);
@@ -73,15 +72,18 @@ void StencilComputerOcttree::compute_stencil(const SpaceElem& element, std::vect
   cf3_assert(m_octtree);
   RealMatrix coordinates = element.comp->support().geometry_space().get_coordinates(element.idx);
   element.comp->support().element_type().compute_centroid(coordinates,m_centroid);
+  const RealVector extent = (coordinates.colwise().maxCoeff() - coordinates.colwise().minCoeff()).transpose();
+  const RealVector tolerance = RealVector::Constant(m_dim, 1e-8*extent.maxCoeff());
+
+  // The search box grows with the size of the element in each direction, so the stencil
+  // follows the local mesh spacing, also in stretched meshes
   m_stencil.resize(0);
-  if (m_octtree->find_octtree_cell(m_centroid,m_octtree_cell))
+  for (Uint ring=0; m_stencil.size() < m_min_stencil_size; ++ring)
   {
-    for (Uint ring=0; m_stencil.size() < m_min_stencil_size; ++ring)
-    {
-      m_octtree->gather_elements_around_idx(m_octtree_cell,ring,m_stencil);
-      if (m_stencil.size() >= m_nb_elems_in_mesh )
-        break;
-    }
+    m_stencil.resize(0);
+    m_octtree->gather_elements_in_box(m_centroid - static_cast<Real>(ring)*extent - tolerance, m_centroid + static_cast<Real>(ring)*extent + tolerance, m_stencil);
+    if (m_stencil.size() >= m_nb_elems_in_mesh )
+      break;
   }
   stencil.resize(m_stencil.size());
   for (Uint e=0; e<stencil.size(); ++e)
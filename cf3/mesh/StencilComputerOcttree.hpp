@@ -47,7 +47,6 @@ private: // data
   Uint m_dim;
   Uint m_nb_elems_in_mesh;
 
-  std::vector<Uint> m_octtree_cell;
   RealVector m_centroid;
 
   std::vector<Entity> m_stencil;
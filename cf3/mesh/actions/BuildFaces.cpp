@@ -7,7 +7,6 @@
 #include <set>
 
 #include <boost/foreach.hpp>
-#include <boost/functional/hash.hpp>
 
 #include "common/Log.hpp"
 #include "common/Builder.hpp"
@@ -31,8 +30,8 @@
 #include "mesh/Region.hpp"
 #include "mesh/MeshElements.hpp"
 #include "mesh/FaceCellConnectivity.hpp"
+#include "mesh/FaceNodeTable.hpp"
 #include "mesh/NodeElementConnectivity.hpp"
-#include "mesh/Node2FaceCellConnectivity.hpp"
 #include "mesh/Cells.hpp"
 #include "mesh/Mesh.hpp"
 #include "mesh/Connectivity.hpp"
@@ -51,21 +50,6 @@ namespace actions {
   using namespace common;
   using namespace math::Functions;
 
-struct FaceCompare
-{
-  bool operator()(const Face2Cell& face1, const Face2Cell& face2) const
-  {
-    std::size_t seed1=0;
-    std::size_t seed2=0;
-
-    boost::hash_combine(seed1,face1.comp->uri().string());
-    boost::hash_combine(seed2,face2.comp->uri().string());
-    boost::hash_combine(seed1,face1.idx);
-    boost::hash_combine(seed2,face2.idx);
-    return seed1 < seed2;
-  }
-};
-
 ////////////////////////////////////////////////////////////////////////////////
 
 common::ComponentBuilder < BuildFaces, MeshTransformer, mesh::actions::LibActions> BuildFaces_Builder;
@@ -449,7 +433,6 @@ boost::shared_ptr< FaceCellConnectivity > BuildFaces::match_faces(Region& region
 
   CFdebug << "matching faces between regions " << region1.uri().path() << "  and  " << region2.uri().path() << CFendl;
 
-  Mesh& mesh = *m_mesh;
   // interface connectivity
   boost::shared_ptr<FaceCellConnectivity> interface = allocate_component<FaceCellConnectivity>("interface_connectivity");
   interface->options().set("face_building_algorithm",true);
@@ -467,9 +450,10 @@ boost::shared_ptr< FaceCellConnectivity > BuildFaces::match_faces(Region& region
   std::map<FaceCellConnectivity*,boost::shared_ptr<common::Table<bool>::Buffer> > buf_cell_orientation;
   std::map<FaceCellConnectivity*,boost::shared_ptr<common::Table<Uint>::Buffer> > buf_cell_rotation;
 
-  // Build a node to face connectivity matching faces2
-  boost::shared_ptr<Node2FaceCellConnectivity> node2faces2_ptr = allocate_component<Node2FaceCellConnectivity>("node2faces");
-  Node2FaceCellConnectivity& node2faces2 = *node2faces2_ptr;
+  // Find the faces of region2 by their nodes
+  FaceNodeTable faces2_table;
+  std::vector<Face2Cell> faces2_list;
+  std::vector<Uint> sorted_nodes;
   boost_foreach(FaceCellConnectivity& faces2, find_components_recursively_with_tag<FaceCellConnectivity>(region2,mesh::Tags::inner_faces()))
   {
     buf_fnb [&faces2] = boost::shared_ptr<common::Table<Uint>::Buffer> ( new common::Table<Uint>::Buffer(faces2.face_number().create_buffer()));
@@ -477,10 +461,18 @@ boost::shared_ptr< FaceCellConnectivity > BuildFaces::match_faces(Region& region
     buf_f2c [&faces2] = boost::shared_ptr<ElementConnectivity::Buffer> ( new ElementConnectivity::Buffer(faces2.connectivity().create_buffer()));
     buf_cell_rotation [&faces2] = boost::shared_ptr<common::Table<Uint>::Buffer> ( new common::Table<Uint>::Buffer(faces2.cell_rotation().create_buffer()));
     buf_cell_orientation [&faces2] = boost::shared_ptr<common::Table<bool>::Buffer> ( new common::Table<bool>::Buffer(faces2.cell_orientation().create_buffer()));
-    node2faces2.add_used(faces2); // it is assumed this is only face types
+
+    faces2_table.reserve(faces2_table.size()+faces2.size());
+    for (Uint idx=0; idx<faces2.size(); ++idx)
+    {
+      Face2Cell face2(faces2,idx);
+      sorted_nodes = face2.nodes();
+      const std::size_t hash = FaceNodeTable::make_key(&sorted_nodes[0],sorted_nodes.size());
+      if (faces2_table.find(&sorted_nodes[0],sorted_nodes.size(),hash) == FaceNodeTable::not_found)
+        faces2_table.insert(&sorted_nodes[0],sorted_nodes.size(),hash,faces2_list.size());
+      faces2_list.push_back(face2);
+    }
   }
-  node2faces2.set_nodes(mesh.geometry_fields());
-  node2faces2.build_connectivity();
 
   Uint f1(0);
   Uint faces1_idx(0);
@@ -509,75 +501,57 @@ boost::shared_ptr< FaceCellConnectivity > BuildFaces::match_faces(Region& region
       face1_nodes = face1.nodes();
       const Uint nb_nodes_per_face = face1_nodes.size();
 
-      std::map<Face2Cell,Uint,FaceCompare> found_faces;
-      std::map<Face2Cell,Uint,FaceCompare>::iterator not_found = found_faces.end();
-
-      bool match_found = false;
-      boost_foreach(const Uint face1_node, face1_nodes)
+      sorted_nodes = face1_nodes;
+      const std::size_t hash = FaceNodeTable::make_key(&sorted_nodes[0],nb_nodes_per_face);
+      const Uint face2_idx = faces2_table.find(&sorted_nodes[0],nb_nodes_per_face,hash);
+      if (face2_idx != FaceNodeTable::not_found)
       {
-        boost_foreach(Face2Cell face2, node2faces2.connectivity()[face1_node])
+        faces2_table.erase(&sorted_nodes[0],nb_nodes_per_face,hash);
+        Face2Cell& face2 = faces2_list[face2_idx];
+
+        elems[LEFT]  = face1.cells()[0];
+        elems[RIGHT] = face2.cells()[0];
+        face_nb[LEFT] = face1.face_nb_in_cells()[0];
+        face_nb[RIGHT] = face2.face_nb_in_cells()[0];
+        orientation[LEFT] = FaceCellConnectivity::MATCHED;
+        orientation[RIGHT] = FaceCellConnectivity::INVERTED;
+        rotation[LEFT] = 0;
+
+        // NOW find the rotation and orientation of this new face to the RIGHT cell
+
+        // Find orientation ( or find match between first face-nodes of both neighbouring elements )
+        face2_nodes = face2.nodes();
+
+        Uint rot;
+        for (rot=0; rot<=nb_nodes_per_face; ++rot)
         {
-          std::map<Face2Cell,Uint,FaceCompare>::iterator it = found_faces.find(face2);
-          if ( it == not_found)
-          {
-            found_faces[face2]=1;
-          }
-          else
+          if (face2_nodes[rot] == face1_nodes[0])
           {
-            Uint& nb_faces = it->second;
-            ++nb_faces;
-            if (nb_faces == nb_nodes_per_face)
-            {
-              match_found = true;
-              elems[LEFT]  = face1.cells()[0];
-              elems[RIGHT] = face2.cells()[0];
-              face_nb[LEFT] = face1.face_nb_in_cells()[0];
-              face_nb[RIGHT] = face2.face_nb_in_cells()[0];
-              orientation[LEFT] = FaceCellConnectivity::MATCHED;
-              orientation[RIGHT] = FaceCellConnectivity::INVERTED;
-              rotation[LEFT] = 0;
-
-              // NOW find the rotation and orientation of this new face to the RIGHT cell
-
-              // Find orientation ( or find match between first face-nodes of both neighbouring elements )
-              face2_nodes = face2.nodes();
-
-              Uint rot;
-              for (rot=0; rot<=nb_nodes_per_face; ++rot)
-              {
-                if (face2_nodes[rot] == face1_nodes[0])
-                {
-                  rotation[RIGHT] = rot;
-                  break;
-                }
-              }
-              cf3_assert(rot != nb_nodes_per_face); // means that the break worked and the rotation was found
-
-
-              // Remove matches from the 2 connectivity tables and add to the interface
-              i2c.add_row(elems);
-              fnb.add_row(face_nb);
-              bdry.add_row(false);
-              cell_rotation.add_row(rotation);
-              cell_orientation.add_row(orientation);
-
-              buf_f2c [face1.comp]->rm_row(face1.idx);
-              buf_f2c [face2.comp]->rm_row(face2.idx);
-              buf_fnb [face1.comp]->rm_row(face1.idx);
-              buf_fnb [face2.comp]->rm_row(face2.idx);
-              buf_bdry[face1.comp]->rm_row(face1.idx);
-              buf_bdry[face2.comp]->rm_row(face2.idx);
-              buf_cell_orientation[face1.comp]->rm_row(face1.idx);
-              buf_cell_orientation[face2.comp]->rm_row(face2.idx);
-              buf_cell_rotation[face1.comp]->rm_row(face1.idx);
-              buf_cell_rotation[face2.comp]->rm_row(face2.idx);
-              ++nb_matches;
-              break;
-            }
+            rotation[RIGHT] = rot;
+            break;
           }
         }
-        if (match_found)
-          break;
+        cf3_assert(rot != nb_nodes_per_face); // means that the break worked and the rotation was found
+
+
+        // Remove matches from the 2 connectivity tables and add to the interface
+        i2c.add_row(elems);
+        fnb.add_row(face_nb);
+        bdry.add_row(false);
+        cell_rotation.add_row(rotation);
+        cell_orientation.add_row(orientation);
+
+        buf_f2c [face1.comp]->rm_row(face1.idx);
+        buf_f2c [face2.comp]->rm_row(face2.idx);
+        buf_fnb [face1.comp]->rm_row(face1.idx);
+        buf_fnb [face2.comp]->rm_row(face2.idx);
+        buf_bdry[face1.comp]->rm_row(face1.idx);
+        buf_bdry[face2.comp]->rm_row(face2.idx);
+        buf_cell_orientation[face1.comp]->rm_row(face1.idx);
+        buf_cell_orientation[face2.comp]->rm_row(face2.idx);
+        buf_cell_rotation[face1.comp]->rm_row(face1.idx);
+        buf_cell_rotation[face2.comp]->rm_row(face2.idx);
+        ++nb_matches;
       }
       ++f1;
     }
@@ -592,7 +566,6 @@ boost::shared_ptr< FaceCellConnectivity > BuildFaces::match_faces(Region& region
 
 void BuildFaces::match_boundary(Region& bdry_region, Region& inner_region)
 {
-  Mesh& mesh = *m_mesh;
   const Uint INNER=0;
   // create buffers for each face_cell_connectivity of unified_inner_faces_to_cells
   std::map<FaceCellConnectivity*,boost::shared_ptr<common::Table<Uint>::Buffer> >  buf_inner_face_nb;
@@ -601,9 +574,10 @@ void BuildFaces::match_boundary(Region& bdry_region, Region& inner_region)
   std::map<FaceCellConnectivity*,boost::shared_ptr<common::Table<bool>::Buffer> >  buf_inner_orientation;
   std::map<FaceCellConnectivity*,boost::shared_ptr<common::Table<Uint>::Buffer> >  buf_inner_rotation;
 
-  // Build a node to face connectivity matching faces2
-  boost::shared_ptr<Node2FaceCellConnectivity> nodes_to_inner_faces_ptr = allocate_component<Node2FaceCellConnectivity>("node2faces");
-  Node2FaceCellConnectivity& nodes_to_inner_faces = *nodes_to_inner_faces_ptr;
+  // Find the inner faces by their nodes
+  FaceNodeTable inner_faces_table;
+  std::vector<Face2Cell> inner_faces_list;
+  std::vector<Uint> sorted_nodes;
   boost_foreach(FaceCellConnectivity& f2c, find_components_recursively_with_tag<FaceCellConnectivity>(inner_region,mesh::Tags::inner_faces()))
   {
     buf_inner_face_nb          [&f2c] = boost::shared_ptr<common::Table<Uint>::Buffer> ( new common::Table<Uint>::Buffer(f2c.face_number().create_buffer()));
@@ -612,10 +586,17 @@ void BuildFaces::match_boundary(Region& bdry_region, Region& inner_region)
     buf_inner_rotation          [&f2c] = boost::shared_ptr<common::Table<Uint>::Buffer> ( new common::Table<Uint>::Buffer(f2c.cell_rotation().create_buffer()));
     buf_inner_orientation       [&f2c] = boost::shared_ptr<common::Table<bool>::Buffer> ( new common::Table<bool>::Buffer(f2c.cell_orientation().create_buffer()));
 
-    nodes_to_inner_faces.add_used(f2c);
+    inner_faces_table.reserve(inner_faces_table.size()+f2c.size());
+    for (Uint idx=0; idx<f2c.size(); ++idx)
+    {
+      Face2Cell inner_face(f2c,idx);
+      sorted_nodes = inner_face.nodes();
+      const std::size_t hash = FaceNodeTable::make_key(&sorted_nodes[0],sorted_nodes.size());
+      if (inner_faces_table.find(&sorted_nodes[0],sorted_nodes.size(),hash) == FaceNodeTable::not_found)
+        inner_faces_table.insert(&sorted_nodes[0],sorted_nodes.size(),hash,inner_faces_list.size());
+      inner_faces_list.push_back(inner_face);
+    }
   }
-  nodes_to_inner_faces.set_nodes(mesh.geometry_fields());
-  nodes_to_inner_faces.build_connectivity();
 
   boost_foreach(Elements& bdry_faces, find_components<Elements>(bdry_region))
   {
@@ -654,92 +635,57 @@ void BuildFaces::match_boundary(Region& bdry_region, Region& inner_region)
       Connectivity::ConstRow bdry_face_nodes = bdry_entity.get_nodes();
       const Uint nb_nodes_per_face = bdry_face_nodes.size();
 
-      std::map<Face2Cell,Uint,FaceCompare> found_faces;
-      std::map<Face2Cell,Uint,FaceCompare>::iterator not_found = found_faces.end();
+      sorted_nodes.assign(bdry_face_nodes.begin(),bdry_face_nodes.end());
+      const std::size_t hash = FaceNodeTable::make_key(&sorted_nodes[0],nb_nodes_per_face);
+      const Uint inner_face_idx = inner_faces_table.find(&sorted_nodes[0],nb_nodes_per_face,hash);
+      if (inner_face_idx == FaceNodeTable::not_found)
+        continue;
+
+      inner_faces_table.erase(&sorted_nodes[0],nb_nodes_per_face,hash);
+      Face2Cell& inner_face = inner_faces_list[inner_face_idx];
 
-      bool match_found = false;
-      boost_foreach(const Uint bdry_face_node, bdry_face_nodes)
+      elems[INNER] = inner_face.cells()[INNER];
+
+      // Remove matches from the inner_faces_connectivity tables and add to the boundary
+      bdry_face_connectivity.set_row(bdry_entity.idx,elems);
+      bdry_face_nb[bdry_entity.idx][INNER] = inner_face.face_nb_in_cells()[INNER];
+      bdry_face_is_bdry[bdry_entity.idx] = true;
+
+      if (nb_nodes_per_face == 1)
       {
-        boost_foreach( Face2Cell& inner_face, nodes_to_inner_faces.connectivity()[bdry_face_node])
+        bdry_rotation[bdry_entity.idx][INNER] = 0;
+        bdry_orientation[bdry_entity.idx][INNER] = FaceCellConnectivity::MATCHED;
+      }
+      else
+      {
+        std::vector<Uint> inner_face_nodes = inner_face.nodes();
+        Uint rot;
+        for (rot=0; rot<=nb_nodes_per_face; ++rot)
         {
-          std::map<Face2Cell,Uint,FaceCompare>::iterator it = found_faces.find(inner_face);
-          if ( it == not_found)
-          {
-            found_faces[inner_face]=1;
-
-            it = found_faces.find(inner_face);
-
-            if (nb_nodes_per_face == 1)
-            {
-              match_found = true;
-              elems[INNER] = inner_face.cells()[INNER];
-
-              // Remove matches from the inner_faces_connectivity tables and add to the boundary
-              bdry_face_connectivity.set_row(bdry_entity.idx,elems);
-              bdry_face_nb[bdry_entity.idx][INNER] = inner_face.face_nb_in_cells()[INNER];
-              bdry_face_is_bdry[bdry_entity.idx] = true;
-              bdry_rotation[bdry_entity.idx][INNER] = 0;
-              bdry_orientation[bdry_entity.idx][INNER] = FaceCellConnectivity::MATCHED;
-
-              buf_inner_face_connectivity[inner_face.comp]->rm_row(inner_face.idx);
-              buf_inner_face_nb[inner_face.comp]->rm_row(inner_face.idx);
-              buf_inner_face_is_bdry[inner_face.comp]->rm_row(inner_face.idx);
-              buf_inner_orientation[inner_face.comp]->rm_row(inner_face.idx);
-              buf_inner_rotation[inner_face.comp]->rm_row(inner_face.idx);
-
-              ++nb_matches;
-              break;
-            }
-          }
-          else
+          if (inner_face_nodes[rot] == bdry_face_nodes[0])
           {
-            Uint& nb_faces = it->second;
-            ++nb_faces;
-
-            if (nb_faces == nb_nodes_per_face)
-            {
-              match_found = true;
-              elems[0] = inner_face.cells()[INNER];
-
-              // Remove matches from the inner_faces_connectivity tables and add to the boundary
-              bdry_face_connectivity.set_row(bdry_entity.idx,elems);
-              bdry_face_nb[bdry_entity.idx][INNER] = inner_face.face_nb_in_cells()[INNER];
-              bdry_face_is_bdry[bdry_entity.idx] = true;
-
-              std::vector<Uint> inner_face_nodes = inner_face.nodes();
-              Uint rot;
-              for (rot=0; rot<=nb_nodes_per_face; ++rot)
-              {
-                if (inner_face_nodes[rot] == bdry_face_nodes[0])
-                {
-                  bdry_rotation[bdry_entity.idx][INNER] = rot;
-                  break;
-                }
-              }
-
-              // Now find the orientation (outward or inward)
-              Uint next_node = rot+1;
-              if (next_node == nb_nodes_per_face)
-                next_node = 0;
-              if (inner_face_nodes[next_node]==bdry_face_nodes[1])
-                bdry_orientation[bdry_entity.idx][INNER] = FaceCellConnectivity::MATCHED;
-              else
-                bdry_orientation[bdry_entity.idx][INNER] = FaceCellConnectivity::INVERTED;
-
-              buf_inner_face_connectivity[inner_face.comp]->rm_row(inner_face.idx);
-              buf_inner_face_nb[inner_face.comp]->rm_row(inner_face.idx);
-              buf_inner_face_is_bdry[inner_face.comp]->rm_row(inner_face.idx);
-              buf_inner_orientation[inner_face.comp]->rm_row(inner_face.idx);
-              buf_inner_rotation[inner_face.comp]->rm_row(inner_face.idx);
-
-              ++nb_matches;
-              break;
-            }
+            bdry_rotation[bdry_entity.idx][INNER] = rot;
+            break;
           }
         }
-        if (match_found)
-          break;
+
+        // Now find the orientation (outward or inward)
+        Uint next_node = rot+1;
+        if (next_node == nb_nodes_per_face)
+          next_node = 0;
+        if (inner_face_nodes[next_node]==bdry_face_nodes[1])
+          bdry_orientation[bdry_entity.idx][INNER] = FaceCellConnectivity::MATCHED;
+        else
+          bdry_orientation[bdry_entity.idx][INNER] = FaceCellConnectivity::INVERTED;
       }
+
+      buf_inner_face_connectivity[inner_face.comp]->rm_row(inner_face.idx);
+      buf_inner_face_nb[inner_face.comp]->rm_row(inner_face.idx);
+      buf_inner_face_is_bdry[inner_face.comp]->rm_row(inner_face.idx);
+      buf_inner_orientation[inner_face.comp]->rm_row(inner_face.idx);
+      buf_inner_rotation[inner_face.comp]->rm_row(inner_face.idx);
+
+      ++nb_matches;
     }
   }
 
@@ -172,33 +172,35 @@ void GlobalConnectivity::execute()
   }
 
 
-  DynTable<Uint>& nodes_glb_elem_connectivity = mesh.geometry_fields().glb_elem_connectivity();
-//  CFinfo << "nodes_glb_elem_connectivity = " << nodes_glb_elem_connectivity.uri() << CFendl;
-  nodes_glb_elem_connectivity.resize(glb_elem_connectivity.size());
+  // Local elements first, then the ones received from other processes, in compressed row storage
+  std::vector<Uint> offsets(glb_elem_connectivity.size()+1);
+  offsets[0] = 0;
   for (Uint i=0; i<glb_elem_connectivity.size(); ++i)
   {
-//    CFinfo << "i = " << i << CFendl;
     cf3_assert(i<node2elem.connectivity().size());
+    offsets[i+1] = offsets[i] + node2elem.connectivity().row_size(i) + glb_elem_connectivity[i].size();
+  }
+  std::vector<Uint> values(offsets.back());
+  cnt = 0;
+  for (Uint i=0; i<glb_elem_connectivity.size(); ++i)
+  {
     DynTable<Uint>::ConstRow elems = node2elem.connectivity()[i];
-    cf3_assert(i<nodes_glb_elem_connectivity.size());
-    cf3_assert(i<glb_elem_connectivity.size());
-    nodes_glb_elem_connectivity[i].resize(glb_elem_connectivity[i].size() + elems.size());
-    cnt = 0;
     boost_foreach(const Uint e, elems)
     {
       cf3_assert(e<node2elem.elements().size());
       boost::tie(elem_comp,elem_idx) = node2elem.elements().location(e);
       cf3_assert(elem_idx < Handle<Elements>(elem_comp)->glb_idx().size());
-      nodes_glb_elem_connectivity[i][cnt++] = Handle<Elements>(elem_comp)->glb_idx()[elem_idx];
+      values[cnt++] = Handle<Elements>(elem_comp)->glb_idx()[elem_idx];
     }
     for (Uint j=0; j<glb_elem_connectivity[i].size(); ++j)
     {
-      cf3_assert(cnt < nodes_glb_elem_connectivity[i].size());
-      nodes_glb_elem_connectivity[i][cnt++] = glb_elem_connectivity[i][j];
+      values[cnt++] = glb_elem_connectivity[i][j];
     }
-
+    cf3_assert(cnt == offsets[i+1]);
   }
 
+  mesh.geometry_fields().glb_elem_connectivity().swap_compressed(offsets, values);
+
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -4,6 +4,7 @@
 // GNU Lesser General Public License version 3 (LGPLv3).
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
+#include <algorithm>
 #include <set>
 
 #include "common/Log.hpp"
@@ -55,6 +56,69 @@ common::ComponentBuilder < GlobalNumbering, MeshTransformer, mesh::actions::LibA
 
 //////////////////////////////////////////////////////////////////////////////
 
+namespace
+{
+
+/// Glb_idx and owner of a hash, as stored on the process responsible for the hash
+struct HashRecord
+{
+  HashRecord(const boost::uint64_t a_hash, const boost::uint64_t a_category, const boost::uint64_t a_glb_idx, const Uint a_rank) :
+    hash(a_hash), category(a_category), glb_idx(a_glb_idx), rank(a_rank)
+  {
+  }
+
+  bool operator<(const HashRecord& other) const
+  {
+    return hash < other.hash || (hash == other.hash && category < other.category);
+  }
+
+  boost::uint64_t hash;
+  boost::uint64_t category;
+  boost::uint64_t glb_idx;
+  Uint rank;
+};
+
+/// Number of hashes each process contributes to choose the splitters
+const Uint nb_samples_per_proc = 64;
+
+/// Choose the nb_procs-1 hashes that divide the hashes of all processes in ranges of about the same size,
+/// using regularly spaced samples of the sorted local hashes (as in a parallel sample sort)
+void compute_splitters(std::vector<boost::uint64_t>& local_hashes, std::vector<boost::uint64_t>& splitters)
+{
+  const Uint nb_procs = PE::Comm::instance().size();
+  std::sort(local_hashes.begin(), local_hashes.end());
+
+  const Uint nb_local = local_hashes.size();
+  const Uint nb_samples = std::min(nb_local, nb_samples_per_proc);
+  std::vector<boost::uint64_t> samples(nb_samples);
+  for (Uint i=0; i<nb_samples; ++i)
+    samples[i] = local_hashes[(2*i+1)*nb_local / (2*nb_samples)];
+
+  std::vector< std::vector<boost::uint64_t> > gathered_samples;
+  PE::Comm::instance().all_gather(samples, gathered_samples);
+  samples.clear();
+  for (Uint p=0; p<gathered_samples.size(); ++p)
+    samples.insert(samples.end(), gathered_samples[p].begin(), gathered_samples[p].end());
+  std::sort(samples.begin(), samples.end());
+
+  splitters.clear();
+  if (samples.empty())
+    return;
+  splitters.reserve(nb_procs-1);
+  for (Uint p=1; p<nb_procs; ++p)
+    splitters.push_back(samples[p*samples.size() / nb_procs]);
+}
+
+/// The process responsible for a hash. Equal hashes always go to the same process.
+Uint responsible_process(const std::vector<boost::uint64_t>& splitters, const boost::uint64_t hash)
+{
+  return std::upper_bound(splitters.begin(), splitters.end(), hash) - splitters.begin();
+}
+
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
 GlobalNumbering::GlobalNumbering( const std::string& name )
 : MeshTransformer(name),
   m_debug(false)
@@ -185,20 +249,16 @@ void GlobalNumbering::execute()
 
   // now renumber
 
-  //------------------------------------------------------------------------------
-  // create node_hilbert2loc mapping
-  Dictionary& nodes = mesh.geometry_fields();
-  std::map<boost::uint64_t,Uint> node_hilbert2loc;
-  Uint loc_node_idx(0);
-  boost_foreach(boost::uint64_t hilbert_idx, hilbert_indices.data())
-    node_hilbert2loc[hilbert_idx]=loc_node_idx++;
-
-  // Check if all nodes have been added to the map
-  cf3_assert(loc_node_idx==nodes.size());
+  // Nodes have category 0, the elements of the i-th Entities have category i+1.
+  // The Entities are found in the same order on all processes.
+  std::vector< Handle<Entities> > entities_list;
+  boost_foreach( Entities& elements, find_components_recursively<Entities>(mesh) )
+    entities_list.push_back(elements.handle<Entities>());
 
   //------------------------------------------------------------------------------
   // get tot nb of owned indexes and communicate
 
+  Dictionary& nodes = mesh.geometry_fields();
   Uint nb_owned_nodes(0);
   common::List<Uint>& nodes_rank = mesh.geometry_fields().rank();
   nodes_rank.resize(nodes.size());
@@ -211,14 +271,14 @@ void GlobalNumbering::execute()
   }
 
   Uint nb_owned_elems(0);
-  boost_foreach( Entities& elements, find_components_recursively<Entities>(mesh) )
+  boost_foreach( const Handle<Entities>& elements, entities_list )
   {
-    common::List<Uint>& elem_rank = elements.rank();
-    elem_rank.resize(elements.size());
+    common::List<Uint>& elem_rank = elements->rank();
+    elem_rank.resize(elements->size());
 
-    for (Uint e=0; e<elements.size(); ++e)
+    for (Uint e=0; e<elements->size(); ++e)
     {
-      if (elements.is_ghost(e) == false)
+      if (elements->is_ghost(e) == false)
       {
         ++nb_owned_elems;
       }
@@ -242,183 +302,170 @@ void GlobalNumbering::execute()
     std::cout << "["<<PE::Comm::instance().rank() << "]  start_ids gathered" << std::endl;
   }
 
-
   //------------------------------------------------------------------------------
-  // add glb_idx to owned nodes, broadcast/receive glb_idx for ghost nodes
-
-  std::vector<boost::uint64_t> node_from(nb_owned_nodes);
-  std::vector<boost::uint64_t> node_to(nb_owned_nodes);
+  // add glb_idx to owned nodes and elements
 
   common::List<Uint>& nodes_glb_idx = mesh.geometry_fields().glb_idx();
   nodes_glb_idx.resize(nodes.size());
 
-  Uint cnt=0;
   Uint glb_id = start_id_per_proc[PE::Comm::instance().rank()];
   for (Uint i=0; i<nodes.size(); ++i)
   {
     cf3_assert(nodes.rank()[i] < PE::Comm::instance().size());
-    if ( ! nodes.is_ghost(i) )
-    {
-      nodes_glb_idx[i] = glb_id++;
-      node_from[cnt] = hilbert_indices.data()[i];
-      node_to[cnt]   = nodes_glb_idx[i];
-      ++cnt;
-    }
-    else
-    {
-      nodes_glb_idx[i] = uint_max();
-    }
+    nodes_glb_idx[i] = nodes.is_ghost(i) ? uint_max() : glb_id++;
   }
 
-  for (Uint root=0; root<PE::Comm::instance().size(); ++root)
+  boost_foreach( const Handle<Entities>& elements, entities_list )
   {
+    common::List<Uint>& elements_glb_idx = elements->glb_idx();
+    elements_glb_idx.resize(elements->size());
+    for (Uint e=0; e<elements->size(); ++e)
+    {
+      elements_glb_idx[e] = elements->is_ghost(e) ? uint_max() : glb_id++;
+    }
+  }
 
-    std::vector<boost::uint64_t> rcv_node_from(0);
-    PE::Comm::instance().broadcast(node_from,rcv_node_from,root);
-    std::vector<boost::uint64_t>        rcv_node_to(0);
-    PE::Comm::instance().broadcast(node_to,rcv_node_to,root);
+  //------------------------------------------------------------------------------
+  // Each process is responsible for a range of hashes, chosen by sampling the hashes
+  // of all processes. The owners send their glb_idx to the responsible process, and the
+  // processes with ghosts ask it for theirs, so every hash is communicated once.
 
-    if (m_debug)
+  std::vector<boost::uint64_t> splitters;
+  {
+    std::vector<boost::uint64_t> local_hashes(hilbert_indices.data());
+    boost_foreach( const Handle<Entities>& elements, entities_list )
     {
-      std::cout << "["<<PE::Comm::instance().rank() << "]  received nodes from " << root << std::endl;
+      const std::vector<boost::uint64_t>& elem_hashes = Handle<CVector_uint64>(elements->get_child("hilbert_indices"))->data();
+      local_hashes.insert(local_hashes.end(), elem_hashes.begin(), elem_hashes.end());
     }
+    compute_splitters(local_hashes, splitters);
+  }
+
+  const Uint nb_procs = PE::Comm::instance().size();
+  std::vector< std::vector<boost::uint64_t> > send_owned(nb_procs);      // hash, category, glb_idx
+  std::vector< std::vector<boost::uint64_t> > send_requests(nb_procs);   // hash, category
+  std::vector< std::vector< std::pair<Uint,Uint> > > requested(nb_procs); // category, local index
 
-    if (PE::Comm::instance().rank() != root)
+  const Uint nb_categories = entities_list.size() + 1;
+  for (Uint category=0; category<nb_categories; ++category)
+  {
+    const std::vector<boost::uint64_t>& hashes = category == 0 ? hilbert_indices.data() : Handle<CVector_uint64>(entities_list[category-1]->get_child("hilbert_indices"))->data();
+    const common::List<Uint>& glb_idx = category == 0 ? nodes_glb_idx : entities_list[category-1]->glb_idx();
+    for (Uint i=0; i<hashes.size(); ++i)
     {
-      for (Uint p=0; p<PE::Comm::instance().size(); ++p)
+      const Uint p = responsible_process(splitters, hashes[i]);
+      if (glb_idx[i] != uint_max())
       {
-        if (p == PE::Comm::instance().rank())
-        {
-          Uint rcv_idx(0);
-          boost_foreach(const boost::uint64_t hilbert_idx, rcv_node_from)
-          {
-            if ( node_hilbert2loc.count(hilbert_idx) )
-            {
-              const Uint loc_idx = node_hilbert2loc[hilbert_idx];
-              if (m_debug)
-                std::cout << "["<<PE::Comm::instance().rank() << "]  will change node "<< hilbert_idx << " (local " << loc_idx<< ") to (global " << rcv_node_to[rcv_idx] << ")" << std::endl;
-              cf3_assert(rcv_idx < rcv_node_to.size());
-              nodes_glb_idx[loc_idx]=rcv_node_to[rcv_idx];
-              cf3_assert(loc_idx < nodes_rank.size());
-              cf3_assert_desc("node "+to_str(loc_idx)+ " with hilbert_idx " +to_str(hilbert_idx) +" must be a ghost, but is owned by "+to_str(nodes_rank[loc_idx]),nodes.is_ghost(loc_idx));
-              nodes_rank[loc_idx]=std::min(root,nodes_rank[loc_idx]);
-            }
-            ++rcv_idx;
-          }
-          break;
-        }
+        send_owned[p].push_back(hashes[i]);
+        send_owned[p].push_back(category);
+        send_owned[p].push_back(glb_idx[i]);
+      }
+      else
+      {
+        send_requests[p].push_back(hashes[i]);
+        send_requests[p].push_back(category);
+        requested[p].push_back(std::make_pair(category, i));
       }
     }
-    if (m_debug)
+  }
+
+  std::vector< std::vector<boost::uint64_t> > recv_owned;
+  std::vector< std::vector<boost::uint64_t> > recv_requests;
+  PE::Comm::instance().all_to_all(send_owned, recv_owned);
+  PE::Comm::instance().all_to_all(send_requests, recv_requests);
+  send_owned.clear();
+  send_requests.clear();
+
+  // Sorted directory of the hashes this process is responsible for
+  std::vector<HashRecord> directory;
+  for (Uint p=0; p<nb_procs; ++p)
+  {
+    for (Uint i=0; i<recv_owned[p].size(); i+=3)
     {
-      std::cout << "["<<PE::Comm::instance().rank() << "]  changed nodes based on " << root << std::endl;
+      directory.push_back(HashRecord(recv_owned[p][i], recv_owned[p][i+1], recv_owned[p][i+2], p));
     }
-
   }
+  recv_owned.clear();
+  std::sort(directory.begin(), directory.end());
 
   if (m_debug)
   {
-    std::cout << "["<<PE::Comm::instance().rank() << "]  checking node validity" << std::endl;
-    for (Uint i=0; i<nodes.size(); ++i)
+    for (Uint i=1; i<directory.size(); ++i)
     {
-      cf3_assert(nodes.glb_idx()[i] != uint_max());
-      if (nodes.is_ghost(i) == false)
-      {
-        cf3_assert(nodes.glb_idx()[i] >= start_id_per_proc[PE::Comm::instance().rank()]);
-        cf3_assert(nodes.glb_idx()[i] < start_id_per_proc[PE::Comm::instance().rank()] + nb_owned_nodes);
-      }
+      if ( !(directory[i-1] < directory[i]) )
+        throw ValueExists(FromHere(), "hash "+to_str(directory[i].hash)+" is owned by processes "+to_str(directory[i-1].rank)+" and "+to_str(directory[i].rank));
     }
   }
 
-  //------------------------------------------------------------------------------
-  // give glb idx to elements
-
-  boost_foreach( Entities& elements, find_components_recursively<Entities>(mesh) )
+  // Answer with glb_idx and owner rank, or uint_max() if no process owns the hash
+  std::vector< std::vector<boost::uint64_t> > send_answers(nb_procs);
+  for (Uint p=0; p<nb_procs; ++p)
   {
-    if (m_debug)
-      std::cout << "give glb idx to elements " << elements.uri() << std::endl;
-    std::vector<boost::uint64_t>& hilbert_indices = Handle<CVector_uint64>(elements.get_child("hilbert_indices"))->data();
-    common::List<Uint>& elem_rank = elements.rank();
-    elem_rank.resize(elements.size());
-
-    //------------------------------------------------------------------------------
-    // create elem_glb2loc mapping
-    Uint nb_owned_elems=0;
-    std::map<boost::uint64_t,Uint> elem_glb2loc;
-    std::map<boost::uint64_t,Uint>::iterator elem_glb2loc_it;
-    std::map<boost::uint64_t,Uint>::iterator hash_not_found = elem_glb2loc.end();
-
-    for (Uint e=0; e<elements.size(); ++e)
+    send_answers[p].reserve(recv_requests[p].size());
+    for (Uint i=0; i<recv_requests[p].size(); i+=2)
     {
-      elem_glb2loc [ hilbert_indices[e] ] = e;
-      if ( ! elements.is_ghost(e) )
-        ++nb_owned_elems;
+      const HashRecord request(recv_requests[p][i], recv_requests[p][i+1], uint_max(), uint_max());
+      std::vector<HashRecord>::const_iterator found = std::lower_bound(directory.begin(), directory.end(), request);
+      const bool is_found = found != directory.end() && !(request < *found);
+      send_answers[p].push_back(is_found ? found->glb_idx : uint_max());
+      send_answers[p].push_back(is_found ? found->rank : uint_max());
     }
+  }
+  recv_requests.clear();
+  directory.clear();
 
+  std::vector< std::vector<boost::uint64_t> > recv_answers;
+  PE::Comm::instance().all_to_all(send_answers, recv_answers);
 
-    std::vector<boost::uint64_t> send_hash(nb_owned_elems);
-    std::vector<boost::uint64_t>   send_id(nb_owned_elems);
-
-    common::List<Uint>& elements_glb_idx = elements.glb_idx();
-    elements_glb_idx.resize(elements.size());
-    cf3_assert(hilbert_indices.size() == elements.size());
+  //------------------------------------------------------------------------------
+  // give glb_idx and rank to ghost nodes and elements
 
-    Uint cnt(0);
-    for (Uint e=0; e<elements.size(); ++e)
+  for (Uint p=0; p<nb_procs; ++p)
+  {
+    cf3_assert(recv_answers[p].size() == 2*requested[p].size());
+    for (Uint r=0; r<requested[p].size(); ++r)
     {
-
-      if ( ! elements.is_ghost(e) )
+      const Uint category = requested[p][r].first;
+      const Uint loc_idx = requested[p][r].second;
+      const Uint received_glb_idx = recv_answers[p][2*r];
+      const Uint owner = recv_answers[p][2*r+1];
+      if (received_glb_idx == uint_max())
+        continue;
+
+      if (category == 0)
       {
         if (m_debug)
-          std::cout << "["<<PE::Comm::instance().rank() << "]  will change owned elem "<< hilbert_indices[e] << " (" << elements.uri().path() << "["<<e<<"]) to " << glb_id << std::endl;
-
-        elements_glb_idx[e] = glb_id++;
-        send_hash[cnt] = hilbert_indices[e];
-        send_id[cnt]   = elements_glb_idx[e];
-        ++cnt;
+          std::cout << "["<<PE::Comm::instance().rank() << "]  will change node "<< hilbert_indices.data()[loc_idx] << " (local " << loc_idx<< ") to (global " << received_glb_idx << ")" << std::endl;
+        cf3_assert(loc_idx < nodes_rank.size());
+        cf3_assert_desc("node "+to_str(loc_idx)+" must be a ghost, but is owned by "+to_str(nodes_rank[loc_idx]),nodes.is_ghost(loc_idx));
+        nodes_glb_idx[loc_idx] = received_glb_idx;
+        nodes_rank[loc_idx] = std::min(owner,nodes_rank[loc_idx]);
       }
       else
       {
-        elements_glb_idx[e] = uint_max();
+        Entities& elements = *entities_list[category-1];
+        if (m_debug)
+          std::cout << "["<<PE::Comm::instance().rank() << "]  will change ghost elem (" << elements.uri().path() << "[" << loc_idx << "]) to " << received_glb_idx << std::endl;
+        cf3_assert(elements.is_ghost(loc_idx));
+        elements.glb_idx()[loc_idx] = received_glb_idx;
+        elements.rank()[loc_idx] = owner;
       }
-    } // end foreach elem_idx
-    cf3_assert(cnt == nb_owned_elems);
+    }
+  }
 
-    for (Uint root=0; root<PE::Comm::instance().size(); ++root)
+  if (m_debug)
+  {
+    std::cout << "["<<PE::Comm::instance().rank() << "]  checking node validity" << std::endl;
+    for (Uint i=0; i<nodes.size(); ++i)
     {
-      std::vector<boost::uint64_t> recv_hash(0);
-      PE::Comm::instance().broadcast(send_hash,recv_hash,root);
-      std::vector<boost::uint64_t>        recv_id(0);
-      PE::Comm::instance().broadcast(send_id,recv_id,root);
-      if (PE::Comm::instance().rank() != root)
+      cf3_assert(nodes.glb_idx()[i] != uint_max());
+      if (nodes.is_ghost(i) == false)
       {
-        for (Uint p=0; p<PE::Comm::instance().size(); ++p)
-        {
-          if (p == PE::Comm::instance().rank())
-          {
-            Uint recv_idx(0);
-            boost_foreach(const boost::uint64_t hash, recv_hash)
-            {
-              elem_glb2loc_it = elem_glb2loc.find(hash);
-              if ( elem_glb2loc_it != hash_not_found )
-              {
-                if (m_debug)
-                  std::cout << "["<<PE::Comm::instance().rank() << "]  will change ghost elem "<< elem_glb2loc_it->first << " (" << elements.uri() << "[" << elem_glb2loc_it->second << "]) to " << recv_id[recv_idx] << std::endl;
-                elements_glb_idx[elem_glb2loc_it->second]=recv_id[recv_idx];
-                cf3_assert(elements.is_ghost(elem_glb2loc_it->second));
-                elem_rank[elem_glb2loc_it->second]=root;
-              }
-              ++recv_idx;
-            }
-            break;
-          }
-        }
+        cf3_assert(nodes.glb_idx()[i] >= start_id_per_proc[PE::Comm::instance().rank()]);
+        cf3_assert(nodes.glb_idx()[i] < start_id_per_proc[PE::Comm::instance().rank()] + nb_owned_nodes);
       }
-    } // end foreach broadcasting process
-
-
-
-  } // end foreach elements
+    }
+  }
 
 
   // In debug mode, check if no hashes are duplicated
@@ -199,6 +199,9 @@ void LinkPeriodicNodes::execute()
       }
     }
   }
+
+  // The links changed, so the stored inverse map is no longer valid
+  mesh.geometry_fields().clear_inverse_periodic_links();
 /*
   boost::shared_ptr<NodeConnectivity> node_connectivity = common::allocate_component<NodeConnectivity>("node_connectivity");
   node_connectivity->initialize(common::find_components_recursively_with_filter<mesh::Entities>(*m_destination_region, IsElementsSurface()));
@@ -62,6 +62,7 @@ void MakeBoundaryGlobal::execute()
   {
     mesh.geometry_fields().remove_component("periodic_links_nodes");
     mesh.geometry_fields().remove_component("periodic_links_active");
+    mesh.geometry_fields().clear_inverse_periodic_links();
   }
 
   std::vector< std::vector< std::vector<Uint> > > elements_to_send(nb_procs, std::vector< std::vector<Uint> > (m_mesh->elements().size()));
@@ -311,6 +311,7 @@ void PeriodicMeshPartitioner::execute()
   // Clean up the mesh structures
   mesh.geometry_fields().remove_component("periodic_links_nodes");
   mesh.geometry_fields().remove_component("periodic_links_active");
+  mesh.geometry_fields().clear_inverse_periodic_links();
   BOOST_FOREACH(mesh::Elements& elements, common::find_components_recursively_with_filter<mesh::Elements>(mesh.topology(), IsElementsSurface()))
   {
     Handle< common::List<Uint> > periodic_links_elements(elements.get_child("periodic_links_elements"));
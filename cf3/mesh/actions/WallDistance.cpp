@@ -4,6 +4,7 @@
 // GNU Lesser General Public License version 3 (LGPLv3).
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
+#include <map>
 #include <set>
 
 #include "common/Builder.hpp"
@@ -13,6 +14,13 @@
 #include "common/Option.hpp"
 #include "common/OptionList.hpp"
 #include "common/List.hpp"
+#include "common/Log.hpp"
+#include "common/Threads.hpp"
+
+#include "common/PE/Comm.hpp"
+
+#include "math/Consts.hpp"
+#include "math/KDTree.hpp"
 
 #include "mesh/ConnectivityData.hpp"
 #include "mesh/DiscontinuousDictionary.hpp"
@@ -46,77 +54,186 @@ common::ComponentBuilder < WallDistance, MeshTransformer, mesh::actions::LibActi
 namespace detail
 {
 
+/// Compact description of the wall: the coordinates of the wall nodes and the surface elements that connect them.
+/// This contains no references to the mesh, so it can be exchanged between processes.
+struct WallSurface
+{
+  WallSurface(const Uint dimension) : dim(dimension)
+  {
+    face_offsets.push_back(0);
+  }
+
+  Uint nb_nodes() const { return node_gids.size(); }
+  Uint nb_faces() const { return face_offsets.size() - 1; }
+
+  /// Add a node, returning its index in the surface. Nodes with the same global index are only stored once
+  Uint add_node(const Uint gid, const Real* coords, const Uint local_node)
+  {
+    const std::pair<std::map<Uint, Uint>::iterator, bool> inserted = gid_to_node.insert(std::make_pair(gid, nb_nodes()));
+    if(inserted.second)
+    {
+      node_gids.push_back(gid);
+      local_nodes.push_back(local_node);
+      coordinates.insert(coordinates.end(), coords, coords + dim);
+    }
+    return inserted.first->second;
+  }
+
+  /// Add a face, given the surface indices of its nodes. Faces that were added before are skipped
+  void add_face(const std::vector<Uint>& nodes, const Real* normal, const NodeConnectivity::ElementReferenceT& element)
+  {
+    std::vector<Uint> sorted_gids;
+    BOOST_FOREACH(const Uint node, nodes)
+      sorted_gids.push_back(node_gids[node]);
+    std::sort(sorted_gids.begin(), sorted_gids.end());
+    if(!known_faces.insert(sorted_gids).second)
+      return;
+
+    face_nodes.insert(face_nodes.end(), nodes.begin(), nodes.end());
+    face_offsets.push_back(face_nodes.size());
+    face_normals.insert(face_normals.end(), normal, normal + dim);
+    face_elements.push_back(element);
+  }
+
+  /// Build the list of faces around each node, needed for the projections
+  void build_node_faces()
+  {
+    node_face_offsets.assign(nb_nodes()+1, 0);
+    for(Uint i = 0; i != face_nodes.size(); ++i)
+      ++node_face_offsets[face_nodes[i]+1];
+    for(Uint i = 0; i != nb_nodes(); ++i)
+      node_face_offsets[i+1] += node_face_offsets[i];
+
+    node_faces.resize(face_nodes.size());
+    std::vector<Uint> fill_pos(node_face_offsets.begin(), node_face_offsets.end()-1);
+    for(Uint face = 0; face != nb_faces(); ++face)
+    {
+      for(Uint i = face_offsets[face]; i != face_offsets[face+1]; ++i)
+        node_faces[fill_pos[face_nodes[i]]++] = face;
+    }
+  }
+
+  /// Pack the nodes and faces for communication
+  void pack(std::vector<Uint>& uint_data, std::vector<Real>& real_data) const
+  {
+    uint_data.clear();
+    uint_data.push_back(nb_nodes());
+    uint_data.push_back(nb_faces());
+    uint_data.insert(uint_data.end(), node_gids.begin(), node_gids.end());
+    uint_data.insert(uint_data.end(), face_offsets.begin(), face_offsets.end());
+    uint_data.insert(uint_data.end(), face_nodes.begin(), face_nodes.end());
+    real_data = coordinates;
+    real_data.insert(real_data.end(), face_normals.begin(), face_normals.end());
+  }
+
+  /// Add the nodes and faces packed by another surface. The faces have no element reference in the local mesh.
+  void unpack(const std::vector<Uint>& uint_data, const std::vector<Real>& real_data)
+  {
+    const Uint other_nb_nodes = uint_data[0];
+    const Uint other_nb_faces = uint_data[1];
+    const Uint* gids = &uint_data[2];
+    const Uint* offsets = gids + other_nb_nodes;
+    const Uint* nodes = offsets + other_nb_faces + 1;
+    const Real* coords = real_data.empty() ? 0 : &real_data[0];
+    const Real* normals = coords + dim*other_nb_nodes;
+
+    std::vector<Uint> node_map(other_nb_nodes);
+    for(Uint i = 0; i != other_nb_nodes; ++i)
+      node_map[i] = add_node(gids[i], coords + dim*i, math::Consts::uint_max());
+
+    const NodeConnectivity::ElementReferenceT no_element(math::Consts::uint_max(), math::Consts::uint_max());
+    std::vector<Uint> face;
+    for(Uint i = 0; i != other_nb_faces; ++i)
+    {
+      face.clear();
+      for(Uint j = offsets[i]; j != offsets[i+1]; ++j)
+        face.push_back(node_map[nodes[j]]);
+      add_face(face, normals + dim*i, no_element);
+    }
+  }
+
+  const Uint dim;
+  /// Coordinates of the wall nodes, dim values per node
+  std::vector<Real> coordinates;
+  /// Global index of each wall node
+  std::vector<Uint> node_gids;
+  /// Index of each wall node in the local mesh, or uint_max for nodes that are only on the walls of other processes
+  std::vector<Uint> local_nodes;
+  std::map<Uint, Uint> gid_to_node;
+  /// Nodes of each face, indexed using face_offsets
+  std::vector<Uint> face_nodes;
+  std::vector<Uint> face_offsets;
+  /// Unit normal of each face, dim values per face
+  std::vector<Real> face_normals;
+  /// Element in the wall node connectivity for each face, or uint_max for faces that only exist on other processes
+  std::vector<NodeConnectivity::ElementReferenceT> face_elements;
+  /// Faces around each node, indexed using node_face_offsets
+  std::vector<Uint> node_faces;
+  std::vector<Uint> node_face_offsets;
+  /// Sorted global node indices of the faces, to skip duplicates
+  std::set< std::vector<Uint> > known_faces;
+};
+
 /// Helper struct to handle projection to the wall near a given surface node
 struct WallProjection
 {
-  WallProjection(const Field& coordinates, const NodeConnectivity& node_connectivity, const std::vector<std::vector<RealVector>>& normals) :
-    m_coords(coordinates),
-    m_node_connectivity(node_connectivity),
-    m_normals(normals)
+  WallProjection(const WallSurface& surface) :
+    m_surface(surface)
   {
   }
 
   // Get the wall distance for an inner node, looking at the elements that are adjacent to the given surface node
-  Real operator()(const Uint inner_node_idx, const Uint surface_node_idx)
+  Real operator()(const RealVector& inner_coord, const Uint surface_node_idx)
   {
     m_has_nearest_element = false;
-    RealMatrix elem_coords;
-    const Uint dim = m_coords.row_size();
-    const RealVector inner_coord = to_vector(m_coords[inner_node_idx]);
+    const Uint dim = m_surface.dim;
     std::vector<Uint> neighbor_nodes; // Collect neighboring nodes, so we can project onto a sharp corner in 3D if needed (i.e. near a step)
     // Loop over all surface elements around the given node
-    BOOST_FOREACH(const NodeConnectivity::ElementReferenceT& element_ref, m_node_connectivity.node_element_range(surface_node_idx))
+    for(Uint face_pos = m_surface.node_face_offsets[surface_node_idx]; face_pos != m_surface.node_face_offsets[surface_node_idx+1]; ++face_pos)
     {
+      const Uint face = m_surface.node_faces[face_pos];
+      const Uint* conn_row = &m_surface.face_nodes[m_surface.face_offsets[face]];
+      const Uint element_nb_nodes = m_surface.face_offsets[face+1] - m_surface.face_offsets[face];
+
       // Get the element coordinates
-      const Entities& elem_entities = *m_node_connectivity.entities()[element_ref.first];
-      const ElementType& etype = elem_entities.element_type();
-      const Uint element_nb_nodes = etype.nb_nodes();
-      elem_coords.resize(element_nb_nodes, dim);
-      const Connectivity::ConstRow conn_row = elem_entities.geometry_space().connectivity()[element_ref.second];
-      fill(elem_coords, m_coords, conn_row);
-
-      // We consider lines, triangles and quads as viable surface elements
-      if(element_nb_nodes < 2 || element_nb_nodes > 4 || etype.order() != 1)
-      {
-        throw common::SetupError(FromHere(), "Unsupported surface element of type " + etype.name() + " in surface region " + elem_entities.uri().path());
-      }
+      m_elem_coords.resize(element_nb_nodes, dim);
+      for(Uint i = 0; i != element_nb_nodes; ++i)
+        m_elem_coords.row(i) = Eigen::Map<const RealRowVector>(&m_surface.coordinates[conn_row[i]*dim], dim);
 
       bool in_element = false;
 
       if(element_nb_nodes == 2) // line segment
       {
         cf3_assert(dim == 2);
-        cf3_assert(etype.shape() == GeoShape::LINE);
-        RealVector e1 = elem_coords.row(1) - elem_coords.row(0); // line segment vector
+        RealVector e1 = m_elem_coords.row(1) - m_elem_coords.row(0); // line segment vector
         Real e1_len = e1.norm();
         e1 /= e1_len;
-        const Real projection = e1.dot(inner_coord - elem_coords.row(0).transpose());
+        const Real projection = e1.dot(inner_coord - m_elem_coords.row(0).transpose());
         // If the projection of the node along the normal fits inside the element, we can take the normal distance
         in_element = projection >= 0 && projection <= e1_len;
       }
       if(element_nb_nodes == 3)
       {
         cf3_assert(dim == 3);
-        cf3_assert(etype.shape() == GeoShape::TRIAG);
-        RealVector3 e1 = (elem_coords.row(1) - elem_coords.row(0)).normalized();
-        RealVector3 en = elem_coords.row(2) - elem_coords.row(0);
+        RealVector3 e1 = (m_elem_coords.row(1) - m_elem_coords.row(0)).normalized();
+        RealVector3 en = m_elem_coords.row(2) - m_elem_coords.row(0);
         RealVector3 e2 = (e1.cross(en)).cross(e1).normalized();
-        RealVector3 p = inner_coord - elem_coords.row(0).transpose();
+        RealVector3 p = inner_coord - m_elem_coords.row(0).transpose();
 
         // Construct 2D coordinates for the boundary element
         Eigen::Matrix<Real, 3, 2> triag_coords_2d;
         triag_coords_2d.row(0).setZero();
-        triag_coords_2d(1,0) = e1.dot(elem_coords.row(1) - elem_coords.row(0));
+        triag_coords_2d(1,0) = e1.dot(m_elem_coords.row(1) - m_elem_coords.row(0));
         triag_coords_2d(1,1) = 0.;
-        triag_coords_2d(2,0) = e1.dot(elem_coords.row(2) - elem_coords.row(0));
-        triag_coords_2d(2,1) = e2.dot(elem_coords.row(2) - elem_coords.row(0));
+        triag_coords_2d(2,0) = e1.dot(m_elem_coords.row(2) - m_elem_coords.row(0));
+        triag_coords_2d(2,1) = e2.dot(m_elem_coords.row(2) - m_elem_coords.row(0));
 
         RealVector2 p_proj(2);
         p_proj[0] = p.dot(e1);
         p_proj[1] = p.dot(e2);
 
         in_element = LagrangeP1::Triag2D::is_coord_in_element(p_proj, triag_coords_2d);
-        const Uint origin_corner = std::find(conn_row.begin(), conn_row.end(), surface_node_idx) - conn_row.begin();
+        const Uint origin_corner = std::find(conn_row, conn_row + 3, surface_node_idx) - conn_row;
         if(origin_corner == 0)
         {
           neighbor_nodes.push_back(conn_row[1]);
@@ -136,19 +253,18 @@ struct WallProjection
       if(element_nb_nodes == 4)
       {
         cf3_assert(dim == 3);
-        cf3_assert(etype.shape() == GeoShape::QUAD);
-        RealVector3 e1 = (elem_coords.row(1) - elem_coords.row(0)).normalized();
-        RealVector3 en = elem_coords.row(3) - elem_coords.row(0);
+        RealVector3 e1 = (m_elem_coords.row(1) - m_elem_coords.row(0)).normalized();
+        RealVector3 en = m_elem_coords.row(3) - m_elem_coords.row(0);
         RealVector3 e2 = (e1.cross(en)).cross(e1).normalized();
-        RealVector3 p = inner_coord - elem_coords.row(0).transpose();
+        RealVector3 p = inner_coord - m_elem_coords.row(0).transpose();
 
         // Construct 2D coordinates for the boundary element
         Eigen::Matrix<Real, 4, 2> quad_coords_2d;
         quad_coords_2d.row(0).setZero();
         for(int i = 1; i != 4; ++i)
         {
-          quad_coords_2d(i, 0) = e1.dot(elem_coords.row(i) - elem_coords.row(0));
-          quad_coords_2d(i, 1) = e2.dot(elem_coords.row(i) - elem_coords.row(0));
+          quad_coords_2d(i, 0) = e1.dot(m_elem_coords.row(i) - m_elem_coords.row(0));
+          quad_coords_2d(i, 1) = e2.dot(m_elem_coords.row(i) - m_elem_coords.row(0));
         }
 
         RealVector2 p_proj(2);
@@ -156,7 +272,7 @@ struct WallProjection
         p_proj[1] = p.dot(e2);
 
         in_element = LagrangeP1::Quad2D::is_coord_in_element(p_proj, quad_coords_2d);
-        const Uint origin_corner = std::find(conn_row.begin(), conn_row.end(), surface_node_idx) - conn_row.begin();
+        const Uint origin_corner = std::find(conn_row, conn_row + 4, surface_node_idx) - conn_row;
         if(origin_corner == 0 || origin_corner == 2)
         {
           neighbor_nodes.push_back(conn_row[1]);
@@ -172,17 +288,18 @@ struct WallProjection
       // If the projection was in an element, we can just proceed to compute the normal distance
       if(in_element)
       {
-        m_last_nearest_element = element_ref;
-        m_has_nearest_element = true;
-        return fabs(m_normals[element_ref.first][element_ref.second].dot(inner_coord - elem_coords.row(0).transpose()));
+        m_last_nearest_element = m_surface.face_elements[face];
+        m_has_nearest_element = m_last_nearest_element.first != math::Consts::uint_max();
+        const Eigen::Map<const RealVector> normal(&m_surface.face_normals[face*dim], dim);
+        return fabs(normal.dot(inner_coord - m_elem_coords.row(0).transpose()));
       }
     }
     // If we got here, no projections on the elements gave a result
     // First, verify the 3D case where we need to project on "step" edges
+    const Eigen::Map<const RealVector> surface_coord(&m_surface.coordinates[surface_node_idx*dim], dim);
     BOOST_FOREACH(const Uint neighbor_node, neighbor_nodes)
     {
-      const RealVector surface_coord = to_vector(m_coords[surface_node_idx]);
-      const RealVector neighbor_coord = to_vector(m_coords[neighbor_node]);
+      const Eigen::Map<const RealVector> neighbor_coord(&m_surface.coordinates[neighbor_node*dim], dim);
       RealVector e1 = neighbor_coord - surface_coord;
       Real e1_len = e1.norm();
       e1 /= e1_len;
@@ -192,12 +309,11 @@ struct WallProjection
         return (inner_coord - (surface_coord + e1*projection)).norm();
       }
     }
-    return (inner_coord - to_vector(m_coords[surface_node_idx])).norm();
+    return (inner_coord - surface_coord).norm();
   }
 
-  const Field& m_coords;
-  const NodeConnectivity& m_node_connectivity;
-  const std::vector<std::vector<RealVector>>& m_normals;
+  const WallSurface& m_surface;
+  RealMatrix m_elem_coords;
   bool m_has_nearest_element = false;
   NodeConnectivity::ElementReferenceT m_last_nearest_element;
 };
@@ -210,6 +326,11 @@ WallDistance::WallDistance(const std::string& name) : MeshTransformer(name)
       .description("Regions that are to be considered as part of the wall")
       .link_to(&m_regions)
       .mark_basic();
+
+  options().add("distributed", m_distributed)
+      .pretty_name("Distributed")
+      .description("Gather the wall surface of all processes, so processes that don't have the wall elements get the correct distance. Requires the node global indices.")
+      .link_to(&m_distributed);
 }
 
 void WallDistance::execute()
@@ -238,35 +359,67 @@ void WallDistance::execute()
   Field& d = mesh.geometry_fields().create_field("wall_distance");
   d.add_tag("wall_distance");
 
-  std::vector<std::vector<RealVector>> normals;
+  common::PE::Comm& comm = common::PE::Comm::instance();
+  const bool distributed = m_distributed && comm.is_active() && comm.size() > 1;
+  const common::List<Uint>& gids = mesh.geometry_fields().glb_idx();
+  if(distributed && gids.size() != nb_nodes)
+    throw common::SetupError(FromHere(), "Distributed wall distance needs the global node indices of mesh " + mesh.uri().path());
 
-  for(const auto& wall_entity : surface_entities)
+  // Build the surface description for the local wall elements. Nodes are identified by their global index in distributed mode.
+  detail::WallSurface surface(dim);
+  for(Uint entities_idx = 0; entities_idx != surface_entities.size(); ++entities_idx)
   {
-    const Uint nb_elems = wall_entity->size();
-    const auto& geom_conn = wall_entity->geometry_space().connectivity();
-    const ElementType& etype = wall_entity->element_type();
+    const Entities& wall_entity = *surface_entities[entities_idx];
+    const Uint nb_elems = wall_entity.size();
+    const auto& geom_conn = wall_entity.geometry_space().connectivity();
+    const ElementType& etype = wall_entity.element_type();
     const Uint element_nb_nodes = etype.nb_nodes();
 
-    normals.push_back(std::vector<RealVector>(nb_elems, RealVector(dim)));
+    // We consider lines, triangles and quads as viable surface elements
+    if(element_nb_nodes < 2 || element_nb_nodes > 4 || etype.order() != 1)
+    {
+      throw common::SetupError(FromHere(), "Unsupported surface element of type " + etype.name() + " in surface region " + wall_entity.uri().path());
+    }
 
     RealMatrix elem_coords(element_nb_nodes, dim);
+    RealVector normal(dim);
+    std::vector<Uint> face(element_nb_nodes);
     for(Uint elem_idx = 0; elem_idx != nb_elems; ++elem_idx)
     {
       const Connectivity::ConstRow conn_row = geom_conn[elem_idx];
       fill(elem_coords, coords, conn_row);
-      RealVector normal(dim);
-      etype.compute_normal(elem_coords, normals.back()[elem_idx]);
-      normals.back()[elem_idx] /= normals.back()[elem_idx].norm();
+      etype.compute_normal(elem_coords, normal);
+      normal /= normal.norm();
+      for(Uint i = 0; i != element_nb_nodes; ++i)
+        face[i] = surface.add_node(distributed ? gids[conn_row[i]] : conn_row[i], &coords[conn_row[i]][0], conn_row[i]);
+      surface.add_face(face, normal.data(), std::make_pair(entities_idx, elem_idx));
     }
   }
 
-  boost::shared_ptr< common::List< Uint > > surface_nodes_ptr = build_used_nodes_list(const_surface_entities, mesh.geometry_fields(), true);
-  const common::List<Uint>& surface_nodes = *surface_nodes_ptr;
-  const Uint nb_surface_nodes = surface_nodes.size();
+  // Add the walls of the other processes
+  if(distributed)
+  {
+    std::vector<Uint> send_uints;
+    std::vector<Real> send_reals;
+    surface.pack(send_uints, send_reals);
+    std::vector< std::vector<Uint> > recv_uints;
+    std::vector< std::vector<Real> > recv_reals;
+    comm.all_gather(send_uints, recv_uints);
+    comm.all_gather(send_reals, recv_reals);
+    for(Uint rank = 0; rank != comm.size(); ++rank)
+    {
+      if(rank != comm.rank())
+        surface.unpack(recv_uints[rank], recv_reals[rank]);
+    }
+  }
+
+  surface.build_node_faces();
 
-  detail::WallProjection normal_distance(coords, *node_connectivity, normals);
+  math::KDTree wall_tree(dim);
+  wall_tree.build(surface.coordinates);
 
   // Link each node to a wall element. First column: 1 if a wall element exists. Second column: index to the entities in the node connectivity. Last column: element index
+  // If there is no wall element, the second column is the local index of the closest wall node, or uint_max if that node is not in the local mesh
   auto& node_to_wall_element = *mesh.create_component<common::Table<Uint>>("node_to_wall_element");
   node_to_wall_element.set_row_size(3);
   node_to_wall_element.resize(nb_nodes);
@@ -275,49 +428,65 @@ void WallDistance::execute()
     std::fill(row.begin(), row.end(), 0);
   }
 
-  for(Uint inner_node_idx = 0; inner_node_idx != nb_nodes; ++inner_node_idx)
+  if(surface.nb_nodes() == 0)
   {
-    bool is_surface_node = false;
-    Real shortest_distance = 1e20;
-    Uint closest_surface_node = 0;
-    for(Uint j = 0; j != nb_surface_nodes; ++j)
-    {
-      const Uint surface_node_idx = surface_nodes[j];
-      if(surface_node_idx == inner_node_idx)
-      {
-        is_surface_node = true;
-        break;
-      }
-      const Real d2 = (to_vector(coords[inner_node_idx]) - to_vector(coords[surface_node_idx])).squaredNorm();
-      if(d2 < shortest_distance)
-      {
-        shortest_distance = d2;
-        closest_surface_node = surface_node_idx;
-      }
-    }
+    CFwarn << "No wall nodes found for wall distance computation on mesh " << mesh.uri().path() << CFendl;
+    return;
+  }
 
-    if(is_surface_node)
-    {
-      d[inner_node_idx][0] = 0.;
-      // Eigen::Map<RealVector> node_normal(&nodal_normals[inner_node_idx][0], dim);
-      // node_normal /= node_normal.norm();
-    }
-    else
+  // Each node is independent, so the nodes are distributed over the threads
+  const int nb_nodes_int = nb_nodes;
+  const int nb_threads = common::nb_threads();
+  std::string error_message;
+  #pragma omp parallel num_threads(nb_threads)
+  {
+    detail::WallProjection normal_distance(surface);
+    RealVector inner_coord(dim);
+
+    #pragma omp for schedule(dynamic, 256)
+    for(int inner_node_idx = 0; inner_node_idx < nb_nodes_int; ++inner_node_idx)
     {
-      d[inner_node_idx][0] = normal_distance(inner_node_idx, closest_surface_node);
-      if(normal_distance.m_has_nearest_element)
+      try
       {
-        node_to_wall_element[inner_node_idx][0] = 1;
-        node_to_wall_element[inner_node_idx][1] = normal_distance.m_last_nearest_element.first;
-        node_to_wall_element[inner_node_idx][2] = normal_distance.m_last_nearest_element.second;
+        inner_coord = to_vector(coords[inner_node_idx]);
+        Real squared_distance;
+        const Uint closest_surface_node = wall_tree.nearest(inner_coord, squared_distance);
+
+        // Nodes on the wall coincide with a wall node
+        if(squared_distance == 0.)
+        {
+          d[inner_node_idx][0] = 0.;
+        }
+        else
+        {
+          d[inner_node_idx][0] = normal_distance(inner_coord, closest_surface_node);
+          if(normal_distance.m_has_nearest_element)
+          {
+            node_to_wall_element[inner_node_idx][0] = 1;
+            node_to_wall_element[inner_node_idx][1] = normal_distance.m_last_nearest_element.first;
+            node_to_wall_element[inner_node_idx][2] = normal_distance.m_last_nearest_element.second;
+          }
+          else
+          {
+            node_to_wall_element[inner_node_idx][0] = 0;
+            node_to_wall_element[inner_node_idx][1] = surface.local_nodes[closest_surface_node];
+          }
+        }
       }
-      else
+      catch(std::exception& e)
       {
-        node_to_wall_element[inner_node_idx][0] = 0;
-        node_to_wall_element[inner_node_idx][1] = closest_surface_node;
+        // Exceptions can't leave the parallel region, so the first error is recorded and rethrown afterwards
+        #pragma omp critical
+        {
+          if(error_message.empty())
+            error_message = e.what();
+        }
       }
     }
   }
+
+  if(!error_message.empty())
+    throw common::ParallelError(FromHere(), "Wall distance computation for mesh " + mesh.uri().path() + " failed: " + error_message);
 }
 
 //////////////////////////////////////////////////////////////////////////////
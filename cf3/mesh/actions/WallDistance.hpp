@@ -22,6 +22,9 @@ namespace actions {
 
 //////////////////////////////////////////////////////////////////////////////
 
+/// Compute the distance to the nearest wall for every node of the mesh, storing it in the field "wall_distance".
+/// The closest wall node is found using a k-d tree, and the distance is refined by projecting onto the wall elements
+/// around that node. In distributed mode, the wall surfaces of all processes are gathered first.
 class WallDistance : public MeshTransformer
 {
 public:
@@ -32,6 +35,9 @@ public:
 private:
   /// Wall regions to operate over
   std::vector< Handle<Region> > m_regions;
+
+  /// True if the walls of all processes must be taken into account
+  bool m_distributed = false;
 };
 
 
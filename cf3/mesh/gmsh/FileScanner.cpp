@@ -0,0 +1,219 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include <cstdlib>
+
+#include <boost/filesystem/operations.hpp>
+
+#include "common/BasicExceptions.hpp"
+#include "common/StringConversion.hpp"
+
+#include "mesh/gmsh/FileScanner.hpp"
+
+//////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace mesh {
+namespace gmsh {
+
+//////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+  inline bool is_space(const char c)
+  {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+FileScanner::FileScanner() :
+  m_begin(0),
+  m_end(0),
+  m_pos(0)
+{
+}
+
+FileScanner::~FileScanner()
+{
+  close();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void FileScanner::open(const std::string& path)
+{
+  close();
+  m_path = path;
+  if(boost::filesystem::file_size(path) == 0)
+    throw common::ParsingFailed(FromHere(), "File " + path + " is empty");
+
+  try
+  {
+    m_file.open(path);
+  }
+  catch(std::exception& e)
+  {
+    throw common::FileSystemError(FromHere(), "Could not map file " + path + " in memory: " + e.what());
+  }
+
+  m_begin = m_file.data();
+  m_end = m_begin + m_file.size();
+  m_pos = m_begin;
+}
+
+void FileScanner::close()
+{
+  if(m_file.is_open())
+    m_file.close();
+  m_begin = m_end = m_pos = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void FileScanner::seek(const std::size_t offset)
+{
+  cf3_assert(offset <= size());
+  m_pos = m_begin + offset;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void FileScanner::skip_line()
+{
+  const char* newline = static_cast<const char*>(std::memchr(m_pos, '\n', m_end - m_pos));
+  m_pos = newline ? newline + 1 : m_end;
+}
+
+void FileScanner::skip_lines(const Uint nb_lines)
+{
+  for(Uint i = 0; i != nb_lines; ++i)
+  {
+    if(eof())
+      throw_parse_error(common::to_str(nb_lines) + " lines");
+    skip_line();
+  }
+}
+
+void FileScanner::skip_bytes(const std::size_t nb_bytes)
+{
+  if(static_cast<std::size_t>(m_end - m_pos) < nb_bytes)
+    throw_parse_error(common::to_str(nb_bytes) + " bytes");
+  m_pos += nb_bytes;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void FileScanner::skip_whitespace()
+{
+  while(m_pos != m_end && is_space(*m_pos))
+    ++m_pos;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+std::string FileScanner::read_line()
+{
+  const char* line_begin = m_pos;
+  skip_line();
+  const char* line_end = m_pos;
+  while(line_end != line_begin && (line_end[-1] == '\n' || line_end[-1] == '\r'))
+    --line_end;
+  return std::string(line_begin, line_end);
+}
+
+std::string FileScanner::read_word()
+{
+  skip_whitespace();
+  const char* word_begin = m_pos;
+  while(m_pos != m_end && !is_space(*m_pos))
+    ++m_pos;
+  if(m_pos == word_begin)
+    throw_parse_error("word");
+  return std::string(word_begin, m_pos);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+Uint FileScanner::read_uint()
+{
+  skip_whitespace();
+  if(m_pos == m_end || *m_pos < '0' || *m_pos > '9')
+    throw_parse_error("unsigned integer");
+
+  Uint result = 0;
+  while(m_pos != m_end && *m_pos >= '0' && *m_pos <= '9')
+  {
+    result = 10*result + static_cast<Uint>(*m_pos - '0');
+    ++m_pos;
+  }
+  return result;
+}
+
+Real FileScanner::read_real()
+{
+  skip_whitespace();
+
+  // The mapped memory is not null-terminated, so the number is copied before conversion
+  char buffer[64];
+  Uint length = 0;
+  while(m_pos + length != m_end && !is_space(m_pos[length]) && length != sizeof(buffer)-1)
+  {
+    buffer[length] = m_pos[length];
+    ++length;
+  }
+  buffer[length] = '\0';
+
+  char* number_end;
+  const Real result = std::strtod(buffer, &number_end);
+  if(length == 0 || number_end != buffer + length)
+    throw_parse_error("real number");
+
+  m_pos += length;
+  return result;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+bool FileScanner::next_section(std::string& name)
+{
+  while(m_pos != m_end)
+  {
+    const char* marker = static_cast<const char*>(std::memchr(m_pos, '$', m_end - m_pos));
+    if(!marker)
+    {
+      m_pos = m_end;
+      return false;
+    }
+
+    m_pos = marker + 1;
+    if(marker != m_begin && marker[-1] != '\n')
+      continue;
+
+    m_pos = marker;
+    name = read_line();
+    const std::string::size_type name_end = name.find_first_of(" \t");
+    if(name_end != std::string::npos)
+      name.resize(name_end);
+    m_pos = marker;
+    return true;
+  }
+  return false;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void FileScanner::throw_parse_error(const std::string& expected) const
+{
+  throw common::ParsingFailed(FromHere(), "Expected " + expected + " at offset " + common::to_str(position()) + " in file " + m_path);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+} // gmsh
+} // mesh
+} // cf3
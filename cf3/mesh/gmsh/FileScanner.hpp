@@ -0,0 +1,129 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_mesh_gmsh_FileScanner_hpp
+#define cf3_mesh_gmsh_FileScanner_hpp
+
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+#include <boost/noncopyable.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include "common/CF.hpp"
+
+#include "mesh/gmsh/LibGmsh.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace mesh {
+namespace gmsh {
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// @brief Memory-mapped reading of gmsh files
+///
+/// The file is mapped in memory and read through a cursor. Numbers are parsed directly
+/// from the mapped characters, and lines are skipped using memchr, so that parts of the file
+/// can be skipped much faster than they can be parsed.
+/// Binary values are read in the native byte order, and swapped if requested.
+class gmsh_API FileScanner : public boost::noncopyable
+{
+public:
+
+  FileScanner();
+  ~FileScanner();
+
+  /// Map the given file in memory, and put the cursor at the beginning
+  void open(const std::string& path);
+
+  /// Release the mapping
+  void close();
+
+  bool is_open() const { return m_begin != 0; }
+
+  /// Size of the file in bytes. Offsets and byte counts are 64-bit, since mesh files can be larger than 4 GiB.
+  std::size_t size() const { return m_end - m_begin; }
+
+  /// Offset of the cursor from the beginning of the file
+  std::size_t position() const { return m_pos - m_begin; }
+
+  /// Move the cursor to the given offset
+  void seek(const std::size_t offset);
+
+  bool eof() const { return m_pos == m_end; }
+
+  /// Move the cursor to the beginning of the next line
+  void skip_line();
+
+  /// Skip the given number of lines
+  void skip_lines(const Uint nb_lines);
+
+  /// Skip the given number of bytes
+  void skip_bytes(const std::size_t nb_bytes);
+
+  /// Read the remainder of the current line, without the line ending, and move to the next line
+  std::string read_line();
+
+  /// Read the next whitespace-delimited word
+  std::string read_word();
+
+  /// Read an unsigned integer in ASCII
+  Uint read_uint();
+
+  /// Read a real number in ASCII
+  Real read_real();
+
+  /// Read a value stored in binary
+  template<typename T>
+  T read_binary(const bool swap_bytes)
+  {
+    if(m_end - m_pos < static_cast<std::ptrdiff_t>(sizeof(T)))
+      throw_parse_error("binary value");
+    T result;
+    if(swap_bytes)
+    {
+      char* bytes = reinterpret_cast<char*>(&result);
+      for(Uint i = 0; i != sizeof(T); ++i)
+        bytes[i] = m_pos[sizeof(T)-1-i];
+    }
+    else
+    {
+      std::memcpy(&result, m_pos, sizeof(T));
+    }
+    m_pos += sizeof(T);
+    return result;
+  }
+
+  /// Move the cursor to the beginning of the next line starting with '$', and read the section name, including the '$'.
+  /// The cursor is left at the beginning of the line with the section name.
+  /// @return false if no more sections are found
+  bool next_section(std::string& name);
+
+private:
+  void skip_whitespace();
+  void throw_parse_error(const std::string& expected) const;
+
+  boost::iostreams::mapped_file_source m_file;
+  std::string m_path;
+  const char* m_begin;
+  const char* m_end;
+  const char* m_pos;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // gmsh
+} // mesh
+} // cf3
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif // cf3_mesh_gmsh_FileScanner_hpp
@@ -4,6 +4,11 @@
 // GNU Lesser General Public License version 3 (LGPLv3).
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
+#include <algorithm>
+#include <cstdlib>
+#include <iterator>
+
+#include <boost/algorithm/string.hpp>
 #include <boost/foreach.hpp>
 #include <boost/tokenizer.hpp>
 #include <boost/regex.hpp>
@@ -20,6 +25,7 @@
 #include "common/List.hpp"
 #include "common/DynTable.hpp"
 
+#include "common/PE/Comm.hpp"
 #include "common/PE/debug.hpp"
 
 #include "mesh/Region.hpp"
@@ -51,6 +57,43 @@ cf3::common::ComponentBuilder < gmsh::Reader, MeshReader, LibGmsh> aGmshReader_B
 
 //////////////////////////////////////////////////////////////////////////////
 
+namespace
+{
+  /// Size of a node in a binary file: node-number x y z
+  const std::size_t binary_node_size = sizeof(int) + 3*sizeof(double);
+
+  /// Range [begin,end) of the objects owned by this process, which is contiguous because
+  /// the owning process does not decrease with the object index
+  void owned_range(const ParallelDistribution& distribution, const Uint nb_obj, Uint& begin, Uint& end)
+  {
+    const Uint rank = PE::Comm::instance().rank();
+    for (Uint i=0; i<2; ++i)
+    {
+      // first object owned by a process >= rank+i
+      Uint lower = 0;
+      Uint upper = nb_obj;
+      while (lower < upper)
+      {
+        const Uint middle = lower + (upper-lower)/2;
+        if (distribution.proc_of_obj(middle) < rank+i)
+          lower = middle+1;
+        else
+          upper = middle;
+      }
+      (i == 0 ? begin : end) = lower;
+    }
+  }
+
+  /// Clear a vector and free its memory
+  template<typename T>
+  void release(std::vector<T>& v)
+  {
+    std::vector<T>().swap(v);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
 Reader::Reader( const std::string& name )
 : MeshReader(name),
   Shared()
@@ -106,6 +149,7 @@ void Reader::do_read_mesh_into(const URI& file, Mesh& mesh)
   {
     CFinfo <<  "Opening file " <<  fp.string() << CFendl;
     m_file.open(fp,std::ios_base::in); // exists so open it
+    m_scanner.open(fp.string());
   }
   else // doesnt exist so throw exception
   {
@@ -127,6 +171,7 @@ void Reader::do_read_mesh_into(const URI& file, Mesh& mesh)
 
   m_mesh->initialize_nodes(0, m_mesh_dimension);
 
+  read_elements();
   find_used_nodes();
   read_coordinates();
   read_connectivity();
@@ -135,21 +180,27 @@ void Reader::do_read_mesh_into(const URI& file, Mesh& mesh)
 
   if (options().value<bool>("read_fields"))
   {
-    read_element_node_data();
-    read_node_data();
+    if (m_binary && (m_element_node_data_positions.size() || m_node_data_positions.size()))
+    {
+      CFwarn << "Field data in binary file " << fp.string() << " is not read" << CFendl;
+    }
+    else
+    {
+      read_element_node_data();
+      read_node_data();
+    }
   }
 
   m_node_idx_gmsh_to_cf.clear();
   m_elem_idx_gmsh_to_cf.clear();
 
   // clean-up
-  m_ghost_nodes.clear();
-  m_used_nodes.clear();
-  m_node_idx_gmsh_to_cf.clear();
+  release(m_used_nodes);
   if (is_not_null(m_hash))
     remove_component(*m_hash);
 
   // close the file
+  m_scanner.close();
   m_file.close();
 
   mesh.raise_mesh_loaded();
@@ -159,107 +210,154 @@ void Reader::do_read_mesh_into(const URI& file, Mesh& mesh)
 
 void Reader::get_file_positions()
 {
-  std::string region_names("$PhysicalNames");
-  std::string nodes("$Nodes");
-  std::string elements("$Elements");
-  std::string element_data("$ElementData");
-  std::string node_data("$NodeData");
-  std::string element_node_data("$ElementNodeData");
-
   m_element_data_positions.clear();
   m_node_data_positions.clear();
   m_element_node_data_positions.clear();
+  m_coordinates_position=0;
   m_elements_position=0;
-  std::streampos p;
-  std::string line;
-  while (!m_file.eof())
+  m_total_nb_nodes=0;
+  m_total_nb_elements=0;
+  m_nb_regions=0;
+  m_binary=false;
+  m_swap_bytes=false;
+  m_mesh_dimension = options().value<Uint>("dimension");
+
+  // Only the section headers are parsed. The data of the ASCII sections contains no '$', so the scanner
+  // jumps directly to the end of the section. The size of the binary sections is computed from their headers.
+  m_scanner.seek(0);
+  std::string section;
+  while (m_scanner.next_section(section))
   {
-    p = m_file.tellg();
-    getline(m_file,line);
-    if (line.find(region_names)!=std::string::npos) {
-      m_region_names_position=p;
-      m_file >> m_nb_regions;
+    const std::streampos p = m_scanner.position();
+    m_scanner.skip_line();
+
+    if (section == "$MeshFormat")
+    {
+      read_mesh_format();
+    }
+    else if (section == "$PhysicalNames")
+    {
+      m_nb_regions = m_scanner.read_uint();
+      m_scanner.skip_line();
       m_region_list.resize(m_nb_regions);
 
       m_nb_gmsh_elem_in_region.resize(m_nb_regions);
       for(Uint ir = 0; ir < m_nb_regions; ++ir)
-      {
-        m_nb_gmsh_elem_in_region[ir].resize(Shared::nb_gmsh_types);
-        for(Uint type = 0; type < Shared::nb_gmsh_types; ++ type)
-           (m_nb_gmsh_elem_in_region[ir])[type] = 0;
-      }
+        m_nb_gmsh_elem_in_region[ir].assign(Shared::nb_gmsh_types,0);
 
-      m_mesh_dimension = options().value<Uint>("dimension");
       for(Uint ir = 0; ir < m_nb_regions; ++ir)
       {
-        Uint phys_group_dimensionality;
-        Uint phys_group_index;
-        std::string phys_group_name;
-        m_file >> phys_group_dimensionality >> phys_group_index >> phys_group_name;
-        m_region_list[phys_group_index-1].dim=phys_group_dimensionality;
-        m_region_list[phys_group_index-1].index=phys_group_index;
+        const Uint phys_group_dimensionality = m_scanner.read_uint();
+        const Uint phys_group_index = m_scanner.read_uint();
+        if (phys_group_index == 0 || phys_group_index > m_nb_regions)
+          throw ParsingFailed(FromHere(),"Physical group index "+to_str(phys_group_index)+" is not in the range [1,"+to_str(m_nb_regions)+"]");
+
+        std::string phys_group_name = m_scanner.read_line();
         //The original name of the region in the mesh file has quotes, we want to strip them off
-        m_region_list[phys_group_index-1].name=phys_group_name.substr(1,phys_group_name.length()-2);
-        m_region_list[phys_group_index-1].region = create_region(m_region_list[phys_group_index-1].name);
-        m_mesh_dimension = std::max(m_region_list[phys_group_index-1].dim,m_mesh_dimension);
+        boost::algorithm::trim(phys_group_name);
+        boost::algorithm::trim_if(phys_group_name, boost::algorithm::is_any_of("\""));
+
+        RegionData& region_data = m_region_list[phys_group_index-1];
+        region_data.dim=phys_group_dimensionality;
+        region_data.index=phys_group_index;
+        region_data.name=phys_group_name;
+        region_data.region = create_region(region_data.name);
+        m_mesh_dimension = std::max(region_data.dim,m_mesh_dimension);
       }
     }
-    else if (line.find(nodes)!=std::string::npos) {
-      m_coordinates_position=p;
-      m_file >> m_total_nb_nodes;
-//      CFinfo << "The total number of nodes is " << m_total_nb_nodes << CFendl;
+    else if (section == "$Nodes")
+    {
+      m_total_nb_nodes = m_scanner.read_uint();
       if (m_total_nb_nodes == 0) throw ParsingFailed(FromHere(),"File contains no nodes");
+      m_scanner.skip_line();
+      m_coordinates_position = m_scanner.position();
+      if (m_binary)
+        m_scanner.skip_bytes(static_cast<std::size_t>(m_total_nb_nodes)*binary_node_size);
     }
-    else if (line.find(elements)!=std::string::npos)
+    else if (section == "$Elements")
     {
-      m_elements_position = p;
-      m_file >> m_total_nb_elements;
-//      CFinfo << "The total number of elements is " << m_total_nb_elements << CFendl;
+      m_total_nb_elements = m_scanner.read_uint();
       if (m_total_nb_elements == 0) throw ParsingFailed(FromHere(),"File contains no elements");
-      //Create a hash
-      m_hash = create_component<MergedParallelDistribution>("hash");
-      std::vector<Uint> num_obj(2);
-      num_obj[0] = m_total_nb_nodes;
-      num_obj[1] = m_total_nb_elements;
-      m_hash->options().set("nb_parts",options().value<Uint>("nb_parts"));
-      m_hash->options().set("nb_obj",num_obj);
-
-
-      Uint elem_idx, elem_type, nb_tags, phys_tag;
-
-      //Let's count how many elements of each type are present
-      for(Uint ie = 0; ie < m_total_nb_elements; ++ie)
+      m_scanner.skip_line();
+      m_elements_position = m_scanner.position();
+      if (m_binary)
       {
-          m_file >> elem_idx;
-          m_file >> elem_type;
-          m_file >> nb_tags;
-          m_file >> phys_tag;
-          cf3_assert(phys_tag > 0);
-          getline(m_file,line);
-          if (m_hash->subhash(ELEMS).owns(ie))
-            (m_nb_gmsh_elem_in_region[phys_tag-1])[elem_type]++;
-          m_region_list[phys_tag-1].element_types.insert(elem_type);
+        // Binary elements come in blocks of elements of the same type
+        for (Uint nb_elems=0; nb_elems<m_total_nb_elements; )
+        {
+          const Uint elem_type = m_scanner.read_binary<int>(m_swap_bytes);
+          const Uint nb_elems_in_block = m_scanner.read_binary<int>(m_swap_bytes);
+          const Uint nb_tags = m_scanner.read_binary<int>(m_swap_bytes);
+          m_scanner.skip_bytes(static_cast<std::size_t>(nb_elems_in_block)*(1+nb_tags+nb_nodes_in_gmsh_elem(elem_type))*sizeof(int));
+          nb_elems += nb_elems_in_block;
+        }
       }
     }
-    else if (line.find(element_data)!=std::string::npos)
+    else if (section == "$ElementData")
     {
       m_element_data_positions.push_back(p);
     }
-    else if (line.find(node_data)!=std::string::npos)
+    else if (section == "$NodeData")
     {
       m_node_data_positions.push_back(p);
     }
-    else if (line.find(element_node_data)!=std::string::npos)
+    else if (section == "$ElementNodeData")
     {
       m_element_node_data_positions.push_back(p);
     }
-
   }
+
   if (m_elements_position==0)
   {
     throw ParsingFailed(FromHere(),"File does not contain any elements");
   }
-  m_file.clear();
+  if (m_coordinates_position==0)
+  {
+    throw ParsingFailed(FromHere(),"File does not contain any nodes");
+  }
+  if (m_nb_regions==0)
+  {
+    throw ParsingFailed(FromHere(),"File does not contain any physical names");
+  }
+
+  //Create a hash
+  m_hash = create_component<MergedParallelDistribution>("hash");
+  std::vector<Uint> num_obj(2);
+  num_obj[0] = m_total_nb_nodes;
+  num_obj[1] = m_total_nb_elements;
+  m_hash->options().set("nb_parts",options().value<Uint>("nb_parts"));
+  m_hash->options().set("nb_obj",num_obj);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Reader::read_mesh_format()
+{
+  const std::string version = m_scanner.read_word();
+  const Uint file_type = m_scanner.read_uint();
+  const Uint data_size = m_scanner.read_uint();
+  m_scanner.skip_line();
+
+  if (std::atof(version.c_str()) >= 3.)
+    throw FileFormatError(FromHere(),"Gmsh file format version "+version+" is not supported. Save the mesh in version 2.2 (e.g. gmsh -format msh22)");
+
+  m_binary = (file_type == 1);
+  if (m_binary)
+  {
+    if (data_size != sizeof(double))
+      throw FileFormatError(FromHere(),"Binary gmsh files must store the coordinates with "+to_str(sizeof(double))+" bytes, not "+to_str(data_size));
+
+    // The integer 1 is written in the byte order of the machine that wrote the file
+    const std::size_t one_position = m_scanner.position();
+    if (m_scanner.read_binary<int>(false) != 1)
+    {
+      m_scanner.seek(one_position);
+      if (m_scanner.read_binary<int>(true) != 1)
+        throw FileFormatError(FromHere(),"Could not determine the byte order of the binary gmsh file");
+      m_swap_bytes = true;
+    }
+    m_scanner.skip_line();
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -283,217 +381,332 @@ Handle< Region > Reader::create_region(std::string const& relative_path)
 
 //////////////////////////////////////////////////////////////////////////////
 
-void Reader::find_used_nodes()
+Uint Reader::nb_nodes_in_gmsh_elem(const Uint gmsh_type)
 {
-  m_used_nodes.clear();
-  std::string line;
-
-  m_file.seekg(m_elements_position,std::ios::beg);
-  // skip next line
-  getline(m_file,line);
-//  if (PE::Comm::instance().rank()==IO_rank)
-//    std::cout << "header = " << line << std::endl;
-  //Skip the line containing the actual number of elements
-  getline(m_file,line);
-//  if (PE::Comm::instance().rank()==IO_rank)
-//    std::cout << "nb_elems = " << line << std::endl;
-
-  // read every line and store the connectivity in the correct region through the buffer
-  Uint elementNumber, elementType, nbElementNodes;
-  Uint gmsh_node_number, nb_tags, phys_tag, other_tag;
+  if (gmsh_type >= Shared::nb_gmsh_types || Shared::m_nodes_in_gmsh_elem[gmsh_type] == 0)
+    throw ParsingFailed(FromHere(),"Unsupported gmsh element type "+to_str(gmsh_type));
+  return Shared::m_nodes_in_gmsh_elem[gmsh_type];
+}
 
-  std::set<Uint>::iterator it=m_used_nodes.begin();
+//////////////////////////////////////////////////////////////////////////////
 
-//  if (PE::Comm::instance().rank()==IO_rank)
-//  {
-//    std::cout << "nb_obj = "   << m_hash->subhash(ELEMS).options()["nb_obj"].value<Uint>() << std::endl;
-//    std::cout << "nb_parts = " <<m_hash->subhash(ELEMS).options()["nb_parts"].value<Uint>() << std::endl;
-//  }
-  for (Uint i=0; i<m_total_nb_elements; ++i)
+void Reader::read_elements()
+{
+  Uint begin, end;
+  owned_range(m_hash->subhash(ELEMS), m_total_nb_elements, begin, end);
+
+  m_elem_numbers.clear();
+  m_elem_types.clear();
+  m_elem_phys_tags.clear();
+  m_elem_nodes_start.clear();
+  m_elem_nodes.clear();
+  m_elem_numbers.reserve(end-begin);
+  m_elem_types.reserve(end-begin);
+  m_elem_phys_tags.reserve(end-begin);
+  m_elem_nodes_start.reserve(end-begin+1);
+
+  // Only the owned elements are parsed, the elements before them are skipped
+  m_scanner.seek(m_elements_position);
+  if (m_binary)
   {
-//    if (m_total_nb_elements > 100000)
-//    {
-//      if(i%(m_total_nb_elements/20)==0)
-//        CFinfo << 100*i/m_total_nb_elements << "% " << CFflush;
-//    }
-
-    cf3_assert(m_hash);
-    if (m_hash->subhash(ELEMS).owns(i))
+    // blocks of elements: elem-type nb-elems nb-tags, followed by the elements: elem-number tags... nodes...
+    Uint block_begin = 0;
+    while (block_begin < end)
     {
-      // element description
-      m_file >> elementNumber >> elementType;
-      nbElementNodes = Shared::m_nodes_in_gmsh_elem[elementType];
-
-//      if (PE::Comm::instance().rank()==IO_rank)
-//        std::cout << i << ":  elem["<<m_hash->subhash(ELEMS).part_of_obj(i)<<"] " << elementNumber << " :    ";
-      m_file >> nb_tags;
-      m_file >> phys_tag;
-      for(Uint itag = 0; itag < (nb_tags-1); ++itag)
-          m_file >> other_tag;
-
-      for (Uint j=0; j<nbElementNodes; ++j)
+      const Uint elem_type = m_scanner.read_binary<int>(m_swap_bytes);
+      const Uint nb_elems_in_block = m_scanner.read_binary<int>(m_swap_bytes);
+      const Uint nb_tags = m_scanner.read_binary<int>(m_swap_bytes);
+      const Uint nb_elem_nodes = nb_nodes_in_gmsh_elem(elem_type);
+      const std::size_t elem_size = (1+nb_tags+nb_elem_nodes)*sizeof(int);
+      const Uint block_end = block_begin + nb_elems_in_block;
+
+      if (block_end <= begin)
+      {
+        m_scanner.skip_bytes(static_cast<std::size_t>(nb_elems_in_block)*elem_size);
+      }
+      else
       {
-        m_file >> gmsh_node_number;
-        it = m_used_nodes.insert(it,gmsh_node_number);
-//        if (PE::Comm::instance().rank()==IO_rank)
-//          std::cout << "  " << gmsh_node_number;
+        if (nb_tags == 0)
+          throw ParsingFailed(FromHere(),"Elements of type "+to_str(elem_type)+" have no physical tag");
+
+        const Uint first = std::max(begin,block_begin);
+        const Uint last = std::min(end,block_end);
+        m_scanner.skip_bytes(static_cast<std::size_t>(first-block_begin)*elem_size);
+        for (Uint i=first; i<last; ++i)
+        {
+          m_elem_numbers.push_back(m_scanner.read_binary<int>(m_swap_bytes));
+          m_elem_types.push_back(elem_type);
+          m_elem_phys_tags.push_back(m_scanner.read_binary<int>(m_swap_bytes));
+          m_scanner.skip_bytes((nb_tags-1)*sizeof(int));
+          m_elem_nodes_start.push_back(m_elem_nodes.size());
+          for (Uint j=0; j<nb_elem_nodes; ++j)
+            m_elem_nodes.push_back(m_scanner.read_binary<int>(m_swap_bytes));
+        }
+        m_scanner.skip_bytes(static_cast<std::size_t>(block_end-last)*elem_size);
       }
-//      if (PE::Comm::instance().rank()==IO_rank)
-//        std::cout << "\n";
+      block_begin = block_end;
     }
-    getline(m_file,line); // finnish the line
   }
+  else
+  {
+    // one element per line: elem-number elem-type nb-tags tags... nodes...
+    m_scanner.skip_lines(begin);
+    for (Uint i=begin; i<end; ++i)
+    {
+      m_elem_numbers.push_back(m_scanner.read_uint());
+      const Uint elem_type = m_scanner.read_uint();
+      m_elem_types.push_back(elem_type);
+      const Uint nb_tags = m_scanner.read_uint();
+      if (nb_tags == 0)
+        throw ParsingFailed(FromHere(),"Element "+to_str(m_elem_numbers.back())+" has no physical tag");
+      m_elem_phys_tags.push_back(m_scanner.read_uint());
+      // other tags, e.g. partitions, may be negative
+      for (Uint itag=1; itag<nb_tags; ++itag)
+        m_scanner.read_word();
+
+      const Uint nb_elem_nodes = nb_nodes_in_gmsh_elem(elem_type);
+      m_elem_nodes_start.push_back(m_elem_nodes.size());
+      for (Uint j=0; j<nb_elem_nodes; ++j)
+        m_elem_nodes.push_back(m_scanner.read_uint());
+      m_scanner.skip_line();
+    }
+  }
+  m_elem_nodes_start.push_back(m_elem_nodes.size());
 
-  // Now we have all nodes, used by the elements
-
-  // Now add owned nodes
-  m_file.seekg(m_coordinates_position,std::ios::beg);
-  //Skip the line with keyword '$Nodes':
-  getline(m_file,line);
-//  if (PE::Comm::instance().rank()==IO_rank)
-//    std::cout << "header = " << line << std::endl;
-  // skip one line, which says how many (total) nodes are  present in the mesh
-  getline(m_file,line);
-//  if (PE::Comm::instance().rank()==IO_rank)
-//    std::cout << "nb_nodes = " << line << std::endl;
+  // Count the owned elements per region and type, and find which types are present in each region on any process
+  std::vector<Uint> region_has_type(m_nb_regions*Shared::nb_gmsh_types,0);
+  for(Uint ir = 0; ir < m_nb_regions; ++ir)
+    m_nb_gmsh_elem_in_region[ir].assign(Shared::nb_gmsh_types,0);
 
-  for (Uint node_idx=0; node_idx<m_total_nb_nodes; ++node_idx)
+  for (Uint e=0; e<m_elem_numbers.size(); ++e)
   {
-//    if (m_total_nb_nodes > 100000)
-//    {
-//      if(node_idx%(m_total_nb_nodes/20)==0)
-//        CFinfo << 100*node_idx/m_total_nb_nodes << "% " << CFflush;
-//      if (node_idx == m_total_nb_nodes-1)
-//        CFinfo << CFendl;
-//    }
-    getline(m_file,line);
-
-    std::stringstream ss(line);
-    ss >> gmsh_node_number;
-    getline(ss,line);
-    if (m_hash->subhash(NODES).owns(node_idx))
-    {
-//      if (PE::Comm::instance().rank()==IO_rank)
-//        std::cout << "node " << gmsh_node_number << "\n";
+    const Uint phys_tag = m_elem_phys_tags[e];
+    if (phys_tag == 0 || phys_tag > m_nb_regions)
+      throw ParsingFailed(FromHere(),"Element "+to_str(m_elem_numbers[e])+" has physical tag "+to_str(phys_tag)+", which is not listed in $PhysicalNames");
+    (m_nb_gmsh_elem_in_region[phys_tag-1])[m_elem_types[e]]++;
+    region_has_type[(phys_tag-1)*Shared::nb_gmsh_types+m_elem_types[e]] = 1;
+  }
 
-      it = m_used_nodes.insert(it,gmsh_node_number);
-    }
-    else
-    {
-      it = m_used_nodes.find(gmsh_node_number);
-      if (it != m_used_nodes.end())
-      {
-        m_ghost_nodes.insert(node_idx);
-//        if (PE::Comm::instance().rank()==IO_rank)
-//          std::cout << "ghostnode " << gmsh_node_number << "\n";
-      }
-    }
+  if (PE::Comm::instance().is_active() && PE::Comm::instance().size() > 1)
+    PE::Comm::instance().all_reduce(PE::max(), &region_has_type[0], region_has_type.size(), &region_has_type[0]);
+
+  for(Uint ir = 0; ir < m_nb_regions; ++ir)
+  {
+    m_region_list[ir].element_types.clear();
+    for(Uint etype = 0; etype < Shared::nb_gmsh_types; ++etype)
+      if (region_has_type[ir*Shared::nb_gmsh_types+etype])
+        m_region_list[ir].element_types.insert(etype);
   }
-//  if (PE::Comm::instance().rank()==IO_rank)
-//    std::cout << std::flush;
 }
 
 //////////////////////////////////////////////////////////////////////////////
 
-void Reader::read_coordinates()
+void Reader::find_used_nodes()
 {
+  // Nodes used by the owned elements
+  m_used_nodes = m_elem_nodes;
+  std::sort(m_used_nodes.begin(),m_used_nodes.end());
+  m_used_nodes.erase(std::unique(m_used_nodes.begin(),m_used_nodes.end()),m_used_nodes.end());
+
+  // Read the owned nodes only: node-number x y z
+  Uint begin, end;
+  owned_range(m_hash->subhash(NODES), m_total_nb_nodes, begin, end);
+  m_owned_nodes_begin = begin;
+  m_owned_node_ids.resize(end-begin);
+  m_owned_node_coords.resize(3*(end-begin)); //Gmsh always stores 3 coordinates, even for 2D meshes
+
+  m_scanner.seek(m_coordinates_position);
+  if (m_binary)
+  {
+    m_scanner.skip_bytes(static_cast<std::size_t>(begin)*binary_node_size);
+    for (Uint i=0; i<end-begin; ++i)
+    {
+      m_owned_node_ids[i] = m_scanner.read_binary<int>(m_swap_bytes);
+      for (Uint d=0; d<3; ++d)
+        m_owned_node_coords[3*i+d] = m_scanner.read_binary<double>(m_swap_bytes);
+    }
+  }
+  else
+  {
+    m_scanner.skip_lines(begin);
+    for (Uint i=0; i<end-begin; ++i)
+    {
+      m_owned_node_ids[i] = m_scanner.read_uint();
+      for (Uint d=0; d<3; ++d)
+        m_owned_node_coords[3*i+d] = m_scanner.read_real();
+    }
+  }
 
-  m_file.seekg(m_coordinates_position,std::ios::beg);
-
-  Dictionary& nodes = m_mesh->geometry_fields();
-  nodes.resize(m_used_nodes.size());
-  m_used_nodes.clear();
-
-  Uint part = options().value<Uint>("part");
+  // Used nodes that are not owned are ghosts
+  std::vector<Uint> owned_ids(m_owned_node_ids);
+  std::sort(owned_ids.begin(),owned_ids.end());
+  std::vector<Uint> ghost_ids;
+  std::set_difference(m_used_nodes.begin(),m_used_nodes.end(),owned_ids.begin(),owned_ids.end(),std::back_inserter(ghost_ids));
 
-  std::string line;
-  //Skip the line with keyword '$Nodes':
-  getline(m_file,line);
-//  CFinfo << line << CFendl;
-  // skip one line, which says how many (total) nodes are  present in the mesh
-  getline(m_file,line);
-//  CFinfo << line << CFendl;
+  fetch_ghost_nodes(ghost_ids);
+}
 
+//////////////////////////////////////////////////////////////////////////////
 
-  // declare and allocate one coordinate row
-//  std::vector<Real> rowVector(m_mesh_dimension);
+void Reader::fetch_ghost_nodes(const std::vector<Uint>& ghost_ids)
+{
+  const Uint nb_ghosts = ghost_ids.size();
+  m_ghost_node_ids = ghost_ids;
+  m_ghost_node_coords.resize(3*nb_ghosts);
+  m_ghost_node_parts.resize(nb_ghosts);
 
-  std::set<Uint>::const_iterator it;
+  PE::Comm& comm = PE::Comm::instance();
+  if (!comm.is_active() || comm.size() == 1)
+  {
+    // All nodes are owned
+    if (nb_ghosts)
+      throw ParsingFailed(FromHere(),"Node "+to_str(ghost_ids.front())+" is used by an element, but is not in $Nodes");
+    return;
+  }
 
-  Uint coord_idx=0;
-  Uint gmsh_node_number;
+  const Uint nb_procs = comm.size();
+  const ParallelDistribution& node_distribution = m_hash->subhash(NODES);
+  const Uint nb_owned = m_owned_node_ids.size();
 
-  for (Uint node_idx=0; node_idx<m_total_nb_nodes; ++node_idx)
+  // 1) Find the process that owns each ghost node.
+  // Usually the nodes are numbered 1..N in file order, so the owner follows from the distribution.
+  // Otherwise the owners are looked up in a directory, where the owner of node n is stored on process n % nb_procs.
+  int numbered_in_order = 1;
+  for (Uint i=0; i<nb_owned; ++i)
   {
-//    if (m_total_nb_nodes > 100000)
-//    {
-//      if(node_idx%(m_total_nb_nodes/20)==0)
-//        CFinfo << 100*node_idx/m_total_nb_nodes << "% " << CFflush;
-//      if(node_idx==m_total_nb_nodes-1)
-//        CFinfo << CFendl;
-//    }
-    getline(m_file,line);
-//    CFinfo << line << CFendl;
-    if (m_hash->subhash(NODES).owns(node_idx))
+    if (m_owned_node_ids[i] != m_owned_nodes_begin+i+1)
     {
-      std::stringstream ss(line);
-      ss >> gmsh_node_number;
-      m_node_idx_gmsh_to_cf[gmsh_node_number]=coord_idx;
-
-//      if (PE::Comm::instance().rank()==IO_rank)
-//        std::cout << gmsh_node_number << " --> " << coord_idx << std::endl;
-
-      for (Uint dim=0; dim<m_mesh_dimension; ++dim)
-        ss >> nodes.coordinates()[coord_idx][dim];
-      if(m_mesh_dimension < DIM_3D) getline(ss,line); //Gmsh always stores 3 coordinates, even for 2D meshes
-
-      nodes.rank()[coord_idx] = part;
-      nodes.glb_idx()[coord_idx] = gmsh_node_number-1;
+      numbered_in_order = 0;
+      break;
+    }
+  }
+  comm.all_reduce(PE::min(), &numbered_in_order, 1, &numbered_in_order);
 
-      coord_idx++;
+  std::vector<Uint> ghost_owners(nb_ghosts);
+  if (numbered_in_order)
+  {
+    for (Uint g=0; g<nb_ghosts; ++g)
+    {
+      if (ghost_ids[g] == 0 || ghost_ids[g] > m_total_nb_nodes)
+        throw ParsingFailed(FromHere(),"Node "+to_str(ghost_ids[g])+" is used by an element, but is not in $Nodes");
+      ghost_owners[g] = node_distribution.proc_of_obj(ghost_ids[g]-1);
     }
-    else
+  }
+  else
+  {
+    std::vector< std::vector<Uint> > send_owned(nb_procs), recv_owned(nb_procs);
+    for (Uint i=0; i<nb_owned; ++i)
+      send_owned[m_owned_node_ids[i] % nb_procs].push_back(m_owned_node_ids[i]);
+    comm.all_to_all(send_owned,recv_owned);
+
+    std::map<Uint,Uint> directory;
+    for (Uint p=0; p<nb_procs; ++p)
+      boost_foreach(const Uint node, recv_owned[p])
+        directory[node] = p;
+
+    std::vector< std::vector<Uint> > send_lookup(nb_procs), recv_lookup(nb_procs);
+    for (Uint g=0; g<nb_ghosts; ++g)
+      send_lookup[ghost_ids[g] % nb_procs].push_back(ghost_ids[g]);
+    comm.all_to_all(send_lookup,recv_lookup);
+
+    std::vector< std::vector<Uint> > send_found(nb_procs), recv_found(nb_procs);
+    for (Uint p=0; p<nb_procs; ++p)
     {
-      it = m_ghost_nodes.find(node_idx);
-      if (it != m_ghost_nodes.end())
+      boost_foreach(const Uint node, recv_lookup[p])
       {
-        std::stringstream ss(line);
-        ss >> gmsh_node_number;
-        m_node_idx_gmsh_to_cf[gmsh_node_number]=coord_idx;
+        std::map<Uint,Uint>::const_iterator it = directory.find(node);
+        send_found[p].push_back(it == directory.end() ? nb_procs : it->second);
+      }
+    }
+    comm.all_to_all(send_found,recv_found);
 
-//        if (PE::Comm::instance().rank()==IO_rank)
-//          std::cout << gmsh_node_number << " --> " << coord_idx << std::endl;
+    std::vector<Uint> nb_unpacked(nb_procs,0);
+    for (Uint g=0; g<nb_ghosts; ++g)
+    {
+      const Uint p = ghost_ids[g] % nb_procs;
+      ghost_owners[g] = recv_found[p][nb_unpacked[p]++];
+      if (ghost_owners[g] == nb_procs)
+        throw ParsingFailed(FromHere(),"Node "+to_str(ghost_ids[g])+" is used by an element, but is not in $Nodes");
+    }
+  }
 
-        for (Uint dim=0; dim<m_mesh_dimension; ++dim)
-        ss >> nodes.coordinates()[coord_idx][dim];
-        if(m_mesh_dimension < DIM_3D) getline(ss, line);
+  // 2) Request the coordinates and parts of the ghost nodes from their owners
+  std::vector< std::vector<Uint> > send_requests(nb_procs), recv_requests(nb_procs);
+  for (Uint g=0; g<nb_ghosts; ++g)
+    send_requests[ghost_owners[g]].push_back(ghost_ids[g]);
+  comm.all_to_all(send_requests,recv_requests);
 
-        nodes.rank()[coord_idx] = m_hash->subhash(NODES).part_of_obj(node_idx);
-        nodes.glb_idx()[coord_idx] = gmsh_node_number-1;
+  std::vector< std::pair<Uint,Uint> > owned_lookup(nb_owned);
+  for (Uint i=0; i<nb_owned; ++i)
+    owned_lookup[i] = std::make_pair(m_owned_node_ids[i],i);
+  std::sort(owned_lookup.begin(),owned_lookup.end());
 
-        coord_idx++;
-      }
+  std::vector< std::vector<Real> > send_coords(nb_procs), recv_coords(nb_procs);
+  std::vector< std::vector<Uint> > send_parts(nb_procs), recv_parts(nb_procs);
+  for (Uint p=0; p<nb_procs; ++p)
+  {
+    boost_foreach(const Uint node, recv_requests[p])
+    {
+      std::vector< std::pair<Uint,Uint> >::const_iterator it =
+          std::lower_bound(owned_lookup.begin(),owned_lookup.end(),std::make_pair(node,Uint(0)));
+      cf3_always_assert(it != owned_lookup.end() && it->first == node);
+      const Uint i = it->second;
+      for (Uint d=0; d<3; ++d)
+        send_coords[p].push_back(m_owned_node_coords[3*i+d]);
+      send_parts[p].push_back(node_distribution.part_of_obj(m_owned_nodes_begin+i));
     }
+  }
+  comm.all_to_all(send_coords,recv_coords);
+  comm.all_to_all(send_parts,recv_parts);
 
+  std::vector<Uint> nb_unpacked(nb_procs,0);
+  for (Uint g=0; g<nb_ghosts; ++g)
+  {
+    const Uint p = ghost_owners[g];
+    const Uint k = nb_unpacked[p]++;
+    for (Uint d=0; d<3; ++d)
+      m_ghost_node_coords[3*g+d] = recv_coords[p][3*k+d];
+    m_ghost_node_parts[g] = recv_parts[p][k];
+  }
+}
 
-  } //loop over nodes
+//////////////////////////////////////////////////////////////////////////////
 
+void Reader::read_coordinates()
+{
+  Dictionary& nodes = m_mesh->geometry_fields();
+  const Uint nb_owned = m_owned_node_ids.size();
+  const Uint nb_ghosts = m_ghost_node_ids.size();
+  nodes.resize(nb_owned+nb_ghosts);
 
+  Uint part = options().value<Uint>("part");
 
-  /*
-  CFinfo << "Printing all nodal coordinates:" << CFendl;
-  for(Uint i = 0; i < m_total_nb_nodes; ++i)
+  Uint coord_idx=0;
+  for (Uint i=0; i<nb_owned; ++i, ++coord_idx)
   {
-      CFinfo << "\t";
-      for(Uint dim = 0; dim < m_mesh_dimension; ++dim)
-        {
-            CFinfo << nodes.coordinates()[i][dim] << " ";
-        }
-      CFinfo << CFendl;
+    const Uint gmsh_node_number = m_owned_node_ids[i];
+    m_node_idx_gmsh_to_cf.insert(m_node_idx_gmsh_to_cf.end(),std::make_pair(gmsh_node_number,coord_idx));
+    for (Uint dim=0; dim<m_mesh_dimension; ++dim)
+      nodes.coordinates()[coord_idx][dim] = m_owned_node_coords[3*i+dim];
+    nodes.rank()[coord_idx] = part;
+    nodes.glb_idx()[coord_idx] = gmsh_node_number-1;
   }
-  */
 
-  getline(m_file,line);
+  for (Uint g=0; g<nb_ghosts; ++g, ++coord_idx)
+  {
+    const Uint gmsh_node_number = m_ghost_node_ids[g];
+    m_node_idx_gmsh_to_cf[gmsh_node_number]=coord_idx;
+    for (Uint dim=0; dim<m_mesh_dimension; ++dim)
+      nodes.coordinates()[coord_idx][dim] = m_ghost_node_coords[3*g+dim];
+    nodes.rank()[coord_idx] = m_ghost_node_parts[g];
+    nodes.glb_idx()[coord_idx] = gmsh_node_number-1;
+  }
+
+  release(m_owned_node_ids);
+  release(m_owned_node_coords);
+  release(m_ghost_node_ids);
+  release(m_ghost_node_coords);
+  release(m_ghost_node_parts);
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -523,8 +736,8 @@ void Reader::read_connectivity()
 
  m_elem_idx_gmsh_to_cf.clear();
  //Loop over all regions and allocate a connectivity table of proper size for each element type that
- //is present in each region. Counting of elements was done during the first pass in the function
- //get_file_positions
+ //is present in each region. Counting of elements was done when reading them in the function
+ //read_elements
  for(Uint ir = 0; ir < m_nb_regions; ++ir)
  {
    // create new region
@@ -563,92 +776,52 @@ void Reader::read_connectivity()
    }
  }
 
-   std::string etype_CF;
-   std::set<Uint>::const_iterator it;
    std::vector<Uint> cf_element;
-   Uint element_number, gmsh_element_type, nb_element_nodes;
-   Uint gmsh_node_number, nb_tags, phys_tag, other_tag;
-   Uint cf_node_number;
-   Uint cf_idx;
-
-   m_file.seekg(m_elements_position,std::ios::beg);
-   // skip next line
-   std::string line;
-   //Re-read the line that contains the keyword '$Elements':
-   getline(m_file,line);
-   //Parse the following line (containing the actual number of elements)
-   getline(m_file,line);
 
    for(Uint ir = 0; ir < m_nb_regions; ++ir)
      for(Uint etype = 0; etype < Shared::nb_gmsh_types; ++etype)
       (m_nb_gmsh_elem_in_region[ir])[etype] = 0;
 
-  for (Uint i=0; i<m_total_nb_elements; ++i)
+  // The owned elements were already read by read_elements()
+  for (Uint e=0; e<m_elem_numbers.size(); ++e)
   {
-//    if (m_total_nb_elements > 100000)
-//    {
-//      if(i%(m_total_nb_elements/20)==0)
-//        CFinfo << 100*i/m_total_nb_elements << "% " << CFflush;
-//      if(i==m_total_nb_elements-1)
-//        CFinfo << CFendl;
-//    }
-
-    // element description
-    m_file >> element_number >> gmsh_element_type;
-
-    nb_element_nodes = Shared::m_nodes_in_gmsh_elem[gmsh_element_type];
-
-    // get element nodes
-    if (m_hash->subhash(ELEMS).owns(i))
+    const Uint element_number = m_elem_numbers[e];
+    const Uint gmsh_element_type = m_elem_types[e];
+    const Uint phys_tag = m_elem_phys_tags[e];
+    const Uint nb_element_nodes = Shared::m_nodes_in_gmsh_elem[gmsh_element_type];
+    const Uint* gmsh_nodes = &m_elem_nodes[m_elem_nodes_start[e]];
+
+    cf_element.resize(nb_element_nodes);
+    for (Uint j=0; j<nb_element_nodes; ++j)
     {
-      m_file >> nb_tags;
-      m_file >> phys_tag;
-      for(Uint itag = 0; itag < (nb_tags-1); ++itag)
-          m_file >> other_tag;
-
-//      CFinfo << "Reading element " << element_number << " of type " << gmsh_element_type;
-//      CFinfo << " in region " << phys_tag << " with " << nb_element_nodes << " nodes " << CFendl;
-
-//      if (PE::Comm::instance().rank()==IO_rank)
-//        std::cout << element_number << "   -->   ";
-
-      cf_element.resize(nb_element_nodes);
-      for (Uint j=0; j<nb_element_nodes; ++j)
-      {
-        cf_idx = Shared::m_nodes_gmsh_to_cf[gmsh_element_type][j];
-        m_file >> gmsh_node_number;
-        cf_node_number = m_node_idx_gmsh_to_cf[gmsh_node_number];
-        cf_element[cf_idx] = cf_node_number;
-//        if (PE::Comm::instance().rank()==IO_rank)
-//          std::cout << "  " << gmsh_node_number << "("<<m_node_idx_gmsh_to_cf[gmsh_node_number]<<")";
-      }
-//      if (PE::Comm::instance().rank()==IO_rank)
-//        std::cout << std::endl;
-
-      elem_table_iter = conn_table_idx[phys_tag-1].find(gmsh_element_type);
-      const Uint row_idx = (m_nb_gmsh_elem_in_region[phys_tag-1])[gmsh_element_type];
-
-      Handle< Elements > elements_region = Handle<Elements>(elem_table_iter->second->handle<Component>());
-      Connectivity::Row element_nodes = elements_region->geometry_space().connectivity()[row_idx];
-
-      m_elem_idx_gmsh_to_cf[element_number] = std::make_pair( elements_region , row_idx);
+      const Uint cf_idx = Shared::m_nodes_gmsh_to_cf[gmsh_element_type][j];
+      cf_element[cf_idx] = m_node_idx_gmsh_to_cf[gmsh_nodes[j]];
+    }
 
-      for(Uint node = 0; node < nb_element_nodes; ++node)
-      {
-         element_nodes[node] = cf_element[node];
-      }
+    elem_table_iter = conn_table_idx[phys_tag-1].find(gmsh_element_type);
+    const Uint row_idx = (m_nb_gmsh_elem_in_region[phys_tag-1])[gmsh_element_type];
 
-      elements_region->rank()[row_idx] = part;
-      elements_region->glb_idx()[row_idx] = element_number-1;
+    Handle< Elements > elements_region = Handle<Elements>(elem_table_iter->second->handle<Component>());
+    Connectivity::Row element_nodes = elements_region->geometry_space().connectivity()[row_idx];
 
-      (m_nb_gmsh_elem_in_region[phys_tag-1])[gmsh_element_type]++;
+    m_elem_idx_gmsh_to_cf[element_number] = std::make_pair( elements_region , row_idx);
 
+    for(Uint node = 0; node < nb_element_nodes; ++node)
+    {
+       element_nodes[node] = cf_element[node];
     }
 
-    // finish the line
-    getline(m_file,line);
+    elements_region->rank()[row_idx] = part;
+    elements_region->glb_idx()[row_idx] = element_number-1;
+
+    (m_nb_gmsh_elem_in_region[phys_tag-1])[gmsh_element_type]++;
   }
-  getline(m_file,line);  // ENDOFSECTION
+
+  release(m_elem_numbers);
+  release(m_elem_types);
+  release(m_elem_phys_tags);
+  release(m_elem_nodes_start);
+  release(m_elem_nodes);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
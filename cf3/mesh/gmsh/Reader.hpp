@@ -16,6 +16,7 @@
 
 #include "mesh/gmsh/LibGmsh.hpp"
 #include "mesh/gmsh/Shared.hpp"
+#include "mesh/gmsh/FileScanner.hpp"
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -25,6 +26,7 @@ namespace mesh {
 class Elements;
 class Region;
 class MergedParallelDistribution;
+class ParallelDistribution;
 class Dictionary;
 
 class Mesh;
@@ -34,6 +36,10 @@ namespace gmsh {
 //////////////////////////////////////////////////////////////////////////////
 
 /// This class defines gmsh mesh format reader
+///
+/// ASCII and binary files in the MSH 2.2 format are supported. The file is memory-mapped,
+/// and each process only parses the contiguous range of nodes and elements it owns.
+/// The coordinates of the ghost nodes are then requested from the processes that own them.
 /// @author Willem Deconinck
 /// @author Martin Vymazal
 class gmsh_API Reader : public MeshReader, public Shared
@@ -53,6 +59,16 @@ private: // functions
 
   void get_file_positions();
 
+  void read_mesh_format();
+
+  void read_elements();
+
+  /// Number of nodes of a gmsh element type
+  /// @throws common::ParsingFailed if the type is not supported
+  static Uint nb_nodes_in_gmsh_elem(const Uint gmsh_type);
+
+  void fetch_ghost_nodes(const std::vector<Uint>& ghost_ids);
+
   Handle<Region> create_region(std::string const& relative_path);
 
   void find_used_nodes();
@@ -79,6 +95,9 @@ private: // data
   std::map<Uint, Uint> m_node_idx_gmsh_to_cf;
 
   boost::filesystem::fstream m_file;
+  FileScanner m_scanner;
+  bool m_binary;
+  bool m_swap_bytes;
   Handle<Mesh> m_mesh;
   Handle<Region> m_region;
 
@@ -100,16 +119,32 @@ private: // data
 
   std::vector<RegionData> m_region_list;
 
-  std::set<Uint> m_ghost_nodes;
-  //std::set<Uint> m_ghost_elems;
-  std::set<Uint> m_used_nodes;
-  
+  /// Sorted gmsh numbers of the nodes used by the owned elements
+  std::vector<Uint> m_used_nodes;
+
+  /// gmsh numbers and coordinates of the owned nodes, in file order, starting at m_owned_nodes_begin
+  Uint m_owned_nodes_begin;
+  std::vector<Uint> m_owned_node_ids;
+  std::vector<Real> m_owned_node_coords;
+
+  /// gmsh numbers, coordinates and parts of the ghost nodes
+  std::vector<Uint> m_ghost_node_ids;
+  std::vector<Real> m_ghost_node_coords;
+  std::vector<Uint> m_ghost_node_parts;
+
+  /// Owned elements, as read from the file. The nodes of element i are in m_elem_nodes,
+  /// starting at m_elem_nodes_start[i]
+  std::vector<Uint> m_elem_numbers;
+  std::vector<Uint> m_elem_types;
+  std::vector<Uint> m_elem_phys_tags;
+  std::vector<Uint> m_elem_nodes_start;
+  std::vector<Uint> m_elem_nodes;
+
   std::vector<std::set<Uint> > m_node_to_glb_elements;
 
-  //Markers for important places in the file to be read
-  std::streampos m_region_names_position;
-  std::streampos m_coordinates_position;
-  std::streampos m_elements_position;
+  //Markers for important places in the file to be read. The nodes and elements positions point to the first record
+  std::size_t m_coordinates_position;
+  std::size_t m_elements_position;
   std::vector<std::streampos> m_element_data_positions;
   std::vector<std::streampos> m_node_data_positions;
   std::vector<std::streampos> m_element_node_data_positions;
@@ -0,0 +1,138 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include "python/BoostPython.hpp"
+
+#include <algorithm>
+
+#include <boost/lexical_cast.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "common/Component.hpp"
+
+#include "python/ArrayView.hpp"
+
+namespace cf3 {
+namespace python {
+
+using namespace boost::python;
+
+namespace
+{
+
+/// Python object holding the description of the memory, and a reference to its owner
+struct ArrayViewObject
+{
+  PyObject_HEAD
+  boost::shared_ptr<common::Component const>* owner;
+  void* data;
+  const char* format;
+  Py_ssize_t item_size;
+  int ndim;
+  Py_ssize_t shape[2];
+  Py_ssize_t strides[2];
+  bool readonly;
+};
+
+PyTypeObject array_view_type = { PyVarObject_HEAD_INIT(NULL, 0) };
+PyBufferProcs array_view_buffer_procs;
+
+/// Points to something valid for empty arrays
+char empty_data = 0;
+
+void array_view_dealloc(PyObject* obj)
+{
+  ArrayViewObject* self = reinterpret_cast<ArrayViewObject*>(obj);
+  delete self->owner;
+  PyObject_Del(obj);
+}
+
+int array_view_getbuffer(PyObject* obj, Py_buffer* view, int flags)
+{
+  ArrayViewObject* self = reinterpret_cast<ArrayViewObject*>(obj);
+  if((flags & PyBUF_WRITABLE) == PyBUF_WRITABLE && self->readonly)
+  {
+    PyErr_SetString(PyExc_BufferError, "Array view of a const component is read-only");
+    view->obj = NULL;
+    return -1;
+  }
+
+  Py_ssize_t nb_items = 1;
+  for(int i = 0; i != self->ndim; ++i)
+    nb_items *= self->shape[i];
+
+  view->buf = self->data;
+  view->obj = obj;
+  Py_INCREF(obj);
+  view->len = nb_items * self->item_size;
+  view->readonly = self->readonly;
+  view->itemsize = self->item_size;
+  view->format = (flags & PyBUF_FORMAT) == PyBUF_FORMAT ? const_cast<char*>(self->format) : NULL;
+  view->ndim = self->ndim;
+  view->shape = (flags & PyBUF_ND) == PyBUF_ND ? self->shape : NULL;
+  view->strides = (flags & PyBUF_STRIDES) == PyBUF_STRIDES ? self->strides : NULL;
+  view->suboffsets = NULL;
+  view->internal = NULL;
+  return 0;
+}
+
+PyObject* array_view_repr(PyObject* obj)
+{
+  ArrayViewObject* self = reinterpret_cast<ArrayViewObject*>(obj);
+  std::string shape = boost::lexical_cast<std::string>(self->shape[0]);
+  if(self->ndim == 2)
+    shape += ", " + boost::lexical_cast<std::string>(self->shape[1]);
+  const std::string result = "ArrayView of " + (*self->owner)->uri().path() + " with shape (" + shape + ") and format " + self->format;
+  return incref(str(result).ptr());
+}
+
+} // namespace
+
+object make_array_view(const common::Component& owner, const void* data, const char* format, const Uint item_size,
+                       const Uint nb_rows, const Uint nb_cols, const bool readonly)
+{
+  ArrayViewObject* self = PyObject_New(ArrayViewObject, &array_view_type);
+  if(self == NULL)
+    throw_error_already_set();
+
+  self->owner = new boost::shared_ptr<common::Component const>(owner.shared_from_this());
+  self->data = nb_rows*std::max(nb_cols, 1u) == 0 ? &empty_data : const_cast<void*>(data);
+  self->format = format;
+  self->item_size = item_size;
+  self->ndim = nb_cols == 0 ? 1 : 2;
+  self->shape[0] = nb_rows;
+  self->shape[1] = nb_cols;
+  self->strides[0] = item_size * std::max(nb_cols, 1u);
+  self->strides[1] = item_size;
+  self->readonly = readonly;
+
+  return object(handle<>(reinterpret_cast<PyObject*>(self)));
+}
+
+void def_array_view()
+{
+  array_view_buffer_procs.bf_getbuffer = array_view_getbuffer;
+
+  array_view_type.tp_name = "libcoolfluid_python.ArrayView";
+  array_view_type.tp_basicsize = sizeof(ArrayViewObject);
+  array_view_type.tp_dealloc = array_view_dealloc;
+  array_view_type.tp_repr = array_view_repr;
+  array_view_type.tp_as_buffer = &array_view_buffer_procs;
+#ifdef Py_TPFLAGS_HAVE_NEWBUFFER
+  array_view_type.tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_NEWBUFFER;
+#else
+  array_view_type.tp_flags = Py_TPFLAGS_DEFAULT;
+#endif
+  array_view_type.tp_doc = "Direct access to the values of a Table, List or Field through the buffer protocol, e.g. using numpy.asarray";
+
+  if(PyType_Ready(&array_view_type) < 0)
+    throw_error_already_set();
+
+  scope().attr("ArrayView") = object(handle<>(borrowed(reinterpret_cast<PyObject*>(&array_view_type))));
+}
+
+} // python
+} // cf3
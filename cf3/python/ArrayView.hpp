@@ -0,0 +1,47 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef CF3_Python_ArrayView_hpp
+#define CF3_Python_ArrayView_hpp
+
+#include <boost/python/object_fwd.hpp>
+
+#include "common/CF.hpp"
+
+namespace cf3 {
+namespace common { class Component; }
+namespace python {
+
+/// Format character of the Python buffer protocol (as in the struct module) for each value type
+template<typename ValueT> struct BufferFormat;
+template<> struct BufferFormat<float> { static const char* value() { return "f"; } };
+template<> struct BufferFormat<double> { static const char* value() { return "d"; } };
+template<> struct BufferFormat<long double> { static const char* value() { return "g"; } };
+template<> struct BufferFormat<int> { static const char* value() { return "i"; } };
+template<> struct BufferFormat<unsigned int> { static const char* value() { return "I"; } };
+template<> struct BufferFormat<bool> { static const char* value() { return "?"; } };
+
+/// Expose contiguous memory owned by a component through the Python buffer protocol, so numpy.asarray
+/// and memoryview access it without copying. The view keeps the component alive, but becomes invalid
+/// when the storage of the component is resized.
+/// @param nb_cols Number of columns of a 2D array, or 0 for a 1D array
+boost::python::object make_array_view(const common::Component& owner, const void* data, const char* format, const Uint item_size,
+                                      const Uint nb_rows, const Uint nb_cols, const bool readonly);
+
+/// Typed version of make_array_view
+template<typename ValueT>
+boost::python::object make_array_view(const common::Component& owner, const ValueT* data, const Uint nb_rows, const Uint nb_cols, const bool readonly)
+{
+  return make_array_view(owner, data, BufferFormat<ValueT>::value(), sizeof(ValueT), nb_rows, nb_cols, readonly);
+}
+
+void def_array_view();
+
+} // python
+} // cf3
+
+
+#endif // CF3_Python_ArrayView_hpp
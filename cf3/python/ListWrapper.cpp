@@ -15,6 +15,7 @@
 
 #include "common/List.hpp"
 
+#include "python/ArrayView.hpp"
 #include "python/ComponentWrapper.hpp"
 #include "python/ListWrapper.hpp"
 #include "python/Utility.hpp"
@@ -57,6 +58,18 @@ struct ListMethods
     list.array()[i] = extract<ValueT>(value);
   }
 
+  static object array_view(ComponentWrapper& wrapped)
+  {
+    ListT& list = wrapped.component<ListT>();
+    return make_array_view(list, list.array().data(), list.size(), 0u, false);
+  }
+
+  static object array_view_const(ComponentWrapperConst& wrapped)
+  {
+    const ListT& list = wrapped.component<ListT const>();
+    return make_array_view(list, list.array().data(), list.size(), 0u, true);
+  }
+
   static std::string to_str(const ComponentWrapperBase& wrapped)
   {
     std::stringstream out_stream;
@@ -74,12 +87,14 @@ void def_clist_types()
 
   boost::python::class_<ListWrapper, boost::python::bases<ComponentWrapper> >(("List_"+common::class_name<ValueT>()).c_str(), boost::python::no_init)
     .def("resize", ListMethods<ValueT>::resize, "Set the size of the List, i.e. the number of rows")
+    .def("array_view", ListMethods<ValueT>::array_view, "Writable view on the list values without copying, for use with numpy.asarray or memoryview. Invalid after resizing the list.")
     .def("__setitem__", ListMethods<ValueT>::set_item)
     .def("__getitem__", ListMethods<ValueT>::get_item)
     .def("__len__", ListMethods<ValueT>::len)
     .def("__str__", ListMethods<ValueT>::to_str);
 
   boost::python::class_<ListWrapperConst, boost::python::bases<ComponentWrapperConst> >(("ListConst_"+common::class_name<ValueT>()).c_str(), boost::python::no_init)
+    .def("array_view", ListMethods<ValueT>::array_view_const, "Read-only view on the list values without copying, for use with numpy.asarray or memoryview")
     .def("__getitem__", ListMethods<ValueT>::get_item)
     .def("__len__", ListMethods<ValueT>::len)
     .def("__str__", ListMethods<ValueT>::to_str);
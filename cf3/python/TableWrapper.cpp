@@ -15,6 +15,7 @@
 
 #include "common/Table.hpp"
 
+#include "python/ArrayView.hpp"
 #include "python/ComponentWrapper.hpp"
 #include "python/TableWrapper.hpp"
 #include "python/Utility.hpp"
@@ -132,6 +133,18 @@ struct TableMethods
       row[j] = extract<ValueT>(values[j]);
   }
 
+  static object array_view(ComponentWrapper& wrapped)
+  {
+    TableT& table = wrapped.component<TableT>();
+    return make_array_view(table, table.array().data(), table.size(), table.row_size(), false);
+  }
+
+  static object array_view_const(ComponentWrapperConst& wrapped)
+  {
+    const TableT& table = wrapped.component<TableT const>();
+    return make_array_view(table, table.array().data(), table.size(), table.row_size(), true);
+  }
+
   static std::string to_str(const ComponentWrapperBase& wrapped)
   {
     std::stringstream out_stream;
@@ -169,6 +182,7 @@ void def_ctable_types()
     .def("row_size", TableMethods<ValueT>::row_size, "Return the number of columns the table can hold")
     .def("resize", TableMethods<ValueT>::resize, "Set the size of the table, i.e. the number of rows")
     .def("set_row_size", TableMethods<ValueT>::set_row_size, "Set the size of a row, i.e. the number of columns in the table")
+    .def("array_view", TableMethods<ValueT>::array_view, "Writable view on the table values without copying, for use with numpy.asarray or memoryview. Invalid after resizing the table.")
     .def("__setitem__", TableMethods<ValueT>::set_item)
     .def("__getitem__", TableMethods<ValueT>::get_item)
     .def("__len__", TableMethods<ValueT>::len)
@@ -176,6 +190,7 @@ void def_ctable_types()
 
   boost::python::class_<TableWrapperConst, boost::python::bases<ComponentWrapperConst> >(("TableConst_"+common::class_name<ValueT>()).c_str(), boost::python::no_init)
     .def("row_size", TableMethods<ValueT>::row_size, "Return the number of columns the table can hold")
+    .def("array_view", TableMethods<ValueT>::array_view_const, "Read-only view on the table values without copying, for use with numpy.asarray or memoryview")
     .def("__getitem__", TableMethods<ValueT>::get_item_const)
     .def("__len__", TableMethods<ValueT>::len)
     .def("__str__", TableMethods<ValueT>::to_str);
@@ -79,6 +79,26 @@ void ComputeArea::execute()
   area[space.connectivity()[idx()][0]][0] = elements().element_type().area( m_coordinates );
 }
 
+/////////////////////////////////////////////////////////////////////////////////////
+
+void ComputeArea::execute_range(const Uint begin, const Uint end)
+{
+  const Space& space = *m_area_field_space;
+  const Space& geometry_space = elements().geometry_space();
+  const ElementType& element_type = elements().element_type();
+  const Connectivity& connectivity = space.connectivity();
+  Field& area = *m_area;
+
+  // Local coordinates, so different ranges may be computed concurrently
+  RealMatrix coordinates;
+  geometry_space.allocate_coordinates(coordinates);
+  for(Uint elem = begin; elem != end; ++elem)
+  {
+    geometry_space.put_coordinates(coordinates, elem);
+    area[connectivity[elem][0]][0] = element_type.area( coordinates );
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 } // actions
@@ -40,6 +40,12 @@ public: // functions
   /// execute the action
   virtual void execute ();
 
+  /// Compute the area of all elements in the range
+  virtual void execute_range ( const Uint begin, const Uint end );
+
+  /// Each element writes its own entry, so ranges can be computed concurrently
+  virtual bool is_thread_safe () const { return true; }
+
 private: // helper functions
 
   void config_field();
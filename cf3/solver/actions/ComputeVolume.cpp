@@ -80,6 +80,26 @@ void ComputeVolume::execute()
   volume[space.connectivity()[idx()][0]][0] = elements().element_type().volume( m_coordinates );
 }
 
+/////////////////////////////////////////////////////////////////////////////////////
+
+void ComputeVolume::execute_range(const Uint begin, const Uint end)
+{
+  const Space& space = *m_volume_field_space;
+  const Space& geometry_space = elements().geometry_space();
+  const ElementType& element_type = elements().element_type();
+  const Connectivity& connectivity = space.connectivity();
+  Field& volume = *m_volume;
+
+  // Local coordinates, so different ranges may be computed concurrently
+  RealMatrix coordinates;
+  geometry_space.allocate_coordinates(coordinates);
+  for(Uint elem = begin; elem != end; ++elem)
+  {
+    geometry_space.put_coordinates(coordinates, elem);
+    volume[connectivity[elem][0]][0] = element_type.volume( coordinates );
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 } // actions
@@ -44,12 +44,7 @@ void ForAllCells::execute()
         op.set_elements(elements);
         if (op.can_start_loop())
         {
-          const Uint nb_elem = elements.size();
-          for ( Uint elem = 0; elem != nb_elem; ++elem )
-          {
-            op.select_loop_idx(elem);
-            op.execute();
-          }
+          execute_operation(op, elements.size());
         }
       }
     }
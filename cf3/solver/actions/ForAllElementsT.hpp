@@ -67,12 +67,7 @@ class solver_actions_API ForAllElementsT : public Loop
           op.set_elements(elements);
           if (op.can_start_loop())
           {
-            const Uint nb_elem = elements.size();
-            for ( Uint elem = 0; elem != nb_elem; ++elem )
-            {
-              op.select_loop_idx(elem);
-              op.execute();
-            }
+            op.execute_range(0, elements.size());
           }
         }
       }
@@ -7,7 +7,12 @@
 #include "common/URI.hpp"
  
 
+#include <algorithm>
+#include <exception>
+
 #include "common/OptionArray.hpp"
+#include "common/OptionList.hpp"
+#include "common/Threads.hpp"
 
 #include "solver/actions/Loop.hpp"
 
@@ -28,6 +33,48 @@ Loop::Loop ( const std::string& name ) :
   solver::Action(name)
 {
   mark_basic();
+
+  options().add("chunk_size", 1024u)
+    .pretty_name("Chunk Size")
+    .description("Number of loop indices executed together by a thread, for operations that can run in parallel");
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+void Loop::execute_operation(LoopOperation& op, const Uint nb_indices)
+{
+  const Uint nb_loop_threads = op.is_thread_safe() ? nb_threads() : 1u;
+  if(nb_loop_threads == 1)
+  {
+    op.execute_range(0, nb_indices);
+    return;
+  }
+
+  const Uint chunk_size = std::max(options().value<Uint>("chunk_size"), 1u);
+  const int nb_chunks = static_cast<int>((nb_indices + chunk_size - 1) / chunk_size);
+
+  // Exceptions can't leave the parallel region, so the first one is stored and rethrown afterwards
+  std::exception_ptr error;
+  #pragma omp parallel for num_threads(nb_loop_threads) schedule(dynamic)
+  for(int chunk = 0; chunk < nb_chunks; ++chunk)
+  {
+    const Uint begin = chunk*chunk_size;
+    try
+    {
+      op.execute_range(begin, std::min(begin + chunk_size, nb_indices));
+    }
+    catch(...)
+    {
+      #pragma omp critical
+      {
+        if(!error)
+          error = std::current_exception();
+      }
+    }
+  }
+
+  if(error)
+    std::rethrow_exception(error);
 }
 
 /////////////////////////////////////////////////////////////////////////////////////
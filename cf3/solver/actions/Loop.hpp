@@ -51,6 +51,12 @@ public: // functions
   virtual LoopOperation& action(const std::string& name);
 
   virtual void execute() = 0;
+
+protected: // functions
+
+  /// Execute the given operation for the indices [0, nb_indices). If the operation is thread-safe, the
+  /// indices are split into chunks of "chunk_size" that are executed in parallel on nb_threads threads.
+  void execute_operation(LoopOperation& op, const Uint nb_indices);
 };
 
 /////////////////////////////////////////////////////////////////////////////////////
@@ -65,6 +65,17 @@ void LoopOperation::config_elements()
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void LoopOperation::execute_range(const Uint begin, const Uint end)
+{
+  for(Uint i = begin; i != end; ++i)
+  {
+    select_loop_idx(i);
+    execute();
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
 void LoopOperation::set_elements(Entities& elements)
 {
   // disable LoopOperation::config_elements() trigger
@@ -47,6 +47,16 @@ public: // functions
 
   void select_loop_idx ( const Uint idx ) { m_idx = idx; }
 
+  /// Execute the operation for the loop indices in the range [begin, end).
+  /// The default implementation calls select_loop_idx and execute for each index. Cheap operations
+  /// should override this with a tight loop, to avoid the virtual call for each index.
+  virtual void execute_range ( const Uint begin, const Uint end );
+
+  /// True if execute_range may be called concurrently for disjoint ranges, in which case loops split
+  /// the indices into chunks that are executed in parallel. The default execute_range uses the
+  /// index stored in the operation, so this returns false unless overridden.
+  virtual bool is_thread_safe () const { return false; }
+
   /// Called before looping to prepare a helper object that caches entries
   /// needed by this operation to perform the loop efficiently.
   /// Typically accesses components and stores their address, since they are not expected to change over looping.
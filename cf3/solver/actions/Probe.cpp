@@ -8,6 +8,7 @@
 #include <boost/function.hpp>
 
 #include "common/Core.hpp"
+#include "common/EventHandler.hpp"
 #include "common/Builder.hpp"
 #include "common/PropertyList.hpp"
 #include "common/OptionList.hpp"
@@ -29,6 +30,7 @@
 #include "mesh/Dictionary.hpp"
 #include "mesh/Space.hpp"
 #include "mesh/PointInterpolator.hpp"
+#include "mesh/Tags.hpp"
 
 namespace cf3 {
 namespace solver {
@@ -54,6 +56,7 @@ Probe::Probe( const std::string& name  ) : common::Action(name)
   options().add("coordinate",std::vector<Real>())
     .pretty_name("Coordinate")
     .description("Coordinate to interpolate fields to")
+    .attach_trigger( boost::bind( &Probe::trigger_coordinate, this ) )
     .mark_basic();
     
   options().add("dict",m_dict)
@@ -70,6 +73,9 @@ Probe::Probe( const std::string& name  ) : common::Action(name)
 
   m_point_interpolator = create_component<PointInterpolator>("point_interpolator");
   m_variables = create_component<math::VariablesDescriptor>("variables");
+
+  Core::instance().event_handler().connect_to_event(mesh::Tags::event_mesh_loaded(), this, &Probe::on_mesh_changed_event);
+  Core::instance().event_handler().connect_to_event(mesh::Tags::event_mesh_changed(), this, &Probe::on_mesh_changed_event);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -77,80 +83,53 @@ Probe::Probe( const std::string& name  ) : common::Action(name)
 void Probe::configure_point_interpolator()
 {
   m_point_interpolator->options().set("dict",m_dict);
+  m_stencil.invalidate();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void Probe::execute()
+void Probe::trigger_coordinate()
 {
-  if ( is_null(m_dict) )
-    throw SetupError(FromHere(), "Option \"dict\" was not configured in "+uri().string());
-
-  // Take the coordinate from the options
-  std::vector<Real> opt_coord = options().value< std::vector<Real> >("coordinate");
-  RealVector coord(opt_coord.size());
-  math::copy(opt_coord,coord);
-
-  // Find interpolation data for this coordinate
-  SpaceElem m_element;
-  std::vector<SpaceElem> m_stencil;
-  std::vector<Uint> m_points;
-  std::vector<Real> m_weights;
-
-  int found = m_point_interpolator->compute_storage(coord,m_element,m_stencil,m_points,m_weights);
-
-//  std::cout << PE::Comm::instance().rank() << ":  found = " << found << std::endl;
+  m_stencil.invalidate();
+}
 
-  int found_on_proc = found ? PE::Comm::instance().rank() : -1;
+////////////////////////////////////////////////////////////////////////////////
 
-  if (PE::Comm::instance().is_active())
-    PE::Comm::instance().all_reduce(PE::max(), &found_on_proc, 1, &found_on_proc);
+void Probe::on_mesh_changed_event(SignalArgs& args)
+{
+  m_stencil.invalidate();
+}
 
-//  std::cout << PE::Comm::instance().rank() << ":  found_on_proc = " << found_on_proc << std::endl;
+////////////////////////////////////////////////////////////////////////////////
 
-  if (found_on_proc<0)
-    throw SetupError(FromHere(),"Cannot probe: coordinate ("+to_str(opt_coord)+") lies outside the domain");
+void Probe::execute()
+{
+  if ( is_null(m_dict) )
+    throw SetupError(FromHere(), "Option \"dict\" was not configured in "+uri().string());
 
-  PE::Buffer elem_comp_buffer;
-  if (found)
+  // Locate the probe only when the coordinate or the mesh changed
+  if (!m_stencil.is_valid(*m_dict))
   {
-    elem_comp_buffer << m_element.comp->uri().path() << m_element.glb_idx();
-  }
-  elem_comp_buffer.broadcast(found_on_proc);
-  std::string elem_comp;
-  Uint glb_idx;
-  elem_comp_buffer >> elem_comp >> glb_idx;
+    std::vector<Real> opt_coord = options().value< std::vector<Real> >("coordinate");
+    std::vector<RealVector> coords(1, RealVector(opt_coord.size()));
+    math::copy(opt_coord,coords[0]);
+    m_stencil.resolve(*m_point_interpolator, *m_dict, coords);
 
-  properties()["space"]=elem_comp;
-  properties()["glb_elem_idx"]=glb_idx;
+    properties()["space"]=m_stencil.space_path(0);
+    properties()["glb_elem_idx"]=m_stencil.glb_elem_idx(0);
+  }
 
-//  std::cout << PE::Comm::instance().rank() << ":  elem_comp = " << elem_comp << std::endl;
-//  std::cout << PE::Comm::instance().rank() << ":  glb_idx = " << glb_idx << std::endl;
+  // Interpolate all fields at once
+  std::vector<Real> interpolated;
+  m_stencil.interpolate(*m_dict, interpolated);
 
+  Uint field_begin = 0;
   boost_foreach (const Handle<Field>& field, m_dict->fields())
   {
-
-    // Interpolate each field to the given point
-    std::vector<Real> interpolated(field->row_size());
-
-    if (found)
-    {
-      for(Uint v=0; v<interpolated.size(); ++v)
-      {
-        interpolated[v]=0.;
-        for(Uint i=0; i<m_points.size(); ++i)
-        {
-          interpolated[v] += field->array()[m_points[i]][v] * m_weights[i];
-        }
-      }
-    }
-
-    PE::Comm::instance().broadcast(interpolated,interpolated,found_on_proc);
-
     // Set interpolated variables as properties
     for (Uint var_idx=0; var_idx<field->nb_vars(); ++var_idx)
     {
-      Uint var_begin  = field->descriptor().offset(var_idx);
+      Uint var_begin  = field_begin + field->descriptor().offset(var_idx);
       Uint var_length = field->descriptor().var_length(var_idx);
       if (var_length==1)
       {
@@ -164,6 +143,7 @@ void Probe::execute()
         }
       }
     }
+    field_begin += field->row_size();
   }
 
   // Do all post-processing actions, which could add more properties to the probe,
@@ -12,6 +12,7 @@
 
 #include "common/Action.hpp"
 #include "solver/actions/LibActions.hpp"
+#include "solver/actions/ProbeStencil.hpp"
 
 namespace cf3 {
 namespace math { class VariablesDescriptor; }
@@ -74,11 +75,18 @@ private: // functions
   /// @brief Configure the point interpolator
   void configure_point_interpolator();
 
+  /// @brief Locate the probe again on the next execution
+  void trigger_coordinate();
+
+  /// @brief The probe location becomes invalid when the mesh changes
+  void on_mesh_changed_event(common::SignalArgs& args);
+
 private: // data
 
   Handle<mesh::Dictionary>            m_dict;                ///< Dictionary to interpolate
   Handle<mesh::PointInterpolator>     m_point_interpolator;  ///< Interpolator for one point
   Handle< math::VariablesDescriptor > m_variables;           ///< Variable description
+  ProbeStencil                        m_stencil;             ///< Cached interpolation stencil
 
 };
 
@@ -8,6 +8,8 @@
 #include <boost/function.hpp>
 
 #include "common/Core.hpp"
+#include "common/EventHandler.hpp"
+#include "common/Table.hpp"
 #include "common/Builder.hpp"
 #include "common/PropertyList.hpp"
 #include "common/OptionList.hpp"
@@ -29,6 +31,7 @@
 #include "mesh/Dictionary.hpp"
 #include "mesh/Space.hpp"
 #include "mesh/PointInterpolator.hpp"
+#include "mesh/Tags.hpp"
 
 namespace cf3 {
 namespace solver {
@@ -54,16 +57,19 @@ ProbePoints::ProbePoints( const std::string& name  ) : common::Action(name)
   options().add("x_coordinate",std::vector<Real>())
     .pretty_name("xcoordinate")
     .description("x-coordinate to interpolate fields to")
+    .attach_trigger( boost::bind( &ProbePoints::trigger_coordinates, this ) )
     .mark_basic();
 
   options().add("y_coordinate",std::vector<Real>())
     .pretty_name("ycoordinate")
     .description("y-coordinate to interpolate fields to")
+    .attach_trigger( boost::bind( &ProbePoints::trigger_coordinates, this ) )
     .mark_basic();
 
   options().add("z_coordinate",std::vector<Real>())
     .pretty_name("zcoordinate")
     .description("z-coordinate to interpolate fields to")
+    .attach_trigger( boost::bind( &ProbePoints::trigger_coordinates, this ) )
     .mark_basic();
     
   options().add("dict",m_dict)
@@ -80,6 +86,10 @@ ProbePoints::ProbePoints( const std::string& name  ) : common::Action(name)
 
   m_point_interpolator = create_component<PointInterpolator>("point_interpolator");
   m_variables = create_component<math::VariablesDescriptor>("variables");
+  m_values = create_component< Table<Real> >("values");
+
+  Core::instance().event_handler().connect_to_event(mesh::Tags::event_mesh_loaded(), this, &ProbePoints::on_mesh_changed_event);
+  Core::instance().event_handler().connect_to_event(mesh::Tags::event_mesh_changed(), this, &ProbePoints::on_mesh_changed_event);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -87,93 +97,101 @@ ProbePoints::ProbePoints( const std::string& name  ) : common::Action(name)
 void ProbePoints::configure_point_interpolator()
 {
   m_point_interpolator->options().set("dict",m_dict);
+  m_stencil.invalidate();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void ProbePoints::execute()
+void ProbePoints::trigger_coordinates()
 {
-  if ( is_null(m_dict) )
-    throw SetupError(FromHere(), "Option \"dict\" was not configured in "+uri().string());
-
-  // Take the coordinate from the options
-  std::vector<Real> opt_coord = options().value< std::vector<Real> >("coordinate");
-  RealVector coord(opt_coord.size()); //get the size
-  math::copy(opt_coord,coord);
-
-  // Find interpolation data for this coordinate
-  SpaceElem m_element;
-  std::vector<SpaceElem> m_stencil;
-  std::vector<Uint> m_points;
-  std::vector<Real> m_weights;
+  m_stencil.invalidate();
+}
 
-  int found = m_point_interpolator->compute_storage(coord,m_element,m_stencil,m_points,m_weights);
+////////////////////////////////////////////////////////////////////////////////
 
-//  std::cout << PE::Comm::instance().rank() << ":  found = " << found << std::endl;
+void ProbePoints::on_mesh_changed_event(SignalArgs& args)
+{
+  m_stencil.invalidate();
+}
 
-  int found_on_proc = found ? PE::Comm::instance().rank() : -1;
+////////////////////////////////////////////////////////////////////////////////
 
-  if (PE::Comm::instance().is_active())
-    PE::Comm::instance().all_reduce(PE::max(), &found_on_proc, 1, &found_on_proc);
+Uint ProbePoints::nb_points() const
+{
+  return options().value< std::vector<Real> >("x_coordinate").size();
+}
 
-//  std::cout << PE::Comm::instance().rank() << ":  found_on_proc = " << found_on_proc << std::endl;
+////////////////////////////////////////////////////////////////////////////////
 
-  if (found_on_proc<0)
-    throw SetupError(FromHere(),"Cannot probe: coordinate ("+to_str(opt_coord)+") lies outside the domain");
+std::vector<RealVector> ProbePoints::coordinates() const
+{
+  std::vector< std::vector<Real> > components;
+  components.push_back(options().value< std::vector<Real> >("x_coordinate"));
+  components.push_back(options().value< std::vector<Real> >("y_coordinate"));
+  components.push_back(options().value< std::vector<Real> >("z_coordinate"));
+  while(!components.empty() && components.back().empty())
+    components.pop_back();
+
+  const Uint nb_pts = nb_points();
+  const Uint dim = components.size();
+  for(Uint d = 0; d != dim; ++d)
+  {
+    if(components[d].size() != nb_pts)
+      throw SetupError(FromHere(), "All coordinate options of "+uri().string()+" must have the same number of entries");
+  }
 
-  PE::Buffer elem_comp_buffer;
-  if (found)
+  std::vector<RealVector> result(nb_pts, RealVector(dim));
+  for(Uint i = 0; i != nb_pts; ++i)
   {
-    elem_comp_buffer << m_element.comp->uri().path() << m_element.glb_idx();
+    for(Uint d = 0; d != dim; ++d)
+      result[i][d] = components[d][i];
   }
-  elem_comp_buffer.broadcast(found_on_proc);
-  std::string elem_comp;
-  Uint glb_idx;
-  elem_comp_buffer >> elem_comp >> glb_idx;
+  return result;
+}
 
-  properties()["space"]=elem_comp;
-  properties()["glb_elem_idx"]=glb_idx;
+////////////////////////////////////////////////////////////////////////////////
 
-//  std::cout << PE::Comm::instance().rank() << ":  elem_comp = " << elem_comp << std::endl;
-//  std::cout << PE::Comm::instance().rank() << ":  glb_idx = " << glb_idx << std::endl;
+void ProbePoints::execute()
+{
+  if ( is_null(m_dict) )
+    throw SetupError(FromHere(), "Option \"dict\" was not configured in "+uri().string());
 
-  boost_foreach (const Handle<Field>& field, m_dict->fields())
+  // Locate the points and describe the table columns only when the coordinates or the mesh changed
+  if (!m_stencil.is_valid(*m_dict))
   {
+    const std::vector<RealVector> coords = coordinates();
+    m_stencil.resolve(*m_point_interpolator, *m_dict, coords);
 
-    // Interpolate each field to the given point
-    std::vector<Real> interpolated(field->row_size());
-
-    if (found)
+    remove_component(*m_variables);
+    m_variables = create_component<math::VariablesDescriptor>("variables");
+    m_variables->options().set("dimension", coords.empty() ? 0u : static_cast<Uint>(coords.front().size()));
+    boost_foreach (const Handle<Field>& field, m_dict->fields())
     {
-      for(Uint v=0; v<interpolated.size(); ++v)
+      for (Uint var_idx=0; var_idx<field->nb_vars(); ++var_idx)
       {
-        interpolated[v]=0.;
-        for(Uint i=0; i<m_points.size(); ++i)
-        {
-          interpolated[v] += field->array()[m_points[i]][v] * m_weights[i];
-        }
+        const std::string var_name = field->descriptor().user_variable_name(var_idx);
+        const Uint var_length = field->descriptor().var_length(var_idx);
+        // Variables with the same name in different fields are qualified with the field name
+        const std::string column_name = m_variables->has_variable(var_name) ? field->name() + "_" + var_name : var_name;
+        if (var_length==1)
+          m_variables->push_back(column_name, math::VariablesDescriptor::Dimensionalities::SCALAR);
+        else
+          m_variables->push_back(column_name, var_length);
       }
     }
+  }
 
-    PE::Comm::instance().broadcast(interpolated,interpolated,found_on_proc);
+  // Interpolate all fields to all points at once
+  std::vector<Real> interpolated;
+  m_stencil.interpolate(*m_dict, interpolated);
 
-    // Set interpolated variables as properties
-    for (Uint var_idx=0; var_idx<field->nb_vars(); ++var_idx)
-    {
-      Uint var_begin  = field->descriptor().offset(var_idx);
-      Uint var_length = field->descriptor().var_length(var_idx);
-      if (var_length==1)
-      {
-        set(field->descriptor().user_variable_name(var_idx) , interpolated[var_begin]);
-      }
-      else
-      {
-        for (Uint i=0; i<var_length; ++i)
-        {
-          set(field->descriptor().user_variable_name(var_idx)+"["+to_str(i)+"]" , interpolated[var_begin+i]);
-        }
-      }
-    }
+  const Uint row_size = ProbeStencil::total_row_size(*m_dict);
+  m_values->set_row_size(row_size);
+  m_values->resize(m_stencil.nb_points());
+  for (Uint i=0; i<m_stencil.nb_points(); ++i)
+  {
+    Table<Real>::Row row = m_values->array()[i];
+    std::copy(interpolated.begin() + i*row_size, interpolated.begin() + (i+1)*row_size, row.begin());
   }
 
   // Do all post-processing actions, which could add more properties to the ProbePoints,
@@ -189,15 +207,6 @@ void ProbePoints::execute()
 
 void ProbePoints::set(const std::string& var_name, const Real& var_value)
 {
-  if (properties().check(var_name) == false)
-  {
-    if (m_variables->nb_vars() == 0)
-    {
-      m_variables->options().set("dimension",(Uint)options().value<std::vector<Real> >("coordinate").size());
-    }
-
-    m_variables->push_back(var_name,math::VariablesDescriptor::Dimensionalities::SCALAR);
-  }
   properties()[var_name] = var_value;
 }
 
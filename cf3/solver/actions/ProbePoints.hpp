@@ -12,8 +12,10 @@
 
 #include "common/Action.hpp"
 #include "solver/actions/LibActions.hpp"
+#include "solver/actions/ProbeStencil.hpp"
 
 namespace cf3 {
+namespace common { template <typename T> class Table; }
 namespace math { class VariablesDescriptor; }
 namespace mesh { class Dictionary; class PointInterpolator; }
 namespace solver {
@@ -23,9 +25,12 @@ class ProbePointsPostProcessor;
 
 ////////////////////////////////////////////////////////////////////////////////
 
-/// @brief Probe to interpolate field values to given coordinate along a line
+/// @brief Probe to interpolate field values to a set of points
 ///
-/// Interpolated values are stored as properties within the probe component.
+/// Interpolated values are stored in the "values" table, with one row per point and
+/// one column per variable, as described by variables().
+/// The points are located once, and again only when the coordinates or the mesh change.
+/// All values of all fields are then collected in a single collective operation.
 /// Actions can be added as child to the probe, and will be executed, after
 /// the probe is executed.
 class solver_actions_API ProbePoints : public common::Action {
@@ -56,6 +61,12 @@ public: // functions
   /// @brief Access to the description of the probed variables
   Handle<math::VariablesDescriptor> variables() { return m_variables; }
 
+  /// @brief Interpolated values, one row per point
+  Handle< common::Table<Real> > values() { return m_values; }
+
+  /// @brief Number of probe points
+  Uint nb_points() const;
+
 private: // functions
 
   /// @brief Add a variable to the internal storage
@@ -73,11 +84,22 @@ private: // functions
   /// @brief Configure the point interpolator
   void configure_point_interpolator();
 
+  /// @brief Locate the points again on the next execution
+  void trigger_coordinates();
+
+  /// @brief The point locations become invalid when the mesh changes
+  void on_mesh_changed_event(common::SignalArgs& args);
+
+  /// @brief Coordinates of the points, built from the x, y and z coordinate options
+  std::vector<RealVector> coordinates() const;
+
 private: // data
 
   Handle<mesh::Dictionary>            m_dict;                ///< Dictionary to interpolate
   Handle<mesh::PointInterpolator>     m_point_interpolator;  ///< Interpolator for one point
   Handle< math::VariablesDescriptor > m_variables;           ///< Variable description
+  Handle< common::Table<Real> >       m_values;              ///< Interpolated values
+  ProbeStencil                        m_stencil;             ///< Cached interpolation stencils
 
 };
 
@@ -0,0 +1,167 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include <boost/foreach.hpp>
+
+#include "common/BasicExceptions.hpp"
+#include "common/StringConversion.hpp"
+
+#include "common/PE/Buffer.hpp"
+#include "common/PE/Comm.hpp"
+
+#include "mesh/Dictionary.hpp"
+#include "mesh/Field.hpp"
+#include "mesh/PointInterpolator.hpp"
+#include "mesh/Space.hpp"
+
+#include "solver/actions/ProbeStencil.hpp"
+
+namespace cf3 {
+namespace solver {
+namespace actions {
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+ProbeStencil::ProbeStencil() :
+  m_valid(false),
+  m_dict_size(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void ProbeStencil::resolve(mesh::APointInterpolator& interpolator, const mesh::Dictionary& dict, const std::vector<RealVector>& coordinates)
+{
+  common::PE::Comm& comm = common::PE::Comm::instance();
+  const Uint nb_pts = coordinates.size();
+  const int my_rank = comm.rank();
+
+  m_valid = false;
+  m_stencil_offsets.assign(1, 0);
+  m_stencil_points.clear();
+  m_stencil_weights.clear();
+
+  // Locate all points locally
+  std::vector<int> found_on_proc(nb_pts, -1);
+  std::vector<mesh::SpaceElem> elements(nb_pts);
+  std::vector< std::vector<Uint> > points(nb_pts);
+  std::vector< std::vector<Real> > weights(nb_pts);
+  std::vector<mesh::SpaceElem> stencil;
+  for(Uint i = 0; i != nb_pts; ++i)
+  {
+    if(interpolator.compute_storage(coordinates[i], elements[i], stencil, points[i], weights[i]))
+      found_on_proc[i] = my_rank;
+  }
+
+  // Points found on several processes are owned by the highest rank
+  if(comm.is_active() && nb_pts != 0)
+    comm.all_reduce(common::PE::max(), &found_on_proc[0], nb_pts, &found_on_proc[0]);
+
+  m_owners.resize(nb_pts);
+  for(Uint i = 0; i != nb_pts; ++i)
+  {
+    if(found_on_proc[i] < 0)
+      throw common::SetupError(FromHere(), "Cannot probe: coordinate (" + common::to_str(std::vector<Real>(coordinates[i].data(), coordinates[i].data() + coordinates[i].size())) + ") lies outside the domain");
+    m_owners[i] = found_on_proc[i];
+  }
+
+  // Keep the stencils of the owned points, and share the element info
+  common::PE::Buffer element_buffer;
+  for(Uint i = 0; i != nb_pts; ++i)
+  {
+    if(found_on_proc[i] == my_rank)
+    {
+      m_stencil_points.insert(m_stencil_points.end(), points[i].begin(), points[i].end());
+      m_stencil_weights.insert(m_stencil_weights.end(), weights[i].begin(), weights[i].end());
+      element_buffer << i << elements[i].comp->uri().path() << elements[i].glb_idx();
+    }
+    m_stencil_offsets.push_back(m_stencil_points.size());
+  }
+
+  m_space_paths.assign(nb_pts, std::string());
+  m_glb_elem_idx.assign(nb_pts, 0);
+  common::PE::Buffer all_elements;
+  if(comm.is_active())
+    element_buffer.all_gather(all_elements);
+  common::PE::Buffer& received = comm.is_active() ? all_elements : element_buffer;
+  while(received.more_to_unpack())
+  {
+    Uint i;
+    received >> i;
+    received >> m_space_paths[i] >> m_glb_elem_idx[i];
+  }
+
+  m_dict_size = dict.size();
+  m_valid = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+bool ProbeStencil::is_valid(const mesh::Dictionary& dict) const
+{
+  return m_valid && m_dict_size == dict.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void ProbeStencil::invalidate()
+{
+  m_valid = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+Uint ProbeStencil::total_row_size(const mesh::Dictionary& dict)
+{
+  Uint result = 0;
+  BOOST_FOREACH(const Handle<mesh::Field>& field, dict.fields())
+  {
+    result += field->row_size();
+  }
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void ProbeStencil::interpolate(const mesh::Dictionary& dict, std::vector<Real>& values) const
+{
+  cf3_assert(m_valid);
+  common::PE::Comm& comm = common::PE::Comm::instance();
+  const Uint nb_pts = nb_points();
+  const Uint row_size = total_row_size(dict);
+  const Uint my_rank = comm.rank();
+
+  // Only the owner of a point fills in its values, the others contribute zero to the sum
+  values.assign(nb_pts*row_size, 0.);
+  for(Uint i = 0; i != nb_pts; ++i)
+  {
+    if(m_owners[i] != my_rank)
+      continue;
+
+    Real* row = &values[i*row_size];
+    BOOST_FOREACH(const Handle<mesh::Field>& field, dict.fields())
+    {
+      const Uint field_row_size = field->row_size();
+      for(Uint s = m_stencil_offsets[i]; s != m_stencil_offsets[i+1]; ++s)
+      {
+        const mesh::Field::ConstRow field_row = field->array()[m_stencil_points[s]];
+        const Real weight = m_stencil_weights[s];
+        for(Uint v = 0; v != field_row_size; ++v)
+          row[v] += field_row[v] * weight;
+      }
+      row += field_row_size;
+    }
+  }
+
+  if(comm.is_active() && !values.empty())
+    comm.all_reduce(common::PE::plus(), &values[0], values.size(), &values[0]);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+} // actions
+} // solver
+} // cf3
@@ -0,0 +1,84 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_solver_actions_ProbeStencil_hpp
+#define cf3_solver_actions_ProbeStencil_hpp
+
+////////////////////////////////////////////////////////////////////////////////
+
+#include <string>
+#include <vector>
+
+#include "math/MatrixTypes.hpp"
+
+#include "solver/actions/LibActions.hpp"
+
+namespace cf3 {
+namespace mesh { class Dictionary; class APointInterpolator; }
+namespace solver {
+namespace actions {
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// @brief Cached interpolation stencils for a set of probe locations
+///
+/// The points are located once, and the process that owns each point keeps the interpolation
+/// points and weights. Interpolating all fields of a dictionary then only needs local work and
+/// a single collective operation for all points.
+class solver_actions_API ProbeStencil
+{
+public:
+  ProbeStencil();
+
+  /// Locate the points in the dictionary of the interpolator. This is collective.
+  /// @throws common::SetupError if a point is outside the domain on all processes
+  void resolve(mesh::APointInterpolator& interpolator, const mesh::Dictionary& dict, const std::vector<RealVector>& coordinates);
+
+  /// True if resolve was called and the dictionary did not change size since
+  bool is_valid(const mesh::Dictionary& dict) const;
+
+  /// Mark the stencils as outdated, i.e. after the mesh or the coordinates changed
+  void invalidate();
+
+  /// Interpolate all fields of the dictionary to the probe points. On return, values contains one row for each point,
+  /// with the values of all fields one after the other, and is the same on all processes. This is collective.
+  void interpolate(const mesh::Dictionary& dict, std::vector<Real>& values) const;
+
+  /// Number of probe points
+  Uint nb_points() const { return m_owners.size(); }
+
+  /// Process that interpolates the given point
+  Uint owner(const Uint point) const { return m_owners[point]; }
+
+  /// Path of the space containing the given point, and global index of the element. The same on all processes
+  const std::string& space_path(const Uint point) const { return m_space_paths[point]; }
+  Uint glb_elem_idx(const Uint point) const { return m_glb_elem_idx[point]; }
+
+  /// Total number of variables in all fields of the dictionary
+  static Uint total_row_size(const mesh::Dictionary& dict);
+
+private:
+  bool m_valid;
+  Uint m_dict_size;
+  std::vector<Uint> m_owners;
+  std::vector<std::string> m_space_paths;
+  std::vector<Uint> m_glb_elem_idx;
+
+  /// Interpolation points and weights of the locally owned probes, indexed using m_stencil_offsets
+  std::vector<Uint> m_stencil_offsets;
+  std::vector<Uint> m_stencil_points;
+  std::vector<Real> m_stencil_weights;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // actions
+} // solver
+} // cf3
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif // cf3_solver_actions_ProbeStencil_hpp
@@ -0,0 +1,134 @@
+// Copyright (C) 2010-2011 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include <limits>
+
+#include <boost/bind.hpp>
+#include <boost/foreach.hpp>
+
+#include "common/Core.hpp"
+#include "common/EventHandler.hpp"
+#include "common/List.hpp"
+
+#include "mesh/Connectivity.hpp"
+#include "mesh/Dictionary.hpp"
+#include "mesh/Space.hpp"
+#include "mesh/Tags.hpp"
+
+#include "ElementColoring.hpp"
+
+namespace cf3 {
+namespace solver {
+namespace actions {
+namespace Proto {
+
+ElementColoring::ElementColoring(const mesh::Elements& elements)
+{
+  const mesh::Dictionary& geometry = elements.geometry_fields();
+  const mesh::Connectivity& connectivity = elements.geometry_space().connectivity();
+  const Uint nb_elems = connectivity.size();
+  m_nb_nodes = geometry.size();
+
+  // Periodic nodes are assembled into the row of their final target node
+  std::vector<Uint> node_map(m_nb_nodes);
+  for(Uint i = 0; i != m_nb_nodes; ++i)
+    node_map[i] = i;
+
+  Handle< common::List<Uint> const > periodic_links_nodes_h(geometry.get_child("periodic_links_nodes"));
+  Handle< common::List<bool> const > periodic_links_active_h(geometry.get_child("periodic_links_active"));
+  if(is_not_null(periodic_links_nodes_h) && is_not_null(periodic_links_active_h))
+  {
+    const common::List<Uint>& periodic_links_nodes = *periodic_links_nodes_h;
+    const common::List<bool>& periodic_links_active = *periodic_links_active_h;
+    for(Uint i = 0; i != m_nb_nodes; ++i)
+    {
+      if(!periodic_links_active[i])
+        continue;
+      Uint final_target_node = periodic_links_nodes[i];
+      while(periodic_links_active[final_target_node])
+        final_target_node = periodic_links_nodes[final_target_node];
+      node_map[i] = final_target_node;
+    }
+  }
+
+  // Each pass over the remaining elements fills one color, deferring elements that touch a node already used in that color
+  std::vector<Uint> node_color(m_nb_nodes, std::numeric_limits<Uint>::max());
+  std::vector<Uint> remaining(nb_elems);
+  for(Uint i = 0; i != nb_elems; ++i)
+    remaining[i] = i;
+
+  m_elements.reserve(nb_elems);
+  m_color_starts.push_back(0);
+  std::vector<Uint> deferred;
+  while(!remaining.empty())
+  {
+    const Uint color = nb_colors();
+    deferred.clear();
+    BOOST_FOREACH(const Uint elem, remaining)
+    {
+      const mesh::Connectivity::ConstRow row = connectivity[elem];
+      bool is_free = true;
+      BOOST_FOREACH(const Uint node, row)
+      {
+        if(node_color[node_map[node]] == color)
+        {
+          is_free = false;
+          break;
+        }
+      }
+
+      if(!is_free)
+      {
+        deferred.push_back(elem);
+        continue;
+      }
+
+      BOOST_FOREACH(const Uint node, row)
+      {
+        node_color[node_map[node]] = color;
+      }
+      m_elements.push_back(elem);
+    }
+    m_color_starts.push_back(m_elements.size());
+    remaining.swap(deferred);
+  }
+}
+
+ElementColoringCache::ElementColoringCache()
+{
+  common::Core::instance().event_handler().connect_to_event(mesh::Tags::event_mesh_loaded(), this, &ElementColoringCache::on_mesh_changed_event);
+  common::Core::instance().event_handler().connect_to_event(mesh::Tags::event_mesh_changed(), this, &ElementColoringCache::on_mesh_changed_event);
+}
+
+ElementColoringCache& ElementColoringCache::instance()
+{
+  static ElementColoringCache instance;
+  return instance;
+}
+
+const ElementColoring& ElementColoringCache::coloring(const mesh::Elements& elements)
+{
+  boost::shared_ptr<ElementColoring>& result = m_colorings[elements.uri().path()];
+  // Recompute if the elements were resized or renumbered without a mesh event
+  if(is_null(result) || result->elements().size() != elements.size() || result->nb_nodes() != elements.geometry_fields().size())
+    result.reset(new ElementColoring(elements));
+  return *result;
+}
+
+void ElementColoringCache::clear()
+{
+  m_colorings.clear();
+}
+
+void ElementColoringCache::on_mesh_changed_event(common::SignalArgs& args)
+{
+  clear();
+}
+
+} // namespace Proto
+} // namespace actions
+} // namespace solver
+} // namespace cf3
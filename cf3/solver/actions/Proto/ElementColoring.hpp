@@ -0,0 +1,99 @@
+// Copyright (C) 2010-2011 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_solver_actions_Proto_ElementColoring_hpp
+#define cf3_solver_actions_Proto_ElementColoring_hpp
+
+#include <boost/shared_ptr.hpp>
+
+#include "common/ConnectionManager.hpp"
+#include "common/SignalHandler.hpp"
+
+#include "mesh/Elements.hpp"
+
+/// @file
+/// Element coloring, used to assemble element contributions on multiple threads
+
+namespace cf3 {
+namespace solver {
+namespace actions {
+namespace Proto {
+
+/// Partitions a set of elements into colors, so that no two elements of the same color share a node.
+/// Elements of a single color can be processed concurrently without write conflicts on nodal data or
+/// on the rows of a linear system. Periodic nodes are merged with their target node, since they share the same LSS row.
+class ElementColoring
+{
+public:
+  /// Compute a greedy coloring, based on the geometry connectivity of the given elements
+  ElementColoring(const mesh::Elements& elements);
+
+  /// Number of colors
+  Uint nb_colors() const
+  {
+    return m_color_starts.size() - 1;
+  }
+
+  /// Position of the first element of color c in elements()
+  Uint color_begin(const Uint c) const
+  {
+    return m_color_starts[c];
+  }
+
+  /// One past the position of the last element of color c in elements()
+  Uint color_end(const Uint c) const
+  {
+    return m_color_starts[c+1];
+  }
+
+  /// Element indices, sorted by color
+  const std::vector<Uint>& elements() const
+  {
+    return m_elements;
+  }
+
+  /// Number of nodes in the geometry at the time the coloring was computed
+  Uint nb_nodes() const
+  {
+    return m_nb_nodes;
+  }
+
+private:
+  std::vector<Uint> m_color_starts;
+  std::vector<Uint> m_elements;
+  Uint m_nb_nodes;
+};
+
+/// Keeps the colorings that were computed, so they are only rebuilt after the mesh changes
+class ElementColoringCache : public common::ConnectionManager, public boost::noncopyable
+{
+public:
+  /// Singleton implementation
+  static ElementColoringCache& instance();
+
+  /// Get the coloring for the given elements, computing it if needed
+  const ElementColoring& coloring(const mesh::Elements& elements);
+
+  /// Drop all stored colorings
+  void clear();
+
+  /// Handler for the mesh_changed and mesh_loaded events
+  void on_mesh_changed_event(common::SignalArgs& args);
+
+private:
+  ElementColoringCache();
+
+  // Colorings are indexed by the path of the Elements component
+  typedef std::map< std::string, boost::shared_ptr<ElementColoring> > ColoringsT;
+  ColoringsT m_colorings;
+};
+
+} // namespace Proto
+} // namespace actions
+} // namespace solver
+} // namespace cf3
+
+#endif // cf3_solver_actions_Proto_ElementColoring_hpp
@@ -12,6 +12,7 @@
 #include "BlockAccumulator.hpp"
 #include "ElementIntegration.hpp"
 #include "ElementMatrix.hpp"
+#include "ElementProduct.hpp"
 #include "ElementTransforms.hpp"
 #include "GaussPoints.hpp"
 #include "IndexLooping.hpp"
@@ -79,6 +80,8 @@ struct SingleExprElementGrammar :
   <
     // Assignment to system matrix
     BlockAccumulation<ElementMath>,
+    // Matrix-free product with an LSS vector
+    ElementProductGrammar<ElementMath>,
     boost::proto::when
     <
       ElementMath,
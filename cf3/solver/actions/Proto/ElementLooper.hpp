@@ -16,6 +16,11 @@
 #include <boost/mpl/for_each.hpp>
 #include <boost/mpl/filter_view.hpp>
 
+#include <boost/ptr_container/ptr_vector.hpp>
+
+#include "common/Threads.hpp"
+
+#include "ElementColoring.hpp"
 #include "ElementData.hpp"
 #include "ElementExpressionWrapper.hpp"
 #include "ElementGrammar.hpp"
@@ -61,7 +66,7 @@ struct CheckSameEtype
 template<typename ElementTypesT, typename ExprT, typename SupportETYPE, typename VariablesT, typename VariablesEtypesT, typename NbVarsT, typename VarIdxT>
 struct ExpressionRunner
 {
-  ExpressionRunner(VariablesT& vars, const ExprT& expr, mesh::Elements& elems) : variables(vars), expression(expr), elements(elems), m_nb_tests(0), m_found(false) {}
+  ExpressionRunner(VariablesT& vars, const ExprT& expr, mesh::Elements& elems, const bool thr) : variables(vars), expression(expr), elements(elems), threaded(thr), m_nb_tests(0), m_found(false) {}
 
   typedef typename boost::remove_reference<typename boost::fusion::result_of::at<VariablesT, VarIdxT>::type>::type VarT;
 
@@ -90,7 +95,7 @@ struct ExpressionRunner
       NewVariablesEtypesT,
       NbVarsT,
       NextIdxT
-    >(variables, expression, elements).run();
+    >(variables, expression, elements, threaded).run();
   }
 
   // Chosen otherwise
@@ -142,12 +147,13 @@ struct ExpressionRunner
       NewVariablesEtypesT,
       NbVarsT,
       NextIdxT
-    >(variables, expression, elements).run();
+    >(variables, expression, elements, threaded).run();
   }
 
   VariablesT& variables;
   const ExprT& expression;
   mesh::Elements& elements;
+  const bool threaded;
   // Number of times we tried a shape function
   mutable Uint m_nb_tests;
   mutable bool m_found;
@@ -159,11 +165,21 @@ struct ExpressionRunner
 template<typename DataT>
 struct ElementLooperImpl
 {
-  template<typename ExprT>
-  void operator()(const ExprT& expr, DataT& data, const Uint nb_elems) const
+  /// Run the expression over all elements. If threaded is true and more than one thread is configured in the Environment,
+  /// the elements are processed color by color (see ElementColoring), distributing each color over the threads.
+  template<typename ExprT, typename VariablesT>
+  void operator()(const ExprT& expr, VariablesT& variables, mesh::Elements& elements, const bool threaded) const
   {
+    const Uint nb_threads = threaded ? common::nb_threads() : 1u;
+    if(nb_threads > 1)
+    {
+      run_colored(expr, variables, elements, nb_threads);
+      return;
+    }
+
+    DataT data(variables, elements);
     const typename DataT::SupportShapeFunction::MappedCoordsT mapped_coords; // needed to deduce proper return type when wrapping
-    run(WrapExpression()(expr, mapped_coords, data), data, nb_elems);
+    run(WrapExpression()(expr, mapped_coords, data), data, elements.size());
   }
 
 private:
@@ -179,13 +195,71 @@ private:
       grammar(expr, elem, data);
     }
   }
+
+  template<typename ExprT, typename VariablesT>
+  void run_colored(const ExprT& expr, VariablesT& variables, mesh::Elements& elements, const Uint nb_threads) const
+  {
+    const ElementColoring& coloring = ElementColoringCache::instance().coloring(elements);
+
+    // Each thread gets its own data. These are created and destroyed outside of the parallel region, since the destructor may communicate
+    boost::ptr_vector<DataT> thread_data;
+    for(Uint i = 0; i != nb_threads; ++i)
+      thread_data.push_back(new DataT(variables, elements));
+
+    std::string error_message;
+
+    #pragma omp parallel num_threads(nb_threads)
+    {
+      DataT& data = thread_data[common::thread_id()];
+      const typename DataT::SupportShapeFunction::MappedCoordsT mapped_coords;
+      // The wrapped expression stores intermediate results, so each thread needs its own
+      run_colors(WrapExpression()(expr, mapped_coords, data), data, coloring, error_message);
+    }
+
+    if(!error_message.empty())
+      throw common::ParallelError(FromHere(), "Threaded element loop over " + elements.uri().path() + " failed: " + error_message);
+  }
+
+  /// Executed by each thread. Elements of a color are shared among the threads, and the implicit barrier at the end of the omp for
+  /// makes sure a color is finished before the next one starts
+  template<typename FilteredExprT>
+  void run_colors(const FilteredExprT& expr, DataT& data, const ElementColoring& coloring, std::string& error_message) const
+  {
+    ElementGrammar grammar;
+    const std::vector<Uint>& colored_elements = coloring.elements();
+    const Uint nb_colors = coloring.nb_colors();
+    for(Uint color = 0; color != nb_colors; ++color)
+    {
+      const int color_begin = coloring.color_begin(color);
+      const int color_end = coloring.color_end(color);
+      #pragma omp for schedule(static)
+      for(int i = color_begin; i < color_end; ++i)
+      {
+        // Exceptions can't leave the parallel region, so the first error is recorded and rethrown afterwards
+        try
+        {
+          const Uint elem = colored_elements[i];
+          data.set_element(elem);
+          grammar(expr, elem, data);
+        }
+        catch(std::exception& e)
+        {
+          #pragma omp critical
+          {
+            if(error_message.empty())
+              error_message = e.what();
+          }
+        }
+      }
+    }
+  }
 };
 
 /// When we recursed to the last variable, actually run the expression
 template<typename ElementTypesT, typename ExprT, typename SupportETYPE, typename VariablesT, typename VariablesEtypesT, typename NbVarsT>
 struct ExpressionRunner<ElementTypesT, ExprT, SupportETYPE, VariablesT, VariablesEtypesT, NbVarsT, NbVarsT>
 {
-  ExpressionRunner(VariablesT& vars, const ExprT& expr, mesh::Elements& elems) : variables(vars), expression(expr), elements(elems) {}
+  ExpressionRunner(VariablesT& vars, const ExprT& expr, mesh::Elements& elems, const bool thr) : variables(vars), expression(expr), elements(elems), threaded(thr) {}
 
   typedef ElementData<VariablesT, VariablesEtypesT, SupportETYPE, typename EquationVariables<ExprT, NbVarsT>::type> DataT;
 
@@ -197,15 +271,14 @@ struct ExpressionRunner<ElementTypesT, ExprT, SupportETYPE, VariablesT, Variable
       INVALID_ELEMENT_EXPRESSION,
       (ElementGrammar));
 
-    DataT data(variables, elements);
-
-    ElementLooperImpl<DataT>()(expression, data, elements.size());
+    ElementLooperImpl<DataT>()(expression, variables, elements, threaded);
   }
 
 private:
   VariablesT& variables;
   const ExprT& expression;
   mesh::Elements& elements;
+  const bool threaded;
 };
 
 /// mpl::for_each compatible functor to loop over elements, using the correct shape function for the geometry
@@ -216,10 +289,12 @@ struct ElementLooper
   // Type of a fusion vector that can contain a copy of each variable that is used in the expression
   typedef typename ExpressionProperties<ExprT>::VariablesT VariablesT;
 
-  ElementLooper(mesh::Elements& elements, const ExprT& expr, VariablesT& variables) :
+  /// If threaded is true, the loop runs on the number of threads set in the Environment
+  ElementLooper(mesh::Elements& elements, const ExprT& expr, VariablesT& variables, const bool threaded = false) :
     m_elements(elements),
     m_expr(expr),
-    m_variables(variables)
+    m_variables(variables),
+    m_threaded(threaded)
   {
   }
 
@@ -253,9 +328,7 @@ struct ElementLooper
     // Verify the types match, and throw an error if non-matching fields are found
     boost::fusion::for_each(m_variables, CheckSameEtype<ETYPE>(m_elements));
 
-    DataT data(m_variables, m_elements);
-
-    ElementLooperImpl<DataT>()(m_expr, data, m_elements.size());
+    ElementLooperImpl<DataT>()(m_expr, m_variables, m_elements, m_threaded);
   }
 
   /// Static dispatch in case different ETYPE are possible
@@ -276,13 +349,14 @@ struct ElementLooper
       boost::mpl::vector0<>, // Start with an empty vector for the per-variable element types
       NbVarsT, // number of variables
       boost::mpl::int_<0> // Start index, as MPL integral constant
-    >(m_variables, m_expr, m_elements).run();
+    >(m_variables, m_expr, m_elements, m_threaded).run();
   }
 
 private:
   mesh::Elements& m_elements;
   const ExprT& m_expr;
   VariablesT& m_variables;
+  const bool m_threaded;
 };
 
 template<typename ElementTypesT, typename ExprT>
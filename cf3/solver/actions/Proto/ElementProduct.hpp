@@ -0,0 +1,205 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_solver_actions_Proto_ElementProduct_hpp
+#define cf3_solver_actions_Proto_ElementProduct_hpp
+
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+#include <boost/proto/core.hpp>
+
+#include "common/Action.hpp"
+
+#include "math/MatrixTypes.hpp"
+#include "math/LSS/System.hpp"
+#include "math/LSS/Vector.hpp"
+
+#include "BlockAccumulator.hpp"
+#include "LSSWrapper.hpp"
+
+/// @file
+/// Matrix-free application of element matrices to an LSS vector
+
+namespace cf3 {
+namespace solver {
+namespace actions {
+namespace Proto {
+
+/// Tag for the element product
+struct ElementProductTag
+{
+};
+
+/// Implementation class for ElementProduct. Uses the system for the mapping between mesh nodes and LSS indices.
+/// The product reads the solution of the system and adds to its RHS, unless other vectors are set using set_vectors.
+class ElementProductImpl : public LSSWrapperImpl<ElementProductTag>
+{
+public:
+  typedef LSSWrapperImpl<ElementProductTag> base_type;
+
+  ElementProductImpl(math::LSS::System& component) :
+    base_type(component),
+    m_input(nullptr),
+    m_output(nullptr)
+  {
+  }
+
+  ElementProductImpl(common::Option& component_option) :
+    base_type(component_option),
+    m_input(nullptr),
+    m_output(nullptr)
+  {
+  }
+
+  /// Vector that is multiplied with the element matrices. Its ghosts must be up-to-date.
+  math::LSS::Vector& input()
+  {
+    return is_null(m_input) ? solution() : *m_input;
+  }
+
+  /// Vector to which the products are added
+  math::LSS::Vector& output()
+  {
+    return is_null(m_output) ? rhs() : *m_output;
+  }
+
+  /// Use the given vectors instead of the solution and RHS of the system. The input is only read.
+  void set_vectors(math::LSS::Vector& output, const math::LSS::Vector& input)
+  {
+    m_output = &output;
+    m_input = const_cast<math::LSS::Vector*>(&input);
+  }
+
+  /// Go back to using the solution and RHS of the system
+  void reset_vectors()
+  {
+    m_input = nullptr;
+    m_output = nullptr;
+  }
+
+  /// Compute y += A*x by executing the given action, which must evaluate an expression of the form product += A_e
+  void apply(common::Action& action, math::LSS::Vector& y, const math::LSS::Vector& x)
+  {
+    set_vectors(y, x);
+    try
+    {
+      action.execute();
+    }
+    catch(...)
+    {
+      reset_vectors();
+      throw;
+    }
+    reset_vectors();
+  }
+
+private:
+  math::LSS::Vector* m_input;
+  math::LSS::Vector* m_output;
+};
+
+/// Proto-ready terminal for the matrix-free product of element matrices with an LSS vector.
+/// In an element expression, product += A_e adds A_e*x_e to y for each element, without assembling the global matrix.
+/// The element matrix uses the same ordering as for assembly into a SystemMatrix, and elements that are skipped by the assembly are skipped here as well.
+class ElementProduct :
+  public boost::proto::extends< boost::proto::literal< ElementProductImpl& >, ElementProduct >
+{
+public:
+
+  typedef boost::proto::extends< boost::proto::literal< ElementProductImpl& >, ElementProduct > base_type;
+
+  /// Operator type, compatible with LSS::NativeOperatorMatrix::OperatorT
+  typedef boost::function<void (math::LSS::Vector&, const math::LSS::Vector&)> OperatorT;
+
+  ElementProduct(math::LSS::System& component) :
+    m_product(component),
+    base_type(m_product)
+  {
+  }
+
+  ElementProduct(common::Option& component_option) :
+    m_product(component_option),
+    base_type(m_product)
+  {
+  }
+
+  ElementProductImpl& product()
+  {
+    return m_product;
+  }
+
+  /// Operator that computes y += A*x by executing the given action, for use with LSS::NativeOperatorMatrix::set_operator.
+  /// Both this terminal and the action must outlive the operator.
+  OperatorT lss_operator(common::Action& action)
+  {
+    return boost::bind(&ElementProductImpl::apply, &m_product, boost::ref(action), _1, _2);
+  }
+
+private:
+  ElementProductImpl m_product;
+};
+
+/// Primitive transform that multiplies the element matrix with the element values of the input and adds the result to the output
+/// Elements with a node outside the LSS are skipped entirely, as is done for assembly into a SystemMatrix, so the product matches the assembled matrix.
+struct ElementProductAccumulator :
+  boost::proto::transform< ElementProductAccumulator >
+{
+  template<typename ExprT, typename StateT, typename DataT>
+  struct impl : boost::proto::transform_impl<ExprT, StateT, DataT>
+  {
+    typedef void result_type;
+
+    result_type operator ()(
+                typename impl::expr_param expr // The accumulation expression
+              , typename impl::state_param state // The evaluated element matrix
+              , typename impl::data_param data // data associated with element loop
+    ) const
+    {
+      typedef typename boost::remove_reference<DataT>::type DataUnrefT;
+      // Same shape function for every variable, as in the assembly. Elements with a node outside the LSS are skipped entirely.
+      static const Uint mat_size = DataUnrefT::EMatrixSizeT::value;
+      detail::assert_nb_nodes<DataUnrefT::nb_lss_nodes>();
+      static const Uint nb_nodes = detail::SafeNbNodes<DataUnrefT::nb_lss_nodes>::value;
+      static const Uint nb_dofs = mat_size / nb_nodes;
+
+      ElementProductImpl& product = boost::proto::value( boost::proto::left(expr) );
+      math::LSS::BlockAccumulator& block_accumulator = data.block_accumulator;
+      product.convert_to_lss(data);
+      if(std::count(block_accumulator.indices.begin(), block_accumulator.indices.end(), static_cast<Uint>(-1)) != 0)
+        return;
+
+      product.input().get_rhs_values(block_accumulator);
+
+      Eigen::Matrix<Real, mat_size, 1> x_e;
+      for(Uint i = 0; i != mat_size; ++i)
+        x_e[i] = block_accumulator.rhs[(i % nb_nodes)*nb_dofs + i / nb_nodes];
+
+      const Eigen::Matrix<Real, mat_size, 1> y_e = state * x_e;
+      for(Uint i = 0; i != mat_size; ++i)
+        block_accumulator.rhs[(i % nb_nodes)*nb_dofs + i / nb_nodes] = y_e[i];
+
+      product.output().add_rhs_values(block_accumulator);
+    }
+  };
+};
+
+/// Grammar matching the matrix-free product with an element matrix
+template<typename GrammarT>
+struct ElementProductGrammar :
+  boost::proto::when
+  <
+    boost::proto::plus_assign< boost::proto::terminal< ElementProductImpl >, boost::proto::_ >,
+    ElementProductAccumulator( boost::proto::_expr, GrammarT(boost::proto::_right) )
+  >
+{
+};
+
+} // namespace Proto
+} // namespace actions
+} // namespace solver
+} // namespace cf3
+
+#endif // cf3_solver_actions_Proto_ElementProduct_hpp
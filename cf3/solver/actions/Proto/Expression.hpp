@@ -46,6 +46,8 @@ namespace Proto {
 class Expression
 {
 public:
+  Expression() : m_threaded(false) {}
+
   /// Run the stored expression in a loop over the region
   virtual void loop(mesh::Region& region) = 0;
 
@@ -65,7 +67,23 @@ public:
   /// value: space library name, to indicate what kind of field is expected
   virtual void insert_field_info(std::map<std::string, std::string>& tags) const = 0;
 
+  /// Allow the loop to run on the number of threads set in the Environment. This is only safe if the expression writes
+  /// exclusively to nodal or element fields and to linear systems, and has no other state shared between elements.
+  void set_threaded(const bool threaded)
+  {
+    m_threaded = threaded;
+  }
+
+  /// True if the loop may use multiple threads
+  bool threaded() const
+  {
+    return m_threaded;
+  }
+
   virtual ~Expression() {}
+
+protected:
+  bool m_threaded;
 };
 
 /// Boilerplate implementation
@@ -255,7 +273,7 @@ public:
     // Traverse all Elements under the region and evaluate the expression
     BOOST_FOREACH(mesh::Elements& elements, common::find_components_recursively<mesh::Elements>(region) )
     {
-      boost::mpl::for_each<boost::mpl::filter_view< ElementTypes, mesh::IsMinimalOrder<1> > >( ElementLooper<ElementTypes, typename BaseT::CopiedExprT>(elements, BaseT::m_expr, BaseT::m_variables) );
+      boost::mpl::for_each<boost::mpl::filter_view< ElementTypes, mesh::IsMinimalOrder<1> > >( ElementLooper<ElementTypes, typename BaseT::CopiedExprT>(elements, BaseT::m_expr, BaseT::m_variables, BaseT::m_threaded) );
     }
   }
 };
@@ -279,7 +297,7 @@ public:
       INVALID_NODE_EXPRESSION,
       (NodeGrammar));
 
-    boost::mpl::for_each< DimsT >( NodeLooper<typename BaseT::CopiedExprT>(BaseT::m_expr, region, BaseT::m_variables) );
+    boost::mpl::for_each< DimsT >( NodeLooper<typename BaseT::CopiedExprT>(BaseT::m_expr, region, BaseT::m_variables, BaseT::m_threaded) );
   }
 };
 
@@ -7,6 +7,8 @@
 #include "common/PE/Comm.hpp"
 #include "common/List.hpp"
 
+#include "mesh/Dictionary.hpp"
+
 #include "FieldSync.hpp"
 
 namespace cf3 {
@@ -32,52 +34,41 @@ void FieldSynchronizer::insert(mesh::Field& f, bool do_periodic_element_update)
 
 void FieldSynchronizer::synchronize()
 {
-  // Periodic update needed even in a sequential run
+  // Periodic update needed even in a sequential run. Fields are grouped per dictionary, so the inverse links are traversed only once
+  typedef std::map< std::string, std::vector<mesh::Field*> > DictFieldsT;
+  DictFieldsT periodic_fields;
   for(FieldsT::iterator field_it = m_fields.begin(); field_it != m_fields.end(); ++field_it)
   {
-    if(!field_it->second.second)
-      continue;
-    
-    mesh::Field& field = *field_it->second.first;
-    const mesh::Dictionary& dict = field.dict();
-    Handle< common::List<Uint> const > periodic_links_nodes_h(dict.get_child("periodic_links_nodes"));
-    Handle< common::List<bool> const > periodic_links_active_h(dict.get_child("periodic_links_active"));
-    if(is_not_null(periodic_links_nodes_h) && is_not_null(periodic_links_active_h))
+    if(field_it->second.second)
     {
-      const common::List<Uint>& periodic_links_nodes = *periodic_links_nodes_h;
-      const common::List<bool>& periodic_links_active = *periodic_links_active_h;
-      const Uint nb_nodes = periodic_links_nodes.size();
-      std::vector< std::vector<Uint> > inverse_periodic_links(nb_nodes);
-
-      for(Uint i = 0; i != nb_nodes; ++i)
-      {
-        if(periodic_links_active[i])
-        {
-          Uint final_target_node = periodic_links_nodes[i];
-          while(periodic_links_active[final_target_node])
-          {
-            final_target_node = periodic_links_nodes[final_target_node];
-          }
-          inverse_periodic_links[final_target_node].push_back(i);
-        }
-      }
-
-      const Uint row_size = field.row_size();
+      mesh::Field& field = *field_it->second.first;
+      periodic_fields[field.dict().uri().path()].push_back(&field);
+    }
+  }
 
-      for(Uint i = 0; i != nb_nodes; ++i)
+  for(DictFieldsT::iterator dict_it = periodic_fields.begin(); dict_it != periodic_fields.end(); ++dict_it)
+  {
+    const std::vector<mesh::Field*>& fields = dict_it->second;
+    const mesh::Dictionary::InversePeriodicLinks& inverse_links = fields.front()->dict().inverse_periodic_links();
+    const Uint nb_targets = inverse_links.targets.size();
+    const Uint nb_fields = fields.size();
+    for(Uint i = 0; i != nb_targets; ++i)
+    {
+      const Uint target = inverse_links.targets[i];
+      const Uint links_begin = inverse_links.offsets[i];
+      const Uint links_end = inverse_links.offsets[i+1];
+      for(Uint f = 0; f != nb_fields; ++f)
       {
-        const std::vector<Uint>& my_links = inverse_periodic_links[i];
-        const Uint nb_links = my_links.size();
-        if(nb_links == 0)
-          continue;
-        Eigen::Map<RealVector> my_row(&field[i][0], row_size);
-        for(Uint j = 0; j != nb_links; ++j)
+        mesh::Field& field = *fields[f];
+        const Uint row_size = field.row_size();
+        Eigen::Map<RealVector> my_row(&field[target][0], row_size);
+        for(Uint j = links_begin; j != links_end; ++j)
         {
-          my_row += Eigen::Map<RealVector>(&field[my_links[j]][0], row_size);
+          my_row += Eigen::Map<RealVector>(&field[inverse_links.nodes[j]][0], row_size);
         }
-        for(Uint j = 0; j != nb_links; ++j)
+        for(Uint j = links_begin; j != links_end; ++j)
         {
-          Eigen::Map<RealVector> other_row(&field[my_links[j]][0], row_size);
+          Eigen::Map<RealVector> other_row(&field[inverse_links.nodes[j]][0], row_size);
           other_row = my_row;
         }
       }
@@ -86,10 +77,14 @@ void FieldSynchronizer::synchronize()
   
   if(common::PE::Comm::instance().is_active())
   {
+    // Fields that share a comm pattern are sent together
+    std::vector< Handle<mesh::Field> > fields;
+    fields.reserve(m_fields.size());
     for(FieldsT::iterator field_it = m_fields.begin(); field_it != m_fields.end(); ++field_it)
     {
-      field_it->second.first->synchronize();
+      fields.push_back(field_it->second.first);
     }
+    mesh::synchronize_fields(fields);
   }
 
   m_fields.clear();
@@ -0,0 +1,70 @@
+// Copyright (C) 2010-2011 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include <boost/bind.hpp>
+#include <boost/foreach.hpp>
+
+#include "common/Core.hpp"
+#include "common/EventHandler.hpp"
+#include "common/FindComponents.hpp"
+
+#include "mesh/Entities.hpp"
+#include "mesh/Functions.hpp"
+#include "mesh/Tags.hpp"
+
+#include "NodeListCache.hpp"
+
+namespace cf3 {
+namespace solver {
+namespace actions {
+namespace Proto {
+
+NodeListCache::NodeListCache()
+{
+  common::Core::instance().event_handler().connect_to_event(mesh::Tags::event_mesh_loaded(), this, &NodeListCache::on_mesh_changed_event);
+  common::Core::instance().event_handler().connect_to_event(mesh::Tags::event_mesh_changed(), this, &NodeListCache::on_mesh_changed_event);
+}
+
+NodeListCache& NodeListCache::instance()
+{
+  static NodeListCache instance;
+  return instance;
+}
+
+const common::List<Uint>& NodeListCache::used_nodes(const mesh::Region& region, const mesh::Dictionary& dict)
+{
+  Entry& entry = m_lists[std::make_pair(region.uri().path(), dict.uri().path())];
+
+  // Also rebuild if the dictionary was resized without a mesh event
+  if(is_null(entry.nodes) || entry.dict_size != dict.size())
+  {
+    std::vector< Handle<mesh::Entities const> > used_entities;
+    BOOST_FOREACH(const mesh::Entities& entities, common::find_components_recursively<mesh::Entities>(region))
+    {
+      used_entities.push_back(entities.handle<mesh::Entities>());
+    }
+
+    entry.nodes = mesh::build_used_nodes_list(used_entities, dict, true);
+    entry.dict_size = dict.size();
+  }
+
+  return *entry.nodes;
+}
+
+void NodeListCache::clear()
+{
+  m_lists.clear();
+}
+
+void NodeListCache::on_mesh_changed_event(common::SignalArgs& args)
+{
+  clear();
+}
+
+} // namespace Proto
+} // namespace actions
+} // namespace solver
+} // namespace cf3
@@ -0,0 +1,64 @@
+// Copyright (C) 2010-2011 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_solver_actions_Proto_NodeListCache_hpp
+#define cf3_solver_actions_Proto_NodeListCache_hpp
+
+#include <map>
+
+#include <boost/shared_ptr.hpp>
+
+#include "common/ConnectionManager.hpp"
+#include "common/List.hpp"
+#include "common/SignalHandler.hpp"
+
+#include "mesh/Dictionary.hpp"
+#include "mesh/Region.hpp"
+
+/// @file
+/// Cache for the list of nodes used by a region, used by the node loops
+
+namespace cf3 {
+namespace solver {
+namespace actions {
+namespace Proto {
+
+/// Keeps the used node lists that were built for each (region, dictionary) pair, so they are only rebuilt after the mesh changes
+class NodeListCache : public common::ConnectionManager, public boost::noncopyable
+{
+public:
+  /// Singleton implementation
+  static NodeListCache& instance();
+
+  /// Get the nodes of dict that are used by the entities in region, including ghosts. The list is built if needed.
+  const common::List<Uint>& used_nodes(const mesh::Region& region, const mesh::Dictionary& dict);
+
+  /// Drop all stored lists
+  void clear();
+
+  /// Handler for the mesh_changed and mesh_loaded events
+  void on_mesh_changed_event(common::SignalArgs& args);
+
+private:
+  NodeListCache();
+
+  struct Entry
+  {
+    boost::shared_ptr< common::List<Uint> > nodes;
+    Uint dict_size;
+  };
+
+  // Lists are indexed by the path of the region, followed by the path of the dictionary
+  typedef std::map< std::pair<std::string, std::string>, Entry > ListsT;
+  ListsT m_lists;
+};
+
+} // namespace Proto
+} // namespace actions
+} // namespace solver
+} // namespace cf3
+
+#endif // cf3_solver_actions_Proto_NodeListCache_hpp
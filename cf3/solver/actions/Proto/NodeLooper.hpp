@@ -7,11 +7,16 @@
 #ifndef cf3_solver_actions_Proto_NodeLooper_hpp
 #define cf3_solver_actions_Proto_NodeLooper_hpp
 
+#include <boost/ptr_container/ptr_vector.hpp>
+
+#include "common/Threads.hpp"
+
 #include "mesh/Functions.hpp"
 
 #include "FieldSync.hpp"
 #include "NodeData.hpp"
 #include "NodeGrammar.hpp"
+#include "NodeListCache.hpp"
 
 /// @file
 /// Loop over the nodes for a region
@@ -40,10 +45,11 @@ struct NodeLooperDim
 
   typedef NodeData<VariablesT, NbDimsT> DataT;
 
-  NodeLooperDim(const ExprT& expr, mesh::Region& region, VariablesT& variables) :
+  NodeLooperDim(const ExprT& expr, mesh::Region& region, VariablesT& variables, const bool threaded = false) :
     m_expr(expr),
     m_region(region),
-    m_variables(variables)
+    m_variables(variables),
+    m_threaded(threaded)
   {
   }
 
@@ -137,28 +143,27 @@ struct NodeLooperDim
       dict = mesh.geometry_fields().handle<mesh::Dictionary>(); // fall back to the geometry if the dict is not found by tag
 
     const mesh::Field& coordinates = dict->coordinates();
+    const common::List<Uint>& nodes = NodeListCache::instance().used_nodes(m_region, *dict);
+
+    const Uint nb_threads = m_threaded ? common::nb_threads() : 1u;
+    if(nb_threads > 1)
+    {
+      run_threaded(nodes, coordinates, nb_threads);
+      return;
+    }
+
     DataT node_data(m_variables, m_region, coordinates, m_expr);
 
     // Wrap things up so that we can store the intermediate product results
-    do_run(WrapExpression()(m_expr, 0, node_data), node_data, *dict);
+    do_run(WrapExpression()(m_expr, 0, node_data), node_data, nodes);
   }
 
 private:
   template<typename FilteredExprT>
-  void do_run(const FilteredExprT& expr, DataT& data, const mesh::Dictionary& dict) const
+  void do_run(const FilteredExprT& expr, DataT& data, const common::List<Uint>& nodes) const
   {
     NodeGrammar grammar;
 
-    // Build a list of used entities
-    std::vector< Handle<mesh::Entities const> > used_entities;
-    BOOST_FOREACH(const mesh::Entities& entities, common::find_components_recursively<mesh::Entities>(m_region))
-    {
-      used_entities.push_back(entities.handle<mesh::Entities>());
-    }
-
-    boost::shared_ptr< common::List<Uint> > used_nodes_ptr = mesh::build_used_nodes_list(used_entities, dict, true);
-
-    const common::List<Uint>& nodes = *used_nodes_ptr;
     const Uint nb_nodes = nodes.size();
     for(Uint i = 0; i != nb_nodes; ++i)
     {
@@ -167,6 +172,53 @@ private:
     }
   }
 
+  void run_threaded(const common::List<Uint>& nodes, const mesh::Field& coordinates, const Uint nb_threads) const
+  {
+    // Each thread gets its own data. These are created and destroyed outside of the parallel region, since the destructor may communicate
+    boost::ptr_vector<DataT> thread_data;
+    for(Uint i = 0; i != nb_threads; ++i)
+      thread_data.push_back(new DataT(m_variables, m_region, coordinates, m_expr));
+
+    std::string error_message;
+
+    #pragma omp parallel num_threads(nb_threads)
+    {
+      DataT& data = thread_data[common::thread_id()];
+      // The wrapped expression stores intermediate results, so each thread needs its own
+      do_run_shared(WrapExpression()(m_expr, 0, data), data, nodes, error_message);
+    }
+
+    if(!error_message.empty())
+      throw common::ParallelError(FromHere(), "Threaded node loop over " + m_region.uri().path() + " failed: " + error_message);
+  }
+
+  /// Executed by each thread, the nodes are shared among the threads
+  template<typename FilteredExprT>
+  void do_run_shared(const FilteredExprT& expr, DataT& data, const common::List<Uint>& nodes, std::string& error_message) const
+  {
+    NodeGrammar grammar;
+
+    const int nb_nodes = nodes.size();
+    #pragma omp for schedule(static)
+    for(int i = 0; i < nb_nodes; ++i)
+    {
+      // Exceptions can't leave the parallel region, so the first error is recorded and rethrown afterwards
+      try
+      {
+        data.set_node(nodes[i]);
+        grammar(expr, 0, data);
+      }
+      catch(std::exception& e)
+      {
+        #pragma omp critical
+        {
+          if(error_message.empty())
+            error_message = e.what();
+        }
+      }
+    }
+  }
+
   struct FindDict
   {
     FindDict(const mesh::Mesh& mesh, Handle<mesh::Dictionary const>& dict) :m_mesh(mesh), m_dict(dict)
@@ -197,6 +249,7 @@ private:
   const ExprT& m_expr;
   mesh::Region& m_region;
   VariablesT& m_variables;
+  const bool m_threaded;
 };
 
 /// Loop over nodes, using static-sized vectors to store coordinates
@@ -206,10 +259,12 @@ struct NodeLooper
   /// Type of a fusion vector that can contain a copy of each variable that is used in the expression
   typedef typename ExpressionProperties<ExprT>::VariablesT VariablesT;
 
-  NodeLooper(const ExprT& expr, mesh::Region& region, VariablesT& variables) :
+  /// If threaded is true, the loop runs on the number of threads set in the Environment
+  NodeLooper(const ExprT& expr, mesh::Region& region, VariablesT& variables, const bool threaded = false) :
     m_expr(expr),
     m_region(region),
-    m_variables(variables)
+    m_variables(variables),
+    m_threaded(threaded)
   {
   }
 
@@ -223,7 +278,7 @@ struct NodeLooper
       return;
 
     // Execute with known dimension
-    NodeLooperDim<ExprT, NbDimsT>(m_expr, m_region, m_variables)();
+    NodeLooperDim<ExprT, NbDimsT>(m_expr, m_region, m_variables, m_threaded)();
 
     FieldSynchronizer::instance().synchronize();
   }
@@ -233,6 +288,7 @@ private:
   const ExprT& m_expr;
   mesh::Region& m_region;
   VariablesT& m_variables;
+  const bool m_threaded;
 };
 
 template<Uint dim, typename ExprT>
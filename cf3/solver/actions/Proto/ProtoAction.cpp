@@ -40,6 +40,17 @@ struct ProtoAction::Implementation
     m_physical_model(physical_model)
   {
     m_component.options().option(Tags::physical_model()).attach_trigger(boost::bind(&Implementation::trigger_physical_model, this));
+
+    m_component.options().add("threaded", false)
+      .pretty_name("Threaded")
+      .description("Run the loop on the number of threads set in the Environment. Only for expressions that write exclusively to fields and linear systems.")
+      .attach_trigger(boost::bind(&Implementation::trigger_threaded, this));
+  }
+
+  void trigger_threaded()
+  {
+    if(m_expression)
+      m_expression->set_threaded(m_component.options().value<bool>("threaded"));
   }
 
   void trigger_physical_model()
@@ -132,6 +143,7 @@ void ProtoAction::set_expression(const boost::shared_ptr< Expression >& expressi
   m_implementation->m_expression = expression;
   expression->add_options(options());
   m_implementation->trigger_physical_model();
+  m_implementation->trigger_threaded();
 }
 
 bool ProtoAction::expression_is_set() const
@@ -4,6 +4,9 @@
 // GNU Lesser General Public License version 3 (LGPLv3).
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
+#include <algorithm>
+#include <map>
+
 #include <boost/bind.hpp>
 #include <boost/function.hpp>
 
@@ -11,6 +14,9 @@
 #include "common/OptionList.hpp"
 #include "common/List.hpp"
 #include "common/BinaryDataReader.hpp"
+#include "common/Foreach.hpp"
+
+#include "common/PE/Comm.hpp"
 
 #include "common/XML/FileOperations.hpp"
 
@@ -38,6 +44,178 @@ common::ComponentBuilder < ReadRestartFile, common::Action, LibActions > ReadRes
 
 ///////////////////////////////////////////////////////////////////////////////////////
 
+namespace
+{
+
+/// Exchange variable-sized data between all processes
+template<typename T>
+void exchange(const std::vector< std::vector<T> >& send, std::vector< std::vector<T> >& recv)
+{
+  common::PE::Comm& comm = common::PE::Comm::instance();
+  if(comm.is_active())
+    comm.all_to_all(send, recv);
+  else
+    recv = send;
+}
+
+/// Moves the rows written by a different set of processes to the rows of a dictionary in the current partitioning.
+/// Each process reads the files of the writing ranks r for which r % nb_procs equals its own rank. The rows are then sent
+/// to a directory process, determined from the global index, where the processes owning the row in the current partitioning
+/// look them up.
+class RowRedistributor
+{
+public:
+  RowRedistributor(const std::vector< boost::shared_ptr<common::BinaryDataReader> >& readers, const Uint gids_block, const mesh::Dictionary& dict) :
+    m_readers(readers)
+  {
+    common::PE::Comm& comm = common::PE::Comm::instance();
+    const Uint nb_procs = comm.size();
+
+    // Send the global indices that were read to their directory process
+    boost::shared_ptr< common::List<Uint> > source_gids = common::allocate_component< common::List<Uint> >("SourceGids");
+    std::vector< std::vector<Uint> > send_gids(nb_procs);
+    BOOST_FOREACH(const boost::shared_ptr<common::BinaryDataReader>& reader, m_readers)
+    {
+      reader->read_list(*source_gids, gids_block);
+      BOOST_FOREACH(const Uint gid, source_gids->array())
+      {
+        m_row_directory.push_back(gid % nb_procs);
+        send_gids[gid % nb_procs].push_back(gid);
+      }
+    }
+    std::vector< std::vector<Uint> > directory_gids;
+    exchange(send_gids, directory_gids);
+
+    // Directory entries: global index, sending process and position in the data received from that process
+    std::vector<DirectoryEntry> directory;
+    for(Uint p = 0; p != nb_procs; ++p)
+    {
+      for(Uint i = 0; i != directory_gids[p].size(); ++i)
+        directory.push_back(DirectoryEntry(directory_gids[p][i], p, i));
+    }
+    std::sort(directory.begin(), directory.end());
+
+    // Request the rows of the current partitioning
+    const common::List<Uint>& gids = dict.glb_idx();
+    std::vector< std::vector<Uint> > send_requests(nb_procs);
+    m_request_directory.resize(gids.size());
+    for(Uint i = 0; i != gids.size(); ++i)
+    {
+      m_request_directory[i] = gids[i] % nb_procs;
+      send_requests[gids[i] % nb_procs].push_back(gids[i]);
+    }
+    std::vector< std::vector<Uint> > requests;
+    exchange(send_requests, requests);
+
+    Uint nb_missing = 0;
+    m_answers.resize(nb_procs);
+    for(Uint p = 0; p != nb_procs; ++p)
+    {
+      BOOST_FOREACH(const Uint gid, requests[p])
+      {
+        std::vector<DirectoryEntry>::const_iterator entry = std::lower_bound(directory.begin(), directory.end(), DirectoryEntry(gid, 0, 0));
+        if(entry == directory.end() || entry->gid != gid)
+        {
+          ++nb_missing;
+          m_answers[p].push_back(std::make_pair(0u, 0u));
+          continue;
+        }
+        m_answers[p].push_back(std::make_pair(entry->rank, entry->index));
+      }
+    }
+
+    if(comm.is_active())
+      comm.all_reduce(common::PE::plus(), &nb_missing, 1, &nb_missing);
+    if(nb_missing != 0)
+      throw common::SetupError(FromHere(), common::to_str(nb_missing) + " rows of dictionary " + dict.uri().path() + " were not found in the restart file");
+  }
+
+  /// Read the data from the given block into the field
+  void redistribute(const Uint block_idx, mesh::Field& field)
+  {
+    common::PE::Comm& comm = common::PE::Comm::instance();
+    const Uint nb_procs = m_answers.size();
+    const Uint nb_cols = field.row_size();
+
+    // Send the rows that were read to their directory process
+    boost::shared_ptr< common::Table<Real> > source_rows = common::allocate_component< common::Table<Real> >("SourceRows");
+    std::vector< std::vector<Real> > send_rows(nb_procs);
+    Uint source_row = 0;
+    // Flag and number of columns for rows that don't fit the field
+    int wrong_cols[2] = {0, 0};
+    BOOST_FOREACH(const boost::shared_ptr<common::BinaryDataReader>& reader, m_readers)
+    {
+      reader->read_table(*source_rows, block_idx);
+      if(source_rows->row_size() != nb_cols && source_rows->size() != 0)
+      {
+        wrong_cols[0] = 1;
+        wrong_cols[1] = source_rows->row_size();
+        break;
+      }
+      for(Uint i = 0; i != source_rows->size(); ++i, ++source_row)
+      {
+        std::vector<Real>& send = send_rows[m_row_directory[source_row]];
+        send.insert(send.end(), (*source_rows)[i].begin(), (*source_rows)[i].end());
+      }
+    }
+
+    // The files of only some processes may be wrong, so all processes must stop before the exchange
+    if(comm.is_active())
+      comm.all_reduce(common::PE::max(), wrong_cols, 2, wrong_cols);
+    if(wrong_cols[0] != 0)
+      throw common::SetupError(FromHere(), "Field " + field.uri().path() + " has " + common::to_str(nb_cols) + " columns, but " + common::to_str(wrong_cols[1]) + " were found in the restart file");
+
+    std::vector< std::vector<Real> > directory_rows;
+    exchange(send_rows, directory_rows);
+
+    // Answer the requests for the current partitioning
+    std::vector< std::vector<Real> > send_answers(nb_procs);
+    for(Uint p = 0; p != nb_procs; ++p)
+    {
+      send_answers[p].reserve(m_answers[p].size()*nb_cols);
+      for(Uint i = 0; i != m_answers[p].size(); ++i)
+      {
+        const Real* row = &directory_rows[m_answers[p][i].first][m_answers[p][i].second*nb_cols];
+        send_answers[p].insert(send_answers[p].end(), row, row + nb_cols);
+      }
+    }
+    std::vector< std::vector<Real> > answers;
+    exchange(send_answers, answers);
+
+    std::vector<Uint> answer_positions(nb_procs, 0);
+    for(Uint i = 0; i != m_request_directory.size(); ++i)
+    {
+      const Uint p = m_request_directory[i];
+      mesh::Field::Row row = field[i];
+      for(Uint j = 0; j != nb_cols; ++j)
+        row[j] = answers[p][answer_positions[p]++];
+    }
+  }
+
+private:
+  struct DirectoryEntry
+  {
+    DirectoryEntry(const Uint gid_, const Uint rank_, const Uint index_) : gid(gid_), rank(rank_), index(index_) {}
+    bool operator<(const DirectoryEntry& other) const { return gid < other.gid; }
+    Uint gid;
+    Uint rank;
+    Uint index;
+  };
+
+  const std::vector< boost::shared_ptr<common::BinaryDataReader> >& m_readers;
+
+  // Directory process for each row that was read
+  std::vector<Uint> m_row_directory;
+  // Directory process for each row of the dictionary
+  std::vector<Uint> m_request_directory;
+  // For each requesting process, the sending process and row index of each requested row
+  std::vector< std::vector< std::pair<Uint, Uint> > > m_answers;
+};
+
+}
+
+///////////////////////////////////////////////////////////////////////////////////////
+
 ReadRestartFile::ReadRestartFile ( const std::string& name ) :
   common::Action(name)
 {  
@@ -60,6 +238,10 @@ ReadRestartFile::ReadRestartFile ( const std::string& name ) :
     .pretty_name("Read  Time Settings")
     .description("Use the time step from the restart file")
     .mark_basic();
+
+  options().add("redistribute", false)
+    .pretty_name("Redistribute")
+    .description("Always match the rows by global index, even if the file was written with the current partitioning");
 }
 
 /////////////////////////////////////////////////////////////////////////////////////
@@ -88,24 +270,87 @@ void ReadRestartFile::execute()
     time->options().set("iteration", common::from_str<Uint>(restart_node.attribute_value("iteration")));
   }
 
-  if(common::from_str<Uint>(restart_node.attribute_value("version")) != 1)
+  const Uint version = common::from_str<Uint>(restart_node.attribute_value("version"));
+  if(version != 1 && version != 2)
     throw common::FileFormatError(FromHere(), "File  " + filepath.path() + " has unsupported version");
 
   common::PE::Comm& comm = common::PE::Comm::instance();
-  if(common::from_str<Uint>(restart_node.attribute_value("nb_procs")) != comm.size())
+  const Uint nb_written_procs = common::from_str<Uint>(restart_node.attribute_value("nb_procs"));
+  if(version == 1 && nb_written_procs != comm.size())
     throw common::SetupError(FromHere(), "File  " + filepath.path() + " was made for " + restart_node.attribute_value("nb_procs") + " CPUs, but we are loading on " + common::to_str(comm.size()) + " CPUs");
 
-  boost::shared_ptr<common::BinaryDataReader> data_reader = common::allocate_component<common::BinaryDataReader>("DataReader");
-  data_reader->options().set("file", common::URI(restart_node.attribute_value("binary_file")));
+  const common::URI binary_file(restart_node.attribute_value("binary_file"));
+
+  // Blocks with the global indices, for each dictionary
+  std::map<std::string, Uint> gid_blocks;
+  for(common::XML::XmlNode dict_node(restart_node.content->first_node("dictionary")); dict_node.is_valid(); dict_node.content = dict_node.content->next_sibling("dictionary"))
+    gid_blocks[dict_node.attribute_value("path")] = common::from_str<Uint>(dict_node.attribute_value("index"));
 
-  common::XML::XmlNode field_node = restart_node.content->first_node("field");
-  for(; field_node.is_valid(); field_node.content = field_node.content->next_sibling("field"))
+  std::vector< Handle<mesh::Field> > fields;
+  std::vector<Uint> field_blocks;
+  std::vector<std::string> field_dictionaries;
+  for(common::XML::XmlNode field_node(restart_node.content->first_node("field")); field_node.is_valid(); field_node.content = field_node.content->next_sibling("field"))
   {
     Handle<mesh::Field> field(mesh->access_component(common::URI(field_node.attribute_value("path"), common::URI::Scheme::CPATH)));
     if(is_null(field))
       throw common::SetupError(FromHere(), "Field " + field_node.attribute_value("path") + " was not found in mesh " + mesh->uri().path());
 
-    data_reader->read_table(*field, common::from_str<Uint>(field_node.attribute_value("index")));
+    fields.push_back(field);
+    field_blocks.push_back(common::from_str<Uint>(field_node.attribute_value("index")));
+    field_dictionaries.push_back(version == 1 ? std::string() : field_node.attribute_value("dictionary"));
+  }
+
+  // Rows can be read directly if the file was written with the same partitioning
+  bool same_partitioning = nb_written_procs == comm.size() && !options().value<bool>("redistribute");
+  if(same_partitioning && !gid_blocks.empty())
+  {
+    boost::shared_ptr<common::BinaryDataReader> data_reader = common::allocate_component<common::BinaryDataReader>("DataReader");
+    data_reader->options().set("file", binary_file);
+    boost::shared_ptr< common::List<Uint> > written_gids = common::allocate_component< common::List<Uint> >("WrittenGids");
+    int matching = 1;
+    for(std::map<std::string, Uint>::const_iterator it = gid_blocks.begin(); it != gid_blocks.end() && matching; ++it)
+    {
+      Handle<mesh::Dictionary> dict(mesh->access_component(common::URI(it->first, common::URI::Scheme::CPATH)));
+      if(is_null(dict))
+        continue;
+      data_reader->read_list(*written_gids, it->second);
+      matching = written_gids->array() == dict->glb_idx().array();
+    }
+    if(comm.is_active())
+      comm.all_reduce(common::PE::min(), &matching, 1, &matching);
+    same_partitioning = matching;
+  }
+
+  if(same_partitioning)
+  {
+    boost::shared_ptr<common::BinaryDataReader> data_reader = common::allocate_component<common::BinaryDataReader>("DataReader");
+    data_reader->options().set("file", binary_file);
+    for(Uint i = 0; i != fields.size(); ++i)
+      data_reader->read_table(*fields[i], field_blocks[i]);
+    return;
+  }
+
+  // Read the files written by the ranks assigned to this process, and match the rows by global index
+  std::vector< boost::shared_ptr<common::BinaryDataReader> > data_readers;
+  for(Uint rank = comm.rank(); rank < nb_written_procs; rank += comm.size())
+  {
+    boost::shared_ptr<common::BinaryDataReader> data_reader = common::allocate_component<common::BinaryDataReader>("DataReader");
+    data_reader->options().set("rank", rank);
+    data_reader->options().set("file", binary_file);
+    data_readers.push_back(data_reader);
+  }
+
+  std::map< std::string, boost::shared_ptr<RowRedistributor> > redistributors;
+  for(Uint i = 0; i != fields.size(); ++i)
+  {
+    const std::map<std::string, Uint>::const_iterator gid_block = gid_blocks.find(field_dictionaries[i]);
+    if(gid_block == gid_blocks.end())
+      throw common::SetupError(FromHere(), "File  " + filepath.path() + " has no global indices for field " + fields[i]->uri().path() + ", so it can only be read on the partitioning it was written with");
+
+    boost::shared_ptr<RowRedistributor>& redistributor = redistributors[gid_block->first];
+    if(is_null(redistributor))
+      redistributor.reset(new RowRedistributor(data_readers, gid_block->second, fields[i]->dict()));
+    redistributor->redistribute(field_blocks[i], *fields[i]);
   }
 }
 
@@ -18,7 +18,9 @@ namespace actions {
 
 ///////////////////////////////////////////////////////////////////////////////////////
 
-/// Read out a restartfile, designed to be loaded into an already-created mesh
+/// Read out a restartfile, designed to be loaded into an already-created mesh.
+/// Files written on a different number of processes (or with a different partitioning) are read by matching the rows
+/// using the global indices of the dictionaries that are stored in the file.
 class solver_actions_API ReadRestartFile : public common::Action
 {
 public: // functions
@@ -4,13 +4,19 @@
 // GNU Lesser General Public License version 3 (LGPLv3).
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
+#include <algorithm>
+#include <deque>
+
 #include <boost/bind.hpp>
 #include <boost/function.hpp>
+#include <boost/thread/thread.hpp>
 
 #include "common/Builder.hpp"
 #include "common/FindComponents.hpp"
 #include "common/OptionList.hpp"
 #include "common/List.hpp"
+#include "common/Log.hpp"
+#include "common/Signal.hpp"
 #include "common/BinaryDataWriter.hpp"
 #include "common/XML/FileOperations.hpp"
 
@@ -38,8 +44,154 @@ common::ComponentBuilder < WriteRestartFile, common::Action, LibActions > WriteR
 
 ///////////////////////////////////////////////////////////////////////////////////////
 
+namespace
+{
+  /// Path of the given component, relative to the given base path
+  std::string relative_path(const common::Component& component, const std::string& base_path)
+  {
+    std::string result = component.uri().path();
+    boost::replace_first(result, base_path, "");
+    cf3_assert(result.size() == component.uri().path().size() - base_path.size());
+    return result;
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////////////
+
+class WriteRestartFile::Implementation
+{
+public:
+  /// All data needed to write a single restart file
+  struct Snapshot
+  {
+    /// Raw data for a single block in the binary file
+    struct DataBlock
+    {
+      /// Name of the XML node describing the block, i.e. "field" or "dictionary"
+      std::string node_name;
+      /// Path relative to the mesh
+      std::string path;
+      std::string name;
+      /// Path of the dictionary holding the global indices of the rows of a field, empty if there is none
+      std::string dictionary;
+      std::string type_name;
+      Uint nb_rows;
+      Uint nb_cols;
+      Uint nb_bytes;
+      Uint element_size;
+      const char* data;
+      std::vector<char> staging_buffer;
+      std::pair<Uint, Uint> block_range;
+    };
+
+    common::URI file;
+    common::URI binfile;
+    Real current_time;
+    Real time_step;
+    Uint iteration;
+    std::vector<DataBlock> blocks;
+    boost::shared_ptr<common::BinaryDataWriter> data_writer;
+    boost::thread thread;
+    std::string error;
+
+    /// Copy the field data into the staging buffers, so the fields may change while writing
+    void stage()
+    {
+      BOOST_FOREACH(DataBlock& block, blocks)
+      {
+        block.staging_buffer.assign(block.data, block.data + block.nb_bytes);
+        block.data = block.staging_buffer.empty() ? 0 : &block.staging_buffer[0];
+      }
+    }
+
+    /// Compress and write the data to the file of this process. No communication takes place here.
+    void write_local()
+    {
+      try
+      {
+        BOOST_FOREACH(DataBlock& block, blocks)
+        {
+          block.block_range = data_writer->write_local_block(block.data, block.nb_bytes, block.element_size);
+          std::vector<char>().swap(block.staging_buffer);
+        }
+      }
+      catch(std::exception& e)
+      {
+        error = e.what();
+      }
+    }
+
+    /// Wait for the local writing to end and build the index of the binary file and the restart file. This is collective.
+    void complete()
+    {
+      if(thread.joinable())
+        thread.join();
+
+      // The index is built even after an error, so all processes take part in the same collective operations
+      common::PE::Comm& comm = common::PE::Comm::instance();
+      common::XML::XmlDoc xml_doc("1.0", "ISO-8859-1");
+      common::XML::XmlNode restart_node = xml_doc.add_node("restart");
+      restart_node.set_attribute("version", "2");
+      restart_node.set_attribute("binary_file", binfile.path());
+      restart_node.set_attribute("nb_procs", common::to_str(comm.size()));
+      restart_node.set_attribute("current_time", common::to_str(current_time));
+      restart_node.set_attribute("time_step", common::to_str(time_step));
+      restart_node.set_attribute("iteration", common::to_str(iteration));
+
+      BOOST_FOREACH(const DataBlock& block, blocks)
+      {
+        common::XML::XmlNode block_node = restart_node.add_node(block.node_name);
+        block_node.set_attribute("path", block.path);
+        block_node.set_attribute("index", common::to_str(data_writer->register_block(block.name, block.nb_rows, block.nb_cols, block.type_name, block.block_range)));
+        if(!block.dictionary.empty())
+          block_node.set_attribute("dictionary", block.dictionary);
+      }
+      data_writer->close();
+
+      if(!error.empty())
+        throw common::FileSystemError(FromHere(), "Error writing restart data to " + binfile.path() + ": " + error);
+
+      if(comm.rank() == 0)
+        common::XML::to_file(xml_doc, file);
+    }
+  };
+
+  /// Complete the oldest pending write
+  void complete_first()
+  {
+    cf3_assert(!pending.empty());
+    boost::shared_ptr<Snapshot> snapshot = pending.front();
+    pending.pop_front();
+    snapshot->complete();
+  }
+
+  void complete_all()
+  {
+    while(!pending.empty())
+      complete_first();
+  }
+
+  /// Drop all pending writes, waiting only for the local threads
+  void discard_all()
+  {
+    BOOST_FOREACH(const boost::shared_ptr<Snapshot>& snapshot, pending)
+    {
+      if(snapshot->thread.joinable())
+        snapshot->thread.join();
+      snapshot->data_writer->discard();
+    }
+    pending.clear();
+  }
+
+  /// Asynchronous writes in the order they were started
+  std::deque< boost::shared_ptr<Snapshot> > pending;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////
+
 WriteRestartFile::WriteRestartFile ( const std::string& name ) :
-  common::Action(name)
+  common::Action(name),
+  m_implementation(new Implementation())
 {
   options().add("fields", std::vector< Handle<mesh::Field> >())
     .pretty_name("Fields")
@@ -55,14 +207,38 @@ WriteRestartFile::WriteRestartFile ( const std::string& name ) :
     .pretty_name("Time")
     .description("Time component, used to extract timing and iteration information")
     .mark_basic();
+
+  options().add("asynchronous", false)
+    .pretty_name("Asynchronous")
+    .description("Copy the fields and compress and write them on a background thread, so the solver can continue");
+
+  options().add("max_pending_writes", 1u)
+    .pretty_name("Max Pending Writes")
+    .description("Maximum number of asynchronous writes in progress. When exceeded, execute waits for the oldest one to complete");
+
+  options().add("nb_files", 0u)
+    .pretty_name("Number of Files")
+    .description("Number of binary files shared by all processes. The default of 0 writes one binary file per process");
+
+  regist_signal( "wait" )
+    .description("Complete all pending asynchronous writes")
+    .pretty_name("Wait")
+    .connect( boost::bind( &WriteRestartFile::signal_wait, this, _1 ) );
+}
+
+WriteRestartFile::~WriteRestartFile()
+{
+  if(m_implementation->pending.empty())
+    return;
+
+  CFerror << "WriteRestartFile " << name() << " destroyed with " << m_implementation->pending.size() << " pending writes. Call wait before destroying it to complete them." << CFendl;
+  m_implementation->discard_all();
 }
 
 /////////////////////////////////////////////////////////////////////////////////////
 
 void WriteRestartFile::execute()
 {
-  common::PE::Comm& comm = common::PE::Comm::instance();
-  
   std::vector< Handle<mesh::Field> > fields = options().value< std::vector< Handle<mesh::Field> > >("fields");
   if(fields.empty())
     throw common::SetupError(FromHere(), "No fields configured");
@@ -81,35 +257,110 @@ void WriteRestartFile::execute()
     mesh = parent_mesh;
   }
   cf3_assert(is_not_null(mesh));
-  
+
+  const bool asynchronous = options().value<bool>("asynchronous");
   const common::URI out_file_path = options().value<common::URI>("file");
-  const common::URI binfile = out_file_path.base_path() / (out_file_path.base_name() + ".cfbinxml");
-  boost::shared_ptr<common::BinaryDataWriter> data_writer = common::allocate_component<common::BinaryDataWriter>("DataWriter");
-  data_writer->options().set("file", binfile);
+
+  // A file that is still being written must be completed before it can be overwritten
+  std::deque< boost::shared_ptr<Implementation::Snapshot> >& pending = m_implementation->pending;
+  for(Uint i = 0; i != pending.size(); ++i)
+  {
+    if(pending[i]->file == out_file_path)
+    {
+      for(Uint j = 0; j <= i; ++j)
+        m_implementation->complete_first();
+      break;
+    }
+  }
+
+  if(asynchronous)
+  {
+    const Uint max_pending = std::max(options().value<Uint>("max_pending_writes"), 1u);
+    while(pending.size() >= max_pending)
+      m_implementation->complete_first();
+  }
   
-  common::XML::XmlDoc xml_doc("1.0", "ISO-8859-1");
-  common::XML::XmlNode restart_node = xml_doc.add_node("restart");
-  restart_node.set_attribute("version", "1");
-  restart_node.set_attribute("binary_file", binfile.path());
-  restart_node.set_attribute("nb_procs", common::to_str(comm.size()));
-  restart_node.set_attribute("current_time", common::to_str(time->current_time()));
-  restart_node.set_attribute("time_step", common::to_str(time->dt()));
-  restart_node.set_attribute("iteration", common::to_str(time->iter()));
+  boost::shared_ptr<Implementation::Snapshot> snapshot(new Implementation::Snapshot());
+  snapshot->file = out_file_path;
+  snapshot->binfile = out_file_path.base_path() / (out_file_path.base_name() + ".cfbinxml");
+  snapshot->current_time = time->current_time();
+  snapshot->time_step = time->dt();
+  snapshot->iteration = time->iter();
+  snapshot->data_writer = common::allocate_component<common::BinaryDataWriter>("DataWriter");
+  snapshot->data_writer->options().set("nb_files", options().value<Uint>("nb_files"));
+  snapshot->data_writer->options().set("file", snapshot->binfile);
+  snapshot->data_writer->open();
   
   const std::string base_path = mesh->uri().path() + "/";
-  
+
+  // The global indices of the dictionaries are stored as well, so the rows can be matched when reading on a different number of processes
+  std::vector<const mesh::Dictionary*> dictionaries;
   BOOST_FOREACH(const Handle<mesh::Field>& field, fields)
   {
-    common::XML::XmlNode field_node = restart_node.add_node("field");
-    std::string relative_path = field->uri().path();
-    boost::replace_first(relative_path, base_path, "");
-    cf3_assert(relative_path.size() == field->uri().path().size() - base_path.size());
-    field_node.set_attribute("path", relative_path);
-    field_node.set_attribute("index", common::to_str(data_writer->append_data(*field)));
+    const mesh::Dictionary& dict = field->dict();
+    if(dict.glb_idx().size() == dict.size() && std::find(dictionaries.begin(), dictionaries.end(), &dict) == dictionaries.end())
+      dictionaries.push_back(&dict);
   }
 
-  if(comm.rank() == 0)
-    common::XML::to_file(xml_doc, out_file_path);
+  BOOST_FOREACH(const mesh::Dictionary* dict, dictionaries)
+  {
+    Implementation::Snapshot::DataBlock block;
+    block.node_name = "dictionary";
+    block.path = relative_path(*dict, base_path);
+    block.name = dict->glb_idx().name();
+    block.type_name = common::class_name<Uint>();
+    block.nb_rows = dict->size();
+    block.nb_cols = 1;
+    block.nb_bytes = sizeof(Uint)*block.nb_rows;
+    block.element_size = sizeof(Uint);
+    block.data = reinterpret_cast<const char*>(dict->glb_idx().array().data());
+    snapshot->blocks.push_back(block);
+  }
+
+  BOOST_FOREACH(const Handle<mesh::Field>& field, fields)
+  {
+    Implementation::Snapshot::DataBlock block;
+    block.node_name = "field";
+    block.path = relative_path(*field, base_path);
+    if(std::find(dictionaries.begin(), dictionaries.end(), &field->dict()) != dictionaries.end())
+      block.dictionary = relative_path(field->dict(), base_path);
+    block.name = field->name();
+    block.type_name = common::class_name<Real>();
+    block.nb_rows = field->size();
+    block.nb_cols = field->row_size();
+    block.nb_bytes = sizeof(Real)*block.nb_rows*block.nb_cols;
+    block.element_size = sizeof(Real);
+    block.data = reinterpret_cast<const char*>(field->array().data());
+    snapshot->blocks.push_back(block);
+  }
+
+  if(!asynchronous)
+  {
+    snapshot->write_local();
+    snapshot->complete();
+    return;
+  }
+
+  snapshot->stage();
+  snapshot->thread = boost::thread(boost::bind(&Implementation::Snapshot::write_local, snapshot.get()));
+  pending.push_back(snapshot);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+void WriteRestartFile::wait()
+{
+  m_implementation->complete_all();
+}
+
+Uint WriteRestartFile::nb_pending_writes() const
+{
+  return m_implementation->pending.size();
+}
+
+void WriteRestartFile::signal_wait(common::SignalArgs& args)
+{
+  wait();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -7,6 +7,8 @@
 #ifndef cf3_solver_actions_WriteRestartFile_hpp
 #define cf3_solver_actions_WriteRestartFile_hpp
 
+#include <boost/scoped_ptr.hpp>
+
 #include "common/Action.hpp"
 #include "solver/actions/LibActions.hpp"
 
@@ -18,7 +20,12 @@ namespace actions {
 
 ///////////////////////////////////////////////////////////////////////////////////////
 
-/// Write out a restartfile, designed to be loaded into an already-created mesh
+/// Write out a restartfile, designed to be loaded into an already-created mesh.
+/// The global indices of the dictionaries of the fields are written as well, so the file can be read back on a different number of processes.
+/// When the option "asynchronous" is set, execute only copies the fields into a staging buffer, and the
+/// compression and writing of the data happens on a background thread. The index of the file is completed
+/// (collectively) when the number of unfinished writes exceeds "max_pending_writes", or when wait is called.
+/// Since wait is collective, it must be called explicitly before the component is destroyed.
 class solver_actions_API WriteRestartFile : public common::Action
 {
 public: // functions
@@ -26,14 +33,26 @@ public: // functions
   /// @param name of the component
   WriteRestartFile ( const std::string& name );
 
-  /// Virtual destructor
-  virtual ~WriteRestartFile() {}
+  /// Virtual destructor. Pending writes are not completed here, since that would require communication, so their files are discarded with an error message
+  virtual ~WriteRestartFile();
 
   /// Get the class name
   static std::string type_name () { return "WriteRestartFile"; }
 
   /// execute the action
   virtual void execute ();
+
+  /// Complete all pending asynchronous writes. This is collective, and must be called before MPI is finalized
+  void wait();
+
+  /// Number of asynchronous writes that are not completed yet
+  Uint nb_pending_writes() const;
+
+private:
+  void signal_wait(common::SignalArgs& args);
+
+  class Implementation;
+  boost::scoped_ptr<Implementation> m_implementation;
 };
 
 /////////////////////////////////////////////////////////////////////////////////////
@@ -14,6 +14,7 @@
 #include "common/OptionList.hpp"
 #include "common/List.hpp"
 
+#include "math/Consts.hpp"
 #include "math/VariablesDescriptor.hpp"
 
 #include "mesh/ConnectivityData.hpp"
@@ -211,10 +212,11 @@ void YPlus::execute()
       const Uint wall_field_idx = wall_entities.space(wall_P0).connectivity()[node_to_wall_element[node_idx][2]][0];
       yplus_field[node_idx][0] = wall_distance_field[node_idx][0] * sqrt(nu*wall_velocity_gradient_field[wall_field_idx][0]) / nu;
     }
-    else
+    else if(node_to_wall_element[node_idx][1] != math::Consts::uint_max())
     {
       yplus_field[node_idx][0] = wall_distance_field[node_idx][0] * sqrt(nu*wall_velocity_gradient_field_nodal[node_to_wall_element[node_idx][1]][0]) / nu;
     }
+    // Otherwise the closest wall node is on another process (distributed wall distance), and the wall velocity gradient is not known here
   }
 }
 
@@ -23,6 +23,8 @@ option( CF3_ENABLE_GPU                "Enable GPU computing    (if available)"
 option( CF3_ENABLE_CUDA               "Enable CUDA for GPGPU   (if available)"         ON  )
 option( CF3_ENABLE_OPENCL             "Enable OpenCL for GPGPU (if available)"         ON  )
 
+option( CF3_ENABLE_OPENMP             "Enable OpenMP for shared-memory parallel loops" OFF )
+
 option( CF3_ENABLE_TCMALLOC           "Google tcmalloc (can be faster, but buggy)"     OFF )
 
 option( CF3_ENABLE_STDDEBUG           "Enable debug of STL code"                       OFF )
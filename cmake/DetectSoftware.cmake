@@ -56,6 +56,18 @@ find_package(Valgrind          QUIET ) # valgrind for profiling and memmory leak
 find_package(GooglePerftools   QUIET ) # dynamic profiler and memory checker
 find_package(PThread           QUIET ) # POSIX Threads library
 
+# OpenMP threading for the loops that support it
+
+if( CF3_ENABLE_OPENMP )
+  find_package(OpenMP QUIET)
+  coolfluid_log_file( "OPENMP_FOUND: [${OPENMP_FOUND}]" )
+  if( OPENMP_FOUND )
+    set( CMAKE_C_FLAGS   "${CMAKE_C_FLAGS} ${OpenMP_C_FLAGS}" )
+    set( CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} ${OpenMP_CXX_FLAGS}" )
+  endif()
+  coolfluid_set_feature( OpenMP "${OPENMP_FOUND}" "shared-memory parallel loops" )
+endif()
+
 # packages that enhance functionality
 # this will appear on the list of enabled features
 
@@ -43,6 +43,16 @@ using namespace solver::actions::Proto;
 
 common::ComponentBuilder < LSSAction, common::ActionDirector, LibUFEM > LSSAction_Builder;
 
+namespace
+{
+  template<typename T>
+  void copy_list(const List<T>& from, List<T>& to)
+  {
+    to.resize(from.size());
+    std::copy(from.array().begin(), from.array().end(), to.array().begin());
+  }
+}
+
 struct LSSAction::Implementation
 {
   Implementation(Component& comp) :
@@ -216,12 +226,20 @@ void LSSAction::on_regions_set()
 
     CFdebug << "Creating LSS for " << uri().path() << " using dictionary " << m_dictionary->uri().path() << CFendl;
 
+    // The sparsity is shared with the other systems on the same regions and dictionary, and only the lists are copied
+    boost::shared_ptr<SparsityData const> sparsity = SparsityCache::instance().sparsity(m_loop_regions, *m_dictionary);
+    const std::vector<Uint>& node_connectivity = sparsity->node_connectivity;
+    const std::vector<Uint>& starting_indices = sparsity->start_indices;
+
     Handle< List<Uint> > gids = m_implementation->m_lss->create_component< List<Uint> >("GIDs");
     Handle< List<Uint> > ranks = m_implementation->m_lss->create_component< List<Uint> >("Ranks");
     Handle< List<int> > used_node_map = m_implementation->m_lss->create_component< List<int> >("used_node_map");
+    copy_list(*sparsity->gids, *gids);
+    copy_list(*sparsity->ranks, *ranks);
+    copy_list(*sparsity->used_node_map, *used_node_map);
 
-    std::vector<Uint> node_connectivity, starting_indices;
-    boost::shared_ptr< List<Uint> > used_nodes = build_sparsity(m_loop_regions, *m_dictionary, node_connectivity, starting_indices, *gids, *ranks, *used_node_map);
+    boost::shared_ptr< List<Uint> > used_nodes = allocate_component< List<Uint> >(sparsity->used_nodes->name());
+    copy_list(*sparsity->used_nodes, *used_nodes);
     if(is_not_null(get_child(used_nodes->name())))
       remove_component(used_nodes->name());
     add_component(used_nodes);
@@ -367,7 +385,7 @@ void LSSAction::on_initial_conditions_set(InitialConditions& initial_conditions)
 {
 }
 
-void LSSAction::do_create_lss(PE::CommPattern &cp, const VariablesDescriptor &vars, std::vector<Uint> &node_connectivity, std::vector<Uint> &starting_indices, const std::vector<Uint> &periodic_links_nodes, const std::vector<bool> &periodic_links_active)
+void LSSAction::do_create_lss(PE::CommPattern &cp, const VariablesDescriptor &vars, const std::vector<Uint> &node_connectivity, const std::vector<Uint> &starting_indices, const std::vector<Uint> &periodic_links_nodes, const std::vector<bool> &periodic_links_active)
 {
   const bool blocked_system = options().option("blocked_system").value<bool>();
   if(blocked_system)
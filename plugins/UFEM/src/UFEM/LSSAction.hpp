@@ -96,7 +96,7 @@ protected:
   virtual void on_initial_conditions_set(InitialConditions& initial_conditions);
 
   /// Called to actually create the LSS. Parameters are described in the LSS interface
-  virtual void do_create_lss(common::PE::CommPattern& cp, const math::VariablesDescriptor& vars, std::vector<Uint>& node_connectivity, std::vector<Uint>& starting_indices, const std::vector<Uint>& periodic_links_nodes, const std::vector<bool>& periodic_links_active);
+  virtual void do_create_lss(common::PE::CommPattern& cp, const math::VariablesDescriptor& vars, const std::vector<Uint>& node_connectivity, const std::vector<Uint>& starting_indices, const std::vector<Uint>& periodic_links_nodes, const std::vector<bool>& periodic_links_active);
 
 public:
   /// Proto placeholder for the system matrix
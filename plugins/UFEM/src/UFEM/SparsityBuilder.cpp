@@ -6,6 +6,8 @@
 
 #include <set>
 
+#include "common/Core.hpp"
+#include "common/EventHandler.hpp"
 #include "common/FindComponents.hpp"
 #include "common/List.hpp"
 #include "common/PE/Comm.hpp"
@@ -191,6 +193,58 @@ boost::shared_ptr< List<Uint> > build_sparsity(const std::vector< Handle<Region>
   return used_nodes_ptr;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+
+SparsityCache::SparsityCache()
+{
+  Core::instance().event_handler().connect_to_event(mesh::Tags::event_mesh_loaded(), this, &SparsityCache::on_mesh_changed_event);
+  Core::instance().event_handler().connect_to_event(mesh::Tags::event_mesh_changed(), this, &SparsityCache::on_mesh_changed_event);
+}
+
+SparsityCache& SparsityCache::instance()
+{
+  static SparsityCache instance;
+  return instance;
+}
+
+boost::shared_ptr<SparsityData const> SparsityCache::sparsity(const std::vector< Handle<Region> >& regions, const Dictionary& dictionary)
+{
+  std::vector<std::string> region_paths;
+  BOOST_FOREACH(const Handle<Region>& region, regions)
+  {
+    region_paths.push_back(region->uri().path());
+  }
+  Entry& entry = m_entries[std::make_pair(region_paths, dictionary.uri().path())];
+
+  // Also rebuild if the dictionary was resized without a mesh event. Building the sparsity is collective,
+  // so all processes must agree on rebuilding it
+  int rebuild = (is_null(entry.data) || entry.dict_size != dictionary.size()) ? 1 : 0;
+  if(PE::Comm::instance().is_active())
+    PE::Comm::instance().all_reduce(PE::max(), &rebuild, 1, &rebuild);
+  if(rebuild)
+  {
+    boost::shared_ptr<SparsityData> data(new SparsityData());
+    data->gids = allocate_component< List<Uint> >("GIDs");
+    data->ranks = allocate_component< List<Uint> >("Ranks");
+    data->used_node_map = allocate_component< List<int> >("used_node_map");
+    data->used_nodes = build_sparsity(regions, dictionary, data->node_connectivity, data->start_indices, *data->gids, *data->ranks, *data->used_node_map);
+    entry.data = data;
+    entry.dict_size = dictionary.size();
+  }
+
+  return entry.data;
+}
+
+void SparsityCache::clear()
+{
+  m_entries.clear();
+}
+
+void SparsityCache::on_mesh_changed_event(SignalArgs& args)
+{
+  clear();
+}
+
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -7,6 +7,16 @@
 #ifndef cf3_UFEM_SparsityBuilder_hpp
 #define cf3_UFEM_SparsityBuilder_hpp
 
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "common/ConnectionManager.hpp"
+#include "common/SignalHandler.hpp"
+
 #include "UFEM/LibUFEM.hpp"
 
 namespace cf3 {
@@ -30,6 +40,49 @@ namespace UFEM {
 /// Size is number of nodes + 1, so the last item is the size of node_connectivity
 UFEM_API boost::shared_ptr< common::List< Uint > > build_sparsity(const std::vector< Handle<mesh::Region> >& regions, const mesh::Dictionary& dictionary, std::vector<Uint>& node_connectivity, std::vector<Uint>& start_indices, common::List<Uint>& gids, common::List<Uint>& ranks, common::List<int>& used_node_map);
 
+/// Result of build_sparsity, shared by all linear systems that are built on the same regions and dictionary
+struct UFEM_API SparsityData
+{
+  boost::shared_ptr< common::List<Uint> > used_nodes;
+  boost::shared_ptr< common::List<Uint> > gids;
+  boost::shared_ptr< common::List<Uint> > ranks;
+  boost::shared_ptr< common::List<int> > used_node_map;
+  std::vector<Uint> node_connectivity;
+  std::vector<Uint> start_indices;
+};
+
+/// Keeps the sparsity that was built for each set of regions and dictionary, so solvers that create
+/// several systems on the same mesh (velocity, pressure, scalars, ...) only build it once.
+/// Everything is dropped when the mesh changes.
+class UFEM_API SparsityCache : public common::ConnectionManager, public boost::noncopyable
+{
+public:
+  /// Singleton implementation
+  static SparsityCache& instance();
+
+  /// Get the sparsity for the given regions and dictionary, building it if needed. This is collective.
+  boost::shared_ptr<SparsityData const> sparsity(const std::vector< Handle<mesh::Region> >& regions, const mesh::Dictionary& dictionary);
+
+  /// Drop all stored sparsity data
+  void clear();
+
+  /// Handler for the mesh_changed and mesh_loaded events
+  void on_mesh_changed_event(common::SignalArgs& args);
+
+private:
+  SparsityCache();
+
+  struct Entry
+  {
+    boost::shared_ptr<SparsityData const> data;
+    Uint dict_size;
+  };
+
+  // Entries are indexed by the paths of the regions, followed by the path of the dictionary
+  typedef std::map< std::pair<std::vector<std::string>, std::string>, Entry > EntriesT;
+  EntriesT m_entries;
+};
+
 ////////////////////////////////////////////////////////////////////////////////////////////
 
 } // UFEM
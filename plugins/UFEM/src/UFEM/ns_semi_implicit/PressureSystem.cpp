@@ -48,7 +48,7 @@ PressureSystem::~PressureSystem()
 {
 }
 
-void PressureSystem::do_create_lss(common::PE::CommPattern &cp, const math::VariablesDescriptor &vars, std::vector<Uint> &node_connectivity, std::vector<Uint> &starting_indices, const std::vector<Uint> &periodic_links_nodes, const std::vector<bool> &periodic_links_active)
+void PressureSystem::do_create_lss(common::PE::CommPattern &cp, const math::VariablesDescriptor &vars, const std::vector<Uint> &node_connectivity, const std::vector<Uint> &starting_indices, const std::vector<Uint> &periodic_links_nodes, const std::vector<bool> &periodic_links_active)
 {
   // Due to simplification, no special sparsity is needed for the pressure LSS
   LSSActionUnsteady::do_create_lss(cp, vars, node_connectivity, starting_indices, periodic_links_nodes, periodic_links_active);
@@ -196,7 +196,7 @@ PressureSystem::~PressureSystem()
 {
 }
 
-void PressureSystem::do_create_lss(common::PE::CommPattern &cp, const math::VariablesDescriptor &vars, std::vector<Uint> &node_connectivity, std::vector<Uint> &starting_indices, const std::vector<Uint> &periodic_links_nodes, const std::vector<bool> &periodic_links_active)
+void PressureSystem::do_create_lss(common::PE::CommPattern &cp, const math::VariablesDescriptor &vars, const std::vector<Uint> &node_connectivity, const std::vector<Uint> &starting_indices, const std::vector<Uint> &periodic_links_nodes, const std::vector<bool> &periodic_links_active)
 {
   const Uint nb_nodes = starting_indices.size()-1;
   cf3_assert(starting_indices.back() == node_connectivity.size());
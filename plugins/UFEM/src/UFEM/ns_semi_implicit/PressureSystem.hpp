@@ -32,7 +32,7 @@ public: // functions
   static std::string type_name () { return "PressureSystem"; }
 
 private:
-  virtual void do_create_lss(common::PE::CommPattern &cp, const math::VariablesDescriptor &vars, std::vector<Uint> &node_connectivity, std::vector<Uint> &starting_indices, const std::vector<Uint> &periodic_links_nodes, const std::vector<bool> &periodic_links_active);
+  virtual void do_create_lss(common::PE::CommPattern &cp, const math::VariablesDescriptor &vars, const std::vector<Uint> &node_connectivity, const std::vector<Uint> &starting_indices, const std::vector<Uint> &periodic_links_nodes, const std::vector<bool> &periodic_links_active);
 };
 
 } // UFEM
@@ -16,6 +16,7 @@
 #include "common/PE/CommPattern.hpp"
 
 #include "math/LSS/System.hpp"
+#include "math/LSS/Trilinos/TrilinosCrsMatrix.hpp"
 
 #include "mesh/Domain.hpp"
 #include "mesh/LagrangeP1/Line1D.hpp"
@@ -354,6 +355,44 @@ BOOST_AUTO_TEST_CASE( Heat1DComponent )
   lss.matrix()->print("utest-ufem-buildsparsity_heat_matrix_1DHeat.plt");
 }
 
+BOOST_AUTO_TEST_CASE( SharedSparsity )
+{
+  Model& model = *root.create_component<Model>("SharedModel");
+  Domain& domain = model.create_domain("Domain");
+  Mesh& mesh = *domain.create_component<Mesh>("Mesh");
+  Tools::MeshGeneration::create_rectangle(mesh, 5., 5., 5, 5);
+  const std::vector< Handle<Region> > regions(1, mesh.topology().handle<Region>());
+
+  // The sparsity is only built once, until the mesh changes
+  boost::shared_ptr<UFEM::SparsityData const> sparsity = UFEM::SparsityCache::instance().sparsity(regions, mesh.geometry_fields());
+  BOOST_CHECK(sparsity == UFEM::SparsityCache::instance().sparsity(regions, mesh.geometry_fields()));
+  mesh.raise_mesh_changed();
+  BOOST_CHECK(sparsity != UFEM::SparsityCache::instance().sparsity(regions, mesh.geometry_fields()));
+  sparsity = UFEM::SparsityCache::instance().sparsity(regions, mesh.geometry_fields());
+
+  // Building is collective, so a miss on one process makes all of them rebuild
+  if(PE::Comm::instance().rank() == 0)
+    UFEM::SparsityCache::instance().clear();
+  BOOST_CHECK(sparsity != UFEM::SparsityCache::instance().sparsity(regions, mesh.geometry_fields()));
+  sparsity = UFEM::SparsityCache::instance().sparsity(regions, mesh.geometry_fields());
+
+  PE::CommPattern& comm_pattern = *domain.create_component<PE::CommPattern>("CommPattern");
+  comm_pattern.insert("gid",sparsity->gids->array(),false);
+  comm_pattern.setup(Handle<PE::CommWrapper>(comm_pattern.get_child("gid")),sparsity->ranks->array());
+
+  // Matrices with the same sparsity and number of equations share their graph
+  LSS::System& lss_a = *model.create_component<LSS::System>("LSSA");
+  LSS::System& lss_b = *model.create_component<LSS::System>("LSSB");
+  lss_a.options().option("matrix_builder").change_value(std::string("cf3.math.LSS.TrilinosCrsMatrix"));
+  lss_b.options().option("matrix_builder").change_value(std::string("cf3.math.LSS.TrilinosCrsMatrix"));
+  lss_a.create(comm_pattern, 2u, sparsity->node_connectivity, sparsity->start_indices);
+  lss_b.create(comm_pattern, 2u, sparsity->node_connectivity, sparsity->start_indices);
+
+  Handle<LSS::TrilinosCrsMatrix> mat_a(lss_a.matrix());
+  Handle<LSS::TrilinosCrsMatrix> mat_b(lss_b.matrix());
+  BOOST_CHECK(mat_a->epetra_matrix()->Graph().DataPtr() == mat_b->epetra_matrix()->Graph().DataPtr());
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 BOOST_AUTO_TEST_SUITE_END()
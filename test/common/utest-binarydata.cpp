@@ -9,6 +9,7 @@
 
 #include <iostream>
 
+#include <boost/filesystem/operations.hpp>
 #include <boost/mpl/if.hpp>
 #include <boost/test/unit_test.hpp>
 #include <boost/random/mersenne_twister.hpp>
@@ -173,6 +174,81 @@ BOOST_AUTO_TEST_CASE( ReadBinaryData )
   BOOST_CHECK_EQUAL(empty_real_table.row_size(), 8);
 }
 
+BOOST_AUTO_TEST_CASE( SharedFiles )
+{
+  common::Component& group = *common::Core::instance().root().create_component("SharedGroup", "cf3.common.Group");
+
+  common::Table<Real>& real_table = *group.create_component< common::Table<Real> >("RealTable");
+  real_table.set_row_size(real_table_cols);
+  real_table.resize(real_table_size);
+  fill_table(real_table);
+
+  common::List<Uint>& int_list = *group.create_component< common::List<Uint> >("IntList");
+  int_list.resize(int_list_size);
+  fill_list(int_list);
+
+  common::BinaryDataWriter& writer = *group.create_component<common::BinaryDataWriter>("Writer");
+  writer.options().set("nb_files", 2u);
+  writer.options().set("file", common::URI("binary_data_shared.cfbinxml"));
+  writer.append_data(real_table);
+  writer.append_data(int_list);
+  writer.close();
+
+  // Processes 0 and 1 share the first file
+  BOOST_CHECK(boost::filesystem::exists("binary_data_shared_F0.cfbin"));
+  BOOST_CHECK(!boost::filesystem::exists("binary_data_shared_P0.cfbin"));
+
+  common::BinaryDataReader& reader = *group.create_component<common::BinaryDataReader>("Reader");
+  reader.options().set("file", common::URI("binary_data_shared.cfbinxml"));
+
+  common::Table<Real>& read_real_table = *group.create_component< common::Table<Real> >("ReadRealTable");
+  common::List<Uint>& read_int_list = *group.create_component< common::List<Uint> >("ReadIntList");
+  reader.read_table(read_real_table, 0);
+  reader.read_list(read_int_list, 1);
+
+  BOOST_CHECK(read_real_table.array() == real_table.array());
+  BOOST_CHECK(read_int_list.array() == int_list.array());
+}
+
+BOOST_AUTO_TEST_CASE( CompressionSettings )
+{
+  common::Component& group = *common::Core::instance().root().create_component("CompressionGroup", "cf3.common.Group");
+
+  common::Table<Real>& real_table = *group.create_component< common::Table<Real> >("RealTable");
+  real_table.set_row_size(real_table_cols);
+  real_table.resize(real_table_size);
+  fill_table(real_table);
+
+  common::List<Uint>& int_list = *group.create_component< common::List<Uint> >("IntList");
+  int_list.resize(int_list_size);
+  fill_list(int_list);
+
+  common::Table<Real>& read_real_table = *group.create_component< common::Table<Real> >("ReadRealTable");
+  common::List<Uint>& read_int_list = *group.create_component< common::List<Uint> >("ReadIntList");
+
+  const std::string codecs[] = {"none", "fast", "zlib"};
+  for(Uint i = 0; i != 3; ++i)
+  {
+    common::BinaryDataWriter& writer = *group.create_component<common::BinaryDataWriter>("Writer" + codecs[i]);
+    writer.options().set("compression", codecs[i]);
+    writer.options().set("shuffle", i != 0);
+    // Chunk size not a multiple of the element size, and smaller than the data
+    writer.options().set("chunk_size", 10001u);
+    writer.options().set("file", common::URI("binary_data_" + codecs[i] + ".cfbinxml"));
+    writer.append_data(real_table);
+    writer.append_data(int_list);
+    writer.close();
+
+    common::BinaryDataReader& reader = *group.create_component<common::BinaryDataReader>("Reader" + codecs[i]);
+    reader.options().set("file", common::URI("binary_data_" + codecs[i] + ".cfbinxml"));
+    reader.read_table(read_real_table, 0);
+    reader.read_list(read_int_list, 1);
+
+    BOOST_CHECK(read_real_table.array() == real_table.array());
+    BOOST_CHECK(read_int_list.array() == int_list.array());
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 BOOST_AUTO_TEST_SUITE_END()
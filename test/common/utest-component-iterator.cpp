@@ -698,6 +698,49 @@ BOOST_AUTO_TEST_CASE( test_find_component_recursively_with_tag )
 
 //////////////////////////////////////////////////////////////////////////////
 
+BOOST_AUTO_TEST_CASE( test_subtree_index_updates )
+{
+  // Fill the index of the root and of group2
+  BOOST_CHECK_EQUAL(find_component_recursively_with_tag(root(),"very_special").name() , "group2_1_1" );
+  BOOST_CHECK_EQUAL(count(find_components_recursively<Group>(group2())), 2u);
+  BOOST_CHECK(is_null(find_component_ptr_recursively_with_tag(root(),"extra_special")));
+
+  // Adding a component deep in the tree must be seen from the top
+  Handle<Group> group2_1_2 = group2_1().create_component<Group>("group2_1_2");
+  BOOST_CHECK_EQUAL(count(find_components_recursively<Group>(group2())), 3u);
+  BOOST_CHECK(is_null(find_component_ptr_recursively_with_tag(root(),"extra_special")));
+
+  // Tags added after insertion
+  group2_1_2->add_tag("extra_special");
+  BOOST_CHECK_EQUAL(find_component_recursively_with_tag<Group>(root(),"extra_special").name() , "group2_1_2" );
+  BOOST_CHECK_EQUAL(find_component_recursively_with_tag(const_group2(),"extra_special").name() , "group2_1_2" );
+
+  // Tag removal
+  group2_1_2->remove_tag("extra_special");
+  BOOST_CHECK(is_null(find_component_ptr_recursively_with_tag(root(),"extra_special")));
+
+  // Moving and removing components
+  Handle<Component> group2_1_1 = group2_1().get_child("group2_1_1");
+  group2_1_1->move_to(group3());
+  BOOST_CHECK(is_null(find_component_ptr_recursively_with_tag(group2(),"very_special")));
+  BOOST_CHECK_EQUAL(find_component_recursively_with_tag(group3(),"very_special").name() , "group2_1_1" );
+  BOOST_CHECK_EQUAL(count(find_components_recursively<Group>(group2())), 2u);
+
+  group3().remove_component("group2_1_1");
+  BOOST_CHECK(is_null(find_component_ptr_recursively_with_tag(root(),"very_special")));
+
+  // The recursive order is unchanged: depth first, parents before children
+  std::vector<std::string> names;
+  BOOST_FOREACH(const Component& comp, find_components_recursively(const_group2()))
+    names.push_back(comp.name());
+  BOOST_REQUIRE_EQUAL(names.size(), 3u);
+  BOOST_CHECK_EQUAL(names[0], "group2_1");
+  BOOST_CHECK_EQUAL(names[1], "group2_1_2");
+  BOOST_CHECK_EQUAL(names[2], "link2");
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
 BOOST_AUTO_TEST_CASE( speed_find_tag )
 {
   Handle<Group> mg = root().create_component<Group>("ManyGroup2");
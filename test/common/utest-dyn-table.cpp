@@ -0,0 +1,97 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Test module for DynTable component"
+
+#include <boost/test/unit_test.hpp>
+
+#include "common/CF.hpp"
+#include "common/DynTable.hpp"
+#include "common/Exception.hpp"
+#include "common/Foreach.hpp"
+
+//////////////////////////////////////////////////////////////////////////////
+
+using namespace cf3;
+using namespace cf3::common;
+
+//////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE( DynTableTests )
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE ( compress )
+{
+  boost::shared_ptr< DynTable<Uint> > table_ptr = allocate_component< DynTable<Uint> >("table");
+  DynTable<Uint>& table = *table_ptr;
+
+  table.resize(4);
+  std::vector<Uint> row(3);
+  row[0] = 5; row[1] = 6; row[2] = 7;
+  table.set_row(0, row);
+  row.resize(1);
+  table.set_row(2, row);
+  table[3].push_back(9);
+  table[3].push_back(10);
+
+  table.compress();
+  BOOST_CHECK(table.is_compressed());
+  ExceptionManager::instance().ExceptionOutputs = false;
+  ExceptionManager::instance().ExceptionDumps = false;
+  BOOST_CHECK_THROW(static_cast<const DynTable<Uint>&>(table).array(), IllegalCall);
+
+  const DynTable<Uint>& const_table = table;
+  BOOST_CHECK_EQUAL(const_table.size(), 4u);
+  BOOST_CHECK_EQUAL(const_table.row_size(0), 3u);
+  BOOST_CHECK_EQUAL(const_table.row_size(1), 0u);
+  BOOST_CHECK_EQUAL(const_table.row_size(2), 1u);
+  BOOST_CHECK_EQUAL(const_table.row_size(3), 2u);
+  BOOST_CHECK(const_table[1].empty());
+  BOOST_CHECK_EQUAL(const_table[0][2], 7u);
+  BOOST_CHECK_EQUAL(const_table[2][0], 5u);
+
+  Uint sum = 0;
+  boost_foreach(const Uint v, const_table[3])
+    sum += v;
+  BOOST_CHECK_EQUAL(sum, 19u);
+
+  // Modification converts back to separate rows
+  table[1].push_back(3);
+  BOOST_CHECK(!table.is_compressed());
+  BOOST_CHECK_EQUAL(table.row_size(1), 1u);
+  BOOST_CHECK_EQUAL(const_table[0][1], 6u);
+  BOOST_CHECK_EQUAL(const_table[3][1], 10u);
+}
+
+BOOST_AUTO_TEST_CASE ( swap_compressed )
+{
+  boost::shared_ptr< DynTable<Real> > table_ptr = allocate_component< DynTable<Real> >("table");
+  DynTable<Real>& table = *table_ptr;
+
+  std::vector<Uint> offsets(3);
+  offsets[0] = 0; offsets[1] = 2; offsets[2] = 3;
+  std::vector<Real> values(3);
+  values[0] = 1.; values[1] = 2.; values[2] = 3.;
+  table.swap_compressed(offsets, values);
+
+  const DynTable<Real>& const_table = table;
+  BOOST_CHECK_EQUAL(const_table.size(), 2u);
+  BOOST_CHECK_EQUAL(const_table[0][1], 2.);
+  BOOST_CHECK_EQUAL(const_table[1][0], 3.);
+
+  table.resize(3);
+  BOOST_CHECK_EQUAL(table.size(), 3u);
+  BOOST_CHECK_EQUAL(table.row_size(0), 2u);
+  BOOST_CHECK_EQUAL(table.row_size(2), 0u);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+////////////////////////////////////////////////////////////////////////////////
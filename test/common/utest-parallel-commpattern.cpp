@@ -18,6 +18,7 @@
 #include <boost/weak_ptr.hpp>
 
 #include "common/Log.hpp"
+#include "common/OptionList.hpp"
 #include "common/FindComponents.hpp"
 #include "common/Component.hpp"
 #include "common/PE/Comm.hpp"
@@ -212,6 +213,155 @@ BOOST_AUTO_TEST_CASE( commpattern_mainstream )
 
 ////////////////////////////////////////////////////////////////////////////////
 
+BOOST_AUTO_TEST_CASE( commpattern_split_synchronization )
+{
+  // general constants in this routine
+  const int nproc=PE::Comm::instance().size();
+  const int irank=PE::Comm::instance().rank();
+
+  // commpattern
+  boost::shared_ptr<CommPattern> pecp_ptr = allocate_component<CommPattern>("CommPattern");
+  CommPattern& pecp = *pecp_ptr;
+  pecp.options().set("neighbour_exchange",true);
+
+  // setup gid & rank
+  std::vector<Uint> gid;
+  std::vector<Uint> rank;
+  setupGidAndRank(gid,rank);
+  pecp.insert("gid",gid,1,false);
+
+  // additional arrays for testing
+  std::vector<int> v1;
+  for(int i=0;i<6*nproc;i++) v1.push_back(-((irank+1)*1000+i+1));
+  pecp.insert("v1",v1,1,true);
+  std::vector<double> v2;
+  for(int i=0;i<12*nproc;i++) v2.push_back((double)((irank+1)*1000+i+1));
+  pecp.insert("v2",v2,2,true);
+
+  pecp.setup(Handle<CommWrapper>(pecp.get_child("gid")),rank);
+
+  // every other rank owns some of the gids, so all of them are neighbours
+  BOOST_CHECK_EQUAL( pecp.send_neighbours().size() , nproc-1 );
+  BOOST_CHECK_EQUAL( pecp.recv_neighbours().size() , nproc-1 );
+
+  // both exchanges are in flight at the same time, started in a different order on odd and even ranks
+  if (irank%2==0)
+  {
+    pecp.start_synchronize(*Handle<CommWrapper>(pecp.get_child("v1")));
+    pecp.start_synchronize(*Handle<CommWrapper>(pecp.get_child("v2")));
+  }
+  else
+  {
+    pecp.start_synchronize(*Handle<CommWrapper>(pecp.get_child("v2")));
+    pecp.start_synchronize(*Handle<CommWrapper>(pecp.get_child("v1")));
+  }
+  BOOST_CHECK_THROW( pecp.start_synchronize(*Handle<CommWrapper>(pecp.get_child("v1"))) , IllegalCall );
+  pecp.finish_synchronize(*Handle<CommWrapper>(pecp.get_child("v1")));
+  pecp.finish_synchronize();
+
+  // check results, which must be the same as for the blocking synchronization
+  Uint idx=0;
+  Uint i;
+  for (i=0; i<  nproc; i++, idx++ ) BOOST_CHECK_EQUAL( v1[i], (int)(-((((i-0*nproc)/1)+1)*1000+idx+1)) );
+  for (   ; i<3*nproc; i++, idx++ ) BOOST_CHECK_EQUAL( v1[i], (int)(-((((i-1*nproc)/2)+1)*1000+idx+1)) );
+  for (   ; i<6*nproc; i++, idx++ ) BOOST_CHECK_EQUAL( v1[i], (int)(-((((i-3*nproc)/3)+1)*1000+idx+1)) );
+  idx=0;
+  for (i=0; i< 2*nproc; i++, idx++) BOOST_CHECK_EQUAL( v2[i], (double)((((i-0*nproc)/2)+1)*1000+idx+1) );
+  for (   ; i< 6*nproc; i++, idx++) BOOST_CHECK_EQUAL( v2[i], (double)((((i-2*nproc)/4)+1)*1000+idx+1) );
+  for (   ; i<12*nproc; i++, idx++) BOOST_CHECK_EQUAL( v2[i], (double)((((i-6*nproc)/6)+1)*1000+idx+1) );
+
+  // the global all_to_all gives the same result
+  for(int i=0;i<6*nproc;i++) v1[i]=-((irank+1)*1000+i+1);
+  pecp.options().set("neighbour_exchange",false);
+  pecp.synchronize("v1");
+  idx=0;
+  for (i=0; i<  nproc; i++, idx++ ) BOOST_CHECK_EQUAL( v1[i], (int)(-((((i-0*nproc)/1)+1)*1000+idx+1)) );
+  for (   ; i<3*nproc; i++, idx++ ) BOOST_CHECK_EQUAL( v1[i], (int)(-((((i-1*nproc)/2)+1)*1000+idx+1)) );
+  for (   ; i<6*nproc; i++, idx++ ) BOOST_CHECK_EQUAL( v1[i], (int)(-((((i-3*nproc)/3)+1)*1000+idx+1)) );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( commpattern_batched_synchronization )
+{
+  // general constants in this routine
+  const int nproc=PE::Comm::instance().size();
+  const int irank=PE::Comm::instance().rank();
+
+  // commpattern
+  boost::shared_ptr<CommPattern> pecp_ptr = allocate_component<CommPattern>("CommPattern");
+  CommPattern& pecp = *pecp_ptr;
+
+  // setup gid & rank
+  std::vector<Uint> gid;
+  std::vector<Uint> rank;
+  setupGidAndRank(gid,rank);
+  pecp.insert("gid",gid,1,false);
+
+  // arrays of different types and strides, so the parts of each message have different sizes
+  std::vector<int> v1;
+  std::vector<double> v2;
+  std::vector<char> v3;
+  pecp.insert("v1",v1,1,true);
+  pecp.insert("v2",v2,2,true);
+  pecp.insert("v3",v3,3,true);
+
+  std::vector<std::string> names;
+  names.push_back("v3");
+  names.push_back("v1");
+  names.push_back("v2");
+
+  for (int neighbour_exchange=0; neighbour_exchange!=2; ++neighbour_exchange)
+  {
+    v1.clear(); v2.clear(); v3.clear();
+    for(int i=0;i<6*nproc;i++) v1.push_back(-((irank+1)*1000+i+1));
+    for(int i=0;i<12*nproc;i++) v2.push_back((double)((irank+1)*1000+i+1));
+    for(int i=0;i<18*nproc;i++) v3.push_back((char)(irank+1));
+
+    if (neighbour_exchange==0) pecp.setup(Handle<CommWrapper>(pecp.get_child("gid")),rank);
+    pecp.options().set("neighbour_exchange",(bool)neighbour_exchange);
+    pecp.synchronize(names);
+
+    Uint idx=0;
+    Uint i;
+    for (i=0; i<  nproc; i++, idx++ ) BOOST_CHECK_EQUAL( v1[i], (int)(-((((i-0*nproc)/1)+1)*1000+idx+1)) );
+    for (   ; i<3*nproc; i++, idx++ ) BOOST_CHECK_EQUAL( v1[i], (int)(-((((i-1*nproc)/2)+1)*1000+idx+1)) );
+    for (   ; i<6*nproc; i++, idx++ ) BOOST_CHECK_EQUAL( v1[i], (int)(-((((i-3*nproc)/3)+1)*1000+idx+1)) );
+    idx=0;
+    for (i=0; i< 2*nproc; i++, idx++) BOOST_CHECK_EQUAL( v2[i], (double)((((i-0*nproc)/2)+1)*1000+idx+1) );
+    for (   ; i< 6*nproc; i++, idx++) BOOST_CHECK_EQUAL( v2[i], (double)((((i-2*nproc)/4)+1)*1000+idx+1) );
+    for (   ; i<12*nproc; i++, idx++) BOOST_CHECK_EQUAL( v2[i], (double)((((i-6*nproc)/6)+1)*1000+idx+1) );
+    for (i=0; i< 3*nproc; i++) BOOST_CHECK_EQUAL( (int)v3[i], (int)(((i-0*nproc)/3)+1) );
+    for (   ; i< 9*nproc; i++) BOOST_CHECK_EQUAL( (int)v3[i], (int)(((i-3*nproc)/6)+1) );
+    for (   ; i<18*nproc; i++) BOOST_CHECK_EQUAL( (int)v3[i], (int)(((i-9*nproc)/9)+1) );
+  }
+
+  // a batch while another exchange is still in flight
+  for(int i=0;i<6*nproc;i++) v1[i]=-((irank+1)*1000+i+1);
+  for(int i=0;i<12*nproc;i++) v2[i]=(double)((irank+1)*1000+i+1);
+  for(int i=0;i<18*nproc;i++) v3[i]=(char)(irank+1);
+  pecp.start_synchronize(*Handle<CommWrapper>(pecp.get_child("v3")));
+  names.assign(1,"v1");
+  names.push_back("v2");
+  pecp.synchronize(names);
+  pecp.finish_synchronize();
+
+  Uint idx=0;
+  Uint i;
+  for (i=0; i<  nproc; i++, idx++ ) BOOST_CHECK_EQUAL( v1[i], (int)(-((((i-0*nproc)/1)+1)*1000+idx+1)) );
+  for (   ; i<3*nproc; i++, idx++ ) BOOST_CHECK_EQUAL( v1[i], (int)(-((((i-1*nproc)/2)+1)*1000+idx+1)) );
+  for (   ; i<6*nproc; i++, idx++ ) BOOST_CHECK_EQUAL( v1[i], (int)(-((((i-3*nproc)/3)+1)*1000+idx+1)) );
+  idx=0;
+  for (i=0; i< 2*nproc; i++, idx++) BOOST_CHECK_EQUAL( v2[i], (double)((((i-0*nproc)/2)+1)*1000+idx+1) );
+  for (   ; i< 6*nproc; i++, idx++) BOOST_CHECK_EQUAL( v2[i], (double)((((i-2*nproc)/4)+1)*1000+idx+1) );
+  for (   ; i<12*nproc; i++, idx++) BOOST_CHECK_EQUAL( v2[i], (double)((((i-6*nproc)/6)+1)*1000+idx+1) );
+  for (i=0; i< 3*nproc; i++) BOOST_CHECK_EQUAL( (int)v3[i], (int)(((i-0*nproc)/3)+1) );
+  for (   ; i< 9*nproc; i++) BOOST_CHECK_EQUAL( (int)v3[i], (int)(((i-3*nproc)/6)+1) );
+  for (   ; i<18*nproc; i++) BOOST_CHECK_EQUAL( (int)v3[i], (int)(((i-9*nproc)/9)+1) );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 BOOST_AUTO_TEST_CASE( commpattern_external_synchronization )
 {
 /*
@@ -0,0 +1,133 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Test module for the gathering of timing statistics"
+
+////////////////////////////////////////////////////////////////////////////////
+
+#include <sstream>
+
+#include <boost/test/unit_test.hpp>
+
+#include "common/Core.hpp"
+#include "common/Group.hpp"
+#include "common/PropertyList.hpp"
+#include "common/TimedComponent.hpp"
+
+#include "common/PE/Comm.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+
+using namespace cf3;
+using namespace cf3::common;
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct TimingStatisticsFixture
+{
+  TimingStatisticsFixture()
+  {
+    m_argc = boost::unit_test::framework::master_test_suite().argc;
+    m_argv = boost::unit_test::framework::master_test_suite().argv;
+  }
+
+  /// Set the timing properties as a TimedComponent would
+  void set_timings(Component& comp, const Real mean, const Real min, const Real max, const Uint count)
+  {
+    comp.properties().add("timer_mean", mean);
+    comp.properties().add("timer_minimum", min);
+    comp.properties().add("timer_maximum", max);
+    comp.properties().add("timer_count", count);
+  }
+
+  int m_argc;
+  char** m_argv;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_FIXTURE_TEST_SUITE( TimingStatisticsSuite, TimingStatisticsFixture )
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( init_mpi )
+{
+  PE::Comm::instance().init(m_argc,m_argv);
+  BOOST_CHECK_EQUAL(PE::Comm::instance().size(), 2);
+}
+
+BOOST_AUTO_TEST_CASE( gather_statistics )
+{
+  const Uint rank = PE::Comm::instance().rank();
+
+  boost::shared_ptr<Group> root = allocate_component<Group>("root");
+  Group& timed = *root->create_component<Group>("timed");
+  root->create_component<Group>("untimed");
+  Group& nested = *timed.create_component<Group>("nested");
+
+  // Rank 1 is twice as slow as rank 0
+  const Real factor = static_cast<Real>(rank + 1);
+  set_timings(timed, 1.*factor, 0.5*factor, 2.*factor, 10u);
+  set_timings(nested, 0.1*factor, 0.05*factor, 0.2*factor, 4u);
+
+  const std::vector<TimingStatistics> statistics = gather_timing_statistics(*root);
+  BOOST_REQUIRE_EQUAL(statistics.size(), 4u);
+
+  // Depth-first order, and the structure is known on all ranks
+  BOOST_CHECK_EQUAL(statistics[0].name, "root");
+  BOOST_CHECK_EQUAL(statistics[1].name, "timed");
+  BOOST_CHECK_EQUAL(statistics[2].name, "nested");
+  BOOST_CHECK_EQUAL(statistics[3].name, "untimed");
+  BOOST_CHECK_EQUAL(statistics[2].depth, 2u);
+  BOOST_CHECK_EQUAL(statistics[2].path, nested.uri().path());
+
+  if(rank != 0)
+    return;
+
+  BOOST_CHECK(!statistics[0].timed);
+  BOOST_CHECK(!statistics[3].timed);
+
+  const TimingStatistics& stats = statistics[1];
+  BOOST_CHECK(stats.timed);
+  BOOST_CHECK_EQUAL(stats.count, 10u);
+  BOOST_CHECK_CLOSE(stats.mean, 1.5, 1e-10);
+  BOOST_CHECK_CLOSE(stats.min, 0.5, 1e-10);
+  BOOST_CHECK_CLOSE(stats.max, 4., 1e-10);
+  BOOST_CHECK_CLOSE(stats.mean_min, 1., 1e-10);
+  BOOST_CHECK_CLOSE(stats.mean_max, 2., 1e-10);
+  BOOST_CHECK_EQUAL(stats.slowest_rank, 1u);
+  BOOST_CHECK_CLOSE(stats.imbalance(), 4./3., 1e-10);
+
+  BOOST_CHECK_EQUAL(statistics[2].count, 4u);
+  BOOST_CHECK_CLOSE(statistics[2].mean, 0.15, 1e-10);
+
+  std::stringstream json;
+  write_timing_json(statistics, json);
+  BOOST_CHECK(json.str().find("\"name\": \"timed\"") != std::string::npos);
+  BOOST_CHECK(json.str().find("\"slowest_rank\": 1") != std::string::npos);
+  BOOST_CHECK(json.str().find("untimed") == std::string::npos);
+
+  // Header plus one line per timed component
+  std::stringstream csv;
+  write_timing_csv(statistics, csv);
+  std::string line;
+  Uint nb_lines = 0;
+  while(std::getline(csv, line))
+    ++nb_lines;
+  BOOST_CHECK_EQUAL(nb_lines, 3u);
+}
+
+BOOST_AUTO_TEST_CASE( finalize_mpi )
+{
+  PE::Comm::instance().finalize();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+////////////////////////////////////////////////////////////////////////////////
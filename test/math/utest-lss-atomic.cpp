@@ -13,7 +13,9 @@
 #include <fstream>
 
 #include <boost/test/unit_test.hpp>
+#include <boost/assign/list_of.hpp>
 #include <boost/assign/std/vector.hpp>
+#include <boost/foreach.hpp>
 #include <boost/lexical_cast.hpp>
 
 #include "common/Log.hpp"
@@ -474,6 +476,54 @@ BOOST_AUTO_TEST_CASE( test_matrix_only )
 
 ////////////////////////////////////////////////////////////////////////////////
 
+BOOST_AUTO_TEST_CASE( test_add_values_scatter_map )
+{
+  boost::shared_ptr<common::PE::CommPattern> cp_ptr = common::allocate_component<common::PE::CommPattern>("commpattern");
+  common::PE::CommPattern& cp = *cp_ptr;
+  build_commpattern(cp);
+  boost::shared_ptr<LSS::System> sys(common::allocate_component<LSS::System>("sys"));
+  sys->options().option("matrix_builder").change_value(matrix_builder);
+  build_system(*sys,cp);
+  Handle<LSS::Matrix> mat=sys->matrix();
+  if(!mat->options().check("use_scatter_map"))
+    return;
+
+  // Assemble the same blocks, including ghost rows, with and without the scatter map
+  LSS::BlockAccumulator ba;
+  ba.resize(3,neq);
+  for (int i=0; i<ba.mat.rows(); i++)
+    for (int j=0; j<ba.mat.cols(); j++)
+      ba.mat(i,j) = 10.*i + j + 1.;
+
+  std::vector<Uint> rows, cols;
+  std::vector<Real> vals_scatter, vals_fallback;
+  BOOST_FOREACH(const bool use_scatter_map, std::vector<bool>(boost::assign::list_of(true)(false)))
+  {
+    mat->options().set("use_scatter_map", use_scatter_map);
+    mat->reset();
+    if (irank==1)
+    {
+      ba.indices[0]=5; ba.indices[1]=2; ba.indices[2]=8;
+      mat->add_values(ba);
+      mat->add_values(ba);
+      ba.indices[0]=3; ba.indices[1]=2; ba.indices[2]=7;
+      mat->add_values(ba);
+    }
+    else
+    {
+      ba.indices[0]=2; ba.indices[1]=1; ba.indices[2]=5;
+      mat->add_values(ba);
+    }
+    mat->debug_data(rows,cols,use_scatter_map ? vals_scatter : vals_fallback);
+  }
+
+  BOOST_CHECK_EQUAL(vals_scatter.size(), vals_fallback.size());
+  for (int i=0; i<(const int)vals_scatter.size(); i++)
+    BOOST_CHECK_EQUAL(vals_scatter[i], vals_fallback[i]);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 BOOST_AUTO_TEST_CASE( test_vector_only )
 {
   // build a commpattern and the two vectors
@@ -0,0 +1,270 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Test module for the native LSS backend"
+
+////////////////////////////////////////////////////////////////////////////////
+
+#include <boost/test/unit_test.hpp>
+#include <boost/assign/list_of.hpp>
+#include <boost/assign/std/vector.hpp>
+#include <boost/foreach.hpp>
+
+#include "common/Core.hpp"
+#include "common/Environment.hpp"
+#include "common/Log.hpp"
+#include "common/OptionList.hpp"
+#include "common/PropertyList.hpp"
+#include "common/PE/Comm.hpp"
+#include "common/PE/CommPattern.hpp"
+
+#include "math/LSS/System.hpp"
+#include "math/LSS/BlockAccumulator.hpp"
+#include "math/LSS/Native/NativeCrsMatrix.hpp"
+#include "math/LSS/Native/NativeVector.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+
+using namespace boost::assign;
+
+using namespace cf3;
+using namespace cf3::math;
+using namespace cf3::math::LSS;
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct LSSNativeFixture
+{
+  LSSNativeFixture() :
+    irank(0)
+  {
+    m_argc = boost::unit_test::framework::master_test_suite().argc;
+    m_argv = boost::unit_test::framework::master_test_suite().argv;
+    if(common::PE::Comm::instance().is_initialized())
+    {
+      irank = common::PE::Comm::instance().rank();
+      BOOST_CHECK_EQUAL(common::PE::Comm::instance().size(), 2);
+    }
+  }
+
+  /// 1D mesh of 7 nodes, split over two processes with node 2 and 3 shared
+  boost::shared_ptr<common::PE::CommPattern> build_commpattern()
+  {
+    gid.clear();
+    rank_updatable.clear();
+    if (irank==0)
+    {
+      gid += 0,1,2,3;
+      rank_updatable += 0,0,0,1;
+    } else {
+      gid += 2,3,4,5,6;
+      rank_updatable += 0,1,1,1,1;
+    }
+    boost::shared_ptr<common::PE::CommPattern> cp = common::allocate_component<common::PE::CommPattern>("commpattern");
+    cp->insert("gid",gid,1,false);
+    cp->setup(Handle<common::PE::CommWrapper>(cp->get_child("gid")),rank_updatable);
+    return cp;
+  }
+
+  /// Laplacian with dirichlet conditions 10 and 16 at the ends, the solution is 10 + gid
+  boost::shared_ptr<System> build_laplacian(common::PE::CommPattern& cp, const bool preserve_symmetry = false)
+  {
+    node_connectivity.clear();
+    starting_indices.clear();
+    if (irank==0)
+    {
+      node_connectivity += 0,1,0,1,2,1,2,3,2,3;
+      starting_indices += 0,2,5,8,10;
+    } else {
+      node_connectivity += 0,1,0,1,2,1,2,3,2,3,4,3,4;
+      starting_indices +=  0,2,5,8,11,13;
+    }
+    boost::shared_ptr<System> sys(common::allocate_component<System>("sys"));
+    sys->options().set("matrix_builder", std::string("cf3.math.LSS.NativeCrsMatrix"));
+    sys->options().set("solution_strategy", std::string("cf3.math.LSS.NativeKrylovStrategy"));
+    sys->options().set("preserve_symmetry", preserve_symmetry);
+    sys->create(cp,1,node_connectivity,starting_indices);
+
+    sys->matrix()->reset(-1.);
+    sys->solution()->reset(0.);
+    sys->rhs()->reset(0.);
+    std::vector<Real> diag(gid.size(),2.);
+    sys->set_diagonal(diag);
+    if (irank==0)
+      sys->dirichlet(0,0,10.);
+    else
+      sys->dirichlet(4,0,16.);
+
+    return sys;
+  }
+
+  void check_laplacian_solution(System& sys)
+  {
+    for(Uint i = 0; i != gid.size(); ++i)
+    {
+      Real value;
+      sys.solution()->get_value(i, 0, value);
+      BOOST_CHECK_CLOSE(value, 10. + gid[i], 1e-5);
+    }
+  }
+
+  int m_argc;
+  char** m_argv;
+  int irank;
+
+  std::vector<Uint> gid;
+  std::vector<Uint> rank_updatable;
+  std::vector<Uint> node_connectivity;
+  std::vector<Uint> starting_indices;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_FIXTURE_TEST_SUITE( LSSNativeSuite, LSSNativeFixture )
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( init_mpi )
+{
+  common::PE::Comm::instance().init(m_argc,m_argv);
+  BOOST_CHECK_EQUAL(common::PE::Comm::instance().is_active(),true);
+  common::Core::instance().environment().options().set("log_level", 3u);
+}
+
+BOOST_AUTO_TEST_CASE( apply_laplacian )
+{
+  boost::shared_ptr<common::PE::CommPattern> cp = build_commpattern();
+  boost::shared_ptr<System> sys = build_laplacian(*cp);
+
+  // Dirichlet conditions are only applied when solving, so the end rows still hold the plain operator
+  Handle<Vector> x = sys->solution();
+  for(Uint i = 0; i != gid.size(); ++i)
+    x->set_value(i, 0, 10. + gid[i]);
+
+  Handle<Vector> y(sys->create_component<NativeVector>("y"));
+  sys->rhs()->clone_to(*y);
+  y->reset(0.);
+  sys->matrix()->apply(y, x);
+
+  for(Uint i = 0; i != gid.size(); ++i)
+  {
+    if(rank_updatable[i] != irank)
+      continue;
+    Real result;
+    y->get_value(i, 0, result);
+    const Real expected = gid[i] == 0 ? 9. : (gid[i] == 6 ? 17. : 0.);
+    BOOST_CHECK_SMALL(result - expected, 1e-12);
+  }
+}
+
+BOOST_AUTO_TEST_CASE( clones_with_the_same_name )
+{
+  boost::shared_ptr<common::PE::CommPattern> cp = build_commpattern();
+  boost::shared_ptr<System> sys = build_laplacian(*cp);
+
+  Handle<Vector> x = sys->solution();
+  for(Uint i = 0; i != gid.size(); ++i)
+    x->set_value(i, 0, 10. + gid[i]);
+
+  // The clones share the comm pattern of the original, but must be synchronized separately
+  boost::shared_ptr<NativeCrsMatrix> a = common::allocate_component<NativeCrsMatrix>("clone");
+  boost::shared_ptr<NativeCrsMatrix> b = common::allocate_component<NativeCrsMatrix>("clone");
+  sys->matrix()->clone_to(*a);
+  sys->matrix()->clone_to(*b);
+  boost::shared_ptr<NativeVector> y_a = common::allocate_component<NativeVector>("y");
+  boost::shared_ptr<NativeVector> y_b = common::allocate_component<NativeVector>("y");
+  sys->rhs()->clone_to(*y_a);
+  sys->rhs()->clone_to(*y_b);
+  a->destroy();
+  y_a->destroy();
+
+  y_b->reset(0.);
+  b->apply(y_b->handle<Vector>(), x);
+  y_b->sync();
+  for(Uint i = 0; i != gid.size(); ++i)
+  {
+    Real result;
+    y_b->get_value(i, 0, result);
+    const Real expected = gid[i] == 0 ? 9. : (gid[i] == 6 ? 17. : 0.);
+    BOOST_CHECK_SMALL(result - expected, 1e-12);
+  }
+}
+
+BOOST_AUTO_TEST_CASE( element_assembly )
+{
+  boost::shared_ptr<common::PE::CommPattern> cp = build_commpattern();
+  boost::shared_ptr<System> sys = build_laplacian(*cp);
+  sys->matrix()->reset(0.);
+
+  // Assemble the same operator element by element
+  BlockAccumulator ba;
+  ba.resize(2, 1);
+  for(Uint i = 0; i != gid.size()-1; ++i)
+  {
+    ba.reset();
+    ba.neighbour_indices(std::vector<Uint>(boost::assign::list_of(i)(i+1)));
+    ba.mat << 1., -1.,
+              -1., 1.;
+    sys->matrix()->add_values(ba);
+  }
+
+  // Only owned rows are stored, so the element shared by both processes is not counted twice
+  Handle<NativeCrsMatrix> mat(sys->matrix());
+  BOOST_REQUIRE(is_not_null(mat));
+  BOOST_CHECK_EQUAL(mat->nb_owned_blocks(), irank == 0 ? 3u : 4u);
+  for(Uint i = 0; i != gid.size(); ++i)
+  {
+    if(rank_updatable[i] != irank)
+      continue;
+    Real diag;
+    mat->get_value(i, i, diag);
+    BOOST_CHECK_EQUAL(diag, (gid[i] == 0 || gid[i] == 6) ? 1. : 2.);
+    if(i != 0)
+    {
+      Real offdiag;
+      mat->get_value(i-1, i, offdiag);
+      BOOST_CHECK_EQUAL(offdiag, -1.);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE( solve_laplacian )
+{
+  boost::shared_ptr<common::PE::CommPattern> cp = build_commpattern();
+
+  std::vector<std::string> solvers, preconditioners;
+  solvers += "GMRES", "BiCGStab", "CG";
+  preconditioners += "ILU0", "BlockJacobi", "Jacobi", "None";
+
+  BOOST_FOREACH(const std::string& solver, solvers)
+  {
+    BOOST_FOREACH(const std::string& preconditioner, preconditioners)
+    {
+      // Plain dirichlet rows make the system non-symmetric, so CG uses the symmetric variant
+      boost::shared_ptr<System> sys = build_laplacian(*cp, solver == "CG");
+      sys->solution_strategy()->options().set("solver", solver);
+      sys->solution_strategy()->options().set("preconditioner", preconditioner);
+      sys->solution_strategy()->options().set("tolerance", 1e-12);
+      sys->solution_strategy()->options().set("compute_residual", true);
+      sys->solve();
+      BOOST_CHECK(sys->solution_strategy()->properties().value<bool>("converged"));
+      check_laplacian_solution(*sys);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE( finalize_mpi )
+{
+  common::PE::Comm::instance().finalize();
+  BOOST_CHECK_EQUAL(common::PE::Comm::instance().is_active(),false);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,126 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Test module for cf3::math::KDTree"
+
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+
+#include <boost/test/unit_test.hpp>
+
+#include "math/KDTree.hpp"
+
+using namespace cf3;
+using namespace cf3::math;
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct KDTreeFixture
+{
+  KDTreeFixture()
+  {
+    // Pseudo-random points in the unit cube, with a fixed seed
+    std::srand(42);
+    coordinates.resize(3*nb_points);
+    for(Uint i = 0; i != coordinates.size(); ++i)
+      coordinates[i] = static_cast<Real>(std::rand()) / static_cast<Real>(RAND_MAX);
+  }
+
+  /// Reference result by checking all points
+  Uint brute_force_nearest(const Real* point, Real& best_distance)
+  {
+    Uint best = nb_points;
+    best_distance = std::numeric_limits<Real>::max();
+    for(Uint i = 0; i != nb_points; ++i)
+    {
+      Real dist = 0.;
+      for(Uint d = 0; d != 3; ++d)
+        dist += (coordinates[3*i+d] - point[d])*(coordinates[3*i+d] - point[d]);
+      if(dist < best_distance)
+      {
+        best_distance = dist;
+        best = i;
+      }
+    }
+    return best;
+  }
+
+  static const Uint nb_points = 2000;
+  std::vector<Real> coordinates;
+};
+
+const Uint KDTreeFixture::nb_points;
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_FIXTURE_TEST_SUITE( KDTreeSuite, KDTreeFixture )
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( EmptyTree )
+{
+  KDTree tree(2);
+  tree.build(std::vector<Real>());
+  Real dist;
+  const Real point[2] = {0., 0.};
+  BOOST_CHECK_EQUAL(tree.nearest(point, dist), 0u);
+  BOOST_CHECK_EQUAL(tree.nb_points(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE( Nearest )
+{
+  KDTree tree(3, 4);
+  tree.build(coordinates);
+  BOOST_CHECK_EQUAL(tree.nb_points(), nb_points);
+
+  for(Uint i = 0; i != 200; ++i)
+  {
+    const Real point[3] = { 1.2*std::rand()/RAND_MAX - 0.1, 1.2*std::rand()/RAND_MAX - 0.1, 1.2*std::rand()/RAND_MAX - 0.1 };
+    Real dist, ref_dist;
+    const Uint found = tree.nearest(point, dist);
+    const Uint ref = brute_force_nearest(point, ref_dist);
+    BOOST_CHECK_EQUAL(found, ref);
+    BOOST_CHECK_EQUAL(dist, ref_dist);
+  }
+
+  // Points in the tree find themselves
+  Real dist;
+  BOOST_CHECK_EQUAL(tree.nearest(&coordinates[3*17], dist), 17u);
+  BOOST_CHECK_EQUAL(dist, 0.);
+}
+
+BOOST_AUTO_TEST_CASE( PointsInRadius )
+{
+  KDTree tree(3);
+  tree.build(coordinates);
+
+  const Real point[3] = {0.5, 0.5, 0.5};
+  const Real radius = 0.2;
+  std::vector<Uint> found;
+  tree.points_in_radius(point, radius, found);
+  std::sort(found.begin(), found.end());
+
+  std::vector<Uint> reference;
+  for(Uint i = 0; i != nb_points; ++i)
+  {
+    Real dist = 0.;
+    for(Uint d = 0; d != 3; ++d)
+      dist += (coordinates[3*i+d] - point[d])*(coordinates[3*i+d] - point[d]);
+    if(dist <= radius*radius)
+      reference.push_back(i);
+  }
+
+  BOOST_CHECK(!reference.empty());
+  BOOST_CHECK_EQUAL_COLLECTIONS(found.begin(), found.end(), reference.begin(), reference.end());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+////////////////////////////////////////////////////////////////////////////////
@@ -7,6 +7,9 @@
 #define BOOST_TEST_DYN_LINK
 #define BOOST_TEST_MODULE "Tests mesh::actions::GlobalConnectivity"
 
+#include <algorithm>
+#include <map>
+
 #include <boost/test/unit_test.hpp>
 
 #include "common/Log.hpp"
@@ -24,7 +27,10 @@
 #include "mesh/Mesh.hpp"
 #include "mesh/Region.hpp"
 #include "mesh/Dictionary.hpp"
+#include "mesh/ElementType.hpp"
+#include "mesh/Field.hpp"
 #include "mesh/MeshReader.hpp"
+#include "mesh/Space.hpp"
 
 using namespace cf3;
 using namespace cf3::common;
@@ -50,6 +56,44 @@ struct TestGlobalConnectivity_Fixture
 
   /// possibly common functions used on the tests below
 
+  /// Global index, rank, ghost flag and position (node coordinates or element centroid) of all nodes and elements
+  struct Items
+  {
+    std::vector<Uint> glb_idx;
+    std::vector<Uint> rank;
+    std::vector<bool> is_ghost;
+    std::vector<Real> positions;
+  };
+
+  Items collect_items()
+  {
+    Items items;
+    const Dictionary& nodes = mesh->geometry_fields();
+    const Uint dim = nodes.coordinates().row_size();
+    for (Uint i=0; i<nodes.size(); ++i)
+    {
+      items.glb_idx.push_back(nodes.glb_idx()[i]);
+      items.rank.push_back(nodes.rank()[i]);
+      items.is_ghost.push_back(nodes.is_ghost(i));
+      items.positions.insert(items.positions.end(), nodes.coordinates()[i].begin(), nodes.coordinates()[i].end());
+    }
+    boost_foreach(const Entities& entities, mesh->topology().elements_range())
+    {
+      RealMatrix element_coordinates(entities.element_type().nb_nodes(), dim);
+      RealVector centroid(dim);
+      for (Uint e=0; e<entities.size(); ++e)
+      {
+        entities.geometry_space().put_coordinates(element_coordinates, e);
+        entities.element_type().compute_centroid(element_coordinates, centroid);
+        items.glb_idx.push_back(entities.glb_idx()[e]);
+        items.rank.push_back(entities.rank()[e]);
+        items.is_ghost.push_back(entities.is_ghost(e));
+        items.positions.insert(items.positions.end(), centroid.data(), centroid.data()+dim);
+      }
+    }
+    return items;
+  }
+
   int m_argc;
   char** m_argv;
 
@@ -105,6 +149,66 @@ BOOST_AUTO_TEST_CASE( build )
 
 ////////////////////////////////////////////////////////////////////////////////
 
+BOOST_AUTO_TEST_CASE( check_numbering )
+{
+  Comm& comm = Comm::instance();
+  const Uint dim = mesh->geometry_fields().coordinates().row_size();
+  const Items items = collect_items();
+
+  // Gather the owned global indices with their positions
+  std::vector<Uint> owned_glb_idx;
+  std::vector<Real> owned_positions;
+  for (Uint i=0; i<items.glb_idx.size(); ++i)
+  {
+    if (items.is_ghost[i])
+      continue;
+    BOOST_CHECK_EQUAL(items.rank[i], comm.rank());
+    owned_glb_idx.push_back(items.glb_idx[i]);
+    owned_positions.insert(owned_positions.end(), items.positions.begin()+i*dim, items.positions.begin()+(i+1)*dim);
+  }
+  std::vector< std::vector<Uint> > all_glb_idx;
+  std::vector< std::vector<Real> > all_positions;
+  comm.all_gather(owned_glb_idx, all_glb_idx);
+  comm.all_gather(owned_positions, all_positions);
+
+  // Owner and position for each global index
+  std::map< Uint, std::pair<Uint,Uint> > owners;
+  std::vector<Uint> sorted_glb_idx;
+  for (Uint p=0; p<comm.size(); ++p)
+  {
+    for (Uint i=0; i<all_glb_idx[p].size(); ++i)
+    {
+      owners[all_glb_idx[p][i]] = std::make_pair(p, i);
+      sorted_glb_idx.push_back(all_glb_idx[p][i]);
+    }
+  }
+
+  // Owned global indices are unique over all processes, and contiguous from 0
+  std::sort(sorted_glb_idx.begin(), sorted_glb_idx.end());
+  BOOST_REQUIRE(!sorted_glb_idx.empty());
+  BOOST_CHECK(std::adjacent_find(sorted_glb_idx.begin(), sorted_glb_idx.end()) == sorted_glb_idx.end());
+  BOOST_CHECK_EQUAL(sorted_glb_idx.front(), 0u);
+  BOOST_CHECK_EQUAL(sorted_glb_idx.back(), sorted_glb_idx.size()-1);
+
+  // Ghosts have the global index and rank of the owner with the same position
+  Uint nb_ghosts = 0;
+  for (Uint i=0; i<items.glb_idx.size(); ++i)
+  {
+    if (!items.is_ghost[i])
+      continue;
+    ++nb_ghosts;
+    const std::map< Uint, std::pair<Uint,Uint> >::const_iterator owner = owners.find(items.glb_idx[i]);
+    BOOST_REQUIRE(owner != owners.end());
+    BOOST_CHECK_EQUAL(items.rank[i], owner->second.first);
+    for (Uint d=0; d<dim; ++d)
+      BOOST_CHECK_EQUAL(items.positions[i*dim+d], all_positions[owner->second.first][owner->second.second*dim+d]);
+  }
+  comm.all_reduce(PE::plus(), &nb_ghosts, 1, &nb_ghosts);
+  BOOST_CHECK(nb_ghosts > 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 BOOST_AUTO_TEST_CASE( Terminate )
 {
   PE::Comm::instance().finalize();
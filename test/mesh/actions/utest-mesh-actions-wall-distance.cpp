@@ -0,0 +1,187 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Tests mesh::actions::WallDistance"
+
+#include <boost/test/unit_test.hpp>
+
+#include "common/Core.hpp"
+#include "common/Environment.hpp"
+#include "common/List.hpp"
+#include "common/OptionList.hpp"
+#include "common/PE/Comm.hpp"
+
+#include "math/Consts.hpp"
+
+#include "mesh/actions/SurfaceToVolumeConnectivity.hpp"
+#include "mesh/actions/WallDistance.hpp"
+
+#include "mesh/Dictionary.hpp"
+#include "mesh/Field.hpp"
+#include "mesh/Mesh.hpp"
+#include "mesh/Region.hpp"
+#include "mesh/SimpleMeshGenerator.hpp"
+
+#include "physics/PhysModel.hpp"
+
+#include "solver/actions/YPlus.hpp"
+
+using namespace cf3;
+using namespace cf3::common;
+using namespace cf3::mesh;
+using namespace cf3::mesh::actions;
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// Compares the wall distance on a partitioned rectangle with the result for the complete rectangle, which every process computes on its own.
+/// The walls are on the left and the bottom, so the process that gets the top of the rectangle has no bottom wall elements.
+struct WallDistanceFixture
+{
+  /// Generate the rectangle, split over the given number of parts
+  static Handle<Mesh> generate(const std::string& name, const Uint nb_parts)
+  {
+    Handle<SimpleMeshGenerator> mesh_generator = Core::instance().root().create_component<SimpleMeshGenerator>("generator_" + name);
+    mesh_generator->options().set("mesh", Core::instance().root().uri()/name);
+    mesh_generator->options().set("lengths", std::vector<Real>(2, 1.));
+    mesh_generator->options().set("nb_cells", std::vector<Uint>(2, 20u));
+    mesh_generator->options().set("nb_parts", nb_parts);
+    mesh_generator->options().set("part", nb_parts == 1 ? 0u : PE::Comm::instance().rank());
+    Handle<Mesh> result(mesh_generator->generate().handle());
+    Core::instance().root().remove_component(*mesh_generator);
+    return result;
+  }
+
+  /// Compute the wall distance on the given mesh
+  static const Field& compute(Mesh& mesh, const bool distributed)
+  {
+    std::vector< Handle<Region> > walls;
+    walls.push_back(Handle<Region>(mesh.topology().get_child("left")));
+    walls.push_back(Handle<Region>(mesh.topology().get_child("bottom")));
+
+    Handle<WallDistance> wall_distance = mesh.create_component<WallDistance>("WallDistance");
+    wall_distance->options().set("mesh", mesh.handle<Mesh>());
+    wall_distance->options().set("regions", walls);
+    wall_distance->options().set("distributed", distributed);
+    wall_distance->execute();
+
+    return *Handle<Field const>(mesh.geometry_fields().get_child("wall_distance"));
+  }
+
+  /// Largest difference with the serial result, over all nodes of all processes
+  static Real max_difference(const Mesh& mesh, const Field& d, const Field& serial_d)
+  {
+    const common::List<Uint>& gids = mesh.geometry_fields().glb_idx();
+    Real result = 0.;
+    for(Uint i = 0; i != d.size(); ++i)
+      result = std::max(result, std::abs(d[i][0] - serial_d[gids[i]][0]));
+    PE::Comm::instance().all_reduce(PE::max(), &result, 1, &result);
+    return result;
+  }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_FIXTURE_TEST_SUITE( WallDistanceSuite, WallDistanceFixture )
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( Init )
+{
+  PE::Comm::instance().init(boost::unit_test::framework::master_test_suite().argc, boost::unit_test::framework::master_test_suite().argv);
+  BOOST_CHECK_EQUAL(PE::Comm::instance().size(), 2);
+}
+
+BOOST_AUTO_TEST_CASE( CompareModes )
+{
+  // Serial reference, where the node index is the global index
+  Handle<Mesh> serial_mesh = generate("serial", 1);
+  const Field& serial_d = compute(*serial_mesh, false);
+  const Field& serial_coords = serial_mesh->geometry_fields().coordinates();
+  BOOST_REQUIRE_EQUAL(serial_d.size(), 21*21);
+  for(Uint i = 0; i != serial_d.size(); ++i)
+    BOOST_CHECK_SMALL(serial_d[i][0] - std::min(serial_coords[i][XX], serial_coords[i][YY]), 1e-12);
+
+  // Without gathering the walls, the top part misses the bottom wall
+  Handle<Mesh> local_mesh = generate("local", 2);
+  BOOST_CHECK(max_difference(*local_mesh, compute(*local_mesh, false), serial_d) > 0.1);
+
+  Handle<Mesh> distributed_mesh = generate("distributed", 2);
+  BOOST_CHECK_SMALL(max_difference(*distributed_mesh, compute(*distributed_mesh, true), serial_d), 1e-12);
+
+  // Same with the nodes split over threads
+  Core::instance().environment().options().set("nb_threads", 4u);
+  Handle<Mesh> threaded_mesh = generate("threaded", 2);
+  BOOST_CHECK_SMALL(max_difference(*threaded_mesh, compute(*threaded_mesh, true), serial_d), 1e-12);
+  Core::instance().environment().options().set("nb_threads", 1u);
+}
+
+/// YPlus must only use local node indices. Nodes that are closest to a wall node of another process get y+ = 0.
+BOOST_AUTO_TEST_CASE( DistributedYPlus )
+{
+  Handle<Mesh> mesh = generate("yplus", 2);
+  const Field& d = compute(*mesh, true);
+  const Uint nb_nodes = d.size();
+
+  Handle<SurfaceToVolumeConnectivity> connectivity = mesh->create_component<SurfaceToVolumeConnectivity>("SurfaceToVolumeConnectivity");
+  connectivity->options().set("mesh", mesh);
+  connectivity->execute();
+
+  // Shear flow along the bottom wall, so y+ equals the distance for nodes that are closest to the bottom
+  Dictionary& geometry = mesh->geometry_fields();
+  Field& velocity = geometry.create_field("navier_stokes_solution", "Velocity[vector]");
+  velocity.add_tag("navier_stokes_solution");
+  const Field& coords = geometry.coordinates();
+  for(Uint i = 0; i != nb_nodes; ++i)
+  {
+    velocity[i][XX] = coords[i][YY];
+    velocity[i][YY] = 0.;
+  }
+
+  Handle<physics::PhysModel> physics(Core::instance().root().create_component("YPlusPhysics", "cf3.physics.DynamicModel"));
+  physics->options().add("kinematic_viscosity", 1.);
+
+  std::vector<URI> walls;
+  walls.push_back(mesh->topology().uri()/"left");
+  walls.push_back(mesh->topology().uri()/"bottom");
+  Handle<solver::actions::YPlus> yplus = mesh->create_component<solver::actions::YPlus>("YPlus");
+  yplus->options().set("mesh", mesh);
+  yplus->options().set("regions", walls);
+  yplus->options().set("physical_model", physics);
+  yplus->execute();
+
+  const common::Table<Uint>& node_to_wall_element = *Handle<common::Table<Uint> const>(mesh->get_child("node_to_wall_element"));
+  const Field& yplus_field = *Handle<Field const>(geometry.get_child("yplus"));
+  Uint nb_remote = 0;
+  for(Uint i = 0; i != nb_nodes; ++i)
+  {
+    if(node_to_wall_element[i][0] == 0 && node_to_wall_element[i][1] == math::Consts::uint_max())
+    {
+      BOOST_CHECK_EQUAL(yplus_field[i][0], 0.);
+      ++nb_remote;
+      continue;
+    }
+    if(node_to_wall_element[i][0] == 0)
+      BOOST_CHECK(node_to_wall_element[i][1] < nb_nodes);
+    if(coords[i][YY] < coords[i][XX] - 1e-8)
+      BOOST_CHECK_SMALL(yplus_field[i][0] - d[i][0], 1e-10);
+  }
+
+  // The upper part has no bottom wall, so some of its nodes depend on the wall of the other process
+  PE::Comm::instance().all_reduce(PE::plus(), &nb_remote, 1, &nb_remote);
+  BOOST_CHECK(nb_remote > 0);
+}
+
+BOOST_AUTO_TEST_CASE( Finalize )
+{
+  PE::Comm::instance().finalize();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+////////////////////////////////////////////////////////////////////////////////
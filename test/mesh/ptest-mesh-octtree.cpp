@@ -0,0 +1,170 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Benchmark of element searches in a stretched mesh"
+
+#include <cmath>
+
+#include <boost/test/unit_test.hpp>
+
+#include "common/Core.hpp"
+#include "common/Environment.hpp"
+#include "common/Log.hpp"
+#include "common/OptionList.hpp"
+#include "common/Threads.hpp"
+#include "common/Timer.hpp"
+
+#include "common/PE/Comm.hpp"
+
+#include "mesh/Dictionary.hpp"
+#include "mesh/Field.hpp"
+#include "mesh/Mesh.hpp"
+#include "mesh/MeshGenerator.hpp"
+#include "mesh/Octtree.hpp"
+
+#include "Tools/Testing/TimedTestFixture.hpp"
+
+using namespace cf3;
+using namespace cf3::common;
+using namespace cf3::mesh;
+using namespace cf3::Tools::Testing;
+
+////////////////////////////////////////////////////////////////////////////////
+
+const Uint nb_cells = 300;
+const Uint nb_queries = 200000;
+
+/// Boundary-layer mesh: uniform in x, exponentially stretched in y,
+/// with a cell aspect ratio going from about 1e4 at the wall to 0.1 at the top
+struct OcttreeBenchmarkFixture : TimedTestFixture
+{
+  OcttreeBenchmarkFixture()
+  {
+    if(is_null(mesh))
+    {
+      boost::shared_ptr< MeshGenerator > mesh_generator = build_component_abstract_type<MeshGenerator>("cf3.mesh.SimpleMeshGenerator","mesh_generator");
+      mesh_generator->options().set("mesh",Core::instance().root().uri()/"mesh");
+      mesh_generator->options().set("lengths",std::vector<Real>(2,1.));
+      mesh_generator->options().set("nb_cells",std::vector<Uint>(2,nb_cells));
+      mesh = mesh_generator->generate().handle<Mesh>();
+
+      Field& coordinates = mesh->geometry_fields().coordinates();
+      for(Uint i = 0; i != coordinates.size(); ++i)
+        coordinates[i][YY] = stretch(coordinates[i][YY]);
+
+      // Query points are distributed like the nodes, so most of them fall in the boundary layer
+      queries.resize(boost::extents[nb_queries][2]);
+      Uint seed = 12345;
+      for(Uint i = 0; i != nb_queries; ++i)
+      {
+        queries[i][XX] = random(seed);
+        queries[i][YY] = stretch(random(seed));
+      }
+    }
+  }
+
+  static Real stretch(const Real y)
+  {
+    const Real beta = 12.;
+    return (std::exp(beta*y) - 1.) / (std::exp(beta) - 1.);
+  }
+
+  /// Reproducible pseudo-random number in [0,1)
+  static Real random(Uint& seed)
+  {
+    seed = 1664525u*seed + 1013904223u;
+    return static_cast<Real>(seed >> 8) / static_cast<Real>(1u << 24);
+  }
+
+  Octtree& create_octtree(const std::string& name, const std::string& structure)
+  {
+    Octtree& octtree = *mesh->create_component<Octtree>(name);
+    octtree.options().set("mesh", mesh);
+    octtree.options().set("search_structure", structure);
+    Timer timer;
+    octtree.create_octtree();
+    CFinfo << structure << ": built in " << timer.elapsed() << " s" << CFendl;
+    return octtree;
+  }
+
+  void query(Octtree& octtree, const std::string& structure)
+  {
+    Timer timer;
+    Uint nb_found = 0;
+    Entity element;
+    RealVector coord(2);
+    for(Uint i = 0; i != nb_queries; ++i)
+    {
+      coord << queries[i][XX], queries[i][YY];
+      if(octtree.find_element(coord, element))
+        ++nb_found;
+    }
+    const Real elapsed = timer.elapsed();
+    CFinfo << structure << ": " << nb_queries/elapsed << " queries/s" << CFendl;
+    BOOST_CHECK_EQUAL(nb_found, nb_queries);
+  }
+
+  static Handle<Mesh> mesh;
+  static boost::multi_array<Real,2> queries;
+};
+
+Handle<Mesh> OcttreeBenchmarkFixture::mesh;
+boost::multi_array<Real,2> OcttreeBenchmarkFixture::queries;
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_FIXTURE_TEST_SUITE( OcttreeBenchmarkSuite, OcttreeBenchmarkFixture )
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( init_mpi )
+{
+  PE::Comm::instance().init(boost::unit_test::framework::master_test_suite().argc, boost::unit_test::framework::master_test_suite().argv);
+}
+
+BOOST_AUTO_TEST_CASE( grid )
+{
+  Octtree& octtree = create_octtree("grid", "grid");
+  restart_timer();
+  query(octtree, "grid");
+}
+
+BOOST_AUTO_TEST_CASE( tree )
+{
+  Octtree& octtree = create_octtree("tree", "tree");
+  restart_timer();
+  query(octtree, "tree");
+}
+
+BOOST_AUTO_TEST_CASE( tree_batched )
+{
+  Octtree& octtree = *Handle<Octtree>(mesh->get_child("tree"));
+  restart_timer();
+  Timer timer;
+  std::vector<Entity> elements;
+  octtree.find_elements(queries, elements);
+  CFinfo << "tree, batched on " << nb_threads() << " threads: " << nb_queries/timer.elapsed() << " queries/s" << CFendl;
+
+  Uint nb_found = 0;
+  for(Uint i = 0; i != nb_queries; ++i)
+  {
+    if(is_not_null(elements[i].comp))
+      ++nb_found;
+  }
+  BOOST_CHECK_EQUAL(nb_found, nb_queries);
+}
+
+BOOST_AUTO_TEST_CASE( finalize_mpi )
+{
+  PE::Comm::instance().finalize();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+////////////////////////////////////////////////////////////////////////////////
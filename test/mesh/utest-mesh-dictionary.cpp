@@ -15,6 +15,7 @@
 #include "common/Log.hpp"
 #include "common/OptionList.hpp"
 #include "common/Core.hpp"
+#include "common/List.hpp"
 
 #include "math/MatrixTypes.hpp"
 #include "math/VariablesDescriptor.hpp"
@@ -309,6 +310,49 @@ BOOST_AUTO_TEST_CASE( FieldVariables )
 
 ////////////////////////////////////////////////////////////////////////////////
 
+BOOST_AUTO_TEST_CASE( InversePeriodicLinks )
+{
+  Dictionary& geometry = m_mesh->geometry_fields();
+  const Uint nb_nodes = geometry.size();
+
+  // Without periodic links the inverse map is empty
+  BOOST_CHECK(geometry.inverse_periodic_links().targets.empty());
+  BOOST_CHECK(geometry.inverse_periodic_links().nodes.empty());
+
+  // Link 2 -> 1 -> 0 and 5 -> 3
+  common::List<Uint>& periodic_links_nodes = *geometry.create_component< common::List<Uint> >("periodic_links_nodes");
+  common::List<bool>& periodic_links_active = *geometry.create_component< common::List<bool> >("periodic_links_active");
+  periodic_links_nodes.resize(nb_nodes);
+  periodic_links_active.resize(nb_nodes);
+  for(Uint i = 0; i != nb_nodes; ++i)
+    periodic_links_active[i] = false;
+  periodic_links_active[1] = true; periodic_links_nodes[1] = 0;
+  periodic_links_active[2] = true; periodic_links_nodes[2] = 1;
+  periodic_links_active[5] = true; periodic_links_nodes[5] = 3;
+
+  geometry.clear_inverse_periodic_links();
+  const Dictionary::InversePeriodicLinks& inverse = geometry.inverse_periodic_links();
+  BOOST_CHECK_EQUAL(inverse.targets.size(), 2);
+  BOOST_CHECK_EQUAL(inverse.targets[0], 0);
+  BOOST_CHECK_EQUAL(inverse.targets[1], 3);
+  BOOST_CHECK_EQUAL(inverse.offsets.size(), 3);
+  BOOST_CHECK_EQUAL(inverse.offsets[1], 2);
+  BOOST_CHECK_EQUAL(inverse.offsets[2], 3);
+  BOOST_CHECK_EQUAL(inverse.nodes[0], 1);
+  BOOST_CHECK_EQUAL(inverse.nodes[1], 2);
+  BOOST_CHECK_EQUAL(inverse.nodes[2], 5);
+
+  // The map is kept until it is invalidated
+  BOOST_CHECK(&inverse == &geometry.inverse_periodic_links());
+
+  geometry.remove_component("periodic_links_nodes");
+  geometry.remove_component("periodic_links_active");
+  geometry.update_structures();
+  BOOST_CHECK(geometry.inverse_periodic_links().targets.empty());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 BOOST_AUTO_TEST_SUITE_END()
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,79 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Tests cf3::mesh::FaceNodeTable"
+
+#include <boost/test/unit_test.hpp>
+
+#include "mesh/FaceNodeTable.hpp"
+
+using namespace cf3;
+using namespace cf3::mesh;
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE( FaceNodeTableSuite )
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( match_rotated_faces )
+{
+  FaceNodeTable table;
+
+  Uint quad[4] = {4, 7, 9, 2};
+  const std::size_t quad_hash = FaceNodeTable::make_key(quad, 4);
+  BOOST_CHECK_EQUAL(quad[0], 2u);
+  BOOST_CHECK_EQUAL(quad[3], 9u);
+  table.insert(quad, 4, quad_hash, 42u);
+
+  // The same face, seen from the neighbouring cell
+  Uint neighbour[4] = {9, 7, 4, 2};
+  const std::size_t neighbour_hash = FaceNodeTable::make_key(neighbour, 4);
+  BOOST_CHECK_EQUAL(neighbour_hash, quad_hash);
+  BOOST_CHECK_EQUAL(table.find(neighbour, 4, neighbour_hash), 42u);
+
+  // A triangle with a subset of the nodes does not match
+  Uint triag[3] = {4, 7, 9};
+  const std::size_t triag_hash = FaceNodeTable::make_key(triag, 3);
+  BOOST_CHECK_EQUAL(table.find(triag, 3, triag_hash), FaceNodeTable::not_found);
+
+  BOOST_CHECK(table.erase(neighbour, 4, neighbour_hash));
+  BOOST_CHECK(!table.erase(neighbour, 4, neighbour_hash));
+  BOOST_CHECK_EQUAL(table.find(quad, 4, quad_hash), FaceNodeTable::not_found);
+  BOOST_CHECK_EQUAL(table.size(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE( many_faces )
+{
+  // Edges of a chain of nodes, inserted and partly erased, so the table grows and rehashes
+  FaceNodeTable table;
+  const Uint nb_faces = 10000;
+  for(Uint i = 0; i != nb_faces; ++i)
+  {
+    Uint edge[2] = {i+1, i};
+    table.insert(edge, 2, FaceNodeTable::make_key(edge, 2), i);
+    if(i % 2 == 1)
+    {
+      Uint previous[2] = {i, i-1};
+      BOOST_CHECK(table.erase(previous, 2, FaceNodeTable::make_key(previous, 2)));
+    }
+  }
+  BOOST_CHECK_EQUAL(table.size(), nb_faces/2);
+
+  for(Uint i = 0; i != nb_faces; ++i)
+  {
+    Uint edge[2] = {i, i+1};
+    const Uint expected = i % 2 == 0 ? FaceNodeTable::not_found : i;
+    BOOST_CHECK_EQUAL(table.find(edge, 2, FaceNodeTable::make_key(edge, 2)), expected);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+////////////////////////////////////////////////////////////////////////////////
@@ -7,6 +7,8 @@
 #define BOOST_TEST_DYN_LINK
 #define BOOST_TEST_MODULE "Test module for cf3::mesh::gmsh::Reader"
 
+#include <fstream>
+
 #include <boost/test/unit_test.hpp>
 
 #include "common/Log.hpp"
@@ -15,6 +17,7 @@
 
 #include "common/Core.hpp"
 #include "common/Environment.hpp"
+#include "common/FindComponents.hpp"
 
 #include "math/VariablesDescriptor.hpp"
 
@@ -26,6 +29,7 @@
 #include "mesh/Field.hpp"
 #include "mesh/Entities.hpp"
 #include "mesh/Space.hpp"
+#include "mesh/Connectivity.hpp"
 #include "common/DynTable.hpp"
 #include "common/List.hpp"
 #include "common/Table.hpp"
@@ -311,6 +315,86 @@ BOOST_AUTO_TEST_CASE( read_2d_mesh_mix_p1_out )
 
 ////////////////////////////////////////////////////////////////////////////////
 
+BOOST_AUTO_TEST_CASE( read_binary_mesh )
+{
+  // Unit square with two triangles and four boundary lines, written in ASCII and in binary
+  const Real coords[4][3] = { {0.,0.,0.}, {1.,0.,0.}, {1.,1.,0.}, {0.,1.,0.} };
+  const int lines[4][2] = { {1,2}, {2,3}, {3,4}, {4,1} };
+  const int triags[2][3] = { {1,2,3}, {1,3,4} };
+
+  const std::string header = "$PhysicalNames\n2\n1 1 \"boundary\"\n2 2 \"interior\"\n$EndPhysicalNames\n";
+
+  std::ofstream ascii("square-ascii.msh");
+  ascii << "$MeshFormat\n2.2 0 8\n$EndMeshFormat\n" << header;
+  ascii << "$Nodes\n4\n";
+  for(int n = 0; n != 4; ++n)
+    ascii << n+1 << " " << coords[n][0] << " " << coords[n][1] << " " << coords[n][2] << "\n";
+  ascii << "$EndNodes\n$Elements\n6\n";
+  for(int e = 0; e != 4; ++e)
+    ascii << e+1 << " 1 2 1 1 " << lines[e][0] << " " << lines[e][1] << "\n";
+  for(int e = 0; e != 2; ++e)
+    ascii << e+5 << " 2 2 2 2 " << triags[e][0] << " " << triags[e][1] << " " << triags[e][2] << "\n";
+  ascii << "$EndElements\n";
+  ascii.close();
+
+  std::ofstream binary("square-binary.msh", std::ios::binary);
+  const int one = 1;
+  binary << "$MeshFormat\n2.2 1 8\n";
+  binary.write(reinterpret_cast<const char*>(&one), sizeof(int));
+  binary << "\n$EndMeshFormat\n" << header;
+  binary << "$Nodes\n4\n";
+  for(int n = 0; n != 4; ++n)
+  {
+    const int node_number = n+1;
+    binary.write(reinterpret_cast<const char*>(&node_number), sizeof(int));
+    binary.write(reinterpret_cast<const char*>(coords[n]), 3*sizeof(double));
+  }
+  binary << "\n$EndNodes\n$Elements\n6\n";
+  const int line_header[3] = {1, 4, 2};
+  binary.write(reinterpret_cast<const char*>(line_header), 3*sizeof(int));
+  for(int e = 0; e != 4; ++e)
+  {
+    const int elem[5] = {e+1, 1, 1, lines[e][0], lines[e][1]};
+    binary.write(reinterpret_cast<const char*>(elem), 5*sizeof(int));
+  }
+  const int triag_header[3] = {2, 2, 2};
+  binary.write(reinterpret_cast<const char*>(triag_header), 3*sizeof(int));
+  for(int e = 0; e != 2; ++e)
+  {
+    const int elem[6] = {e+5, 2, 2, triags[e][0], triags[e][1], triags[e][2]};
+    binary.write(reinterpret_cast<const char*>(elem), 6*sizeof(int));
+  }
+  binary << "\n$EndElements\n";
+  binary.close();
+
+  boost::shared_ptr< MeshReader > meshreader = build_component_abstract_type<MeshReader>("cf3.mesh.gmsh.Reader","meshreader");
+  Mesh& ascii_mesh = *Core::instance().root().create_component<Mesh>("square_ascii");
+  Mesh& binary_mesh = *Core::instance().root().create_component<Mesh>("square_binary");
+  meshreader->read_mesh_into("square-ascii.msh",ascii_mesh);
+  meshreader->read_mesh_into("square-binary.msh",binary_mesh);
+
+  BOOST_CHECK_EQUAL(binary_mesh.dimension(), 2u);
+  BOOST_CHECK_EQUAL(binary_mesh.geometry_fields().size(), 4u);
+  BOOST_CHECK_EQUAL(find_component_with_name<Region>(binary_mesh.topology(),"interior").recursive_elements_count(true), 2u);
+  BOOST_CHECK_EQUAL(find_component_with_name<Region>(binary_mesh.topology(),"boundary").recursive_elements_count(true), 4u);
+
+  for(Uint n = 0; n != 4; ++n)
+  {
+    for(Uint d = 0; d != 2; ++d)
+      BOOST_CHECK_EQUAL(binary_mesh.geometry_fields().coordinates()[n][d], ascii_mesh.geometry_fields().coordinates()[n][d]);
+  }
+
+  const Entities& ascii_triags = find_component_recursively_with_filter<Entities>(ascii_mesh.topology(), IsElementsVolume());
+  const Entities& binary_triags = find_component_recursively_with_filter<Entities>(binary_mesh.topology(), IsElementsVolume());
+  for(Uint e = 0; e != 2; ++e)
+  {
+    for(Uint n = 0; n != 3; ++n)
+      BOOST_CHECK_EQUAL(binary_triags.geometry_space().connectivity()[e][n], ascii_triags.geometry_space().connectivity()[e][n]);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 BOOST_AUTO_TEST_CASE( finalize_mpi )
 {
   Core::instance().terminate();
@@ -305,6 +305,43 @@ BOOST_AUTO_TEST_CASE( test_new_interpolation )
 }
 
 
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( routed_interpolation )
+{
+  Handle<Mesh> source_mesh = Core::instance().root().create_component<Mesh>("routed_source");
+  boost::shared_ptr<MeshGenerator> mesh_gen = allocate_component<SimpleMeshGenerator>("meshgen");
+  mesh_gen->options().set("nb_cells",std::vector<Uint>(2,8));
+  mesh_gen->options().set("lengths",std::vector<Real>(2,4.));
+  mesh_gen->options().set("mesh",source_mesh->uri());
+  mesh_gen->execute();
+
+  // Target points are the nodes of a coarser mesh, partitioned differently from the source
+  Handle<Mesh> target_mesh = Core::instance().root().create_component<Mesh>("routed_target");
+  mesh_gen->options().set("nb_cells",std::vector<Uint>(2,3));
+  mesh_gen->options().set("mesh",target_mesh->uri());
+  mesh_gen->execute();
+  const Field& target_coords = target_mesh->geometry_fields().coordinates();
+  Field& target_field = target_mesh->geometry_fields().create_field("interpolated","interpolated[vector]");
+
+  // Interpolating the coordinates must reproduce them, with and without stored weights
+  boost::shared_ptr< Interpolator > interpolator = allocate_component<Interpolator>("interpolator");
+  for (Uint store = 0; store != 2; ++store)
+  {
+    interpolator->options().set("store",static_cast<bool>(store));
+    for (Uint repeat = 0; repeat != 2; ++repeat)
+    {
+      target_field = 0.;
+      interpolator->interpolate_vars(source_mesh->geometry_fields().coordinates(), target_coords, target_field, list_of(0)(1), list_of(0)(1));
+      for (Uint i = 0; i != target_coords.size(); ++i)
+      {
+        BOOST_CHECK_SMALL(target_field[i][0] - target_coords[i][0], 1e-10);
+        BOOST_CHECK_SMALL(target_field[i][1] - target_coords[i][1], 1e-10);
+      }
+    }
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 BOOST_AUTO_TEST_CASE( finalize_mpi )
@@ -147,6 +147,49 @@ BOOST_AUTO_TEST_CASE( Octtree_creation )
 
 ////////////////////////////////////////////////////////////////////////////////
 
+BOOST_AUTO_TEST_CASE( Octtree_structures )
+{
+  Mesh& mesh = *Handle<Mesh>(Core::instance().root().get_child("mesh"));
+
+  Octtree& grid = *mesh.create_component<Octtree>("grid");
+  grid.options().set("mesh", mesh.handle<Mesh>());
+  grid.options().set("search_structure", std::string("grid"));
+  Octtree& tree = *mesh.create_component<Octtree>("tree");
+  tree.options().set("mesh", mesh.handle<Mesh>());
+  tree.options().set("nb_elems_per_leaf", 2u);
+
+  // Both structures find the same elements, also for points on element boundaries
+  boost::multi_array<Real,2> coordinates(boost::extents[36][2]);
+  for (Uint i=0; i<6; ++i)
+  {
+    for (Uint j=0; j<6; ++j)
+    {
+      coordinates[6*i+j][XX] = 2.*i + (i == 5 ? 0. : 0.7);
+      coordinates[6*i+j][YY] = 2.*j + (j == 5 ? 0. : 1.3);
+    }
+  }
+  std::vector<Entity> tree_elements;
+  tree.find_elements(coordinates, tree_elements);
+  RealVector2 coord;
+  Entity element;
+  for (Uint i=0; i<coordinates.size(); ++i)
+  {
+    coord << coordinates[i][XX], coordinates[i][YY];
+    BOOST_CHECK(grid.find_element(coord, element));
+    BOOST_CHECK(is_not_null(tree_elements[i].comp));
+    RealMatrix nodes = tree_elements[i].get_coordinates();
+    BOOST_CHECK(tree_elements[i].element_type().is_coord_in_element(coord, nodes));
+    if (coordinates[i][XX] != 10. && coordinates[i][YY] != 10.)
+      BOOST_CHECK(element == tree_elements[i]);
+  }
+
+  // Points outside the mesh are not found, but have a closest element
+  coord << 11., 3.;
+  BOOST_CHECK(!tree.find_element(coord, element));
+  BOOST_CHECK(tree.find_closest_element(coord, element));
+  BOOST_CHECK_EQUAL(element.idx, 9u);
+}
+
 BOOST_AUTO_TEST_CASE( Octtree_parallel )
 {
   Handle< MeshGenerator > mesh_generator(Core::instance().root().get_child("mesh_generator"));
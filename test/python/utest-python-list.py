@@ -20,3 +20,15 @@ cf_check(not list[1], 'Second table row is incorrect')
 
 print 'Full list:'
 print list
+
+# Direct access to the values, without copying
+import struct
+values = root.create_component("values", "cf3.common.List<unsigned>")
+values.resize(3)
+view = memoryview(values.array_view())
+cf_check_equal(view.shape, (3,), 'Incorrect array view shape')
+try:
+  view[1] = 7
+except TypeError:
+  view[1] = struct.pack('I', 7)
+cf_check_equal(values[1], 7, 'Writing through the array view failed')
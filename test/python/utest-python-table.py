@@ -37,3 +37,11 @@ cf_check_equal(table[0][0],2,'Table increment failed')
 
 print 'Full table:'
 print table
+
+# Direct access to the values, without copying
+import struct
+view = memoryview(table.array_view())
+cf_check_equal(view.format, 'I', 'Incorrect array view format')
+cf_check_equal(view.shape, (10, 2), 'Incorrect array view shape')
+cf_check(not view.readonly, 'Array view of a table should be writable')
+cf_check_equal(struct.unpack('II', view.tobytes()[0:8]), (2, 2), 'Array view values differ from the table')
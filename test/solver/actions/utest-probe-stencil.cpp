@@ -0,0 +1,163 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Test module for the cached probe stencils"
+
+#include <boost/test/unit_test.hpp>
+
+#include "common/Core.hpp"
+#include "common/Environment.hpp"
+#include "common/OptionList.hpp"
+#include "common/Table.hpp"
+
+#include "common/PE/Comm.hpp"
+
+#include "mesh/Dictionary.hpp"
+#include "mesh/Field.hpp"
+#include "mesh/Mesh.hpp"
+#include "mesh/MeshGenerator.hpp"
+#include "mesh/PointInterpolator.hpp"
+
+#include "solver/actions/ProbePoints.hpp"
+#include "solver/actions/ProbeStencil.hpp"
+
+using namespace cf3;
+using namespace cf3::common;
+using namespace cf3::mesh;
+using namespace cf3::solver::actions;
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// Distributed 10x10 square with the linear field u = x + 2y, which is interpolated exactly
+struct ProbeStencilFixture
+{
+  ProbeStencilFixture()
+  {
+    if(is_null(mesh))
+    {
+      boost::shared_ptr< MeshGenerator > mesh_generator = build_component_abstract_type<MeshGenerator>("cf3.mesh.SimpleMeshGenerator","mesh_generator");
+      mesh_generator->options().set("mesh",Core::instance().root().uri()/"mesh");
+      mesh_generator->options().set("lengths",std::vector<Real>(2,1.));
+      mesh_generator->options().set("nb_cells",std::vector<Uint>(2,10u));
+      mesh = mesh_generator->generate().handle<Mesh>();
+
+      Dictionary& dict = mesh->geometry_fields();
+      Field& u = dict.create_field("u");
+      for(Uint i = 0; i != dict.size(); ++i)
+        u[i][0] = dict.coordinates()[i][XX] + 2.*dict.coordinates()[i][YY];
+    }
+  }
+
+  static std::vector<RealVector> points()
+  {
+    std::vector<RealVector> result(3, RealVector(2));
+    result[0] << 0.15, 0.25;
+    result[1] << 0.5, 0.5;
+    result[2] << 0.83, 0.71;
+    return result;
+  }
+
+  static Handle<Mesh> mesh;
+};
+
+Handle<Mesh> ProbeStencilFixture::mesh;
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_FIXTURE_TEST_SUITE( ProbeStencilSuite, ProbeStencilFixture )
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( init_mpi )
+{
+  PE::Comm::instance().init(boost::unit_test::framework::master_test_suite().argc, boost::unit_test::framework::master_test_suite().argv);
+  BOOST_CHECK_EQUAL(PE::Comm::instance().size(), 2);
+}
+
+BOOST_AUTO_TEST_CASE( interpolate )
+{
+  Dictionary& dict = mesh->geometry_fields();
+  Handle<PointInterpolator> interpolator = mesh->create_component<PointInterpolator>("interpolator");
+  interpolator->options().set("dict", dict.handle<Dictionary>());
+
+  ProbeStencil stencil;
+  BOOST_CHECK(!stencil.is_valid(dict));
+  const std::vector<RealVector> coords = points();
+  stencil.resolve(*interpolator, dict, coords);
+  BOOST_CHECK(stencil.is_valid(dict));
+  BOOST_CHECK_EQUAL(stencil.nb_points(), coords.size());
+
+  // All processes get all values, from a single reduction
+  std::vector<Real> values;
+  stencil.interpolate(dict, values);
+  BOOST_CHECK_EQUAL(values.size(), coords.size()*ProbeStencil::total_row_size(dict));
+  for(Uint i = 0; i != coords.size(); ++i)
+  {
+    BOOST_CHECK(stencil.owner(i) < PE::Comm::instance().size());
+    BOOST_CHECK_CLOSE(values[i*ProbeStencil::total_row_size(dict) + dict.coordinates().row_size()], coords[i][XX] + 2.*coords[i][YY], 1e-8);
+  }
+
+  stencil.invalidate();
+  BOOST_CHECK(!stencil.is_valid(dict));
+
+  // Without points, there is nothing to locate or reduce
+  stencil.resolve(*interpolator, dict, std::vector<RealVector>());
+  BOOST_CHECK_EQUAL(stencil.nb_points(), 0);
+  stencil.interpolate(dict, values);
+  BOOST_CHECK(values.empty());
+
+  // Points outside the domain are rejected on all processes
+  std::vector<RealVector> outside(1, RealVector(2));
+  outside[0] << 2., 2.;
+  BOOST_CHECK_THROW(stencil.resolve(*interpolator, dict, outside), SetupError);
+}
+
+BOOST_AUTO_TEST_CASE( probe_points_cache )
+{
+  Dictionary& dict = mesh->geometry_fields();
+  Handle<ProbePoints> probe = mesh->create_component<ProbePoints>("probe");
+  std::vector<Real> x, y;
+  const std::vector<RealVector> coords = points();
+  for(Uint i = 0; i != coords.size(); ++i)
+  {
+    x.push_back(coords[i][XX]);
+    y.push_back(coords[i][YY]);
+  }
+  probe->options().set("x_coordinate", x);
+  probe->options().set("y_coordinate", y);
+  probe->options().set("dict", dict.handle<Dictionary>());
+  probe->execute();
+
+  const Uint u_column = dict.coordinates().row_size();
+  for(Uint i = 0; i != coords.size(); ++i)
+    BOOST_CHECK_CLOSE(probe->values()->array()[i][u_column], x[i] + 2.*y[i], 1e-8);
+
+  // Move the mesh without telling anyone: the cached stencils are still used, with the unchanged field values
+  const Real shift = 0.05;
+  for(Uint i = 0; i != dict.size(); ++i)
+    dict.coordinates()[i][XX] += shift;
+  probe->execute();
+  for(Uint i = 0; i != coords.size(); ++i)
+    BOOST_CHECK_CLOSE(probe->values()->array()[i][u_column], x[i] + 2.*y[i], 1e-8);
+
+  // After the mesh changed event, the points are located again in the moved mesh
+  mesh->raise_mesh_changed();
+  probe->execute();
+  for(Uint i = 0; i != coords.size(); ++i)
+    BOOST_CHECK_CLOSE(probe->values()->array()[i][u_column], x[i] - shift + 2.*y[i], 1e-8);
+}
+
+BOOST_AUTO_TEST_CASE( finalize_mpi )
+{
+  PE::Comm::instance().finalize();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,404 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Test module for matrix-free element products in proto"
+
+#include <cmath>
+#include <set>
+
+#include <boost/foreach.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include "common/Core.hpp"
+#include "common/Environment.hpp"
+#include "common/FindComponents.hpp"
+#include "common/List.hpp"
+#include "common/OptionList.hpp"
+#include "common/PE/Comm.hpp"
+#include "common/PE/CommPattern.hpp"
+#include "common/PropertyList.hpp"
+#include "common/Table.hpp"
+
+#include "math/LSS/System.hpp"
+#include "math/LSS/SolutionStrategy.hpp"
+#include "math/LSS/Vector.hpp"
+#include "math/LSS/Native/NativeOperatorMatrix.hpp"
+
+#include "mesh/Domain.hpp"
+#include "mesh/Mesh.hpp"
+#include "mesh/Region.hpp"
+#include "mesh/Elements.hpp"
+#include "mesh/FieldManager.hpp"
+#include "mesh/Dictionary.hpp"
+#include "mesh/Connectivity.hpp"
+
+#include "physics/PhysModel.hpp"
+
+#include "solver/Model.hpp"
+#include "solver/Tags.hpp"
+
+#include "solver/actions/Proto/ElementProduct.hpp"
+#include "solver/actions/Proto/ProtoAction.hpp"
+#include "solver/actions/Proto/Expression.hpp"
+
+#include "Tools/MeshGeneration/MeshGeneration.hpp"
+
+using namespace cf3;
+using namespace cf3::common;
+using namespace cf3::mesh;
+using namespace cf3::solver;
+using namespace cf3::solver::actions;
+using namespace cf3::solver::actions::Proto;
+
+struct ElementProductFixture
+{
+  ElementProductFixture() :
+    root(Core::instance().root())
+  {
+    if(is_null(model))
+    {
+      common::PE::Comm::instance().init(boost::unit_test::framework::master_test_suite().argc, boost::unit_test::framework::master_test_suite().argv);
+
+      model = Core::instance().root().create_component<Model>("Model");
+      physical_model = Handle<physics::PhysModel>(model->create_physics("cf3.physics.DynamicModel").handle());
+      Domain& dom = model->create_domain("Domain");
+      mesh = dom.create_component<Mesh>("mesh");
+      Tools::MeshGeneration::create_rectangle(*mesh, 1., 1., 10, 10);
+
+      field_manager = model->create_component<FieldManager>("FieldManager");
+      field_manager->options().set("variable_manager", model->physics().variable_manager().handle<math::VariableManager>());
+
+      // Build node connectivity
+      const Uint nb_nodes = mesh->geometry_fields().size();
+      std::vector< std::set<Uint> > connectivity_sets(nb_nodes);
+      BOOST_FOREACH(const Entities& elements, common::find_components_recursively_with_filter<Entities>(*mesh, IsElementsVolume()))
+      {
+        const Connectivity& connectivity = elements.geometry_space().connectivity();
+        const Uint nb_elems = connectivity.size();
+        for(Uint elem = 0; elem != nb_elems; ++elem)
+        {
+          BOOST_FOREACH(const Uint node_a, connectivity[elem])
+          {
+            BOOST_FOREACH(const Uint node_b, connectivity[elem])
+            {
+              connectivity_sets[node_a].insert(node_b);
+            }
+          }
+        }
+      }
+
+      starting_indices.push_back(0);
+      BOOST_FOREACH(const std::set<Uint>& nodes, connectivity_sets)
+      {
+        starting_indices.push_back(starting_indices.back() + nodes.size());
+        node_connectivity.insert(node_connectivity.end(), nodes.begin(), nodes.end());
+      }
+
+      loop_regions.push_back(mesh->topology().uri());
+    }
+  }
+
+  /// Set some non-trivial values in the given vector
+  static void fill(math::LSS::Vector& vector)
+  {
+    const Uint nb_rows = vector.blockrow_size()*vector.neq();
+    for(Uint i = 0; i != nb_rows; ++i)
+      vector.set_value(i, std::sin(0.37*i) + 0.1*i);
+  }
+
+  /// Largest difference between the values of two vectors
+  static Real max_difference(math::LSS::Vector& a, math::LSS::Vector& b)
+  {
+    Real result = 0.;
+    const Uint nb_rows = a.blockrow_size()*a.neq();
+    for(Uint i = 0; i != nb_rows; ++i)
+    {
+      Real a_i, b_i;
+      a.get_value(i, a_i);
+      b.get_value(i, b_i);
+      result = std::max(result, std::abs(a_i - b_i));
+    }
+    return result;
+  }
+
+  Component& root;
+  static Handle<Model> model;
+  static Handle<physics::PhysModel> physical_model;
+  static Handle<Mesh> mesh;
+  static Handle<FieldManager> field_manager;
+  static std::vector<URI> loop_regions;
+
+  static std::vector<Uint> node_connectivity;
+  static std::vector<Uint> starting_indices;
+};
+
+Handle<Model> ElementProductFixture::model;
+Handle<physics::PhysModel> ElementProductFixture::physical_model;
+Handle<Mesh> ElementProductFixture::mesh;
+Handle<FieldManager> ElementProductFixture::field_manager;
+std::vector<URI> ElementProductFixture::loop_regions;
+
+std::vector<Uint> ElementProductFixture::node_connectivity;
+std::vector<Uint> ElementProductFixture::starting_indices;
+
+BOOST_FIXTURE_TEST_SUITE( ElementProductSuite, ElementProductFixture )
+
+//////////////////////////////////////////////////////////////////////////////
+
+/// The matrix-free product must match the product with the assembled matrix, also for several unknowns per node
+BOOST_AUTO_TEST_CASE( VectorProduct )
+{
+  Handle<math::LSS::System> lss = root.create_component<math::LSS::System>("vector_lss");
+  lss->options().set("matrix_builder", std::string("cf3.math.LSS.NativeCrsMatrix"));
+  lss->create(mesh->geometry_fields().comm_pattern(), 2, node_connectivity, starting_indices);
+
+  FieldVariable<0, VectorField> v("VectorVar", "vector");
+  SystemMatrix matrix(*lss);
+  ElementProduct product(*lss);
+
+  Handle<ProtoAction> action = root.create_component<ProtoAction>("VectorProductAction");
+  action->set_expression(elements_expression(
+    group
+    (
+      _A = _0,
+      element_quadrature
+      (
+        _A(v[_i],v[_i]) += transpose(nabla(v)) * nabla(v) + transpose(N(v)) * N(v),
+        _A(v[_i],v[_j]) += transpose(nabla(v)[_i]) * nabla(v)[_j]
+      ),
+      matrix += _A,
+      product += _A
+    )
+  ));
+  action->options().set("physical_model", physical_model);
+  action->options().set(solver::Tags::regions(), loop_regions);
+
+  field_manager->create_field("vector", mesh->geometry_fields());
+  fill(*lss->solution());
+  lss->rhs()->reset();
+  action->execute();
+
+  Handle<math::LSS::Vector> reference(root.create_component("VectorReference", "cf3.math.LSS.NativeVector"));
+  lss->solution()->clone_to(*reference);
+  lss->matrix()->apply(reference, lss->solution());
+
+  Real norm = 0.;
+  for(Uint i = 0; i != reference->blockrow_size()*2; ++i)
+  {
+    Real val;
+    reference->get_value(i, val);
+    norm = std::max(norm, std::abs(val));
+  }
+  BOOST_CHECK(norm > 1e-3);
+  BOOST_CHECK_SMALL(max_difference(*reference, *lss->rhs()), 1e-12);
+}
+
+/// Solve a system without assembling its matrix, using the element product as operator
+BOOST_AUTO_TEST_CASE( MatrixFreeSolve )
+{
+  FieldVariable<0, ScalarField> u("ScalarVar", "scalar");
+
+  // Assembled system, to compute a right hand side and compare the solution
+  Handle<math::LSS::System> assembled_lss = root.create_component<math::LSS::System>("assembled_lss");
+  assembled_lss->options().set("matrix_builder", std::string("cf3.math.LSS.NativeCrsMatrix"));
+  assembled_lss->create(mesh->geometry_fields().comm_pattern(), 1, node_connectivity, starting_indices);
+  SystemMatrix assembled_matrix(*assembled_lss);
+
+  Handle<ProtoAction> assembly = root.create_component<ProtoAction>("Assembly");
+  assembly->set_expression(elements_expression(
+    group
+    (
+      _A = _0,
+      element_quadrature( _A(u,u) += transpose(nabla(u)) * nabla(u) + transpose(N(u)) * N(u) ),
+      assembled_matrix += _A
+    )
+  ));
+
+  // Matrix-free system. Assembly only fills the diagonal, used for the Jacobi preconditioner
+  Handle<math::LSS::System> free_lss = root.create_component<math::LSS::System>("free_lss");
+  free_lss->options().set("matrix_builder", std::string("cf3.math.LSS.NativeOperatorMatrix"));
+  free_lss->options().set("solution_strategy", std::string("cf3.math.LSS.NativeKrylovStrategy"));
+  free_lss->create(mesh->geometry_fields().comm_pattern(), 1, node_connectivity, starting_indices);
+  SystemMatrix free_matrix(*free_lss);
+  ElementProduct free_product(*free_lss);
+
+  Handle<ProtoAction> diagonal = root.create_component<ProtoAction>("Diagonal");
+  diagonal->set_expression(elements_expression(
+    group
+    (
+      _A = _0,
+      element_quadrature( _A(u,u) += transpose(nabla(u)) * nabla(u) + transpose(N(u)) * N(u) ),
+      free_matrix += _A
+    )
+  ));
+
+  Handle<ProtoAction> apply = root.create_component<ProtoAction>("Apply");
+  apply->set_expression(elements_expression(
+    group
+    (
+      _A = _0,
+      element_quadrature( _A(u,u) += transpose(nabla(u)) * nabla(u) + transpose(N(u)) * N(u) ),
+      free_product += _A
+    )
+  ));
+
+  BOOST_FOREACH(ProtoAction& action, common::find_components<ProtoAction>(root))
+  {
+    action.options().set("physical_model", physical_model);
+    action.options().set(solver::Tags::regions(), loop_regions);
+  }
+
+  field_manager->create_field("scalar", mesh->geometry_fields());
+
+  Handle<math::LSS::NativeOperatorMatrix> free_op(free_lss->matrix());
+  BOOST_REQUIRE(is_not_null(free_op));
+  free_op->set_operator(free_product.lss_operator(*apply));
+
+  assembled_lss->matrix()->reset();
+  assembly->execute();
+  free_lss->matrix()->reset();
+  diagonal->execute();
+
+  // The diagonal of both matrices must match
+  std::vector<Real> assembled_diag, free_diag;
+  assembled_lss->matrix()->get_diagonal(assembled_diag);
+  free_lss->matrix()->get_diagonal(free_diag);
+  BOOST_REQUIRE_EQUAL(assembled_diag.size(), free_diag.size());
+  for(Uint i = 0; i != free_diag.size(); ++i)
+    BOOST_CHECK_CLOSE(assembled_diag[i], free_diag[i], 1e-10);
+
+  // b = A x_exact
+  Handle<math::LSS::Vector> exact(root.create_component("ScalarExact", "cf3.math.LSS.NativeVector"));
+  assembled_lss->solution()->clone_to(*exact);
+  fill(*exact);
+  assembled_lss->matrix()->apply(assembled_lss->rhs(), exact);
+  free_lss->rhs()->assign(*assembled_lss->rhs());
+
+  // Matrix-free product through the LSS interface
+  Handle<math::LSS::Vector> free_result(root.create_component("FreeResult", "cf3.math.LSS.NativeVector"));
+  exact->clone_to(*free_result);
+  free_lss->matrix()->apply(free_result, exact);
+  BOOST_CHECK_SMALL(max_difference(*free_result, *assembled_lss->rhs()), 1e-12);
+
+  // Solve using the operator
+  math::LSS::SolutionStrategy& strategy = *free_lss->solution_strategy();
+  strategy.options().set("solver", std::string("CG"));
+  strategy.options().set("preconditioner", std::string("Jacobi"));
+  strategy.options().set("tolerance", 1e-12);
+  free_lss->solution()->reset();
+  free_lss->solve();
+
+  BOOST_CHECK(strategy.properties().value<bool>("converged"));
+  BOOST_CHECK_SMALL(max_difference(*free_lss->solution(), *exact), 1e-8);
+
+  // ILU needs the assembled matrix
+  strategy.options().set("preconditioner", std::string("ILU0"));
+  BOOST_CHECK_THROW(free_lss->solve(), common::SetupError);
+}
+
+/// Elements with a node outside the LSS are skipped by the product, in the same way as by the assembly
+BOOST_AUTO_TEST_CASE( PartialSystem )
+{
+  // Only the nodes with x <= 0.5 are in the system, so the column of elements at x = 0.5 has unknown nodes
+  const Table<Real>& coords = mesh->geometry_fields().coordinates();
+  const Uint nb_nodes = coords.size();
+  std::vector<int> node_map(nb_nodes, -1);
+  std::vector<Uint> gids;
+  for(Uint i = 0; i != nb_nodes; ++i)
+  {
+    if(coords[i][XX] < 0.55)
+    {
+      node_map[i] = gids.size();
+      gids.push_back(gids.size());
+    }
+  }
+  BOOST_REQUIRE(gids.size() < nb_nodes);
+
+  std::vector<Uint> partial_connectivity;
+  std::vector<Uint> partial_starting_indices(1, 0);
+  for(Uint i = 0; i != nb_nodes; ++i)
+  {
+    if(node_map[i] == -1)
+      continue;
+    for(Uint j = starting_indices[i]; j != starting_indices[i+1]; ++j)
+    {
+      if(node_map[node_connectivity[j]] != -1)
+        partial_connectivity.push_back(node_map[node_connectivity[j]]);
+    }
+    partial_starting_indices.push_back(partial_connectivity.size());
+  }
+
+  Handle<common::PE::CommPattern> cp = root.create_component<common::PE::CommPattern>("partial_commpattern");
+  cp->insert("gid", gids, 1, false);
+  std::vector<Uint> ranks(gids.size(), 0);
+  cp->setup(Handle<common::PE::CommWrapper>(cp->get_child("gid")), ranks);
+
+  Handle<math::LSS::System> lss = root.create_component<math::LSS::System>("partial_lss");
+  lss->options().set("matrix_builder", std::string("cf3.math.LSS.NativeCrsMatrix"));
+  lss->create(*cp, 1, partial_connectivity, partial_starting_indices);
+  Handle< common::List<int> > used_node_map = lss->create_component< common::List<int> >("used_node_map");
+  used_node_map->resize(nb_nodes);
+  for(Uint i = 0; i != nb_nodes; ++i)
+    (*used_node_map)[i] = node_map[i];
+
+  FieldVariable<0, ScalarField> u("ScalarVar", "scalar");
+  SystemMatrix matrix(*lss);
+  ElementProduct product(*lss);
+
+  Handle<ProtoAction> action = root.create_component<ProtoAction>("PartialProductAction");
+  action->set_expression(elements_expression(
+    group
+    (
+      _A = _0,
+      element_quadrature( _A(u,u) += transpose(nabla(u)) * nabla(u) + transpose(N(u)) * N(u) ),
+      matrix += _A,
+      product += _A
+    )
+  ));
+  action->options().set("physical_model", physical_model);
+  action->options().set(solver::Tags::regions(), loop_regions);
+
+  lss->matrix()->reset();
+  fill(*lss->solution());
+  lss->rhs()->reset();
+  action->execute();
+
+  // The nodes at x = 0.5 only get the elements on their left, just like the nodes at x = 0 on the other side
+  std::vector<Real> diag;
+  lss->matrix()->get_diagonal(diag);
+  Uint nb_checked = 0;
+  for(Uint i = 0; i != nb_nodes; ++i)
+  {
+    if(node_map[i] == -1 || std::abs(coords[i][XX] - 0.5) > 1e-8)
+      continue;
+    for(Uint j = 0; j != nb_nodes; ++j)
+    {
+      if(std::abs(coords[j][XX]) < 1e-8 && std::abs(coords[j][YY] - coords[i][YY]) < 1e-8)
+      {
+        BOOST_CHECK_CLOSE(diag[node_map[i]], diag[node_map[j]], 1e-10);
+        ++nb_checked;
+      }
+    }
+  }
+  BOOST_CHECK_EQUAL(nb_checked, 11);
+
+  Handle<math::LSS::Vector> reference(root.create_component("PartialReference", "cf3.math.LSS.NativeVector"));
+  lss->solution()->clone_to(*reference);
+  lss->matrix()->apply(reference, lss->solution());
+  BOOST_CHECK_SMALL(max_difference(*reference, *lss->rhs()), 1e-12);
+}
+
+BOOST_AUTO_TEST_CASE( CleanUp )
+{
+  common::PE::Comm::instance().finalize();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+//////////////////////////////////////////////////////////////////////////////
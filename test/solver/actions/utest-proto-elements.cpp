@@ -7,11 +7,15 @@
 #define BOOST_TEST_DYN_LINK
 #define BOOST_TEST_MODULE "Test module for proto operators"
 
+#include <algorithm>
+#include <set>
+
 #include <boost/assign.hpp>
 #include <boost/foreach.hpp>
 #include <boost/test/unit_test.hpp>
 
 #include "common/Core.hpp"
+#include "common/Environment.hpp"
 #include "common/Log.hpp"
 
 #include "math/MatrixTypes.hpp"
@@ -22,6 +26,8 @@
 #include "mesh/Region.hpp"
 #include "mesh/Elements.hpp"
 #include "mesh/MeshWriter.hpp"
+#include "mesh/Connectivity.hpp"
+#include "mesh/Space.hpp"
 #include "mesh/ElementData.hpp"
 #include "mesh/FieldManager.hpp"
 #include "mesh/Dictionary.hpp"
@@ -39,13 +45,16 @@
 #include "solver/Solver.hpp"
 #include "solver/Tags.hpp"
 
+#include "solver/actions/NodeValence.hpp"
 #include "solver/actions/Proto/ProtoAction.hpp"
+#include "solver/actions/Proto/ElementColoring.hpp"
 #include "solver/actions/Proto/ElementLooper.hpp"
 #include "solver/actions/Proto/Expression.hpp"
 #include "solver/actions/Proto/Functions.hpp"
 #include "solver/actions/Proto/NodeLooper.hpp"
 #include "solver/actions/Proto/Terminals.hpp"
 
+#include "Tools/MeshGeneration/MeshGeneration.hpp"
 #include "Tools/Testing/TimedTestFixture.hpp"
 
 using namespace cf3;
@@ -236,6 +245,59 @@ BOOST_AUTO_TEST_CASE( ProtoVectorElementField )
   writer.execute();
 }
 
+// Threaded assembly into a nodal field must match the sequential result
+BOOST_AUTO_TEST_CASE( ProtoThreadedElementLoop )
+{
+  Model& model = *Core::instance().root().create_component<Model>("ThreadedModel");
+  physics::PhysModel& phys_model = model.create_physics("cf3.physics.DynamicModel");
+  Domain& dom = model.create_domain("Domain");
+  Solver& solver = model.create_solver("cf3.solver.SimpleSolver");
+
+  Mesh& mesh = *dom.create_component<Mesh>("mesh");
+  Tools::MeshGeneration::create_rectangle(mesh, 1., 1., 20, 20);
+
+  // Each element must have exactly one color, and elements of the same color may not share nodes
+  BOOST_FOREACH(const Elements& elements, find_components_recursively_with_filter<Elements>(mesh.topology(), IsElementsVolume()))
+  {
+    const ElementColoring& coloring = ElementColoringCache::instance().coloring(elements);
+    const Connectivity& connectivity = elements.geometry_space().connectivity();
+    std::vector<Uint> nb_visits(elements.size(), 0);
+    for(Uint color = 0; color != coloring.nb_colors(); ++color)
+    {
+      std::set<Uint> color_nodes;
+      for(Uint i = coloring.color_begin(color); i != coloring.color_end(color); ++i)
+      {
+        const Uint elem = coloring.elements()[i];
+        ++nb_visits[elem];
+        BOOST_FOREACH(const Uint node, connectivity[elem])
+        {
+          BOOST_CHECK(color_nodes.insert(node).second);
+        }
+      }
+    }
+    BOOST_CHECK(std::count(nb_visits.begin(), nb_visits.end(), 1u) == elements.size());
+  }
+
+  NodeValence& valence = *solver.create_component<NodeValence>("NodeValence");
+  valence.options().set("physical_model", phys_model.handle<physics::PhysModel>());
+  valence.options().set(solver::Tags::regions(), std::vector<URI>(1, mesh.topology().uri()));
+  solver.field_manager().create_field("node_valence", mesh.geometry_fields());
+
+  valence.execute();
+  const Field& valence_field = find_component_recursively_with_tag<Field>(mesh, "node_valence");
+  std::vector<Real> sequential_valence(valence_field.size());
+  for(Uint i = 0; i != valence_field.size(); ++i)
+    sequential_valence[i] = valence_field[i][0];
+
+  Core::instance().environment().options().set("nb_threads", 4u);
+  valence.options().set("threaded", true);
+  valence.execute();
+  Core::instance().environment().options().set("nb_threads", 1u);
+
+  for(Uint i = 0; i != valence_field.size(); ++i)
+    BOOST_CHECK_EQUAL(valence_field[i][0], sequential_valence[i]);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -21,11 +21,13 @@
 #include "solver/actions/Proto/ElementLooper.hpp"
 #include "solver/actions/Proto/Expression.hpp"
 #include "solver/actions/Proto/Functions.hpp"
+#include "solver/actions/Proto/NodeListCache.hpp"
 #include "solver/actions/Proto/NodeLooper.hpp"
 #include "solver/actions/Proto/Terminals.hpp"
 #include <solver/actions/Proto/ProtoAction.hpp>
 
 #include "common/Core.hpp"
+#include "common/Environment.hpp"
 #include "common/Log.hpp"
 
 #include "math/MatrixTypes.hpp"
@@ -174,6 +176,60 @@ BOOST_AUTO_TEST_CASE( NodeFunctor )
   BOOST_CHECK_CLOSE(vec_norm.m_sum, 501.*501.*sqrt(2),1e-8);
 }
 
+BOOST_AUTO_TEST_CASE( UsedNodesCache )
+{
+  Handle<Model> model(Core::instance().root().get_child("Model"));
+  Handle<Mesh> mesh(model->domain().get_child("mesh"));
+
+  // The list is built once and reused on subsequent calls
+  const common::List<Uint>& nodes = NodeListCache::instance().used_nodes(mesh->topology(), mesh->geometry_fields());
+  BOOST_CHECK_EQUAL(nodes.size(), 501*501);
+  BOOST_CHECK(&nodes == &NodeListCache::instance().used_nodes(mesh->topology(), mesh->geometry_fields()));
+
+  // Changing the mesh drops the stored lists
+  mesh->raise_mesh_changed();
+  BOOST_CHECK_EQUAL(NodeListCache::instance().used_nodes(mesh->topology(), mesh->geometry_fields()).size(), 501*501);
+}
+
+BOOST_AUTO_TEST_CASE( ThreadedNodeLoop )
+{
+  Handle<Model> model(Core::instance().root().get_child("Model"));
+
+  FieldVariable<0, VectorField> u("u","velocity");
+  FieldVariable<1, VectorField> u_adv("u_adv", "advection");
+  FieldVariable<2, VectorField> u1("u1", "advection");
+
+  ProtoAction& init = *model->create_component<ProtoAction>("ActionThreadedInit");
+  init.set_expression(nodes_expression(group(u_adv[_i] = 0., u = coordinates, u1 = 2.*coordinates)));
+  init.options().set("physical_model", model->physics().handle<physics::PhysModel>());
+  init.options().set(solver::Tags::regions(), std::vector<URI>(1, model->domain().get_child("mesh")->handle<Mesh>()->topology().uri()));
+  init.options().set("threaded", true);
+
+  ProtoAction& action = *model->create_component<ProtoAction>("ActionThreaded");
+  action.set_expression(nodes_expression(u_adv = 3.*u - u1));
+  action.options().set("physical_model", model->physics().handle<physics::PhysModel>());
+  action.options().set(solver::Tags::regions(), std::vector<URI>(1, model->domain().get_child("mesh")->handle<Mesh>()->topology().uri()));
+  action.options().set("threaded", true);
+
+  Core::instance().environment().options().set("nb_threads", 4u);
+  init.execute();
+  action.execute();
+  Core::instance().environment().options().set("nb_threads", 1u);
+
+  // u_adv must equal the coordinates everywhere
+  Handle<Mesh> mesh(model->domain().get_child("mesh"));
+  const Field& coords = mesh->geometry_fields().coordinates();
+  const Field& advection = find_component_with_tag<Field>(mesh->geometry_fields(), "advection");
+  const Uint u_adv_offset = advection.descriptor().offset("u_adv");
+  Real max_error = 0.;
+  for(Uint i = 0; i != coords.size(); ++i)
+  {
+    for(Uint j = 0; j != 2; ++j)
+      max_error = std::max(max_error, std::abs(advection[i][u_adv_offset+j] - coords[i][j]));
+  }
+  BOOST_CHECK_SMALL(max_error, 1e-12);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 ////////////////////////////////////////////////////////////////////////////////
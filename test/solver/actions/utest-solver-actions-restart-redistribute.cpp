@@ -0,0 +1,181 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Test module for reading restart files on a different number of processes"
+
+#include <string>
+
+#include <boost/test/unit_test.hpp>
+
+#include "common/Core.hpp"
+#include "common/Environment.hpp"
+#include "common/List.hpp"
+#include "common/OptionList.hpp"
+#include "common/Table.hpp"
+
+#include "common/PE/Comm.hpp"
+
+#include "mesh/Dictionary.hpp"
+#include "mesh/Field.hpp"
+#include "mesh/Mesh.hpp"
+#include "mesh/MeshGenerator.hpp"
+
+#include "solver/Tags.hpp"
+#include "solver/Time.hpp"
+
+#include "solver/actions/ReadRestartFile.hpp"
+#include "solver/actions/WriteRestartFile.hpp"
+
+using namespace cf3;
+using namespace cf3::common;
+using namespace cf3::mesh;
+using namespace cf3::solver;
+using namespace cf3::solver::actions;
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// The test is run twice: first with the argument "write" on some number of processes, then with "read" on a different number.
+/// The global node indices of the generated mesh don't depend on the number of processes.
+struct RestartFixture
+{
+  RestartFixture()
+  {
+    if(is_null(mesh))
+    {
+      boost::shared_ptr< MeshGenerator > mesh_generator = build_component_abstract_type<MeshGenerator>("cf3.mesh.SimpleMeshGenerator","mesh_generator");
+      mesh_generator->options().set("mesh",Core::instance().root().uri()/"mesh");
+      mesh_generator->options().set("lengths",std::vector<Real>(2,1.));
+      mesh_generator->options().set("nb_cells",std::vector<Uint>(2,12u));
+      mesh = mesh_generator->generate().handle<Mesh>();
+      time = Core::instance().root().create_component<Time>("Time");
+    }
+  }
+
+  static std::string mode()
+  {
+    BOOST_REQUIRE(boost::unit_test::framework::master_test_suite().argc > 1);
+    return boost::unit_test::framework::master_test_suite().argv[1];
+  }
+
+  /// Value of column j of field u at node i
+  static Real u_value(const Dictionary& dict, const Uint i, const Uint j)
+  {
+    return dict.coordinates()[i][j] + 10.*dict.glb_idx()[i];
+  }
+
+  static const URI file;
+
+  static Handle<Mesh> mesh;
+  static Handle<Time> time;
+};
+
+const URI RestartFixture::file("restart-redistribute.cf3restart");
+
+Handle<Mesh> RestartFixture::mesh;
+Handle<Time> RestartFixture::time;
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_FIXTURE_TEST_SUITE( RestartSuite, RestartFixture )
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( init_mpi )
+{
+  PE::Comm::instance().init(boost::unit_test::framework::master_test_suite().argc, boost::unit_test::framework::master_test_suite().argv);
+}
+
+BOOST_AUTO_TEST_CASE( write_restart )
+{
+  if(mode() != "write")
+    return;
+
+  Dictionary& dict = mesh->geometry_fields();
+  Field& u = dict.create_field("u", 2);
+  Field& w = dict.create_field("w", 1);
+  for(Uint i = 0; i != dict.size(); ++i)
+  {
+    u[i][0] = u_value(dict, i, 0);
+    u[i][1] = u_value(dict, i, 1);
+    w[i][0] = dict.glb_idx()[i];
+  }
+
+  time->options().set("current_time", 2.);
+  time->options().set("time_step", 0.2);
+  time->options().set("iteration", 10u);
+
+  Handle<WriteRestartFile> writer = Core::instance().root().create_component<WriteRestartFile>("Writer");
+  std::vector< Handle<Field> > fields;
+  fields.push_back(u.handle<Field>());
+  fields.push_back(w.handle<Field>());
+  writer->options().set("fields", fields);
+  writer->options().set("file", file);
+  writer->options().set(solver::Tags::time(), time);
+  writer->execute();
+
+  // Asynchronous writes are only completed by an explicit wait
+  Handle<WriteRestartFile> async_writer = Core::instance().root().create_component<WriteRestartFile>("AsyncWriter");
+  async_writer->options().set("fields", fields);
+  async_writer->options().set("file", URI("restart-redistribute-async.cf3restart"));
+  async_writer->options().set(solver::Tags::time(), time);
+  async_writer->options().set("asynchronous", true);
+  async_writer->execute();
+  BOOST_CHECK_EQUAL(async_writer->nb_pending_writes(), 1u);
+  async_writer->wait();
+  BOOST_CHECK_EQUAL(async_writer->nb_pending_writes(), 0u);
+
+  // Destroying the writer with a pending write doesn't communicate, so it may happen on one process only
+  async_writer->options().set("file", URI("restart-redistribute-discarded.cf3restart"));
+  async_writer->execute();
+  if(PE::Comm::instance().rank() == 0)
+    Core::instance().root().remove_component(*async_writer);
+  PE::Comm::instance().barrier();
+  if(PE::Comm::instance().rank() != 0)
+    Core::instance().root().remove_component(*async_writer);
+}
+
+BOOST_AUTO_TEST_CASE( read_restart )
+{
+  if(mode() != "read")
+    return;
+
+  Dictionary& dict = mesh->geometry_fields();
+  Field& u = dict.create_field("u", 2);
+
+  Handle<ReadRestartFile> reader = Core::instance().root().create_component<ReadRestartFile>("Reader");
+  reader->options().set("mesh", mesh);
+  reader->options().set("file", file);
+  reader->options().set(solver::Tags::time(), time);
+
+  // A field with the wrong number of columns is rejected on all processes, including those that read no file
+  Handle<Field> wrong_w(dict.create_field("w", 3).handle());
+  BOOST_CHECK_THROW(reader->execute(), SetupError);
+  dict.remove_component(*wrong_w);
+
+  Field& w = dict.create_field("w", 1);
+  reader->execute();
+
+  BOOST_CHECK_EQUAL(time->options().value<Uint>("iteration"), 10u);
+  BOOST_CHECK_CLOSE(time->options().value<Real>("time_step"), 0.2, 1e-12);
+  for(Uint i = 0; i != dict.size(); ++i)
+  {
+    BOOST_CHECK_EQUAL(u[i][0], u_value(dict, i, 0));
+    BOOST_CHECK_EQUAL(u[i][1], u_value(dict, i, 1));
+    BOOST_CHECK_EQUAL(w[i][0], dict.glb_idx()[i]);
+  }
+}
+
+BOOST_AUTO_TEST_CASE( finalize_mpi )
+{
+  PE::Comm::instance().finalize();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+////////////////////////////////////////////////////////////////////////////////
@@ -66,6 +66,15 @@ writer.file = restart_file
 writer.time = time
 writer.execute()
 
+# Write the same data on a background thread
+async_restart_file = cf.URI('restart-test-async.cf3restart')
+async_writer = domain.create_component('AsyncWriter', 'cf3.solver.actions.WriteRestartFile')
+async_writer.fields = [mesh.geometry.node_gids, mesh.elems_P0.element_gids]
+async_writer.file = async_restart_file
+async_writer.time = time
+async_writer.asynchronous = True
+async_writer.execute()
+
 # Store reference data and destroy the original
 ref_node_gids = copy_and_reset(mesh.geometry.node_gids, domain)
 ref_element_gids = copy_and_reset(mesh.elems_P0.element_gids, domain)
@@ -73,6 +82,9 @@ time.current_time = 0.
 time.time_step = 1.
 time.iteration = 0
 
+# The fields were copied before they were reset, so the asynchronous write is not affected
+async_writer.wait()
+
 # Read back the data
 reader = domain.create_component('Reader', 'cf3.solver.actions.ReadRestartFile')
 reader.mesh = mesh
@@ -101,4 +113,38 @@ if not differ.properties()['arrays_equal']:
   raise Exception('Element GIDS do not match')
 
 if time.current_time != 2. or time.time_step != 0.2 or time.iteration != 10:
-  raise Exception('Error in time data')
\ No newline at end of file
+  raise Exception('Error in time data')
+
+# Check the asynchronously written file
+reader.file = async_restart_file
+reader.execute()
+
+differ.left = ref_node_gids
+differ.right = mesh.geometry.node_gids
+differ.execute()
+if not differ.properties()['arrays_equal']:
+  raise Exception('Node GIDS do not match for the asynchronous restart')
+
+differ.left = ref_element_gids
+differ.right = mesh.elems_P0.element_gids
+differ.execute()
+if not differ.properties()['arrays_equal']:
+  raise Exception('Element GIDS do not match for the asynchronous restart')
+
+# Read the data by matching the global indices, as is done for files written on a different number of CPUs
+mesh.geometry.node_gids[0][0] = -1.
+reader.file = restart_file
+reader.redistribute = True
+reader.execute()
+
+differ.left = ref_node_gids
+differ.right = mesh.geometry.node_gids
+differ.execute()
+if not differ.properties()['arrays_equal']:
+  raise Exception('Node GIDS do not match after redistribution')
+
+differ.left = ref_element_gids
+differ.right = mesh.elems_P0.element_gids
+differ.execute()
+if not differ.properties()['arrays_equal']:
+  raise Exception('Element GIDS do not match after redistribution')
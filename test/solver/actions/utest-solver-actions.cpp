@@ -224,6 +224,30 @@ BOOST_AUTO_TEST_CASE ( test_CSetFieldValue )
 
 ////////////////////////////////////////////////////////////////////////////////
 
+BOOST_AUTO_TEST_CASE ( test_execute_range )
+{
+  Component& root = Core::instance().root();
+  Handle< Mesh > mesh = root.get_child("mesh2")->handle<Mesh>();
+  Dictionary& cells_P0 = *mesh->get_child("cells_P0")->handle<Dictionary>();
+  Field& volumes = *cells_P0.get_child("volume")->handle<Field>();
+  Field& range_volumes = cells_P0.create_field("range_volume");
+
+  // Chunked execution on several threads must give the same result as the per-element execution
+  Core::instance().environment().options().set("nb_threads", 2u);
+  Handle<Loop> elem_loop = root.create_component< ForAllElements >("range_elem_loop");
+  elem_loop->options().set("regions",std::vector<URI>(1,mesh->topology().uri()));
+  elem_loop->options().set("chunk_size",7u);
+  elem_loop->create_loop_operation("cf3.solver.actions.ComputeVolume");
+  elem_loop->action("cf3.solver.actions.ComputeVolume").options().set("volume",range_volumes.uri());
+  elem_loop->execute();
+  Core::instance().environment().options().set("nb_threads", 1u);
+
+  BOOST_CHECK(volumes.array() == range_volumes.array());
+  root.remove_component(*elem_loop);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 BOOST_AUTO_TEST_CASE ( test_ForAllElementsT )
 {
   Component& root = Core::instance().root();